@@ -0,0 +1,176 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_INCLUDE_BASE_FE_SKETCH_H_
+#define HYBRIDSE_INCLUDE_BASE_FE_SKETCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace hybridse {
+namespace base {
+
+// Mergeable summary of a set of values.
+//
+// The pre-aggregation buckets of the aggregate functions which are not
+// decomposable into a fixed size value (e.g, distinct_count, median) keep
+// a sketch, which is encoded into the aggr table and merged with the sketches
+// of the other buckets and the raw rows of the window at request time.
+class Sketch {
+ public:
+    virtual ~Sketch() {}
+
+    virtual std::unique_ptr<Sketch> Clone() const = 0;
+
+    // merge the other sketch of the same kind, return false otherwise
+    virtual bool Merge(const Sketch& other) = 0;
+
+    virtual void Encode(std::string* output) const = 0;
+
+    // replace the content with the encoded one, return false if it is
+    // corrupted or of another kind
+    virtual bool Decode(const char* data, size_t size) = 0;
+
+    virtual void Clear() = 0;
+
+    virtual bool Empty() const = 0;
+};
+
+// HyperLogLog with 2^12 registers for distinct_count, the standard error is
+// about 1.6%. The registers are kept sparse until 1/8 of them are set, so
+// that the buckets of a few rows stay small.
+class HyperLogLog : public Sketch {
+ public:
+    static constexpr uint32_t PRECISION = 12;
+    static constexpr uint32_t REGISTER_CNT = 1u << PRECISION;
+
+    HyperLogLog() {}
+    ~HyperLogLog() override {}
+
+    // the integers, the dates and the timestamps are hashed as int64, the
+    // floats as double, so that the same value always hits the same register
+    template <class T>
+    std::enable_if_t<std::is_integral<T>::value> AddValue(const T& val) {
+        AddInt(static_cast<int64_t>(val));
+    }
+    template <class T>
+    std::enable_if_t<std::is_floating_point<T>::value> AddValue(const T& val) {
+        AddDouble(static_cast<double>(val));
+    }
+    void AddValue(const std::string& val) { AddString(val.data(), val.size()); }
+
+    void AddInt(int64_t val);
+    void AddDouble(double val);
+    void AddString(const char* data, size_t size);
+    void AddHash(uint64_t hash);
+
+    // estimated number of the distinct values
+    int64_t Estimate() const;
+
+    std::unique_ptr<Sketch> Clone() const override;
+    bool Merge(const Sketch& other) override;
+    void Encode(std::string* output) const override;
+    bool Decode(const char* data, size_t size) override;
+    void Clear() override;
+    bool Empty() const override { return sparse_.empty() && dense_.empty(); }
+
+ private:
+    void SetRegister(uint32_t idx, uint8_t rank);
+    void ToDense();
+
+    // (idx << 8 | rank) sorted by idx, valid while dense_ is empty
+    std::vector<uint32_t> sparse_;
+    std::vector<uint8_t> dense_;
+};
+
+// Merging t-digest for median. A centroid near the median holds about
+// pi * count / (2 * COMPRESSION) values and the ones at the tails hold less,
+// so a digest of less than 2 * COMPRESSION / pi values keeps every value and
+// its median is exact.
+class TDigest : public Sketch {
+ public:
+    static constexpr double COMPRESSION = 200;
+
+    TDigest() {}
+    ~TDigest() override {}
+
+    void Add(double val, double weight = 1);
+
+    // the value at quantile q in [0, 1], interpolated between the centroids
+    // as the same way as the exact median of the values does
+    double Quantile(double q) const;
+
+    double Count() const { return total_weight_; }
+
+    std::unique_ptr<Sketch> Clone() const override;
+    bool Merge(const Sketch& other) override;
+    void Encode(std::string* output) const override;
+    bool Decode(const char* data, size_t size) override;
+    void Clear() override;
+    bool Empty() const override { return total_weight_ == 0; }
+
+ private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    // merge the buffered values into the centroids
+    void Compress() const;
+
+    mutable std::vector<Centroid> centroids_;
+    mutable std::vector<Centroid> buffer_;
+    double total_weight_ = 0;
+    double min_ = 0;
+    double max_ = 0;
+};
+
+// Count, mean and the sum of squared differences from the mean kept by
+// Welford's algorithm for the variance and standard deviation, merged by
+// Chan's parallel formula.
+class Moments : public Sketch {
+ public:
+    Moments() {}
+    ~Moments() override {}
+
+    void Add(double val);
+
+    int64_t Count() const { return count_; }
+    double Mean() const { return mean_; }
+    double VarPop() const { return count_ > 0 ? m2_ / count_ : 0; }
+    double VarSamp() const { return count_ > 1 ? m2_ / (count_ - 1) : 0; }
+
+    std::unique_ptr<Sketch> Clone() const override;
+    bool Merge(const Sketch& other) override;
+    void Encode(std::string* output) const override;
+    bool Decode(const char* data, size_t size) override;
+    void Clear() override;
+    bool Empty() const override { return count_ == 0; }
+
+ private:
+    int64_t count_ = 0;
+    double mean_ = 0;
+    double m2_ = 0;
+};
+
+}  // namespace base
+}  // namespace hybridse
+#endif  // HYBRIDSE_INCLUDE_BASE_FE_SKETCH_H_
@@ -16,6 +16,7 @@
 
 #ifndef HYBRIDSE_INCLUDE_BASE_ITERATOR_H_
 #define HYBRIDSE_INCLUDE_BASE_ITERATOR_H_
+#include <stddef.h>
 #include <stdint.h>
 
 namespace hybridse {
@@ -96,6 +97,16 @@ class Iterator : public AbstractIterator<K, V, V&> {};
 /// \tparam V value type of elements
 template <class K, class V>
 class ConstIterator : public hybridse::base::AbstractIterator<K, V, const V&> {
+ public:
+    /// Fill `values` with the addresses of up to `n` elements from the current
+    /// position, and `keys` with their keys unless it is null, then move past
+    /// them. Return the count filled. The addresses are valid until the next
+    /// call on the iterator.
+    ///
+    /// Iterators over stable storage implement it to pull a chunk without a
+    /// virtual call per element. The default fills nothing and doesn't move, so
+    /// the caller checks Valid() on a short count and goes on element by element.
+    virtual size_t NextBatch(const V** values, K* keys, size_t n) { return 0; }
 };
 }  // namespace base
 }  // namespace hybridse
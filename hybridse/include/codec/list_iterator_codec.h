@@ -16,10 +16,12 @@
 
 #ifndef HYBRIDSE_INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
 #define HYBRIDSE_INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "base/fe_object.h"
@@ -229,6 +231,23 @@ class ArrayListIterator : public ConstIterator<uint64_t, V> {
     void SeekToFirst() { iter_ = iter_start_; }
 
     bool IsSeekable() const override { return true; }
+
+    size_t NextBatch(const V **values, uint64_t *keys, size_t n) override {
+        // the packed bits of std::vector<bool> have no addresses
+        if constexpr (std::is_same<V, bool>::value) {
+            return 0;
+        } else {
+            size_t cnt = 0;
+            for (; cnt < n && iter_ != iter_end_; ++cnt, ++iter_) {
+                values[cnt] = &*iter_;
+                if (keys != nullptr) {
+                    keys[cnt] = key_;
+                }
+            }
+            return cnt;
+        }
+    }
+
     ArrayListIterator<V> *range(int start, int end) {
         if (start > end || end < iter_start_ || start > iter_end_) {
             return new ArrayListIterator(buffer_, iter_start_, iter_start_);
@@ -347,6 +366,32 @@ class BoolArrayListV : public ListV<bool> {
     std::vector<int> *buffer_;
 };
 
+// Pull the elements of `root` while their keys are within [lo, hi]. The keys
+// of a window descend, so `root` is out of the bounds too once an element
+// beyond them is pulled.
+template <class V>
+size_t NextBatchInRange(ConstIterator<uint64_t, V> *root, uint64_t lo,
+                        uint64_t hi, const V **values, uint64_t *keys,
+                        size_t n) {
+    uint64_t chunk_keys[64];
+    size_t cnt = 0;
+    while (cnt < n) {
+        size_t want = keys != nullptr ? n - cnt : std::min<size_t>(n - cnt, 64);
+        uint64_t *pulled_keys = keys != nullptr ? keys + cnt : chunk_keys;
+        size_t pulled = root->NextBatch(values + cnt, pulled_keys, want);
+        size_t in_range = 0;
+        while (in_range < pulled && pulled_keys[in_range] >= lo &&
+               pulled_keys[in_range] <= hi) {
+            in_range++;
+        }
+        cnt += in_range;
+        if (in_range < pulled || pulled < want) {
+            break;
+        }
+    }
+    return cnt;
+}
+
 template <class V>
 class InnerRowsIterator : public ConstIterator<uint64_t, V> {
  public:
@@ -380,6 +425,15 @@ class InnerRowsIterator : public ConstIterator<uint64_t, V> {
         }
     }
     bool IsSeekable() const { return root_->IsSeekable(); }
+    size_t NextBatch(const V **values, uint64_t *keys, size_t n) override {
+        if (pos_ < start_ || pos_ > end_) {
+            return 0;
+        }
+        uint64_t rest = end_ - pos_;
+        size_t cnt = root_->NextBatch(values, keys, rest < n ? rest + 1 : n);
+        pos_ += cnt;
+        return cnt;
+    }
     std::unique_ptr<ConstIterator<uint64_t, V>> root_;
     uint64_t pos_;
     const uint64_t start_;
@@ -415,6 +469,15 @@ class InnerRowsRangeIterator : public ConstIterator<uint64_t, V> {
         }
     }
     bool IsSeekable() const { return root_->IsSeekable(); }
+    size_t NextBatch(const V **values, uint64_t *keys, size_t n) override {
+        if (pos_ < start_rows_) {
+            return 0;
+        }
+        size_t cnt = NextBatchInRange(root_.get(), end_range_, UINT64_MAX,
+                                      values, keys, n);
+        pos_ += cnt;
+        return cnt;
+    }
 
     std::unique_ptr<ConstIterator<uint64_t, V>> root_;
     uint64_t pos_;
@@ -450,6 +513,9 @@ class InnerRangeIterator : public ConstIterator<uint64_t, V> {
         root_->Seek(start_);
     }
     virtual bool IsSeekable() const { return root_->IsSeekable(); }
+    size_t NextBatch(const V **values, uint64_t *keys, size_t n) override {
+        return NextBatchInRange(root_.get(), end_, start_, values, keys, n);
+    }
 
     std::unique_ptr<ConstIterator<uint64_t, V>> root_;
     // the row key corresponding to the window
@@ -550,6 +616,78 @@ class ColumnIterator : public ConstIterator<uint64_t, V> {
     V value_;
 };
 
+// Pull the values of a numeric column in chunks into a contiguous buffer, so
+// that the aggregation runs over arrays instead of one ConstIterator call per
+// value. Bit i of the validity is set if the ith value of the chunk is not
+// null, and the null values are zero.
+//
+// The rows of a chunk are pulled from the window by RowIterator::NextBatch,
+// one virtual call per chunk. A window which doesn't support it is read row
+// by row.
+template <class V>
+class ColumnBatchIterator {
+ public:
+    static_assert(std::is_arithmetic<V>::value,
+                  "batch iterator only supports the numeric columns");
+
+    explicit ColumnBatchIterator(const ColumnImpl<V> *column_impl,
+                                 size_t batch_size = 1024)
+        : column_impl_(column_impl),
+          row_iter_(column_impl->root()->GetIterator()),
+          batch_size_((std::max<size_t>(batch_size, 1) + 63) / 64 * 64),
+          rows_(new const Row *[batch_size_]),
+          values_(new V[batch_size_]()),
+          validity_(batch_size_ / 64) {
+        if (row_iter_) {
+            row_iter_->SeekToFirst();
+        }
+    }
+
+    // decode the next chunk, return the count of the values in it, or 0 if
+    // the column is exhausted
+    size_t Next() {
+        if (!row_iter_) {
+            return 0;
+        }
+        std::fill(validity_.begin(), validity_.end(), 0);
+        size_t cnt = row_iter_->NextBatch(rows_.get(), nullptr, batch_size_);
+        for (size_t i = 0; i < cnt; i++) {
+            Decode(*rows_[i], i);
+        }
+        // the window ends, or it is read row by row
+        while (cnt < batch_size_ && row_iter_->Valid()) {
+            Decode(row_iter_->GetValue(), cnt);
+            row_iter_->Next();
+            cnt++;
+        }
+        return cnt;
+    }
+
+    const V *values() const { return values_.get(); }
+    const uint64_t *validity() const { return validity_.data(); }
+    size_t batch_size() const { return batch_size_; }
+
+ private:
+    void Decode(const Row &row, size_t i) {
+        bool is_null = true;
+        // call the numeric implementation directly instead of virtually
+        column_impl_->ColumnImpl<V>::GetField(row, &values_[i], &is_null);
+        if (is_null) {
+            values_[i] = 0;
+        } else {
+            validity_[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+
+    const ColumnImpl<V> *column_impl_;
+    std::unique_ptr<RowIterator> row_iter_;
+    const size_t batch_size_;
+    std::unique_ptr<const Row *[]> rows_;
+    // not a vector, which packs bool
+    std::unique_ptr<V[]> values_;
+    std::vector<uint64_t> validity_;
+};
+
 }  // namespace codec
 }  // namespace hybridse
 
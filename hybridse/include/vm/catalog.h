@@ -369,6 +369,16 @@ class PartitionHandler : public TableHandler {
         return std::shared_ptr<TableHandler>();
     }
 
+    /// Return the partial aggregate of `func` over column `col` of the rows
+    /// binding to given key whose order key lies in [start, end], encoded as
+    /// the `agg_val` of a pre-aggregate table. An empty `col` means `*`.
+    /// Return `false` by default, then the caller aggregates the segment itself.
+    virtual bool GetWindowAggr(const std::string& key, const std::string& func,
+                               const std::string& col, int64_t start,
+                               int64_t end, std::string* agg_val) {
+        return false;
+    }
+
     /// Return a sequence of table handles of specify segments binding to given
     /// keys set.
     virtual std::vector<std::shared_ptr<TableHandler>> GetSegments(
@@ -42,6 +42,8 @@ namespace vm {
 using ::hybridse::codec::Row;
 
 inline constexpr const char* LONG_WINDOWS = "long_windows";
+// set by the tablets keeping incremental window aggregates, see `PartitionHandler::GetWindowAggr`
+inline constexpr const char* WINDOW_AGGR_CACHE = "window_aggr_cache";
 
 class Engine;
 /// \brief An options class for controlling engine behaviour.
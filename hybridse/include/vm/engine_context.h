@@ -101,11 +101,16 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    // the dir to keep the compiled objects across restarts, empty to disable
+    const std::string& GetObjectCacheDir() const { return object_cache_dir_; }
+    void SetObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    std::string object_cache_dir_;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -72,6 +72,7 @@ class MemTimeTableIterator : public RowIterator {
     bool Valid() const;
     const Row& GetValue() override;
     bool IsSeekable() const override;
+    size_t NextBatch(const Row** values, uint64_t* keys, size_t n) override;
 
  private:
     const MemTimeTable* table_;
@@ -94,6 +95,7 @@ class MemTableIterator : public RowIterator {
     void Next();
     bool Valid() const;
     bool IsSeekable() const override;
+    size_t NextBatch(const Row** values, uint64_t* keys, size_t n) override;
 
  private:
     const MemTable* table_;
@@ -758,6 +760,52 @@ class MemCatalog : public Catalog {
     Databases dbs_;
 };
 
+/**
+ * Table handler over the rows [start, end) of a shared MemTimeTable:
+ * (1) The windows of a batch of requests share the rows without copying them
+ * (2) O(1) time construction
+ */
+class MemTimeTableSliceHandler : public TableHandler {
+ public:
+    MemTimeTableSliceHandler(std::shared_ptr<const MemTimeTable> table,
+                             size_t start, size_t end)
+        : table_(table), start_(start), end_(end) {}
+    ~MemTimeTableSliceHandler() override {}
+
+    std::unique_ptr<RowIterator> GetIterator() override {
+        return std::unique_ptr<RowIterator>(GetRawIterator());
+    }
+    RowIterator* GetRawIterator() override {
+        return new MemTimeTableIterator(table_.get(), nullptr, start_, end_);
+    }
+    const uint64_t GetCount() override { return end_ - start_; }
+    Row At(uint64_t pos) override {
+        return pos < end_ - start_ ? (*table_)[start_ + pos].second : Row();
+    }
+
+    const Types& GetTypes() override { return types_; }
+    const IndexHint& GetIndex() override { return index_hint_; }
+    std::unique_ptr<WindowIterator> GetWindowIterator(
+        const std::string&) override {
+        return nullptr;
+    }
+    const Schema* GetSchema() override { return nullptr; }
+    const std::string& GetName() override { return name_; }
+    const std::string& GetDatabase() override { return db_; }
+    const std::string GetHandlerTypeName() override {
+        return "MemTimeTableSliceHandler";
+    }
+
+ private:
+    std::shared_ptr<const MemTimeTable> table_;
+    size_t start_;
+    size_t end_;
+    const std::string name_;
+    const std::string db_;
+    Types types_;
+    IndexHint index_hint_;
+};
+
 /**
  * Result table handler specified for request union:
  * (1) The first row is fixed to be the request row
@@ -774,6 +822,7 @@ class RequestUnionTableHandler : public TableHandler {
         return std::unique_ptr<RowIterator>(GetRawIterator());
     }
     RowIterator* GetRawIterator() override;
+    const uint64_t GetCount() override { return window_->GetCount() + 1; }
 
     const Types& GetTypes() override { return window_->GetTypes(); }
     const IndexHint& GetIndex() override { return window_->GetIndex(); }
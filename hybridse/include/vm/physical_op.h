@@ -1497,13 +1497,16 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
 
 class PhysicalRequestAggUnionNode : public PhysicalOpNode {
  public:
-    PhysicalRequestAggUnionNode(PhysicalOpNode *request, PhysicalOpNode *raw, PhysicalOpNode *aggr,
-                                const RequestWindowOp &window, const RequestWindowOp &aggr_window,
-                                bool instance_not_in_window, bool exclude_current_time, bool output_request_row,
-                                const node::FnDefNode *func, const node::ExprNode* agg_col)
+    // `aggrs` are the pre-aggregated tables of the raw table, from the coarsest
+    // bucket size to the finest one, `aggr_windows` are their windows
+    PhysicalRequestAggUnionNode(PhysicalOpNode *request, PhysicalOpNode *raw,
+                                const std::vector<PhysicalOpNode *> &aggrs, const RequestWindowOp &window,
+                                const std::vector<RequestWindowOp> &aggr_windows, bool instance_not_in_window,
+                                bool exclude_current_time, bool output_request_row, const node::FnDefNode *func,
+                                const node::ExprNode *agg_col)
         : PhysicalOpNode(kPhysicalOpRequestAggUnion, true),
           window_(window),
-          agg_window_(aggr_window),
+          agg_windows_(aggr_windows),
           func_(func),
           agg_col_(agg_col),
           instance_not_in_window_(instance_not_in_window),
@@ -1516,12 +1519,14 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
         fn_infos_.push_back(&window_.range_.fn_info());
         fn_infos_.push_back(&window_.index_key_.fn_info());
 
-        fn_infos_.push_back(&agg_window_.partition_.fn_info());
-        fn_infos_.push_back(&agg_window_.sort_.fn_info());
-        fn_infos_.push_back(&agg_window_.range_.fn_info());
-        fn_infos_.push_back(&agg_window_.index_key_.fn_info());
+        for (auto &agg_window : agg_windows_) {
+            fn_infos_.push_back(&agg_window.partition_.fn_info());
+            fn_infos_.push_back(&agg_window.sort_.fn_info());
+            fn_infos_.push_back(&agg_window.range_.fn_info());
+            fn_infos_.push_back(&agg_window.index_key_.fn_info());
+        }
 
-        AddProducers(request, raw, aggr);
+        AddProducers(request, raw, aggrs);
     }
     virtual ~PhysicalRequestAggUnionNode() {}
     base::Status InitSchema(PhysicalPlanContext *) override;
@@ -1546,7 +1551,9 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
     }
 
     RequestWindowOp window_;
-    RequestWindowOp agg_window_;
+    // one window for each pre-aggregated table, never resized after the construction as
+    // `fn_infos_` refers to them
+    std::vector<RequestWindowOp> agg_windows_;
     const node::FnDefNode* func_ = nullptr;
     const node::ExprNode* agg_col_;
     const SchemasContext* parent_schema_context_ = nullptr;
@@ -1563,10 +1570,12 @@ class PhysicalRequestAggUnionNode : public PhysicalOpNode {
     // `EXCLUDE CURRENT_ROW`
     bool output_request_row_;
 
-    void AddProducers(PhysicalOpNode *request, PhysicalOpNode *raw, PhysicalOpNode *aggr) {
+    void AddProducers(PhysicalOpNode *request, PhysicalOpNode *raw, const std::vector<PhysicalOpNode *> &aggrs) {
         AddProducer(request);
         AddProducer(raw);
-        AddProducer(aggr);
+        for (auto aggr : aggrs) {
+            AddProducer(aggr);
+        }
     }
 
     Schema agg_schema_;
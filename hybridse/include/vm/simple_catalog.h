@@ -106,6 +106,10 @@ class SimpleCatalog : public Catalog {
         const std::string& partition_cols,
         const std::string& order_col) override;
 
+    // the pre-aggregation tables of the base tables, GetAggrTables returns a
+    // default one for a base table without any
+    void AddAggrTable(const AggrTableInfo& info) { aggr_tables_.push_back(info); }
+
  private:
     bool enable_index_;
     std::map<std::string,
@@ -113,6 +117,7 @@ class SimpleCatalog : public Catalog {
         table_handlers_;
 
     std::map<std::string, std::shared_ptr<type::Database>> databases_;
+    std::vector<AggrTableInfo> aggr_tables_;
 };
 
 }  // namespace vm
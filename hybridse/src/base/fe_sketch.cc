@@ -0,0 +1,423 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/fe_sketch.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/fe_hash.h"
+
+namespace hybridse {
+namespace base {
+
+// the first byte of an encoded sketch
+enum SketchTag : uint8_t {
+    kHyperLogLogTag = 1,
+    kTDigestTag = 2,
+    kMomentsTag = 3,
+};
+
+static const uint32_t HASH_SEED = 0xe17a1465;
+
+template <class T>
+static void AppendValue(std::string* output, const T& val) {
+    output->append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template <class T>
+static T ReadValue(const char* data) {
+    T val;
+    memcpy(&val, data, sizeof(T));
+    return val;
+}
+
+void HyperLogLog::AddInt(int64_t val) {
+    AddHash(MurmurHash64A(&val, sizeof(val), HASH_SEED));
+}
+
+void HyperLogLog::AddDouble(double val) {
+    // 0.0 and -0.0 are the same value
+    if (val == 0) {
+        val = 0;
+    }
+    AddHash(MurmurHash64A(&val, sizeof(val), HASH_SEED));
+}
+
+void HyperLogLog::AddString(const char* data, size_t size) {
+    AddHash(MurmurHash64A(data, size, HASH_SEED));
+}
+
+void HyperLogLog::AddHash(uint64_t hash) {
+    uint32_t idx = hash >> (64 - PRECISION);
+    // the sentinel bit bounds the rank by 64 - PRECISION + 1
+    uint64_t rest = (hash << PRECISION) | (1ull << (PRECISION - 1));
+    SetRegister(idx, __builtin_clzll(rest) + 1);
+}
+
+void HyperLogLog::SetRegister(uint32_t idx, uint8_t rank) {
+    if (!dense_.empty()) {
+        dense_[idx] = std::max(dense_[idx], rank);
+        return;
+    }
+    auto it = std::lower_bound(sparse_.begin(), sparse_.end(), idx << 8);
+    if (it != sparse_.end() && (*it >> 8) == idx) {
+        if ((*it & 0xff) < rank) {
+            *it = idx << 8 | rank;
+        }
+        return;
+    }
+    sparse_.insert(it, idx << 8 | rank);
+    if (sparse_.size() > REGISTER_CNT / 8) {
+        ToDense();
+    }
+}
+
+void HyperLogLog::ToDense() {
+    dense_.assign(REGISTER_CNT, 0);
+    for (auto entry : sparse_) {
+        dense_[entry >> 8] = entry & 0xff;
+    }
+    sparse_.clear();
+    sparse_.shrink_to_fit();
+}
+
+int64_t HyperLogLog::Estimate() const {
+    const double m = REGISTER_CNT;
+    double sum = 0;
+    uint32_t zeros = 0;
+    if (dense_.empty()) {
+        zeros = REGISTER_CNT - sparse_.size();
+        sum = zeros;
+        for (auto entry : sparse_) {
+            sum += std::ldexp(1.0, -static_cast<int>(entry & 0xff));
+        }
+    } else {
+        for (auto rank : dense_) {
+            zeros += rank == 0;
+            sum += std::ldexp(1.0, -static_cast<int>(rank));
+        }
+    }
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        // linear counting is more accurate for the small cardinalities
+        estimate = m * std::log(m / zeros);
+    }
+    return std::llround(estimate);
+}
+
+std::unique_ptr<Sketch> HyperLogLog::Clone() const {
+    return std::make_unique<HyperLogLog>(*this);
+}
+
+bool HyperLogLog::Merge(const Sketch& other) {
+    auto hll = dynamic_cast<const HyperLogLog*>(&other);
+    if (hll == nullptr) {
+        return false;
+    }
+    if (hll->dense_.empty()) {
+        for (auto entry : hll->sparse_) {
+            SetRegister(entry >> 8, entry & 0xff);
+        }
+        return true;
+    }
+    if (dense_.empty()) {
+        ToDense();
+    }
+    for (uint32_t i = 0; i < REGISTER_CNT; i++) {
+        dense_[i] = std::max(dense_[i], hll->dense_[i]);
+    }
+    return true;
+}
+
+void HyperLogLog::Encode(std::string* output) const {
+    output->clear();
+    output->push_back(kHyperLogLogTag);
+    output->push_back(PRECISION);
+    if (dense_.empty()) {
+        output->push_back(0);
+        output->append(reinterpret_cast<const char*>(sparse_.data()),
+                       sparse_.size() * sizeof(uint32_t));
+    } else {
+        output->push_back(1);
+        output->append(reinterpret_cast<const char*>(dense_.data()),
+                       dense_.size());
+    }
+}
+
+bool HyperLogLog::Decode(const char* data, size_t size) {
+    Clear();
+    if (size < 3 || data[0] != kHyperLogLogTag || data[1] != PRECISION) {
+        return false;
+    }
+    bool dense = data[2] != 0;
+    data += 3;
+    size -= 3;
+    if (dense) {
+        if (size != REGISTER_CNT) {
+            return false;
+        }
+        dense_.assign(data, data + size);
+        return true;
+    }
+    if (size % sizeof(uint32_t) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i += sizeof(uint32_t)) {
+        uint32_t entry = ReadValue<uint32_t>(data + i);
+        if ((entry >> 8) >= REGISTER_CNT) {
+            Clear();
+            return false;
+        }
+        SetRegister(entry >> 8, entry & 0xff);
+    }
+    return true;
+}
+
+void HyperLogLog::Clear() {
+    sparse_.clear();
+    dense_.clear();
+    dense_.shrink_to_fit();
+}
+
+void TDigest::Add(double val, double weight) {
+    if (weight <= 0 || std::isnan(val)) {
+        return;
+    }
+    if (total_weight_ == 0) {
+        min_ = val;
+        max_ = val;
+    } else {
+        min_ = std::min(min_, val);
+        max_ = std::max(max_, val);
+    }
+    total_weight_ += weight;
+    buffer_.push_back({val, weight});
+    if (buffer_.size() >= 4 * COMPRESSION) {
+        Compress();
+    }
+}
+
+void TDigest::Compress() const {
+    if (buffer_.empty()) {
+        return;
+    }
+    buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+    std::stable_sort(buffer_.begin(), buffer_.end(),
+                     [](const Centroid& lhs, const Centroid& rhs) {
+                         return lhs.mean < rhs.mean;
+                     });
+    centroids_.clear();
+    // the k1 scale function of t-digest, a centroid covers no more than 1 of
+    // k, which is steeper at the tails so that the extreme quantiles stay
+    // accurate, and the digest keeps no more than COMPRESSION centroids
+    auto scale = [this](double weight) {
+        double q = std::min(1.0, weight / total_weight_);
+        return COMPRESSION / (2 * M_PI) * std::asin(2 * q - 1);
+    };
+    Centroid cur = buffer_[0];
+    double weight_so_far = 0;
+    double k_lo = scale(0);
+    for (size_t i = 1; i < buffer_.size(); i++) {
+        const auto& next = buffer_[i];
+        double weight = cur.weight + next.weight;
+        if (scale(weight_so_far + weight) - k_lo <= 1) {
+            cur.mean += (next.mean - cur.mean) * next.weight / weight;
+            cur.weight = weight;
+        } else {
+            weight_so_far += cur.weight;
+            k_lo = scale(weight_so_far);
+            centroids_.push_back(cur);
+            cur = next;
+        }
+    }
+    centroids_.push_back(cur);
+    buffer_.clear();
+}
+
+double TDigest::Quantile(double q) const {
+    if (total_weight_ == 0) {
+        return NAN;
+    }
+    Compress();
+    q = std::min(1.0, std::max(0.0, q));
+    // the rank of the quantile among the values counting from 0, a centroid
+    // stands for the values around the rank of its center
+    double rank = q * (total_weight_ - 1);
+    double center = (centroids_[0].weight - 1) / 2;
+    if (rank <= center) {
+        if (center <= 0) {
+            return centroids_[0].mean;
+        }
+        return min_ + (centroids_[0].mean - min_) * rank / center;
+    }
+    double weight_so_far = 0;
+    for (size_t i = 0; i + 1 < centroids_.size(); i++) {
+        weight_so_far += centroids_[i].weight;
+        double next_center = weight_so_far + (centroids_[i + 1].weight - 1) / 2;
+        if (rank <= next_center) {
+            return centroids_[i].mean + (centroids_[i + 1].mean -
+                                         centroids_[i].mean) *
+                                            (rank - center) /
+                                            (next_center - center);
+        }
+        center = next_center;
+    }
+    double last_rank = total_weight_ - 1;
+    if (last_rank <= center) {
+        return centroids_.back().mean;
+    }
+    return centroids_.back().mean + (max_ - centroids_.back().mean) *
+                                        (rank - center) / (last_rank - center);
+}
+
+std::unique_ptr<Sketch> TDigest::Clone() const {
+    Compress();
+    return std::make_unique<TDigest>(*this);
+}
+
+bool TDigest::Merge(const Sketch& other) {
+    auto digest = dynamic_cast<const TDigest*>(&other);
+    if (digest == nullptr) {
+        return false;
+    }
+    if (digest->Empty()) {
+        return true;
+    }
+    digest->Compress();
+    if (Empty()) {
+        min_ = digest->min_;
+        max_ = digest->max_;
+    } else {
+        min_ = std::min(min_, digest->min_);
+        max_ = std::max(max_, digest->max_);
+    }
+    total_weight_ += digest->total_weight_;
+    buffer_.insert(buffer_.end(), digest->centroids_.begin(),
+                   digest->centroids_.end());
+    if (buffer_.size() >= 4 * COMPRESSION) {
+        Compress();
+    }
+    return true;
+}
+
+void TDigest::Encode(std::string* output) const {
+    Compress();
+    output->clear();
+    output->push_back(kTDigestTag);
+    AppendValue<uint32_t>(output, centroids_.size());
+    AppendValue(output, min_);
+    AppendValue(output, max_);
+    for (const auto& centroid : centroids_) {
+        AppendValue(output, centroid.mean);
+        AppendValue(output, centroid.weight);
+    }
+}
+
+bool TDigest::Decode(const char* data, size_t size) {
+    Clear();
+    const size_t header_size = 1 + sizeof(uint32_t) + 2 * sizeof(double);
+    if (size < header_size || data[0] != kTDigestTag) {
+        return false;
+    }
+    uint32_t cnt = ReadValue<uint32_t>(data + 1);
+    if (size != header_size + cnt * 2 * sizeof(double)) {
+        return false;
+    }
+    min_ = ReadValue<double>(data + 1 + sizeof(uint32_t));
+    max_ = ReadValue<double>(data + 1 + sizeof(uint32_t) + sizeof(double));
+    const char* pos = data + header_size;
+    for (uint32_t i = 0; i < cnt; i++) {
+        Centroid centroid = {ReadValue<double>(pos),
+                             ReadValue<double>(pos + sizeof(double))};
+        pos += 2 * sizeof(double);
+        if (!(centroid.weight > 0)) {
+            Clear();
+            return false;
+        }
+        total_weight_ += centroid.weight;
+        centroids_.push_back(centroid);
+    }
+    return true;
+}
+
+void TDigest::Clear() {
+    centroids_.clear();
+    buffer_.clear();
+    total_weight_ = 0;
+    min_ = 0;
+    max_ = 0;
+}
+
+void Moments::Add(double val) {
+    count_++;
+    double delta = val - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (val - mean_);
+}
+
+std::unique_ptr<Sketch> Moments::Clone() const {
+    return std::make_unique<Moments>(*this);
+}
+
+bool Moments::Merge(const Sketch& other) {
+    auto moments = dynamic_cast<const Moments*>(&other);
+    if (moments == nullptr) {
+        return false;
+    }
+    if (moments->count_ == 0) {
+        return true;
+    }
+    int64_t count = count_ + moments->count_;
+    double delta = moments->mean_ - mean_;
+    mean_ += delta * moments->count_ / count;
+    m2_ += moments->m2_ +
+           delta * delta * count_ / count * moments->count_;
+    count_ = count;
+    return true;
+}
+
+void Moments::Encode(std::string* output) const {
+    output->clear();
+    output->push_back(kMomentsTag);
+    AppendValue(output, count_);
+    AppendValue(output, mean_);
+    AppendValue(output, m2_);
+}
+
+bool Moments::Decode(const char* data, size_t size) {
+    Clear();
+    if (size != 1 + sizeof(int64_t) + 2 * sizeof(double) ||
+        data[0] != kMomentsTag) {
+        return false;
+    }
+    count_ = ReadValue<int64_t>(data + 1);
+    mean_ = ReadValue<double>(data + 1 + sizeof(int64_t));
+    m2_ = ReadValue<double>(data + 1 + sizeof(int64_t) + sizeof(double));
+    return count_ >= 0;
+}
+
+void Moments::Clear() {
+    count_ = 0;
+    mean_ = 0;
+    m2_ = 0;
+}
+
+}  // namespace base
+}  // namespace hybridse
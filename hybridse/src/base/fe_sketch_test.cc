@@ -0,0 +1,178 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/fe_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace base {
+
+class SketchTest : public ::testing::Test {
+ public:
+    SketchTest() {}
+    ~SketchTest() {}
+};
+
+// encode and decode the sketch, as the pre-aggregation buckets do
+template <class T>
+static T RoundTrip(const T& sketch) {
+    std::string encoded;
+    sketch.Encode(&encoded);
+    T decoded;
+    EXPECT_TRUE(decoded.Decode(encoded.data(), encoded.size()));
+    return decoded;
+}
+
+TEST_F(SketchTest, HyperLogLogSmall) {
+    HyperLogLog hll;
+    ASSERT_TRUE(hll.Empty());
+    ASSERT_EQ(0, hll.Estimate());
+    for (int i = 0; i < 10; i++) {
+        hll.AddValue(i % 5);
+        hll.AddValue(std::string("key") + std::to_string(i % 3));
+    }
+    ASSERT_EQ(8, hll.Estimate());
+    ASSERT_EQ(8, RoundTrip(hll).Estimate());
+    // the same value of int16 and int64 hits the same register
+    HyperLogLog other;
+    other.AddValue(static_cast<int16_t>(4));
+    other.AddValue(static_cast<int64_t>(5));
+    ASSERT_TRUE(hll.Merge(other));
+    ASSERT_EQ(9, hll.Estimate());
+
+    HyperLogLog doubles;
+    doubles.AddValue(0.0);
+    doubles.AddValue(-0.0);
+    doubles.AddValue(0.5f);
+    ASSERT_EQ(2, doubles.Estimate());
+}
+
+TEST_F(SketchTest, HyperLogLogMerge) {
+    std::vector<HyperLogLog> buckets(20);
+    HyperLogLog all;
+    for (int64_t i = 0; i < 100000; i++) {
+        int64_t val = i % 30000;
+        buckets[i % buckets.size()].AddValue(val);
+        all.AddValue(val);
+    }
+    HyperLogLog merged;
+    for (const auto& bucket : buckets) {
+        ASSERT_TRUE(merged.Merge(RoundTrip(bucket)));
+    }
+    ASSERT_EQ(all.Estimate(), merged.Estimate());
+    ASSERT_NEAR(30000, merged.Estimate(), 30000 * 0.05);
+
+    Moments moments;
+    ASSERT_FALSE(merged.Merge(moments));
+    std::string encoded;
+    moments.Encode(&encoded);
+    ASSERT_FALSE(merged.Decode(encoded.data(), encoded.size()));
+}
+
+TEST_F(SketchTest, TDigestExact) {
+    TDigest digest;
+    ASSERT_TRUE(std::isnan(digest.Quantile(0.5)));
+    digest.Add(3);
+    ASSERT_EQ(3, digest.Quantile(0.5));
+    digest.Add(1);
+    digest.Add(2);
+    ASSERT_EQ(2, digest.Quantile(0.5));
+    digest.Add(0);
+    ASSERT_EQ(1.5, digest.Quantile(0.5));
+    ASSERT_EQ(0, digest.Quantile(0));
+    ASSERT_EQ(3, digest.Quantile(1));
+
+    // small buckets keep every value
+    std::vector<double> values;
+    TDigest merged;
+    for (int b = 0; b < 8; b++) {
+        TDigest bucket;
+        for (int i = 0; i < 15; i++) {
+            double val = (b * 37 + i * 11) % 101;
+            bucket.Add(val);
+            values.push_back(val);
+        }
+        ASSERT_TRUE(merged.Merge(RoundTrip(bucket)));
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(120, merged.Count());
+    ASSERT_DOUBLE_EQ((values[59] + values[60]) / 2, merged.Quantile(0.5));
+}
+
+TEST_F(SketchTest, TDigestApproximate) {
+    std::mt19937 rng(0);
+    std::normal_distribution<double> dist(100, 20);
+    std::vector<double> values;
+    TDigest merged;
+    for (int b = 0; b < 50; b++) {
+        TDigest bucket;
+        for (int i = 0; i < 2000; i++) {
+            double val = dist(rng);
+            bucket.Add(val);
+            values.push_back(val);
+        }
+        ASSERT_TRUE(merged.Merge(RoundTrip(bucket)));
+    }
+    std::sort(values.begin(), values.end());
+    std::string encoded;
+    merged.Encode(&encoded);
+    // the size is bounded by the compression instead of the count
+    ASSERT_LT(encoded.size(), 4096u);
+    for (double q : {0.01, 0.25, 0.5, 0.75, 0.99}) {
+        double expect = values[static_cast<size_t>(q * (values.size() - 1))];
+        ASSERT_NEAR(expect, merged.Quantile(q), 0.5) << "quantile " << q;
+    }
+}
+
+TEST_F(SketchTest, Moments) {
+    Moments all;
+    Moments merged;
+    for (int b = 0; b < 7; b++) {
+        Moments bucket;
+        for (int i = 0; i < b * 3; i++) {
+            double val = 1e6 + b * 0.5 + i;
+            bucket.Add(val);
+            all.Add(val);
+        }
+        ASSERT_TRUE(merged.Merge(RoundTrip(bucket)));
+    }
+    ASSERT_EQ(63, merged.Count());
+    ASSERT_NEAR(all.Mean(), merged.Mean(), 1e-6);
+    ASSERT_NEAR(all.VarPop(), merged.VarPop(), 1e-6);
+    ASSERT_NEAR(all.VarSamp(), merged.VarSamp(), 1e-6);
+
+    Moments two;
+    two.Add(1);
+    two.Add(3);
+    ASSERT_DOUBLE_EQ(2, two.Mean());
+    ASSERT_DOUBLE_EQ(1, two.VarPop());
+    ASSERT_DOUBLE_EQ(2, two.VarSamp());
+}
+
+}  // namespace base
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -41,6 +41,32 @@ static void BM_ArraySumColDouble(benchmark::State& state) {  // NOLINT
     SumArrayListCol(&state, BENCHMARK, state.range(0), "col4");
 }
 
+// the batch column iterator with the column kernels the sum udaf calls for
+// integer columns, compare with the per value loop it replaces, floating
+// point columns are still summed in order by the udaf, see BM_MemSumColDouble
+static void BM_MemSumColIntBatch(benchmark::State& state) {  // NOLINT
+    SumMemTableColBatch(&state, BENCHMARK, state.range(0), "col1",
+                        udf::DetectColumnKernelIsa());
+}
+
+static void BM_MemSumColIntBatchScalar(benchmark::State& state) {  // NOLINT
+    SumMemTableColBatch(&state, BENCHMARK, state.range(0), "col1",
+                        udf::ColumnKernelIsa::kScalar);
+}
+
+static void BM_MemSumColIntPerValue(benchmark::State& state) {  // NOLINT
+    SumMemTableColPerValue(&state, BENCHMARK, state.range(0), "col1");
+}
+
+static void BM_ArraySumColIntBatch(benchmark::State& state) {  // NOLINT
+    SumArrayListColBatch(&state, BENCHMARK, state.range(0), "col1",
+                         udf::DetectColumnKernelIsa());
+}
+
+static void BM_ArraySumColIntPerValue(benchmark::State& state) {  // NOLINT
+    SumArrayListColPerValue(&state, BENCHMARK, state.range(0), "col1");
+}
+
 static void BM_CopyMemSegment(benchmark::State& state) {  // NOLINT
     CopyMemSegment(&state, BENCHMARK, state.range(0));
 }
@@ -140,6 +166,31 @@ BENCHMARK(BM_MemSumColDouble)
     ->Args({100})
     ->Args({1000})
     ->Args({10000});
+BENCHMARK(BM_ArraySumColIntBatch)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_ArraySumColIntPerValue)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_MemSumColIntBatch)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_MemSumColIntBatchScalar)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
+BENCHMARK(BM_MemSumColIntPerValue)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000});
 BENCHMARK(BM_Day)->Args({1})->Args({10})->Args({100})->Args({1000})->Args(
     {10000});
 BENCHMARK(BM_Month)->Args({1})->Args({10})->Args({100})->Args({1000})->Args(
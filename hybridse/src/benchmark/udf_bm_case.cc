@@ -15,6 +15,7 @@
  */
 
 #include "benchmark/udf_bm_case.h"
+#include <cmath>
 #include <memory>
 #include <string>
 #include <vector>
@@ -23,6 +24,7 @@
 #include "codec/type_codec.h"
 #include "codegen/ir_base_builder.h"
 #include "codegen/window_ir_builder.h"
+#include "codec/list_iterator_codec.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
 #include "udf/udf_test.h"
@@ -177,10 +179,12 @@ void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
     size_t col_idx;
     ASSERT_TRUE(
         schemas_context
-            .ResolveColumnIndexByName("", col_name, &schema_idx, &col_idx)
+            .ResolveColumnIndexByName("", "", col_name, &schema_idx,
+                                      &col_idx)
             .isOK());
     const codec::ColInfo* info =
-        schemas_context.GetRowFormat(schema_idx)->GetColumnInfo(col_idx);
+        schemas_context.GetRowFormat()->GetColumnInfo(schema_idx,
+                                                     col_idx);
 
     codegen::MemoryWindowDecodeIRBuilder builder(&schemas_context, nullptr);
     node::TypeNode type;
@@ -282,18 +286,20 @@ void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
 void DoSumTableCol(vm::TableHandler* window, benchmark::State* state, MODE mode,
                    int64_t data_size, const std::string& col_name) {
     vm::SchemasContext schemas_context;
-    schemas_context.BuildTrivial(window->GetDatabase(), {window->GetSchema()});
+    schemas_context.BuildTrivial({window->GetSchema()});
     codegen::MemoryWindowDecodeIRBuilder builder(&schemas_context, nullptr);
 
     size_t schema_idx;
     size_t col_idx;
     ASSERT_TRUE(
         schemas_context
-            .ResolveColumnIndexByName("", col_name, &schema_idx, &col_idx)
+            .ResolveColumnIndexByName("", "", col_name, &schema_idx,
+                                      &col_idx)
             .isOK());
 
     const codec::ColInfo* info =
-        schemas_context.GetRowFormat(schema_idx)->GetColumnInfo(col_idx);
+        schemas_context.GetRowFormat()->GetColumnInfo(schema_idx,
+                                                     col_idx);
 
     node::TypeNode type;
     ASSERT_TRUE(codegen::SchemaType2DataType(info->type, &type));
@@ -417,6 +423,184 @@ void SumRequestUnionTableCol(benchmark::State* state, MODE mode,
     DoSumTableCol(request_union.get(), state, mode, data_size, col_name);
 }
 
+template <typename V>
+static V SumColumnBatch(const int8_t* col, udf::ColumnKernelIsa isa) {
+    codec::ColumnBatchIterator<V> iter(
+        reinterpret_cast<const codec::ColumnImpl<V>*>(col));
+    V sum = 0;
+    size_t cnt = 0;
+    while ((cnt = iter.Next()) > 0) {
+        sum += udf::SumColumn(iter.values(), iter.validity(), cnt, isa);
+    }
+    return sum;
+}
+
+// decode the rows of the window one by one, independent of the batch
+// iterator, the kernels and the sum udf which calls them
+template <typename V>
+static V SumColumnPerValue(const int8_t* col) {
+    auto* column = reinterpret_cast<const codec::ColumnImpl<V>*>(col);
+    auto iter = column->root()->GetIterator();
+    V sum = 0;
+    iter->SeekToFirst();
+    while (iter->Valid()) {
+        V value;
+        bool is_null = true;
+        column->GetField(iter->GetValue(), &value, &is_null);
+        if (!is_null) {
+            sum += value;
+        }
+        iter->Next();
+    }
+    return sum;
+}
+
+enum class SumColPath { kBatch, kPerValue };
+
+template <typename V>
+static void DoSumColBatch(benchmark::State* state, MODE mode, int8_t* col,
+                          SumColPath path, udf::ColumnKernelIsa isa) {
+    switch (mode) {
+        case BENCHMARK: {
+            if (path == SumColPath::kPerValue) {
+                for (auto _ : *state) {
+                    benchmark::DoNotOptimize(SumColumnPerValue<V>(col));
+                }
+                break;
+            }
+            for (auto _ : *state) {
+                benchmark::DoNotOptimize(SumColumnBatch<V>(col, isa));
+            }
+            break;
+        }
+        case TEST: {
+            V expect = SumColumnPerValue<V>(col);
+            if (std::is_floating_point<V>::value) {
+                // the lanes change the order of the additions
+                ASSERT_NEAR(expect, SumColumnBatch<V>(col, isa),
+                            std::abs(expect) * 1e-6);
+            } else {
+                ASSERT_EQ(expect, SumColumnBatch<V>(col, isa));
+            }
+            break;
+        }
+    }
+}
+
+// decode the column of the window like the codegen does, then sum it in batch
+static void DoSumTableColBatch(vm::ListV<Row>* window,
+                               const vm::SchemasContext& schemas_context,
+                               benchmark::State* state, MODE mode,
+                               const std::string& col_name, SumColPath path,
+                               udf::ColumnKernelIsa isa) {
+    size_t schema_idx;
+    size_t col_idx;
+    ASSERT_TRUE(
+        schemas_context
+            .ResolveColumnIndexByName("", "", col_name, &schema_idx,
+                                      &col_idx)
+            .isOK());
+    const codec::ColInfo* info =
+        schemas_context.GetRowFormat()->GetColumnInfo(schema_idx,
+                                                     col_idx);
+
+    node::TypeNode type;
+    ASSERT_TRUE(codegen::SchemaType2DataType(info->type, &type));
+    uint32_t col_size;
+    ASSERT_TRUE(codegen::GetLlvmColumnSize(&type, &col_size));
+    int8_t* buf = reinterpret_cast<int8_t*>(alloca(col_size));
+    codec::ListRef<> window_ref;
+    window_ref.list = reinterpret_cast<int8_t*>(window);
+    ASSERT_EQ(0, ::hybridse::codec::v1::GetCol(
+                     reinterpret_cast<int8_t*>(&window_ref), 0, info->idx,
+                     info->offset, info->type, buf));
+    switch (type.base_) {
+        case node::kInt16: {
+            DoSumColBatch<int16_t>(state, mode, buf, path, isa);
+            break;
+        }
+        case node::kInt32: {
+            DoSumColBatch<int32_t>(state, mode, buf, path, isa);
+            break;
+        }
+        case node::kInt64: {
+            DoSumColBatch<int64_t>(state, mode, buf, path, isa);
+            break;
+        }
+        case node::kFloat: {
+            DoSumColBatch<float>(state, mode, buf, path, isa);
+            break;
+        }
+        case node::kDouble: {
+            DoSumColBatch<double>(state, mode, buf, path, isa);
+            break;
+        }
+        default: {
+            FAIL();
+        }
+    }
+}
+
+static void SumMemTableCol(benchmark::State* state, MODE mode,
+                           int64_t data_size, const std::string& col_name,
+                           SumColPath path, udf::ColumnKernelIsa isa) {
+    type::TableDef table_def;
+    std::vector<Row> buffer;
+    CaseDataMock::BuildOnePkTableData(table_def, buffer, data_size);
+    vm::MemTableHandler window(&table_def.columns());
+    for (int i = 0; i < data_size - 1; ++i) {
+        window.AddRow(buffer[i]);
+    }
+    vm::SchemasContext schemas_context;
+    schemas_context.BuildTrivial({window.GetSchema()});
+    DoSumTableColBatch(&window, schemas_context, state, mode, col_name, path,
+                       isa);
+}
+
+static void SumArrayListCol(benchmark::State* state, MODE mode,
+                            int64_t data_size, const std::string& col_name,
+                            SumColPath path, udf::ColumnKernelIsa isa) {
+    vm::MemTimeTableHandler window;
+    type::TableDef table_def;
+    BuildData(table_def, window, data_size);
+
+    std::vector<Row> buffer;
+    auto from_iter = window.GetIterator();
+    while (from_iter->Valid()) {
+        buffer.push_back(from_iter->GetValue());
+        from_iter->Next();
+    }
+    codec::ArrayListV<Row> list_table(&buffer);
+    vm::SchemasContext schemas_context;
+    schemas_context.BuildTrivial(table_def.catalog(), {&table_def});
+    DoSumTableColBatch(&list_table, schemas_context, state, mode, col_name,
+                       path, isa);
+}
+
+void SumMemTableColBatch(benchmark::State* state, MODE mode, int64_t data_size,
+                         const std::string& col_name,
+                         udf::ColumnKernelIsa isa) {
+    SumMemTableCol(state, mode, data_size, col_name, SumColPath::kBatch, isa);
+}
+
+void SumArrayListColBatch(benchmark::State* state, MODE mode,
+                          int64_t data_size, const std::string& col_name,
+                          udf::ColumnKernelIsa isa) {
+    SumArrayListCol(state, mode, data_size, col_name, SumColPath::kBatch, isa);
+}
+
+void SumMemTableColPerValue(benchmark::State* state, MODE mode,
+                            int64_t data_size, const std::string& col_name) {
+    SumMemTableCol(state, mode, data_size, col_name, SumColPath::kPerValue,
+                   udf::ColumnKernelIsa::kScalar);
+}
+
+void SumArrayListColPerValue(benchmark::State* state, MODE mode,
+                             int64_t data_size, const std::string& col_name) {
+    SumArrayListCol(state, mode, data_size, col_name, SumColPath::kPerValue,
+                    udf::ColumnKernelIsa::kScalar);
+}
+
 bool CTimeDays(int data_size) {
     for (int i = 0; i < data_size; i++) {
         udf::v1::dayofmonth(1590115420000L + ((i)) * 86400000);
@@ -18,6 +18,7 @@
 #define HYBRIDSE_SRC_BENCHMARK_UDF_BM_CASE_H_
 #include <string>
 #include "benchmark/benchmark.h"
+#include "udf/column_kernels.h"
 #include "vm/mem_catalog.h"
 namespace hybridse {
 namespace bm {
@@ -28,6 +29,20 @@ void SumRequestUnionTableCol(benchmark::State* state, MODE mode,
                              int64_t data_size, const std::string& col_name);
 void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
                      const std::string& col_name);
+// sum the column with the batch column iterator and the column kernels
+// instead of the sum udf, the TEST mode checks it against a plain loop over
+// the rows of the window
+void SumMemTableColBatch(benchmark::State* state, MODE mode, int64_t data_size,
+                         const std::string& col_name, udf::ColumnKernelIsa isa);
+void SumArrayListColBatch(benchmark::State* state, MODE mode,
+                          int64_t data_size, const std::string& col_name,
+                          udf::ColumnKernelIsa isa);
+// sum the column value by value like the update loop of the sum udaf, the
+// baseline of the batch path
+void SumMemTableColPerValue(benchmark::State* state, MODE mode,
+                            int64_t data_size, const std::string& col_name);
+void SumArrayListColPerValue(benchmark::State* state, MODE mode,
+                             int64_t data_size, const std::string& col_name);
 void CopyMemTable(benchmark::State* state, MODE mode, int64_t data_size);
 void CopyMemSegment(benchmark::State* state, MODE mode, int64_t data_size);
 void CopyArrayList(benchmark::State* state, MODE mode, int64_t data_size);
@@ -38,6 +38,18 @@ TEST_F(UdfBMCaseTest, SumMemTableCol1_TEST) {
     SumMemTableCol(nullptr, TEST, 10000L, "col1");
 }
 
+TEST_F(UdfBMCaseTest, SumColBatch_TEST) {
+    for (auto isa :
+         {udf::ColumnKernelIsa::kScalar, udf::DetectColumnKernelIsa()}) {
+        for (auto col : {"col1", "col2", "col3", "col4", "col5"}) {
+            SumArrayListColBatch(nullptr, TEST, 10L, col, isa);
+            SumArrayListColBatch(nullptr, TEST, 1000L, col, isa);
+            SumMemTableColBatch(nullptr, TEST, 10L, col, isa);
+            SumMemTableColBatch(nullptr, TEST, 1000L, col, isa);
+        }
+    }
+}
+
 TEST_F(UdfBMCaseTest, SumRequestUnionTableCol1_TEST) {
     SumRequestUnionTableCol(nullptr, TEST, 10L, "col1");
     SumRequestUnionTableCol(nullptr, TEST, 100L, "col1");
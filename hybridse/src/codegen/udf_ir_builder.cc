@@ -27,6 +27,7 @@
 #include "llvm/IR/Attributes.h"
 #include "node/node_manager.h"
 #include "node/sql_node.h"
+#include "udf/column_kernels.h"
 #include "udf/udf.h"
 #include "udf/udf_registry.h"
 
@@ -536,6 +537,68 @@ Status UdfIRBuilder::BuildDynamicUdfCall(
 }
 
 Status UdfIRBuilder::BuildUdafCall(
+    const node::UdafDefNode* fn,
+    const std::vector<NativeValue>& args, NativeValue* output) {
+    std::vector<const node::TypeNode*> elem_types;
+    for (size_t i = 0; i < fn->GetArgSize(); ++i) {
+        elem_types.push_back(fn->GetElementType(i));
+    }
+    std::string column_fn_name;
+    if (!udf::GetColumnListUdafName(fn->GetName(), elem_types,
+                                    &column_fn_name)) {
+        return BuildUdafLoop(fn, args, output);
+    }
+
+    // the builtin udaf over window columns runs the batch kernels, the update
+    // loop runs only if the lists are not columns
+    ::llvm::Type* ret_ty = nullptr;
+    CHECK_TRUE(GetLlvmType(ctx_->GetModule(), fn->GetReturnType(), &ret_ty),
+               kCodegenError,
+               "Fail to get llvm type for " + fn->GetReturnType()->GetName());
+    ::llvm::IRBuilder<> builder(ctx_->GetCurrentBlock());
+    ::llvm::Value* ret_alloca =
+        CreateAllocaAtHead(&builder, ret_ty, "column_udaf_ret");
+    ::llvm::Value* is_null_alloca =
+        CreateAllocaAtHead(&builder, builder.getInt8Ty(), "column_udaf_null");
+    std::vector<::llvm::Value*> call_args;
+    std::vector<::llvm::Type*> call_arg_tys;
+    for (auto& arg : args) {
+        call_args.push_back(arg.GetValue(&builder));
+        call_arg_tys.push_back(call_args.back()->getType());
+    }
+    call_args.push_back(ret_alloca);
+    call_arg_tys.push_back(ret_alloca->getType());
+    call_args.push_back(is_null_alloca);
+    call_arg_tys.push_back(is_null_alloca->getType());
+    auto callee = ctx_->GetModule()->getOrInsertFunction(
+        column_fn_name, ::llvm::FunctionType::get(builder.getInt1Ty(),
+                                                  call_arg_tys, false));
+    ::llvm::Value* done = builder.CreateCall(callee, call_args);
+    CHECK_STATUS(ctx_->CreateBranchNot(done, [&]() {
+        NativeValue loop_output;
+        CHECK_STATUS(BuildUdafLoop(fn, args, &loop_output));
+        ::llvm::IRBuilder<> loop_builder(ctx_->GetCurrentBlock());
+        loop_builder.CreateStore(loop_output.GetValue(&loop_builder),
+                                 ret_alloca);
+        loop_builder.CreateStore(
+            loop_builder.CreateZExt(loop_output.GetIsNull(&loop_builder),
+                                    loop_builder.getInt8Ty()),
+            is_null_alloca);
+        return Status::OK();
+    }));
+    builder.SetInsertPoint(ctx_->GetCurrentBlock());
+    ::llvm::Value* ret = builder.CreateLoad(ret_alloca);
+    if (fn->IsReturnNullable()) {
+        ::llvm::Value* is_null = builder.CreateICmpNE(
+            builder.CreateLoad(is_null_alloca), builder.getInt8(0));
+        *output = NativeValue::CreateWithFlag(ret, is_null);
+    } else {
+        *output = NativeValue::Create(ret);
+    }
+    return Status::OK();
+}
+
+Status UdfIRBuilder::BuildUdafLoop(
     const node::UdafDefNode* fn,
     const std::vector<NativeValue>& args, NativeValue* output) {
     // udaf state type
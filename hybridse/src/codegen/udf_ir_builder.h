@@ -66,6 +66,11 @@ class UdfIRBuilder {
                          const std::vector<NativeValue>& args,
                          NativeValue* output);
 
+    // the update loop of the udaf over the lists
+    Status BuildUdafLoop(const node::UdafDefNode* fn,
+                         const std::vector<NativeValue>& args,
+                         NativeValue* output);
+
     Status GetUdfCallee(const node::UdfDefNode* fn,
                         ::llvm::FunctionCallee* callee, bool* return_by_arg);
 
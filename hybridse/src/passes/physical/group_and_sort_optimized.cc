@@ -172,13 +172,15 @@ bool GroupAndSortOptimized::Transform(PhysicalOpNode* in,
                     }
                 }
 
-                if (KeysAndOrderFilterOptimized(
-                        union_op->GetProducer(2)->schemas_ctx(), union_op->GetProducer(2),
-                        &union_op->agg_window_.partition_,
-                        &union_op->agg_window_.index_key_, &union_op->agg_window_.sort_,
-                        &new_producer)) {
-                    if (!ResetProducer(plan_ctx_, union_op, 2, new_producer)) {
-                        return false;
+                for (size_t i = 0; i < union_op->agg_windows_.size(); i++) {
+                    auto& agg_window = union_op->agg_windows_[i];
+                    if (KeysAndOrderFilterOptimized(
+                            union_op->GetProducer(i + 2)->schemas_ctx(), union_op->GetProducer(i + 2),
+                            &agg_window.partition_, &agg_window.index_key_, &agg_window.sort_,
+                            &new_producer)) {
+                        if (!ResetProducer(plan_ctx_, union_op, i + 2, new_producer)) {
+                            return false;
+                        }
                     }
                 }
             }
@@ -17,9 +17,14 @@
 
 #include <absl/strings/str_cat.h>
 
+#include <algorithm>
+#include <cctype>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "boost/algorithm/string.hpp"
 #include "vm/engine.h"
 #include "vm/physical_op.h"
 
@@ -34,6 +39,10 @@ LongWindowOptimized::LongWindowOptimized(PhysicalPlanContext* plan_ctx) : Transf
         return;
     }
 
+    window_aggr_cache_ = options->count(vm::WINDOW_AGGR_CACHE) > 0;
+    if (!options->count(vm::LONG_WINDOWS)) {
+        return;
+    }
     boost::split(windows, options->at(vm::LONG_WINDOWS), boost::is_any_of(","));
     for (auto& w : windows) {
         std::vector<std::string> window_info;
@@ -62,8 +71,9 @@ bool LongWindowOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** output)
         return false;
     }
 
-    // this case shouldn't happen as we add the LongWindowOptimized pass only when `long_windows` option exists
-    if (long_windows_.empty()) {
+    // this case shouldn't happen as we add the LongWindowOptimized pass only when `long_windows` or
+    // `window_aggr_cache` option exists
+    if (long_windows_.empty() && !window_aggr_cache_) {
         LOG(ERROR) << "Long Windows is empty";
         return false;
     }
@@ -79,16 +89,34 @@ bool LongWindowOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** output)
             // skip ANONYMOUS_WINDOW
             if (!window->GetName().empty()) {
                 if (long_windows_.count(window->GetName())) {
-                    return OptimizeWithPreAggr(project_aggr_op, i, output);
+                    return OptimizeWithPreAggr(project_aggr_op, i, false, output);
                 }
             }
+            if (window_aggr_cache_ && SupportWindowAggrCache(call_expr, projects.GetFrame(i))) {
+                return OptimizeWithPreAggr(project_aggr_op, i, true, output);
+            }
         }
     }
 
     return true;
 }
 
-bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, PhysicalOpNode** output) {
+bool LongWindowOptimized::SupportWindowAggrCache(const node::CallExprNode* call, const node::FrameNode* frame) {
+    static const std::set<std::string> cached_funcs = {"sum", "min", "max", "count", "avg"};
+    if (call->GetFnDef() == nullptr || cached_funcs.count(call->GetFnDef()->GetName()) == 0 ||
+        call->GetChildNum() != 1) {
+        return false;
+    }
+    auto expr_type = call->GetChild(0)->GetExprType();
+    if (expr_type != node::kExprColumnRef && expr_type != node::kExprAll) {
+        return false;
+    }
+    return frame != nullptr && frame->frame_type() == node::kFrameRowsRange && frame->frame_maxsize() <= 0 &&
+           frame->GetHistoryRangeEnd() == 0;
+}
+
+bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, bool window_aggr_cache,
+                                              PhysicalOpNode** output) {
     *output = in;
 
     if (in->producers()[0]->GetOpType() != vm::kPhysicalOpRequestUnion) {
@@ -103,6 +131,15 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
     auto orig_data_provider = dynamic_cast<vm::PhysicalDataProviderNode*>(req_union_op->GetProducer(1));
     auto aggr_op = dynamic_cast<const node::CallExprNode*>(projects.GetExpr(idx));
     auto window = aggr_op->GetOver();
+    if (window_aggr_cache) {
+        // the windows merged into the request union keep their own frames, only the frame of the union is cached
+        const auto* union_frame = req_union_op->window().range().frame();
+        const auto* frame = projects.GetFrame(idx);
+        if (!SupportWindowAggrCache(aggr_op, union_frame) ||
+            (frame != nullptr && !node::SqlEquals(frame, union_frame))) {
+            return false;
+        }
+    }
 
     auto expr_type = aggr_op->GetChild(0)->GetExprType();
     if (aggr_op->GetChildNum() != 1 || (expr_type != node::kExprColumnRef && expr_type != node::kExprAll)) {
@@ -114,6 +151,22 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
     const std::string& table_name = orig_data_provider->GetName();
     std::string func_name = aggr_op->GetFnDef()->GetName();
     std::string aggr_col = ConcatExprList(aggr_op->children_);
+    if (window_aggr_cache && expr_type == node::kExprColumnRef && func_name != "count") {
+        // sum and avg over the numbers, min and max over the types the aggregators of the runner keep too
+        type::Type col_type = type::kNull;
+        for (const auto& column : *orig_data_provider->GetOutputSchema()) {
+            if (column.name() == aggr_col) {
+                col_type = column.type();
+                break;
+            }
+        }
+        bool is_number = col_type == type::kInt16 || col_type == type::kInt32 || col_type == type::kInt64 ||
+                         col_type == type::kFloat || col_type == type::kDouble || col_type == type::kTimestamp;
+        bool is_ordered = col_type == type::kDate || col_type == type::kVarchar;
+        if (!is_number && !(is_ordered && (func_name == "min" || func_name == "max"))) {
+            return false;
+        }
+    }
     std::string partition_col;
     if (window->GetPartitions()) {
         partition_col = ConcatExprList(window->GetPartitions()->children_);
@@ -145,70 +198,82 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
         }
     }
 
-    auto table_infos = catalog_->GetAggrTables(db_name, table_name, func_name, aggr_col, partition_col, order_col);
-    if (table_infos.empty()) {
+    // a window answered by the window aggregate cache unions the raw table only, its requests missing the cache
+    // aggregate the raw rows of the window
+    std::vector<vm::AggrTableInfo> table_infos;
+    if (!window_aggr_cache) {
+        table_infos = catalog_->GetAggrTables(db_name, table_name, func_name, aggr_col, partition_col, order_col);
+    }
+    if (table_infos.empty() && !window_aggr_cache) {
         LOG(WARNING) << absl::StrCat("No Pre-aggregation tables exists for ", db_name, ".", table_name, ": ", func_name,
                                      "(", aggr_col, ")", " partition by ", partition_col, " order by ", order_col);
         return false;
     }
 
-    // TODO(zhanghao): optimize the selection of the best pre-aggregation tables
-    auto table = catalog_->GetTable(table_infos[0].aggr_db, table_infos[0].aggr_table);
-    if (!table) {
-        LOG(ERROR) << "Fail to get table handler for pre-aggregation table " << table_infos[0].aggr_db << "."
-                   << table_infos[0].aggr_table;
-        return false;
-    }
-
-    vm::PhysicalTableProviderNode* aggr = nullptr;
-    auto status = plan_ctx_->CreateOp<vm::PhysicalTableProviderNode>(&aggr, table);
-    if (!status.isOK()) {
-        LOG(ERROR) << "Fail to create PhysicalTableProviderNode for pre-aggregation table " << table_infos[0].aggr_db
-                   << "." << table_infos[0].aggr_table << ": " << status;
-        return false;
-    }
-
-    if (table->GetIndex().size() != 1) {
-        LOG(ERROR) << "PreAggregation table index size != 1";
-        return false;
-    }
-    auto index = table->GetIndex().cbegin()->second;
+    table_infos = SelectAggrTables(table_infos, req_union_op->window().range().frame());
     auto nm = plan_ctx_->node_manager();
-
     auto request = req_union_op->GetProducer(0);
     auto raw = req_union_op->GetProducer(1);
-
-    // generate an aggregation window for the aggr table
     auto req_window = req_union_op->window();
-    auto partitions = nm->MakeExprList();
-    for (size_t i = 0; i < index.keys.size(); i++) {
-        auto col_ref = nm->MakeColumnRefNode(index.keys[i].name, table->GetName(), table->GetDatabase());
-        partitions->AddChild(col_ref);
-    }
-    vm::RequestWindowOp aggr_window(partitions);
 
-    auto order_col_ref =
-        nm->MakeColumnRefNode((*table->GetSchema())[index.ts_pos].name(), table->GetName(), table->GetDatabase());
-    auto order_expr = nm->MakeOrderExpression(order_col_ref, true);
-    auto orders = nm->MakeExprList();
-    orders->AddChild(order_expr);
+    std::vector<vm::PhysicalOpNode*> aggrs;
+    std::vector<vm::RequestWindowOp> aggr_windows;
+    for (const auto& table_info : table_infos) {
+        auto table = catalog_->GetTable(table_info.aggr_db, table_info.aggr_table);
+        if (!table) {
+            LOG(ERROR) << "Fail to get table handler for pre-aggregation table " << table_info.aggr_db << "."
+                       << table_info.aggr_table;
+            return false;
+        }
 
-    auto partition_by = nm->MakeExprList();
-    for (size_t i = 0; i < index.keys.size(); i++) {
-        auto col_ref = nm->MakeColumnRefNode((*table->GetSchema())[index.keys[i].idx].name(), table->GetName(),
-                                             table->GetDatabase());
-        partition_by->AddChild(col_ref);
-    }
+        vm::PhysicalTableProviderNode* aggr = nullptr;
+        auto status = plan_ctx_->CreateOp<vm::PhysicalTableProviderNode>(&aggr, table);
+        if (!status.isOK()) {
+            LOG(ERROR) << "Fail to create PhysicalTableProviderNode for pre-aggregation table " << table_info.aggr_db
+                       << "." << table_info.aggr_table << ": " << status;
+            return false;
+        }
+
+        if (table->GetIndex().size() != 1) {
+            LOG(ERROR) << "PreAggregation table index size != 1";
+            return false;
+        }
+        auto index = table->GetIndex().cbegin()->second;
+
+        // generate an aggregation window for the aggr table
+        auto partitions = nm->MakeExprList();
+        for (size_t i = 0; i < index.keys.size(); i++) {
+            auto col_ref = nm->MakeColumnRefNode(index.keys[i].name, table->GetName(), table->GetDatabase());
+            partitions->AddChild(col_ref);
+        }
+        vm::RequestWindowOp aggr_window(partitions);
+
+        auto order_col_ref =
+            nm->MakeColumnRefNode((*table->GetSchema())[index.ts_pos].name(), table->GetName(), table->GetDatabase());
+        auto order_expr = nm->MakeOrderExpression(order_col_ref, true);
+        auto orders = nm->MakeExprList();
+        orders->AddChild(order_expr);
+
+        auto partition_by = nm->MakeExprList();
+        for (size_t i = 0; i < index.keys.size(); i++) {
+            auto col_ref = nm->MakeColumnRefNode((*table->GetSchema())[index.keys[i].idx].name(), table->GetName(),
+                                                 table->GetDatabase());
+            partition_by->AddChild(col_ref);
+        }
 
-    aggr_window.sort_.orders_ = nm->MakeOrderByNode(orders);
-    aggr_window.name_ = req_window.name();
-    aggr_window.range_ = req_window.range_;
-    aggr_window.range_.range_key_ = order_col_ref;
-    aggr_window.partition_.keys_ = partition_by;
+        aggr_window.sort_.orders_ = nm->MakeOrderByNode(orders);
+        aggr_window.name_ = req_window.name();
+        aggr_window.range_ = req_window.range_;
+        aggr_window.range_.range_key_ = order_col_ref;
+        aggr_window.partition_.keys_ = partition_by;
+
+        aggrs.push_back(aggr);
+        aggr_windows.push_back(aggr_window);
+    }
 
     vm::PhysicalRequestAggUnionNode* request_aggr_union = nullptr;
-    status = plan_ctx_->CreateOp<vm::PhysicalRequestAggUnionNode>(
-        &request_aggr_union, request, raw, aggr, req_union_op->window(), aggr_window,
+    auto status = plan_ctx_->CreateOp<vm::PhysicalRequestAggUnionNode>(
+        &request_aggr_union, request, raw, aggrs, req_union_op->window(), aggr_windows,
         req_union_op->instance_not_in_window(), req_union_op->exclude_current_time(),
         req_union_op->output_request_row(), aggr_op->GetFnDef(),
         aggr_op->GetChild(0));
@@ -246,6 +311,92 @@ bool LongWindowOptimized::OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, i
     return true;
 }
 
+// the bucket size is a number of rows like 1000, or an interval like 1d which is parsed into milliseconds
+static bool ParseBucketSize(const std::string& bucket_size, bool* is_rows, int64_t* size) {
+    std::string str = boost::trim_copy(bucket_size);
+    if (str.empty()) {
+        return false;
+    }
+    int64_t unit = 1;
+    *is_rows = std::isdigit(static_cast<unsigned char>(str.back()));
+    if (!*is_rows) {
+        switch (std::tolower(static_cast<unsigned char>(str.back()))) {
+            case 's':
+                unit = 1000;
+                break;
+            case 'm':
+                unit = 1000 * 60;
+                break;
+            case 'h':
+                unit = 1000 * 60 * 60;
+                break;
+            case 'd':
+                unit = 1000 * 60 * 60 * 24;
+                break;
+            default:
+                return false;
+        }
+        str = boost::trim_copy(str.substr(0, str.size() - 1));
+    }
+    if (str.empty() || !std::all_of(str.begin(), str.end(), [](char c) { return std::isdigit(c); })) {
+        return false;
+    }
+    *size = std::stoll(str) * unit;
+    return *size > 0;
+}
+
+std::vector<vm::AggrTableInfo> LongWindowOptimized::SelectAggrTables(const std::vector<vm::AggrTableInfo>& infos,
+                                                                     const node::FrameNode* frame) {
+    if (infos.size() <= 1) {
+        return infos;
+    }
+    // the window length in the unit of the matched bucket size, rows or milliseconds
+    bool rows_window = frame != nullptr && frame->frame_type() == node::kFrameRows;
+    int64_t window_length = INT64_MAX;
+    if (frame != nullptr) {
+        int64_t history_start = rows_window ? frame->GetHistoryRowsStart() : frame->GetHistoryRangeStart();
+        if (history_start != INT64_MIN) {
+            window_length = -history_start + 1;
+        }
+    }
+
+    // prefer the buckets of the same kind as the window, e.g. 1h buckets for a rows_range window
+    std::vector<std::pair<int64_t, vm::AggrTableInfo>> matched;
+    std::vector<std::pair<int64_t, vm::AggrTableInfo>> unmatched;
+    for (const auto& info : infos) {
+        bool is_rows = false;
+        int64_t size = 0;
+        if (!ParseBucketSize(info.bucket_size, &is_rows, &size)) {
+            LOG(WARNING) << "Invalid bucket size " << info.bucket_size << " of pre-aggregation table "
+                         << info.aggr_db << "." << info.aggr_table;
+            continue;
+        }
+        (is_rows == rows_window ? matched : unmatched).emplace_back(size, info);
+    }
+    auto& levels = matched.empty() ? unmatched : matched;
+    if (levels.empty()) {
+        return {infos[0]};
+    }
+    std::stable_sort(levels.begin(), levels.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    // the coarsest level whose bucket fits into the window answers the middle of the window,
+    // the finer levels answer the edges only
+    std::vector<vm::AggrTableInfo> selected;
+    int64_t last_size = 0;
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (&levels == &matched && levels[i].first > window_length && i + 1 < levels.size()) {
+            continue;
+        }
+        if (!selected.empty() && levels[i].first == last_size) {
+            continue;
+        }
+        selected.push_back(levels[i].second);
+        last_size = levels[i].first;
+    }
+    return selected;
+}
+
 bool LongWindowOptimized::VerifySingleAggregation(vm::PhysicalProjectNode* op) { return op->project().size() == 1; }
 
 std::string LongWindowOptimized::ConcatExprList(std::vector<node::ExprNode*> exprs, const std::string& delimiter) {
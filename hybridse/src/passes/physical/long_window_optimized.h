@@ -29,13 +29,24 @@ class LongWindowOptimized : public TransformUpPysicalPass {
     explicit LongWindowOptimized(PhysicalPlanContext* plan_ctx);
     ~LongWindowOptimized() {}
 
+    // whether the window aggregate cache of the tablets answers `call` over `frame`: an aggregate kept
+    // incrementally over a rows_range window that ends at the current row
+    static bool SupportWindowAggrCache(const node::CallExprNode* call, const node::FrameNode* frame);
+
  private:
     bool Transform(PhysicalOpNode* in, PhysicalOpNode** output) override;
     bool VerifySingleAggregation(vm::PhysicalProjectNode* op);
-    bool OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, PhysicalOpNode** output);
+    // `window_aggr_cache` to union the raw table only as the window is answered by the window aggregate cache
+    bool OptimizeWithPreAggr(vm::PhysicalAggregationNode* in, int idx, bool window_aggr_cache,
+                             PhysicalOpNode** output);
+    // the pre-aggregation tables of the window, from the coarsest bucket size to the finest one
+    static std::vector<vm::AggrTableInfo> SelectAggrTables(const std::vector<vm::AggrTableInfo>& infos,
+                                                           const node::FrameNode* frame);
     static std::string ConcatExprList(std::vector<node::ExprNode*> exprs, const std::string& delimiter = ",");
 
     std::set<std::string> long_windows_;
+    // the other windows are answered by the window aggregate cache of the tablets when supported
+    bool window_aggr_cache_ = false;
 };
 }  // namespace passes
 }  // namespace hybridse
@@ -17,6 +17,7 @@
 
 #include <vector>
 
+#include "passes/physical/long_window_optimized.h"
 #include "vm/engine.h"
 #include "vm/physical_op.h"
 
@@ -31,6 +32,10 @@ SplitAggregationOptimized::SplitAggregationOptimized(PhysicalPlanContext* plan_c
         return;
     }
 
+    window_aggr_cache_ = options->count(vm::WINDOW_AGGR_CACHE) > 0;
+    if (!options->count(vm::LONG_WINDOWS)) {
+        return;
+    }
     boost::split(windows, options->at(vm::LONG_WINDOWS), boost::is_any_of(","));
     for (auto& w : windows) {
         std::vector<std::string> window_info;
@@ -46,7 +51,7 @@ bool SplitAggregationOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** o
         return false;
     }
 
-    if (long_windows_.empty()) {
+    if (long_windows_.empty() && !window_aggr_cache_) {
         LOG(ERROR) << "Long Windows is empty";
         return false;
     }
@@ -71,6 +76,10 @@ bool SplitAggregationOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** o
                     return SplitProjects(project_aggr_op, output);
                 }
             }
+            if (window_aggr_cache_ &&
+                LongWindowOptimized::SupportWindowAggrCache(call_expr, projects.GetFrame(i))) {
+                return SplitProjects(project_aggr_op, output);
+            }
         }
     }
     return false;
@@ -35,6 +35,7 @@ class SplitAggregationOptimized : public TransformUpPysicalPass {
     bool IsSplitable(vm::PhysicalAggregationNode* op);
 
     std::set<std::string> long_windows_;
+    bool window_aggr_cache_ = false;
 };
 }  // namespace passes
 }  // namespace hybridse
@@ -0,0 +1,654 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/column_kernels.h"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <typeinfo>
+
+#include "codec/list_iterator_codec.h"
+#include "udf/udf_library.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HYBRIDSE_COLUMN_KERNEL_AVX2
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace hybridse {
+namespace udf {
+
+static inline bool IsValidAt(const uint64_t* validity, size_t i) {
+    return (validity[i >> 6] >> (i & 63)) & 1;
+}
+
+// integer sums wrap around instead of the undefined signed overflow
+template <class V>
+static inline V AddValue(V acc, V val) {
+    if constexpr (std::is_integral<V>::value) {
+        using U = std::make_unsigned_t<V>;
+        return static_cast<V>(static_cast<U>(acc) + static_cast<U>(val));
+    } else {
+        return acc + val;
+    }
+}
+
+template <class V>
+static inline V MaxIdentity() {
+    if constexpr (std::is_floating_point<V>::value) {
+        return std::numeric_limits<V>::infinity();
+    } else {
+        return std::numeric_limits<V>::max();
+    }
+}
+
+template <class V>
+static inline V MinIdentity() {
+    if constexpr (std::is_floating_point<V>::value) {
+        return -std::numeric_limits<V>::infinity();
+    } else {
+        return std::numeric_limits<V>::lowest();
+    }
+}
+
+enum class FoldOp { kSum, kMin, kMax };
+
+// the comparisons are false for nan, so nan is skipped by min and max
+template <FoldOp op, class V>
+static inline V ScalarApply(V val, V acc) {
+    if constexpr (op == FoldOp::kSum) {
+        return AddValue(acc, val);
+    } else if constexpr (op == FoldOp::kMin) {
+        return val < acc ? val : acc;
+    } else {
+        return val > acc ? val : acc;
+    }
+}
+
+template <FoldOp op, class V>
+static V ScalarFold(const V* values, const uint64_t* validity, size_t begin,
+                    size_t n, V acc) {
+    for (size_t i = begin; i < n; i++) {
+        if (IsValidAt(validity, i)) {
+            acc = ScalarApply<op>(values[i], acc);
+        }
+    }
+    return acc;
+}
+
+#ifdef HYBRIDSE_COLUMN_KERNEL_AVX2
+template <class V>
+struct Avx2Trait;
+
+template <>
+struct Avx2Trait<int16_t> {
+    using Vec = __m256i;
+    static constexpr size_t kLanes = 16;
+    AVX2_TARGET static Vec Load(const int16_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    AVX2_TARGET static void Store(int16_t* p, Vec v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    AVX2_TARGET static Vec Set1(int16_t v) { return _mm256_set1_epi16(v); }
+    AVX2_TARGET static Vec Mask(uint64_t bits) {
+        const __m256i lanes = _mm256_setr_epi16(
+            0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080,
+            0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000,
+            static_cast<int16_t>(0x8000));
+        __m256i set = _mm256_set1_epi16(static_cast<int16_t>(bits));
+        return _mm256_cmpeq_epi16(_mm256_and_si256(set, lanes), lanes);
+    }
+    AVX2_TARGET static Vec Select(Vec mask, Vec a, Vec b) {
+        return _mm256_blendv_epi8(b, a, mask);
+    }
+    AVX2_TARGET static Vec Add(Vec a, Vec b) { return _mm256_add_epi16(a, b); }
+    AVX2_TARGET static Vec Min(Vec a, Vec b) { return _mm256_min_epi16(a, b); }
+    AVX2_TARGET static Vec Max(Vec a, Vec b) { return _mm256_max_epi16(a, b); }
+};
+
+template <>
+struct Avx2Trait<int32_t> {
+    using Vec = __m256i;
+    static constexpr size_t kLanes = 8;
+    AVX2_TARGET static Vec Load(const int32_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    AVX2_TARGET static void Store(int32_t* p, Vec v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    AVX2_TARGET static Vec Set1(int32_t v) { return _mm256_set1_epi32(v); }
+    AVX2_TARGET static Vec Mask(uint64_t bits) {
+        const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        __m256i set = _mm256_set1_epi32(static_cast<int32_t>(bits));
+        return _mm256_cmpeq_epi32(_mm256_and_si256(set, lanes), lanes);
+    }
+    AVX2_TARGET static Vec Select(Vec mask, Vec a, Vec b) {
+        return _mm256_blendv_epi8(b, a, mask);
+    }
+    AVX2_TARGET static Vec Add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+    AVX2_TARGET static Vec Min(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+    AVX2_TARGET static Vec Max(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+};
+
+template <>
+struct Avx2Trait<int64_t> {
+    using Vec = __m256i;
+    static constexpr size_t kLanes = 4;
+    AVX2_TARGET static Vec Load(const int64_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    AVX2_TARGET static void Store(int64_t* p, Vec v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    }
+    AVX2_TARGET static Vec Set1(int64_t v) { return _mm256_set1_epi64x(v); }
+    AVX2_TARGET static Vec Mask(uint64_t bits) {
+        const __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+        __m256i set = _mm256_set1_epi64x(static_cast<int64_t>(bits));
+        return _mm256_cmpeq_epi64(_mm256_and_si256(set, lanes), lanes);
+    }
+    AVX2_TARGET static Vec Select(Vec mask, Vec a, Vec b) {
+        return _mm256_blendv_epi8(b, a, mask);
+    }
+    AVX2_TARGET static Vec Add(Vec a, Vec b) { return _mm256_add_epi64(a, b); }
+    // there is no 64 bits min and max before AVX-512
+    AVX2_TARGET static Vec Min(Vec a, Vec b) {
+        return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    }
+    AVX2_TARGET static Vec Max(Vec a, Vec b) {
+        return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+    }
+};
+
+template <>
+struct Avx2Trait<float> {
+    using Vec = __m256;
+    static constexpr size_t kLanes = 8;
+    AVX2_TARGET static Vec Load(const float* p) { return _mm256_loadu_ps(p); }
+    AVX2_TARGET static void Store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+    AVX2_TARGET static Vec Set1(float v) { return _mm256_set1_ps(v); }
+    AVX2_TARGET static Vec Mask(uint64_t bits) {
+        return _mm256_castsi256_ps(Avx2Trait<int32_t>::Mask(bits));
+    }
+    AVX2_TARGET static Vec Select(Vec mask, Vec a, Vec b) {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+    AVX2_TARGET static Vec Add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    // the second operand is returned if any is nan, which keeps the acc
+    AVX2_TARGET static Vec Min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+    AVX2_TARGET static Vec Max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+};
+
+template <>
+struct Avx2Trait<double> {
+    using Vec = __m256d;
+    static constexpr size_t kLanes = 4;
+    AVX2_TARGET static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+    AVX2_TARGET static void Store(double* p, Vec v) { _mm256_storeu_pd(p, v); }
+    AVX2_TARGET static Vec Set1(double v) { return _mm256_set1_pd(v); }
+    AVX2_TARGET static Vec Mask(uint64_t bits) {
+        return _mm256_castsi256_pd(Avx2Trait<int64_t>::Mask(bits));
+    }
+    AVX2_TARGET static Vec Select(Vec mask, Vec a, Vec b) {
+        return _mm256_blendv_pd(b, a, mask);
+    }
+    AVX2_TARGET static Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+    AVX2_TARGET static Vec Min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+    AVX2_TARGET static Vec Max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+};
+
+template <FoldOp op, class T>
+AVX2_TARGET static inline typename T::Vec Avx2Apply(typename T::Vec val,
+                                                    typename T::Vec acc) {
+    if constexpr (op == FoldOp::kSum) {
+        return T::Add(acc, val);
+    } else if constexpr (op == FoldOp::kMin) {
+        return T::Min(val, acc);
+    } else {
+        return T::Max(val, acc);
+    }
+}
+
+// the lanes never cross a validity word since the lane count divides 64
+template <FoldOp op, class V>
+AVX2_TARGET static V Avx2Fold(const V* values, const uint64_t* validity,
+                              size_t n, V identity) {
+    using T = Avx2Trait<V>;
+    constexpr uint64_t lane_mask = (1ULL << T::kLanes) - 1;
+    const typename T::Vec identity_vec = T::Set1(identity);
+    typename T::Vec acc = identity_vec;
+    size_t i = 0;
+    for (; i + T::kLanes <= n; i += T::kLanes) {
+        uint64_t bits = (validity[i >> 6] >> (i & 63)) & lane_mask;
+        if (bits == 0) {
+            continue;
+        }
+        typename T::Vec val = T::Load(values + i);
+        if (bits != lane_mask) {
+            val = T::Select(T::Mask(bits), val, identity_vec);
+        }
+        acc = Avx2Apply<op, T>(val, acc);
+    }
+    alignas(32) V lanes[T::kLanes];
+    T::Store(lanes, acc);
+    V result = identity;
+    for (size_t lane = 0; lane < T::kLanes; lane++) {
+        result = ScalarApply<op>(lanes[lane], result);
+    }
+    return ScalarFold<op>(values, validity, i, n, result);
+}
+
+// load 4 values converted to double
+AVX2_TARGET static inline __m256d LoadAsDouble(const int16_t* p) {
+    __m128i val = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(val));
+}
+AVX2_TARGET static inline __m256d LoadAsDouble(const int32_t* p) {
+    return _mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+AVX2_TARGET static inline __m256d LoadAsDouble(const float* p) {
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+AVX2_TARGET static inline __m256d LoadAsDouble(const double* p) {
+    return _mm256_loadu_pd(p);
+}
+
+template <class V>
+AVX2_TARGET static double Avx2SumAsDouble(const V* values,
+                                          const uint64_t* validity, size_t n) {
+    using T = Avx2Trait<double>;
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + T::kLanes <= n; i += T::kLanes) {
+        uint64_t bits = (validity[i >> 6] >> (i & 63)) & 0x0F;
+        if (bits == 0) {
+            continue;
+        }
+        __m256d val = LoadAsDouble(values + i);
+        if (bits != 0x0F) {
+            val = T::Select(T::Mask(bits), val, _mm256_setzero_pd());
+        }
+        acc = _mm256_add_pd(acc, val);
+    }
+    alignas(32) double lanes[T::kLanes];
+    T::Store(lanes, acc);
+    double result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++) {
+        if (IsValidAt(validity, i)) {
+            result += static_cast<double>(values[i]);
+        }
+    }
+    return result;
+}
+#endif
+
+ColumnKernelIsa DetectColumnKernelIsa() {
+#ifdef HYBRIDSE_COLUMN_KERNEL_AVX2
+    static const ColumnKernelIsa isa = __builtin_cpu_supports("avx2")
+                                           ? ColumnKernelIsa::kAVX2
+                                           : ColumnKernelIsa::kScalar;
+    return isa;
+#else
+    return ColumnKernelIsa::kScalar;
+#endif
+}
+
+template <FoldOp op, class V>
+static V FoldColumn(const V* values, const uint64_t* validity, size_t n,
+                    V identity, ColumnKernelIsa isa) {
+#ifdef HYBRIDSE_COLUMN_KERNEL_AVX2
+    if (isa == ColumnKernelIsa::kAVX2) {
+        return Avx2Fold<op>(values, validity, n, identity);
+    }
+#endif
+    return ScalarFold<op>(values, validity, 0, n, identity);
+}
+
+template <class V>
+V SumColumn(const V* values, const uint64_t* validity, size_t n,
+            ColumnKernelIsa isa) {
+    return FoldColumn<FoldOp::kSum>(values, validity, n, V(0), isa);
+}
+
+template <class V>
+double SumColumnAsDouble(const V* values, const uint64_t* validity, size_t n,
+                         ColumnKernelIsa isa) {
+#ifdef HYBRIDSE_COLUMN_KERNEL_AVX2
+    // int64 can not be converted to double lanes before AVX-512
+    if constexpr (!std::is_same<V, int64_t>::value) {
+        if (isa == ColumnKernelIsa::kAVX2) {
+            return Avx2SumAsDouble(values, validity, n);
+        }
+    }
+#endif
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (IsValidAt(validity, i)) {
+            sum += static_cast<double>(values[i]);
+        }
+    }
+    return sum;
+}
+
+template <class V>
+bool MinColumn(const V* values, const uint64_t* validity, size_t n, V* result,
+               ColumnKernelIsa isa) {
+    if (CountColumn(validity, n) == 0) {
+        return false;
+    }
+    *result = FoldColumn<FoldOp::kMin>(values, validity, n, MaxIdentity<V>(),
+                                       isa);
+    return true;
+}
+
+template <class V>
+bool MaxColumn(const V* values, const uint64_t* validity, size_t n, V* result,
+               ColumnKernelIsa isa) {
+    if (CountColumn(validity, n) == 0) {
+        return false;
+    }
+    *result = FoldColumn<FoldOp::kMax>(values, validity, n, MinIdentity<V>(),
+                                       isa);
+    return true;
+}
+
+int64_t CountColumn(const uint64_t* validity, size_t n) {
+    int64_t cnt = 0;
+    size_t words = n >> 6;
+    for (size_t i = 0; i < words; i++) {
+        cnt += __builtin_popcountll(validity[i]);
+    }
+    if (n & 63) {
+        cnt += __builtin_popcountll(validity[words] &
+                                    ((1ULL << (n & 63)) - 1));
+    }
+    return cnt;
+}
+
+int64_t CountColumnWhere(const uint64_t* validity, const uint64_t* cond,
+                         size_t n) {
+    int64_t cnt = 0;
+    size_t words = n >> 6;
+    for (size_t i = 0; i < words; i++) {
+        cnt += __builtin_popcountll(validity[i] & cond[i]);
+    }
+    if (n & 63) {
+        cnt += __builtin_popcountll(validity[words] & cond[words] &
+                                    ((1ULL << (n & 63)) - 1));
+    }
+    return cnt;
+}
+
+#define INSTANTIATE_COLUMN_KERNELS(V)                                         \
+    template V SumColumn<V>(const V*, const uint64_t*, size_t,                \
+                            ColumnKernelIsa);                                 \
+    template double SumColumnAsDouble<V>(const V*, const uint64_t*, size_t,   \
+                                         ColumnKernelIsa);                    \
+    template bool MinColumn<V>(const V*, const uint64_t*, size_t, V*,         \
+                               ColumnKernelIsa);                              \
+    template bool MaxColumn<V>(const V*, const uint64_t*, size_t, V*,         \
+                               ColumnKernelIsa);
+
+INSTANTIATE_COLUMN_KERNELS(int16_t)
+INSTANTIATE_COLUMN_KERNELS(int32_t)
+INSTANTIATE_COLUMN_KERNELS(int64_t)
+INSTANTIATE_COLUMN_KERNELS(float)
+INSTANTIATE_COLUMN_KERNELS(double)
+
+#undef INSTANTIATE_COLUMN_KERNELS
+
+template <class V>
+static const codec::ColumnImpl<V>* GetColumn(codec::ListRef<V>* list) {
+    auto* list_v = reinterpret_cast<codec::ListV<V>*>(list->list);
+    // a derived column decodes the values its own way
+    if (list_v == nullptr || typeid(*list_v) != typeid(codec::ColumnImpl<V>)) {
+        return nullptr;
+    }
+    return static_cast<const codec::ColumnImpl<V>*>(list_v);
+}
+
+// the floating point sums and the nan handling of min and max depend on the
+// order of the values, so the floating point columns and the double sum of
+// int64 run the update rule of the udaf over the values in the list order
+template <class V>
+static constexpr bool kSequentialOnly = std::is_floating_point<V>::value;
+
+template <class V>
+bool SumColumnList(codec::ListRef<V>* list, V* result, bool* is_null) {
+    auto* column = GetColumn(list);
+    if (column == nullptr) {
+        return false;
+    }
+    codec::ColumnBatchIterator<V> iter(column);
+    V sum = 0;
+    int64_t cnt = 0;
+    size_t n = 0;
+    while ((n = iter.Next()) > 0) {
+        if constexpr (kSequentialOnly<V>) {
+            for (size_t i = 0; i < n; i++) {
+                if (IsValidAt(iter.validity(), i)) {
+                    sum = sum + iter.values()[i];
+                }
+            }
+        } else {
+            sum = AddValue(sum, SumColumn(iter.values(), iter.validity(), n));
+        }
+        cnt += CountColumn(iter.validity(), n);
+    }
+    *result = sum;
+    *is_null = cnt == 0;
+    return true;
+}
+
+template <class V>
+bool AvgColumnList(codec::ListRef<V>* list, double* result, bool* is_null) {
+    auto* column = GetColumn(list);
+    if (column == nullptr) {
+        return false;
+    }
+    codec::ColumnBatchIterator<V> iter(column);
+    double sum = 0;
+    int64_t cnt = 0;
+    size_t n = 0;
+    while ((n = iter.Next()) > 0) {
+        // the double sums of int16 and int32 are exact in any order
+        if constexpr (kSequentialOnly<V> || std::is_same<V, int64_t>::value) {
+            for (size_t i = 0; i < n; i++) {
+                if (IsValidAt(iter.validity(), i)) {
+                    sum = sum + static_cast<double>(iter.values()[i]);
+                }
+            }
+        } else {
+            sum += SumColumnAsDouble(iter.values(), iter.validity(), n);
+        }
+        cnt += CountColumn(iter.validity(), n);
+    }
+    *result = cnt == 0 ? 0 : sum / cnt;
+    *is_null = cnt == 0;
+    return true;
+}
+
+template <FoldOp op, class V>
+static bool FoldColumnList(codec::ListRef<V>* list, V* result, bool* is_null) {
+    auto* column = GetColumn(list);
+    if (column == nullptr) {
+        return false;
+    }
+    codec::ColumnBatchIterator<V> iter(column);
+    *is_null = true;
+    if constexpr (kSequentialOnly<V>) {
+        // start from the finite limits and skip nan by the comparison as
+        // the min and max udafs do
+        V acc = op == FoldOp::kMin ? std::numeric_limits<V>::max()
+                                   : std::numeric_limits<V>::lowest();
+        size_t n = 0;
+        while ((n = iter.Next()) > 0) {
+            acc = ScalarFold<op>(iter.values(), iter.validity(), 0, n, acc);
+            *is_null = *is_null && CountColumn(iter.validity(), n) == 0;
+        }
+        *result = acc;
+        return true;
+    }
+    size_t n = 0;
+    while ((n = iter.Next()) > 0) {
+        V val;
+        bool found = op == FoldOp::kMin
+                         ? MinColumn(iter.values(), iter.validity(), n, &val)
+                         : MaxColumn(iter.values(), iter.validity(), n, &val);
+        if (!found) {
+            continue;
+        }
+        *result = *is_null ? val : ScalarApply<op>(val, *result);
+        *is_null = false;
+    }
+    return true;
+}
+
+template <class V>
+bool MinColumnList(codec::ListRef<V>* list, V* result, bool* is_null) {
+    return FoldColumnList<FoldOp::kMin>(list, result, is_null);
+}
+
+template <class V>
+bool MaxColumnList(codec::ListRef<V>* list, V* result, bool* is_null) {
+    return FoldColumnList<FoldOp::kMax>(list, result, is_null);
+}
+
+template <class V>
+bool CountWhereColumnList(codec::ListRef<V>* list, codec::ListRef<bool>* cond,
+                          int64_t* result, bool* is_null) {
+    auto* column = GetColumn(list);
+    auto* cond_column = GetColumn(cond);
+    if (column == nullptr || cond_column == nullptr) {
+        return false;
+    }
+    codec::ColumnBatchIterator<V> iter(column);
+    codec::ColumnBatchIterator<bool> cond_iter(cond_column, iter.batch_size());
+    std::vector<uint64_t> cond_bits(iter.batch_size() / 64);
+    int64_t cnt = 0;
+    size_t n = 0;
+    while ((n = iter.Next()) > 0) {
+        // the columns are of the same window
+        if (cond_iter.Next() != n) {
+            return false;
+        }
+        std::fill(cond_bits.begin(), cond_bits.end(), 0);
+        for (size_t i = 0; i < n; i++) {
+            // a null condition is false
+            if (cond_iter.values()[i]) {
+                cond_bits[i >> 6] |= 1ULL << (i & 63);
+            }
+        }
+        cnt += CountColumnWhere(iter.validity(), cond_bits.data(), n);
+    }
+    *result = cnt;
+    *is_null = false;
+    return true;
+}
+
+#define INSTANTIATE_COLUMN_LIST_UDAFS(V)                                        \
+    template bool SumColumnList<V>(codec::ListRef<V>*, V*, bool*);              \
+    template bool AvgColumnList<V>(codec::ListRef<V>*, double*, bool*);         \
+    template bool MinColumnList<V>(codec::ListRef<V>*, V*, bool*);              \
+    template bool MaxColumnList<V>(codec::ListRef<V>*, V*, bool*);              \
+    template bool CountWhereColumnList<V>(codec::ListRef<V>*,                   \
+                                          codec::ListRef<bool>*, int64_t*,      \
+                                          bool*);
+
+INSTANTIATE_COLUMN_LIST_UDAFS(int16_t)
+INSTANTIATE_COLUMN_LIST_UDAFS(int32_t)
+INSTANTIATE_COLUMN_LIST_UDAFS(int64_t)
+INSTANTIATE_COLUMN_LIST_UDAFS(float)
+INSTANTIATE_COLUMN_LIST_UDAFS(double)
+
+#undef INSTANTIATE_COLUMN_LIST_UDAFS
+
+static const char* GetElementTypeName(const node::TypeNode* type) {
+    switch (type->base()) {
+        case node::kInt16:
+            return "int16";
+        case node::kInt32:
+            return "int32";
+        case node::kInt64:
+            return "int64";
+        case node::kFloat:
+            return "float";
+        case node::kDouble:
+            return "double";
+        default:
+            return nullptr;
+    }
+}
+
+bool GetColumnListUdafName(const std::string& udaf,
+                           const std::vector<const node::TypeNode*>& elem_types,
+                           std::string* fn_name) {
+    if (elem_types.empty() || elem_types[0] == nullptr) {
+        return false;
+    }
+    const char* type_name = GetElementTypeName(elem_types[0]);
+    if (type_name == nullptr) {
+        return false;
+    }
+    if (udaf == "sum" || udaf == "avg" || udaf == "min" || udaf == "max") {
+        if (elem_types.size() != 1) {
+            return false;
+        }
+    } else if (udaf == "count_where") {
+        if (elem_types.size() != 2 || elem_types[1] == nullptr ||
+            elem_types[1]->base() != node::kBool) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    *fn_name = udaf + "_column_list." + type_name;
+    return true;
+}
+
+template <class V>
+static void RegisterColumnListUdafsOf(UdfLibrary* library,
+                                      const std::string& type_name) {
+    library->AddExternalFunction(
+        "sum_column_list." + type_name,
+        reinterpret_cast<void*>(&SumColumnList<V>));
+    library->AddExternalFunction(
+        "avg_column_list." + type_name,
+        reinterpret_cast<void*>(&AvgColumnList<V>));
+    library->AddExternalFunction(
+        "min_column_list." + type_name,
+        reinterpret_cast<void*>(&MinColumnList<V>));
+    library->AddExternalFunction(
+        "max_column_list." + type_name,
+        reinterpret_cast<void*>(&MaxColumnList<V>));
+    library->AddExternalFunction(
+        "count_where_column_list." + type_name,
+        reinterpret_cast<void*>(&CountWhereColumnList<V>));
+}
+
+void RegisterColumnListUdafs(UdfLibrary* library) {
+    RegisterColumnListUdafsOf<int16_t>(library, "int16");
+    RegisterColumnListUdafsOf<int32_t>(library, "int32");
+    RegisterColumnListUdafsOf<int64_t>(library, "int64");
+    RegisterColumnListUdafsOf<float>(library, "float");
+    RegisterColumnListUdafsOf<double>(library, "double");
+}
+
+}  // namespace udf
+}  // namespace hybridse
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_UDF_COLUMN_KERNELS_H_
+#define HYBRIDSE_SRC_UDF_COLUMN_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "codec/type_codec.h"
+#include "node/type_node.h"
+
+namespace hybridse {
+namespace udf {
+
+class UdfLibrary;
+
+/**
+ * Aggregation kernels over a chunk of a numeric column, as decoded by
+ * codec::ColumnBatchIterator. Bit i of validity[i / 64] is set if values[i]
+ * is not null, the null values are skipped.
+ *
+ * The kernels use AVX2 if the cpu supports it, and fall back to the scalar
+ * loops otherwise. Integer sums wrap around as the sum udaf does, while the
+ * floating point sums may differ in the last bits since the lanes change the
+ * order of the additions.
+ */
+enum class ColumnKernelIsa { kScalar, kAVX2 };
+
+// the best instruction set of the running cpu
+ColumnKernelIsa DetectColumnKernelIsa();
+
+// supported V: int16_t, int32_t, int64_t, float, double
+template <class V>
+V SumColumn(const V* values, const uint64_t* validity, size_t n,
+            ColumnKernelIsa isa = DetectColumnKernelIsa());
+
+// sum the valid values as double, for avg
+template <class V>
+double SumColumnAsDouble(const V* values, const uint64_t* validity, size_t n,
+                         ColumnKernelIsa isa = DetectColumnKernelIsa());
+
+// return false if all the values are null
+template <class V>
+bool MinColumn(const V* values, const uint64_t* validity, size_t n, V* result,
+               ColumnKernelIsa isa = DetectColumnKernelIsa());
+
+template <class V>
+bool MaxColumn(const V* values, const uint64_t* validity, size_t n, V* result,
+               ColumnKernelIsa isa = DetectColumnKernelIsa());
+
+// count of the valid values
+int64_t CountColumn(const uint64_t* validity, size_t n);
+
+// count of the valid values whose condition is true, as count_where does,
+// cond is a bitmap of the same layout as the validity
+int64_t CountColumnWhere(const uint64_t* validity, const uint64_t* cond,
+                         size_t n);
+
+/**
+ * The builtin sum, avg, min, max and count_where over a window column, the
+ * udaf codegen calls them before the update loop of the udaf. They decode the
+ * column by codec::ColumnBatchIterator and run the kernels above. They return
+ * false if the list is not a codec::ColumnImpl of V, and the loop runs then.
+ * The floating point columns, and the avg of int64, run the update rule of the
+ * udaf in the list order instead, so the results equal the loop exactly.
+ */
+template <class V>
+bool SumColumnList(codec::ListRef<V>* list, V* result, bool* is_null);
+
+template <class V>
+bool AvgColumnList(codec::ListRef<V>* list, double* result, bool* is_null);
+
+template <class V>
+bool MinColumnList(codec::ListRef<V>* list, V* result, bool* is_null);
+
+template <class V>
+bool MaxColumnList(codec::ListRef<V>* list, V* result, bool* is_null);
+
+template <class V>
+bool CountWhereColumnList(codec::ListRef<V>* list, codec::ListRef<bool>* cond,
+                          int64_t* result, bool* is_null);
+
+// the external function of the udaf over the lists of elem_types above,
+// return false if there is none
+bool GetColumnListUdafName(const std::string& udaf,
+                           const std::vector<const node::TypeNode*>& elem_types,
+                           std::string* fn_name);
+
+// add the external functions of GetColumnListUdafName to the library
+void RegisterColumnListUdafs(UdfLibrary* library);
+
+}  // namespace udf
+}  // namespace hybridse
+
+#endif  // HYBRIDSE_SRC_UDF_COLUMN_KERNELS_H_
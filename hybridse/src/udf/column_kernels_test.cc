@@ -0,0 +1,378 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/column_kernels.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "codec/list_iterator_codec.h"
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace udf {
+
+class ColumnKernelsTest : public ::testing::Test {};
+
+static std::vector<ColumnKernelIsa> AvailableIsas() {
+    std::vector<ColumnKernelIsa> isas = {ColumnKernelIsa::kScalar};
+    if (DetectColumnKernelIsa() == ColumnKernelIsa::kAVX2) {
+        isas.push_back(ColumnKernelIsa::kAVX2);
+    }
+    return isas;
+}
+
+// every 3th value is null, and all the values of [64, 128) are null
+static std::vector<uint64_t> BuildValidity(size_t n) {
+    std::vector<uint64_t> validity((n + 63) / 64 + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        if (i % 3 != 0 && (i < 64 || i >= 128)) {
+            validity[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+    return validity;
+}
+
+template <class V>
+static void CheckKernels(const std::vector<V>& values) {
+    for (size_t n : {0, 1, 7, 15, 16, 17, 63, 64, 65, 130, 1000}) {
+        if (n > values.size()) {
+            continue;
+        }
+        auto validity = BuildValidity(n);
+        V sum = 0;
+        double sum_double = 0;
+        int64_t cnt = 0;
+        V min = std::numeric_limits<V>::max();
+        V max = std::numeric_limits<V>::lowest();
+        for (size_t i = 0; i < n; i++) {
+            if (validity[i >> 6] >> (i & 63) & 1) {
+                sum += values[i];
+                sum_double += values[i];
+                min = std::min(min, values[i]);
+                max = std::max(max, values[i]);
+                cnt++;
+            }
+        }
+        ASSERT_EQ(cnt, CountColumn(validity.data(), n));
+        for (auto isa : AvailableIsas()) {
+            if (std::is_integral<V>::value) {
+                ASSERT_EQ(sum, SumColumn(values.data(), validity.data(), n, isa)) << n;
+            } else {
+                ASSERT_NEAR(sum, SumColumn(values.data(), validity.data(), n, isa), 1e-6) << n;
+            }
+            ASSERT_NEAR(sum_double, SumColumnAsDouble(values.data(), validity.data(), n, isa), 1e-6) << n;
+            V res = 0;
+            ASSERT_EQ(cnt > 0, MinColumn(values.data(), validity.data(), n, &res, isa));
+            if (cnt > 0) {
+                ASSERT_EQ(min, res) << n;
+            }
+            ASSERT_EQ(cnt > 0, MaxColumn(values.data(), validity.data(), n, &res, isa));
+            if (cnt > 0) {
+                ASSERT_EQ(max, res) << n;
+            }
+        }
+    }
+}
+
+TEST_F(ColumnKernelsTest, Numeric) {
+    std::mt19937 rng(0);
+    std::vector<int16_t> i16;
+    std::vector<int32_t> i32;
+    std::vector<int64_t> i64;
+    std::vector<float> f;
+    std::vector<double> d;
+    for (int i = 0; i < 1000; i++) {
+        int32_t val = static_cast<int32_t>(rng() % 2001) - 1000;
+        i16.push_back(val / 10);
+        i32.push_back(val * 100);
+        i64.push_back(val * 10000000000L);
+        f.push_back(val * 0.25f);
+        d.push_back(val * 0.125);
+    }
+    CheckKernels(i16);
+    CheckKernels(i32);
+    CheckKernels(i64);
+    CheckKernels(f);
+    CheckKernels(d);
+}
+
+TEST_F(ColumnKernelsTest, OverflowAndNaN) {
+    std::vector<int32_t> values(64, std::numeric_limits<int32_t>::max());
+    std::vector<uint64_t> validity = {~0ULL};
+    for (auto isa : AvailableIsas()) {
+        // wrap around as the sum udaf does
+        ASSERT_EQ(static_cast<int32_t>(0x7FFFFFFFu * 64u), SumColumn(values.data(), validity.data(), 64, isa));
+    }
+
+    std::vector<double> doubles(20, 1.0);
+    doubles[3] = std::nan("");
+    doubles[17] = -2.0;
+    doubles[18] = 5.0;
+    for (auto isa : AvailableIsas()) {
+        double res = 0;
+        ASSERT_TRUE(MinColumn(doubles.data(), validity.data(), doubles.size(), &res, isa));
+        ASSERT_EQ(-2.0, res);
+        ASSERT_TRUE(MaxColumn(doubles.data(), validity.data(), doubles.size(), &res, isa));
+        ASSERT_EQ(5.0, res);
+    }
+}
+
+TEST_F(ColumnKernelsTest, CountWhere) {
+    std::vector<uint64_t> validity = {0xFFFF0000FFFF0000ULL, 0x0F};
+    std::vector<uint64_t> cond = {0x00FF00FF00FF00FFULL, 0xFF};
+    ASSERT_EQ(32 + 4, CountColumn(validity.data(), 100));
+    ASSERT_EQ(32 + 2, CountColumn(validity.data(), 66));
+    ASSERT_EQ(16 + 4, CountColumnWhere(validity.data(), cond.data(), 100));
+    ASSERT_EQ(8, CountColumnWhere(validity.data(), cond.data(), 40));
+}
+
+TEST_F(ColumnKernelsTest, BatchIterator) {
+    codec::Schema schema;
+    auto* column = schema.Add();
+    column->set_name("col1");
+    column->set_type(type::kVarchar);
+    column = schema.Add();
+    column->set_name("col2");
+    column->set_type(type::kInt32);
+    codec::RowBuilder builder(schema);
+    std::vector<codec::Row> rows;
+    int64_t expect_sum = 0;
+    for (int i = 0; i < 2500; i++) {
+        uint32_t size = builder.CalTotalLength(3);
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        builder.AppendString("key", 3);
+        if (i % 7 == 0) {
+            builder.AppendNULL();
+        } else {
+            builder.AppendInt32(i);
+            expect_sum += i;
+        }
+        rows.emplace_back(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+    codec::ArrayListV<codec::Row> list(&rows);
+    codec::SliceFormat format(&schema);
+    codec::ColumnImpl<int32_t> col(&list, 0, 1, format.GetColumnInfo(1)->offset);
+
+    codec::ColumnBatchIterator<int32_t> iter(&col, 1000);
+    ASSERT_EQ(1024u, iter.batch_size());
+    int64_t sum = 0;
+    int64_t cnt = 0;
+    size_t total = 0;
+    size_t batch = 0;
+    while ((batch = iter.Next()) > 0) {
+        for (size_t i = 0; i < batch; i++) {
+            bool valid = iter.validity()[i >> 6] >> (i & 63) & 1;
+            ASSERT_EQ((total + i) % 7 != 0, valid);
+            if (valid) {
+                ASSERT_EQ(static_cast<int32_t>(total + i), iter.values()[i]);
+            }
+        }
+        sum += SumColumn(iter.values(), iter.validity(), batch);
+        cnt += CountColumn(iter.validity(), batch);
+        total += batch;
+    }
+    ASSERT_EQ(2500u, total);
+    ASSERT_EQ(expect_sum, sum);
+    ASSERT_EQ(2500 - 358, cnt);
+}
+
+TEST_F(ColumnKernelsTest, ColumnList) {
+    codec::Schema schema;
+    auto* column = schema.Add();
+    column->set_name("col1");
+    column->set_type(type::kDouble);
+    column = schema.Add();
+    column->set_name("col2");
+    column->set_type(type::kBool);
+    codec::RowBuilder builder(schema);
+    std::vector<codec::Row> rows;
+    double sum = 0;
+    int64_t cnt = 0;
+    int64_t cnt_where = 0;
+    for (int i = 0; i < 3000; i++) {
+        uint32_t size = builder.CalTotalLength(0);
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        bool is_null = i % 5 == 0;
+        if (is_null) {
+            builder.AppendNULL();
+        } else {
+            builder.AppendDouble(i - 1000.5);
+            sum += i - 1000.5;
+            cnt++;
+        }
+        if (i % 11 == 0) {
+            builder.AppendNULL();
+        } else {
+            builder.AppendBool(i % 2 == 0);
+            cnt_where += !is_null && i % 2 == 0;
+        }
+        rows.emplace_back(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+    codec::ArrayListV<codec::Row> list(&rows);
+    codec::SliceFormat format(&schema);
+    codec::ColumnImpl<double> col(&list, 0, 0, format.GetColumnInfo(0)->offset);
+    codec::ColumnImpl<bool> cond(&list, 0, 1, format.GetColumnInfo(1)->offset);
+    codec::ListRef<double> col_ref{reinterpret_cast<int8_t*>(&col)};
+    codec::ListRef<bool> cond_ref{reinterpret_cast<int8_t*>(&cond)};
+
+    double result = 0;
+    bool is_null = true;
+    ASSERT_TRUE(SumColumnList(&col_ref, &result, &is_null));
+    ASSERT_FALSE(is_null);
+    ASSERT_NEAR(sum, result, 1e-6);
+    ASSERT_TRUE(AvgColumnList(&col_ref, &result, &is_null));
+    ASSERT_NEAR(sum / cnt, result, 1e-9);
+    ASSERT_TRUE(MinColumnList(&col_ref, &result, &is_null));
+    ASSERT_EQ(1 - 1000.5, result);
+    ASSERT_TRUE(MaxColumnList(&col_ref, &result, &is_null));
+    ASSERT_EQ(2999 - 1000.5, result);
+    int64_t count = 0;
+    ASSERT_TRUE(CountWhereColumnList(&col_ref, &cond_ref, &count, &is_null));
+    ASSERT_FALSE(is_null);
+    ASSERT_EQ(cnt_where, count);
+
+    // all null
+    std::vector<codec::Row> null_rows(rows.begin(), rows.begin() + 1);
+    codec::ArrayListV<codec::Row> null_list(&null_rows);
+    codec::ColumnImpl<double> null_col(&null_list, 0, 0, format.GetColumnInfo(0)->offset);
+    codec::ListRef<double> null_ref{reinterpret_cast<int8_t*>(&null_col)};
+    ASSERT_TRUE(MaxColumnList(&null_ref, &result, &is_null));
+    ASSERT_TRUE(is_null);
+    ASSERT_TRUE(AvgColumnList(&null_ref, &result, &is_null));
+    ASSERT_TRUE(is_null);
+
+    // the other lists are left to the update loop of the udaf
+    std::vector<double> values = {1.0, 2.0};
+    codec::ArrayListV<double> array(&values);
+    codec::ListRef<double> array_ref{reinterpret_cast<int8_t*>(&array)};
+    ASSERT_FALSE(SumColumnList(&array_ref, &result, &is_null));
+    ASSERT_FALSE(CountWhereColumnList(&col_ref, reinterpret_cast<codec::ListRef<bool>*>(&array_ref), &count,
+                                      &is_null));
+
+    node::TypeNode double_type(node::kDouble);
+    node::TypeNode bool_type(node::kBool);
+    node::TypeNode string_type(node::kVarchar);
+    std::string fn_name;
+    ASSERT_TRUE(GetColumnListUdafName("avg", {&double_type}, &fn_name));
+    ASSERT_EQ("avg_column_list.double", fn_name);
+    ASSERT_TRUE(GetColumnListUdafName("count_where", {&double_type, &bool_type}, &fn_name));
+    ASSERT_EQ("count_where_column_list.double", fn_name);
+    ASSERT_FALSE(GetColumnListUdafName("sum", {&string_type}, &fn_name));
+    ASSERT_FALSE(GetColumnListUdafName("count_where", {&double_type, &double_type}, &fn_name));
+    ASSERT_FALSE(GetColumnListUdafName("distinct_count", {&double_type}, &fn_name));
+}
+
+TEST_F(ColumnKernelsTest, FloatColumnListMatchesUdaf) {
+    codec::Schema schema;
+    auto* column = schema.Add();
+    column->set_name("col1");
+    column->set_type(type::kFloat);
+    codec::RowBuilder builder(schema);
+    std::mt19937 rng(0);
+    std::vector<codec::Row> rows;
+    std::vector<float> values;
+    for (int i = 0; i < 3000; i++) {
+        uint32_t size = builder.CalTotalLength(0);
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(size));
+        builder.SetBuffer(buf, size);
+        if (i % 7 == 0) {
+            builder.AppendNULL();
+        } else {
+            // the magnitudes differ a lot so that any reordering changes the sum
+            float val = (static_cast<float>(rng() % 100000) - 50000.0f) / 7.0f;
+            if (i % 13 == 0) {
+                val *= 1e6f;
+            } else if (i == 1) {
+                val = std::nanf("");
+            }
+            builder.AppendFloat(val);
+            values.push_back(val);
+        }
+        rows.emplace_back(base::RefCountedSlice::CreateManaged(buf, size));
+    }
+    // the update rules of the sum, avg, min and max udafs
+    float sum = 0;
+    double avg_sum = 0;
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+    for (float val : values) {
+        sum = sum + val;
+        avg_sum = avg_sum + val;
+        min = val < min ? val : min;
+        max = val > max ? val : max;
+    }
+    codec::ArrayListV<codec::Row> list(&rows);
+    codec::SliceFormat format(&schema);
+    codec::ColumnImpl<float> col(&list, 0, 0, format.GetColumnInfo(0)->offset);
+    codec::ListRef<float> col_ref{reinterpret_cast<int8_t*>(&col)};
+    float result = 0;
+    bool is_null = true;
+    ASSERT_TRUE(SumColumnList(&col_ref, &result, &is_null));
+    ASSERT_FALSE(is_null);
+    // nan propagates through the sums
+    ASSERT_TRUE(std::isnan(sum));
+    ASSERT_TRUE(std::isnan(result));
+    ASSERT_TRUE(MinColumnList(&col_ref, &result, &is_null));
+    ASSERT_FALSE(is_null);
+    ASSERT_EQ(min, result);
+    ASSERT_TRUE(MaxColumnList(&col_ref, &result, &is_null));
+    ASSERT_EQ(max, result);
+
+    // without nan the sums are compared bit by bit
+    values.clear();
+    std::vector<codec::Row> finite_rows;
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (i == 1) {
+            continue;
+        }
+        finite_rows.push_back(rows[i]);
+    }
+    sum = 0;
+    avg_sum = 0;
+    int64_t cnt = 0;
+    codec::RowView view(schema);
+    for (auto& row : finite_rows) {
+        view.Reset(row.buf(), row.size());
+        float val = 0;
+        if (view.GetFloat(0, &val) == 0) {
+            sum = sum + val;
+            avg_sum = avg_sum + val;
+            cnt++;
+        }
+    }
+    codec::ArrayListV<codec::Row> finite_list(&finite_rows);
+    codec::ColumnImpl<float> finite_col(&finite_list, 0, 0, format.GetColumnInfo(0)->offset);
+    codec::ListRef<float> finite_ref{reinterpret_cast<int8_t*>(&finite_col)};
+    ASSERT_TRUE(SumColumnList(&finite_ref, &result, &is_null));
+    ASSERT_EQ(sum, result);
+    double avg = 0;
+    ASSERT_TRUE(AvgColumnList(&finite_ref, &avg, &is_null));
+    ASSERT_EQ(avg_sum / cnt, avg);
+}
+
+}  // namespace udf
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -23,11 +23,14 @@
 #include <vector>
 #include <queue>
 #include <functional>
+#include <cmath>
 
 #include "absl/strings/str_cat.h"
+#include "base/fe_sketch.h"
 #include "codegen/date_ir_builder.h"
 #include "codegen/string_ir_builder.h"
 #include "codegen/timestamp_ir_builder.h"
+#include "udf/column_kernels.h"
 #include "udf/containers.h"
 #include "udf/udf.h"
 #include "udf/udf_registry.h"
@@ -377,6 +380,54 @@ struct MedianDef {
     }
 };
 
+enum class VarianceKind { kVarSamp, kVarPop, kStddev, kStddevPop };
+
+// the variance and standard deviation share the moments container, which is
+// also the pre-aggregation state of the long windows
+template <typename T, VarianceKind KIND>
+struct VarianceDef {
+    using ContainerT = base::Moments;
+
+    void operator()(UdafRegistryHelper& helper) {  // NOLINT
+        std::string suffix = ".opaque_moments_" + DataTypeTrait<T>::to_string();
+        helper.templates<Nullable<double>, Opaque<ContainerT>, Nullable<T>>()
+            .init(helper.name() + "_init" + suffix, VarianceDef::Init)
+            .update(helper.name() + "_update" + suffix, VarianceDef::Update)
+            .output(helper.name() + "_output" + suffix, reinterpret_cast<void*>(VarianceDef::Output), true);
+    }
+
+    static void Init(ContainerT* addr) { new (addr) ContainerT(); }
+
+    static ContainerT* Update(ContainerT* container, T value, bool is_null) {
+        if (!is_null) {
+            container->Add(static_cast<double>(value));
+        }
+        return container;
+    }
+
+    static void Output(ContainerT* container, double* ret, bool* is_null) {
+        bool samp = KIND == VarianceKind::kVarSamp || KIND == VarianceKind::kStddev;
+        // the sample variance of a single value is undefined
+        *is_null = container->Count() < (samp ? 2 : 1);
+        if (!*is_null) {
+            *ret = samp ? container->VarSamp() : container->VarPop();
+            if (KIND == VarianceKind::kStddev || KIND == VarianceKind::kStddevPop) {
+                *ret = std::sqrt(*ret);
+            }
+        }
+        container->~ContainerT();
+    }
+};
+
+template <typename T>
+using VarSampDef = VarianceDef<T, VarianceKind::kVarSamp>;
+template <typename T>
+using VarPopDef = VarianceDef<T, VarianceKind::kVarPop>;
+template <typename T>
+using StddevDef = VarianceDef<T, VarianceKind::kStddev>;
+template <typename T>
+using StddevPopDef = VarianceDef<T, VarianceKind::kStddevPop>;
+
 template <typename T>
 struct SumWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
@@ -2226,6 +2277,7 @@ void DefaultUdfLibrary::Init() {
 
     InitWindowFunctions();
     InitUdaf();
+    RegisterColumnListUdafs(this);
     InitFeatureZero();
 
     AddExternalFunction("init_udfcontext.opaque",
@@ -2570,6 +2622,94 @@ void DefaultUdfLibrary::InitUdaf() {
         )")
         .args_in<int16_t, int32_t, int64_t, float, double>();
 
+    RegisterUdafTemplate<VarSampDef>("var_samp")
+        .doc(R"(
+            @brief Compute the sample variance of values.
+
+            @param value  Specify value column to aggregate on.
+
+            Example:
+
+            |value|
+            |--|
+            |1|
+            |2|
+            |3|
+            |4|
+            @code{.sql}
+                SELECT var_samp(value) OVER w;
+                -- output 1.666667
+            @endcode
+            @since 0.6.0
+        )")
+        .args_in<int16_t, int32_t, int64_t, float, double>();
+
+    RegisterUdafTemplate<VarPopDef>("var_pop")
+        .doc(R"(
+            @brief Compute the population variance of values.
+
+            @param value  Specify value column to aggregate on.
+
+            Example:
+
+            |value|
+            |--|
+            |1|
+            |2|
+            |3|
+            |4|
+            @code{.sql}
+                SELECT var_pop(value) OVER w;
+                -- output 1.25
+            @endcode
+            @since 0.6.0
+        )")
+        .args_in<int16_t, int32_t, int64_t, float, double>();
+
+    RegisterUdafTemplate<StddevDef>("stddev")
+        .doc(R"(
+            @brief Compute the sample standard deviation of values.
+
+            @param value  Specify value column to aggregate on.
+
+            Example:
+
+            |value|
+            |--|
+            |1|
+            |2|
+            |3|
+            |4|
+            @code{.sql}
+                SELECT stddev(value) OVER w;
+                -- output 1.290994
+            @endcode
+            @since 0.6.0
+        )")
+        .args_in<int16_t, int32_t, int64_t, float, double>();
+
+    RegisterUdafTemplate<StddevPopDef>("stddev_pop")
+        .doc(R"(
+            @brief Compute the population standard deviation of values.
+
+            @param value  Specify value column to aggregate on.
+
+            Example:
+
+            |value|
+            |--|
+            |1|
+            |2|
+            |3|
+            |4|
+            @code{.sql}
+                SELECT stddev_pop(value) OVER w;
+                -- output 1.118034
+            @endcode
+            @since 0.6.0
+        )")
+        .args_in<int16_t, int32_t, int64_t, float, double>();
+
 
     InitAggByCateUdafs();
 }
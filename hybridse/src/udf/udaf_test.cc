@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <cmath>
+
 #include "udf/udf_test.h"
 
 namespace hybridse {
@@ -122,6 +124,19 @@ TEST_F(UdafTest, MedianTest) {
     CheckUdafOneParam<Nullable<double>, Nullable<double>>("median", 3.0, {1.0, 5.0, 2.0, 4.0, 3.0});
 }
 
+TEST_F(UdafTest, VarianceTest) {
+    CheckUdafOneParam<Nullable<double>, Nullable<int32_t>>("var_pop", nullptr, {});
+    CheckUdafOneParam<Nullable<double>, Nullable<int32_t>>("var_pop", nullptr, {nullptr});
+    CheckUdafOneParam<Nullable<double>, Nullable<int32_t>>("var_pop", 0.0, {3, nullptr});
+    CheckUdafOneParam<Nullable<double>, Nullable<int32_t>>("var_samp", nullptr, {3, nullptr});
+
+    CheckUdafOneParam<Nullable<double>, Nullable<int32_t>>("var_samp", 5.0 / 3, {1, 2, 3, 4});
+    CheckUdafOneParam<Nullable<double>, Nullable<int64_t>>("var_pop", 1.25, {1, 2, 3, 4});
+    CheckUdafOneParam<Nullable<double>, Nullable<double>>("stddev", std::sqrt(5.0 / 3), {1.0, 2.0, 3.0, 4.0});
+    CheckUdafOneParam<Nullable<double>, Nullable<float>>("stddev_pop", std::sqrt(1.25),
+                                                         {1.0f, 2.0f, nullptr, 3.0f, 4.0f});
+}
+
 TEST_F(UdafTest, SumWhereTest) {
     CheckUdf<int32_t, ListRef<int32_t>, ListRef<bool>>(
         "sum_where", 10, MakeList<int32_t>({4, 5, 6}),
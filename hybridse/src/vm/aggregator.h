@@ -18,11 +18,13 @@
 #define HYBRIDSE_SRC_VM_AGGREGATOR_H_
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <string>
 #include <boost/algorithm/string/compare.hpp>
 
+#include "base/fe_sketch.h"
 #include "codec/fe_row_codec.h"
 #include "codec/row.h"
 #include "proto/fe_type.pb.h"
@@ -366,6 +368,138 @@ class MaxAggregator : public Aggregator<T> {
     }
 };
 
+// the aggr vals of the sketch aggregators are the encoded sketches, see base/fe_sketch.h
+template <class T>
+class DistinctCountAggregator : public Aggregator<T> {
+ public:
+    DistinctCountAggregator(type::Type type, const Schema& output_schema)
+        : Aggregator<T>(type, output_schema, T()) {}
+
+    // val is assumed to be not null
+    void UpdateValue(const T& val) override {
+        hll_.AddValue(val);
+        this->counter_++;
+    }
+
+    void Update(const std::string& bval) override {
+        base::HyperLogLog hll;
+        if (!hll.Decode(bval.data(), bval.size())) {
+            LOG(ERROR) << "encoded aggr val is not valid";
+            return;
+        }
+        hll_.Merge(hll);
+        this->counter_++;
+    }
+
+    Row Output() override {
+        uint32_t total_len = this->row_builder_.CalTotalLength(0);
+        int8_t* buf = static_cast<int8_t*>(malloc(total_len));
+        this->row_builder_.SetBuffer(buf, total_len);
+        this->row_builder_.AppendInt64(hll_.Estimate());
+        Reset();
+        return Row(base::RefCountedSlice::CreateManaged(buf, total_len));
+    }
+
+    bool IsNull() const override {
+        return false;
+    }
+
+    void Reset() override {
+        Aggregator<T>::Reset();
+        hll_.Clear();
+    }
+
+ private:
+    base::HyperLogLog hll_;
+};
+
+class MedianAggregator : public Aggregator<double> {
+ public:
+    MedianAggregator(type::Type type, const Schema& output_schema) : Aggregator<double>(type, output_schema, 0) {}
+
+    // val is assumed to be not null
+    void UpdateValue(const double& val) override {
+        digest_.Add(val);
+        this->counter_++;
+    }
+
+    void Update(const std::string& bval) override {
+        base::TDigest digest;
+        if (!digest.Decode(bval.data(), bval.size())) {
+            LOG(ERROR) << "encoded aggr val is not valid";
+            return;
+        }
+        digest_.Merge(digest);
+        this->counter_ += static_cast<int64_t>(digest.Count());
+    }
+
+    const double& val() override {
+        this->val_ = digest_.Quantile(0.5);
+        return this->val_;
+    }
+
+    type::Type GetRepType() const override {
+        return type::kDouble;
+    }
+
+    void Reset() override {
+        Aggregator::Reset();
+        digest_.Clear();
+    }
+
+ private:
+    base::TDigest digest_;
+};
+
+class VarianceAggregator : public Aggregator<double> {
+ public:
+    VarianceAggregator(type::Type type, const Schema& output_schema, bool samp, bool stddev)
+        : Aggregator<double>(type, output_schema, 0), samp_(samp), stddev_(stddev) {}
+
+    // val is assumed to be not null
+    void UpdateValue(const double& val) override {
+        moments_.Add(val);
+        this->counter_++;
+    }
+
+    void Update(const std::string& bval) override {
+        base::Moments moments;
+        if (!moments.Decode(bval.data(), bval.size())) {
+            LOG(ERROR) << "encoded aggr val is not valid";
+            return;
+        }
+        moments_.Merge(moments);
+        this->counter_ += moments.Count();
+    }
+
+    // the sample variance of a single value is undefined
+    bool IsNull() const override {
+        return moments_.Count() < (samp_ ? 2 : 1);
+    }
+
+    const double& val() override {
+        this->val_ = samp_ ? moments_.VarSamp() : moments_.VarPop();
+        if (stddev_) {
+            this->val_ = std::sqrt(this->val_);
+        }
+        return this->val_;
+    }
+
+    type::Type GetRepType() const override {
+        return type::kDouble;
+    }
+
+    void Reset() override {
+        Aggregator::Reset();
+        moments_.Clear();
+    }
+
+ private:
+    base::Moments moments_;
+    bool samp_;
+    bool stddev_;
+};
+
 template <template<class> class AggregatorClass>
 std::unique_ptr<BaseAggregator> MakeOverflowAggregator(type::Type agg_col_type, const Schema& output_schema) {
     switch (agg_col_type) {
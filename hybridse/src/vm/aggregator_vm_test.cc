@@ -505,6 +505,77 @@ TEST_P(AggregatorVMTest, MaxTest) {
     }
 }
 
+TEST_P(AggregatorVMTest, SketchTest) {
+    auto agg_col_type = GetParam();
+    codec::Schema count_schema;
+    auto column = count_schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("val");
+    codec::Schema double_schema;
+    column = double_schema.Add();
+    column->set_type(type::kDouble);
+    column->set_name("val");
+
+    // the values 0..9 twice, half of them from the raw rows and the rest from a pre-aggregated bucket
+    auto distinct_count = MakeSameTypeAggregator<DistinctCountAggregator>(agg_col_type, count_schema);
+    ASSERT_TRUE(distinct_count != nullptr);
+    base::HyperLogLog hll;
+    for (int i = 0; i < 20; i++) {
+        if (agg_col_type == type::kVarchar) {
+            std::string val = std::to_string(i % 10);
+            if (i % 2 == 0) {
+                AggregatorUpdate(distinct_count.get(), val);
+            } else {
+                hll.AddValue(val);
+            }
+        } else if (i % 2 == 0) {
+            AggregatorUpdate(distinct_count.get(), static_cast<int64_t>(i % 10));
+        } else if (agg_col_type == type::kFloat || agg_col_type == type::kDouble) {
+            hll.AddValue(static_cast<double>(i % 10));
+        } else {
+            hll.AddValue(static_cast<int64_t>(i % 10));
+        }
+    }
+    std::string bval;
+    hll.Encode(&bval);
+    distinct_count->Update(bval);
+    codec::RowView row_view(count_schema);
+    Row row = distinct_count->Output();
+    row_view.Reset(row.buf());
+    int64_t cnt = 0;
+    ASSERT_EQ(0, row_view.GetInt64(0, &cnt));
+    ASSERT_EQ(10, cnt);
+
+    if (agg_col_type == type::kVarchar || agg_col_type == type::kDate || agg_col_type == type::kTimestamp) {
+        return;
+    }
+    base::TDigest digest;
+    base::Moments moments;
+    std::unique_ptr<BaseAggregator> median = std::make_unique<MedianAggregator>(agg_col_type, double_schema);
+    std::unique_ptr<BaseAggregator> var_samp =
+        std::make_unique<VarianceAggregator>(agg_col_type, double_schema, true, false);
+    std::unique_ptr<BaseAggregator> stddev_pop =
+        std::make_unique<VarianceAggregator>(agg_col_type, double_schema, false, true);
+    for (int i = 1; i <= 4; i++) {
+        if (i % 2 == 0) {
+            AggregatorUpdate(median.get(), i);
+            AggregatorUpdate(var_samp.get(), i);
+            AggregatorUpdate(stddev_pop.get(), i);
+        } else {
+            digest.Add(i);
+            moments.Add(i);
+        }
+    }
+    digest.Encode(&bval);
+    median->Update(bval);
+    moments.Encode(&bval);
+    var_samp->Update(bval);
+    stddev_pop->Update(bval);
+    EXPECT_DOUBLE_EQ(2.5, dynamic_cast<Aggregator<double>*>(median.get())->val());
+    EXPECT_DOUBLE_EQ(5.0 / 3, dynamic_cast<Aggregator<double>*>(var_samp.get())->val());
+    EXPECT_DOUBLE_EQ(std::sqrt(1.25), dynamic_cast<Aggregator<double>*>(stddev_pop.get())->val());
+}
+
 TEST_F(AggregatorVMTest, NullTest) {
     auto agg_col_type = type::kInt64;
     codec::Schema schema;
@@ -538,6 +609,16 @@ TEST_F(AggregatorVMTest, NullTest) {
     check_null(aggregator.get());
     aggregator = std::make_unique<MaxAggregator<int64_t>>(agg_col_type, schema);
     check_null(aggregator.get());
+    aggregator = std::make_unique<MedianAggregator>(agg_col_type, schema);
+    check_null(aggregator.get());
+    aggregator = std::make_unique<VarianceAggregator>(agg_col_type, schema, false, false);
+    check_null(aggregator.get());
+    // the sample variance of a single value is null
+    aggregator = std::make_unique<VarianceAggregator>(agg_col_type, schema, true, false);
+    AggregatorUpdate(aggregator.get(), 1.0);
+    check_null(aggregator.get());
+    aggregator = std::make_unique<DistinctCountAggregator<int64_t>>(agg_col_type, schema);
+    check_not_null(aggregator.get());
 
     schema.RemoveLast();
     agg_col_type = type::kVarchar;
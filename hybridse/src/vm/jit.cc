@@ -150,8 +150,26 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
 
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (!object_cache_dir_.empty()) {
+        object_cache_ = std::unique_ptr<JitObjectCache>(
+            new JitObjectCache(object_cache_dir_));
+        // the default compiler of LLJIT, with the object cache attached
+        auto object_cache = object_cache_.get();
+        builder.setCompileFunctionCreator(
+            [object_cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<
+                    ::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                return ::llvm::orc::IRCompileLayer::CompileFunction(
+                    ::llvm::orc::TMOwningSimpleCompiler(std::move(*tm),
+                                                        object_cache));
+            });
+    }
+    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
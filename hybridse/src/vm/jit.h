@@ -22,6 +22,7 @@
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "vm/jit_object_cache.h"
 #include "vm/jit_wrapper.h"
 
 #ifdef LLVM_EXT_ENABLE
@@ -88,6 +89,8 @@ std::string LlvmToString(const T& value) {
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
     HybridSeLlvmJitWrapper() {}
+    explicit HybridSeLlvmJitWrapper(const JitOptions& jit_options)
+        : object_cache_dir_(jit_options.GetObjectCacheDir()) {}
     ~HybridSeLlvmJitWrapper() {}
 
     bool Init() override;
@@ -102,7 +105,12 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
     hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) override;
 
+    const JitObjectCache* GetObjectCache() const { return object_cache_.get(); }
+
  private:
+    const std::string object_cache_dir_;
+    // declared before jit_ as the compiler of jit_ refers to it
+    std::unique_ptr<JitObjectCache> object_cache_;
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
 };
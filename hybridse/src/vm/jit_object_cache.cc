@@ -0,0 +1,161 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace hybridse {
+namespace vm {
+
+// bump it once the layout of the cached objects changes
+static const char OBJECT_CACHE_VERSION[] = "hybridse_jit_object_v1";
+
+// the host cpu and features the native target machine is built with
+static std::string GetHostCpuKey() {
+    std::string key = ::llvm::sys::getHostCPUName().str();
+    ::llvm::StringMap<bool> features;
+    if (::llvm::sys::getHostCPUFeatures(features)) {
+        std::vector<std::string> names;
+        for (auto& feature : features) {
+            names.push_back((feature.second ? "+" : "-") +
+                            feature.first().str());
+        }
+        std::sort(names.begin(), names.end());
+        for (auto& name : names) {
+            key.append(",").append(name);
+        }
+    }
+    return key;
+}
+
+JitObjectCache::JitObjectCache(const std::string& dir)
+    : dir_(dir), available_(false), hit_cnt_(0), miss_cnt_(0) {
+    std::error_code ec = ::llvm::sys::fs::create_directories(dir_);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object cache dir " << dir_ << ": "
+                     << ec.message();
+        return;
+    }
+    available_ = true;
+}
+
+std::string JitObjectCache::GetPath(const ::llvm::Module* m) const {
+    static const std::string host_cpu_key = GetHostCpuKey();
+    std::string ir;
+    ::llvm::raw_string_ostream ss(ir);
+    m->print(ss, nullptr);
+    ss.flush();
+
+    ::llvm::MD5 md5;
+    md5.update(OBJECT_CACHE_VERSION);
+    md5.update(LLVM_VERSION_STRING);
+    md5.update(m->getTargetTriple());
+    md5.update(host_cpu_key);
+    md5.update(ir);
+    ::llvm::MD5::MD5Result result;
+    md5.final(result);
+    ::llvm::SmallString<32> hex;
+    ::llvm::MD5::stringifyResult(result, hex);
+
+    ::llvm::SmallString<256> path(dir_);
+    ::llvm::sys::path::append(path, hex.str() + ".o");
+    return path.str().str();
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(
+    const ::llvm::Module* m) {
+    if (!available_) {
+        return nullptr;
+    }
+    std::string path = GetPath(m);
+    auto buf = ::llvm::MemoryBuffer::getFile(path);
+    if (buf) {
+        hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+        DLOG(INFO) << "load jit object from " << path;
+        return std::move(buf.get());
+    }
+    miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mu_);
+    pending_paths_[m] = path;
+    return nullptr;
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* m,
+                                          ::llvm::MemoryBufferRef obj) {
+    if (!available_) {
+        return;
+    }
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = pending_paths_.find(m);
+        if (it != pending_paths_.end()) {
+            path = std::move(it->second);
+            pending_paths_.erase(it);
+        }
+    }
+    if (path.empty()) {
+        path = GetPath(m);
+    }
+    // write to a unique temp file and rename it, so that the concurrent
+    // compilers and the readers never see a partial object
+    int fd = -1;
+    ::llvm::SmallString<256> tmp_path;
+    std::error_code ec =
+        ::llvm::sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tmp_path);
+    if (ec) {
+        LOG(WARNING) << "fail to create jit object file in " << dir_ << ": "
+                     << ec.message();
+        return;
+    }
+    {
+        ::llvm::raw_fd_ostream os(fd, true);
+        os << obj.getBuffer();
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            LOG(WARNING) << "fail to write jit object file "
+                         << tmp_path.str().str();
+            ::llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    ec = ::llvm::sys::fs::rename(tmp_path, path);
+    if (ec) {
+        LOG(WARNING) << "fail to rename jit object file to " << path << ": "
+                     << ec.message();
+        ::llvm::sys::fs::remove(tmp_path);
+        return;
+    }
+    DLOG(INFO) << "store jit object to " << path;
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace hybridse {
+namespace vm {
+
+// Content addressed object cache of the jit on local disk.
+//
+// The object file of a module is stored under the hash of its optimized ir,
+// the target triple and the host cpu. The ir already carries everything the
+// plan, the engine options and the udf library put into the generated code,
+// so a module compiled again after a restart is loaded from disk instead of
+// going through the llvm backend, and any change of them is a cache miss.
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    explicit JitObjectCache(const std::string& dir);
+    ~JitObjectCache() override {}
+
+    void notifyObjectCompiled(const ::llvm::Module* m,
+                              ::llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(
+        const ::llvm::Module* m) override;
+
+    uint64_t GetHitCnt() const { return hit_cnt_.load(); }
+    uint64_t GetMissCnt() const { return miss_cnt_.load(); }
+
+ private:
+    std::string GetPath(const ::llvm::Module* m) const;
+
+    const std::string dir_;
+    bool available_;
+    std::mutex mu_;
+    // the path of the modules missed in getObject, to be stored once compiled
+    std::map<const ::llvm::Module*, std::string> pending_paths_;
+    std::atomic<uint64_t> hit_cnt_;
+    std::atomic<uint64_t> miss_cnt_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
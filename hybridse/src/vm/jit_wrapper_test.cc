@@ -15,10 +15,12 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <unistd.h>
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
+#include "vm/jit.h"
 #include "vm/simple_catalog.h"
 #include "vm/sql_compiler.h"
 
@@ -130,6 +132,59 @@ TEST_F(JitWrapperTest, test_mcjit) {
 }
 #endif
 
+TEST_F(JitWrapperTest, test_object_cache) {
+    std::string cache_dir =
+        "/tmp/jit_object_cache_" + std::to_string(getpid());
+    EngineOptions options;
+    options.SetKeepIr(true);
+    auto catalog = GetTestCatalog();
+    auto compile_info =
+        Compile("select col_1, col_2 + 1 from t1;", options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    auto &sql_context = compile_info->get_sql_context();
+    std::string ir_str = sql_context.ir;
+    ASSERT_FALSE(ir_str.empty());
+    auto fn_name = sql_context.physical_plan->GetFnInfos()[0]->fn_name();
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+
+    // the first one compiles and stores the object, the second one loads it
+    JitOptions jit_options;
+    jit_options.SetObjectCacheDir(cache_dir);
+    for (int i = 0; i < 2; i++) {
+        auto jit = std::unique_ptr<HybridSeJitWrapper>(
+            HybridSeJitWrapper::Create(jit_options));
+        ASSERT_TRUE(jit->Init());
+        HybridSeJitWrapper::InitJitSymbols(jit.get());
+        base::RawBuffer ir_buf(const_cast<char *>(ir_str.data()),
+                               ir_str.size());
+        ASSERT_TRUE(jit->AddModuleFromBuffer(ir_buf));
+        auto fn = jit->FindFunction(fn_name);
+        ASSERT_TRUE(fn != nullptr);
+
+        auto object_cache =
+            dynamic_cast<HybridSeLlvmJitWrapper *>(jit.get())
+                ->GetObjectCache();
+        ASSERT_TRUE(object_cache != nullptr);
+        ASSERT_EQ(i == 0 ? 0u : 1u, object_cache->GetHitCnt());
+        ASSERT_EQ(i == 0 ? 1u : 0u, object_cache->GetMissCnt());
+
+        int8_t buf[1024];
+        codec::RowBuilder row_builder(*schema);
+        row_builder.SetBuffer(buf, 1024);
+        row_builder.AppendDouble(3.14);
+        row_builder.AppendInt64(42);
+        hybridse::codec::Row empty_parameter;
+        hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+        hybridse::codec::Row output =
+            CoreAPI::RowProject(fn, row, empty_parameter);
+        codec::RowView row_view(*schema, output.buf(), output.size());
+        int64_t c2;
+        ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+        ASSERT_EQ(c2, 43);
+    }
+    ASSERT_EQ(0, system(("rm -rf " + cache_dir).c_str()));
+}
+
 TEST_F(JitWrapperTest, test_window) {
     EngineOptions options;
     options.SetKeepIr(true);
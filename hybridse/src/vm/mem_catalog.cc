@@ -57,6 +57,17 @@ const Row& hybridse::vm::MemTimeTableIterator::GetValue() {
 void MemTimeTableIterator::Next() { iter_++; }
 bool MemTimeTableIterator::Valid() const { return end_iter_ > iter_; }
 bool MemTimeTableIterator::IsSeekable() const { return true; }
+size_t MemTimeTableIterator::NextBatch(const Row** values, uint64_t* keys,
+                                       size_t n) {
+    size_t cnt = 0;
+    for (; cnt < n && iter_ < end_iter_; ++cnt, ++iter_) {
+        values[cnt] = &iter_->second;
+        if (keys != nullptr) {
+            keys[cnt] = iter_->first;
+        }
+    }
+    return cnt;
+}
 MemWindowIterator::MemWindowIterator(const MemSegmentMap* partitions,
                                      const Schema* schema)
     : WindowIterator(),
@@ -326,6 +337,17 @@ void MemTableIterator::Next() {
 }
 const Row& MemTableIterator::GetValue() { return *iter_; }
 bool MemTableIterator::IsSeekable() const { return true; }
+size_t MemTableIterator::NextBatch(const Row** values, uint64_t* keys,
+                                   size_t n) {
+    size_t cnt = 0;
+    for (; cnt < n && iter_ < end_iter_; ++cnt, ++iter_, ++key_) {
+        values[cnt] = &*iter_;
+        if (keys != nullptr) {
+            keys[cnt] = key_;
+        }
+    }
+    return cnt;
+}
 
 /**
  * Iterator implementation for request union table
@@ -367,6 +389,24 @@ class RequestUnionIterator : public RowIterator {
         window_iter_start_ = false;
     }
     bool IsSeekable() const override { return window_iter_->IsSeekable(); }
+    size_t NextBatch(const Row** values, uint64_t* keys, size_t n) override {
+        if (window_iter_start_) {
+            return window_iter_->NextBatch(values, keys, n);
+        }
+        if (n == 0) {
+            return 0;
+        }
+        // the window is read row by row after the request row unless it
+        // supports the batch as well
+        values[0] = request_row_;
+        if (keys != nullptr) {
+            keys[0] = request_ts_;
+        }
+        window_iter_start_ = true;
+        return 1 + window_iter_->NextBatch(values + 1,
+                                           keys != nullptr ? keys + 1 : nullptr,
+                                           n - 1);
+    }
 
  private:
     uint64_t request_ts_;
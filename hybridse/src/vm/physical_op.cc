@@ -1283,10 +1283,16 @@ void PhysicalRequestAggUnionNode::Print(std::ostream& output, const std::string&
 }
 
 void PhysicalRequestAggUnionNode::PrintChildren(std::ostream& output, const std::string& tab) const {
-    if (3 != producers_.size() || nullptr == producers_[0] || nullptr == producers_[1] || nullptr == producers_[2]) {
+    if (producers_.size() < 2) {
         LOG(WARNING) << "fail to print PhysicalRequestAggUnionNode children";
         return;
     }
+    for (auto producer : producers_) {
+        if (nullptr == producer) {
+            LOG(WARNING) << "fail to print PhysicalRequestAggUnionNode children";
+            return;
+        }
+    }
     producers_[0]->Print(output, tab + INDENT);
     for (size_t i = 1; i < producers_.size(); i++) {
         output << "\n";
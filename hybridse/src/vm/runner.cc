@@ -16,6 +16,9 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -562,13 +565,16 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
         LOG(WARNING) << status;
         return fail;
     }
-    auto agg_table_task = Build(node->producers().at(2), status);
-    auto agg_table = agg_table_task.GetRoot();
-    if (!agg_table_task.IsValid()) {
-        status.msg = "fail to build agg_table input runner";
-        status.code = common::kExecutionPlanError;
-        LOG(WARNING) << status;
-        return fail;
+    std::vector<ClusterTask> agg_table_tasks;
+    for (size_t i = 2; i < node->producers().size(); i++) {
+        auto agg_table_task = Build(node->producers().at(i), status);
+        if (!agg_table_task.IsValid()) {
+            status.msg = "fail to build agg_table input runner";
+            status.code = common::kExecutionPlanError;
+            LOG(WARNING) << status;
+            return fail;
+        }
+        agg_table_tasks.push_back(agg_table_task);
     }
     auto op = dynamic_cast<const PhysicalRequestAggUnionNode*>(node);
     RequestAggUnionRunner* runner = nullptr;
@@ -580,10 +586,15 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
     if (!op->instance_not_in_window()) {
         index_key = op->window_.index_key();
         runner->AddWindowUnion(op->window_, base_table);
-        runner->AddWindowUnion(op->agg_window_, agg_table);
+        for (size_t i = 0; i < agg_table_tasks.size(); i++) {
+            runner->AddWindowUnion(op->agg_windows_[i], agg_table_tasks[i].GetRoot());
+        }
     }
-    auto task = RegisterTask(node, MultipleInherit({&request_task, &base_table_task, &agg_table_task}, runner,
-                                                   index_key, kRightBias));
+    std::vector<const ClusterTask*> children({&request_task, &base_table_task});
+    for (auto& agg_table_task : agg_table_tasks) {
+        children.push_back(&agg_table_task);
+    }
+    auto task = RegisterTask(node, MultipleInherit(children, runner, index_key, kRightBias));
     if (!runner->InitAggregator()) {
         return fail;
     } else {
@@ -613,8 +624,8 @@ ClusterTask RunnerBuilder::MultipleInherit(const std::vector<const ClusterTask*>
         return ClusterTask();
     }
 
-    if (children.size() < 3) {
-        LOG(WARNING) << "MultipleInherit should be called for children size >= 3, but children.size() = "
+    if (children.size() < 2) {
+        LOG(WARNING) << "MultipleInherit should be called for children size >= 2, but children.size() = "
                      << children.size();
         return ClusterTask();
     }
@@ -1590,6 +1601,77 @@ std::shared_ptr<DataHandler> RequestLastJoinRunner::Run(
     }
 }
 
+std::shared_ptr<DataHandlerList> RequestLastJoinRunner::BatchRequestRun(
+    RunnerContext& ctx) {
+    // fallback to the row by row way unless the right input is the same
+    // partition for all requests
+    if (need_batch_cache_ || ctx.GetRequestSize() <= 1 ||
+        producers_.size() < 2u) {
+        return Runner::BatchRequestRun(ctx);
+    }
+    if (need_cache_) {
+        auto cached = ctx.GetBatchCache(id_);
+        if (cached != nullptr) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+            return cached;
+        }
+    }
+    auto left = producers_[0]->BatchRequestRun(ctx);
+    auto right = producers_[1]->BatchRequestRun(ctx);
+    size_t request_size = ctx.GetRequestSize();
+    std::vector<Row> left_rows(request_size);
+    std::shared_ptr<DataHandler> right_handler;
+    bool batch_join = left && right;
+    for (size_t idx = 0; batch_join && idx < request_size; idx++) {
+        auto left_handler = left->Get(idx);
+        if (!left_handler || kRowHandler != left_handler->GetHandlerType()) {
+            batch_join = false;
+            break;
+        }
+        left_rows[idx] =
+            std::dynamic_pointer_cast<RowHandler>(left_handler)->GetValue();
+        auto handler = right->Get(idx);
+        if (!handler || kPartitionHandler != handler->GetHandlerType() ||
+            (right_handler && right_handler != handler)) {
+            batch_join = false;
+        }
+        right_handler = handler;
+    }
+
+    auto outputs = std::make_shared<DataHandlerVector>();
+    if (batch_join) {
+        auto joined_rows = join_gen_.RowLastJoinBatch(
+            left_rows, std::dynamic_pointer_cast<PartitionHandler>(right_handler),
+            ctx.GetParameterRow());
+        for (auto& joined : joined_rows) {
+            outputs->Add(std::make_shared<MemRowHandler>(
+                output_right_only_ ? join_gen_.DropLeftSlices(joined) : joined));
+        }
+    } else {
+        for (size_t idx = 0; idx < request_size; idx++) {
+            outputs->Add(Run(ctx, {left ? left->Get(idx) : nullptr,
+                                   right ? right->Get(idx) : nullptr}));
+        }
+    }
+    if (ctx.is_debug()) {
+        std::ostringstream oss;
+        oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_
+            << (batch_join ? ", batch join" : "") << "\n";
+        for (size_t idx = 0; idx < outputs->GetSize(); idx++) {
+            if (idx >= MAX_DEBUG_BATCH_SiZE) {
+                oss << ">= MAX_DEBUG_BATCH_SiZE...\n";
+                break;
+            }
+            Runner::PrintData(oss, output_schemas_, outputs->Get(idx));
+        }
+        LOG(INFO) << oss.str();
+    }
+    if (need_cache_) {
+        ctx.SetBatchCache(id_, outputs);
+    }
+    return outputs;
+}
+
 std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
                                                  const std::vector<std::shared_ptr<DataHandler>>& inputs) {
     auto fail_ptr = std::shared_ptr<DataHandler>();
@@ -1888,13 +1970,37 @@ std::shared_ptr<TableHandler> SortGenerator::Sort(
 }
 Row JoinGenerator::RowLastJoinDropLeftSlices(
     const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter) {
-    Row joined = RowLastJoin(left_row, right, parameter);
+    return DropLeftSlices(RowLastJoin(left_row, right, parameter));
+}
+Row JoinGenerator::DropLeftSlices(const Row& joined) {
     Row right_row(joined.GetSlice(left_slices_));
     for (size_t offset = 1; offset < right_slices_; offset++) {
         right_row.Append(joined.GetSlice(left_slices_ + offset));
     }
     return right_row;
 }
+std::vector<Row> JoinGenerator::RowLastJoinBatch(
+    const std::vector<Row>& left_rows,
+    std::shared_ptr<PartitionHandler> right, const Row& parameter) {
+    if (!index_key_gen_.Valid()) {
+        LOG(WARNING) << "can't join right partition table when partition "
+                        "keys is empty";
+        return std::vector<Row>(left_rows.size());
+    }
+    std::vector<std::string> keys;
+    keys.reserve(left_rows.size());
+    for (auto& left_row : left_rows) {
+        keys.push_back(index_key_gen_.Gen(left_row, parameter));
+    }
+    auto segments = right->GetSegments(keys);
+    std::vector<Row> joined_rows;
+    joined_rows.reserve(left_rows.size());
+    for (size_t i = 0; i < left_rows.size(); i++) {
+        joined_rows.push_back(
+            RowLastJoinTable(left_rows[i], segments[i], parameter));
+    }
+    return joined_rows;
+}
 Row JoinGenerator::RowLastJoin(const Row& left_row,
                                std::shared_ptr<DataHandler> right,
                                const Row& parameter) {
@@ -2714,6 +2820,18 @@ std::unique_ptr<BaseAggregator> RequestAggUnionRunner::CreateAggregator() const
             return MakeSameTypeAggregator<MinAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
         case kMax:
             return MakeSameTypeAggregator<MaxAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+        case kDistinctCount:
+            return MakeSameTypeAggregator<DistinctCountAggregator>(agg_col_type_,
+                                                                   *output_schemas_->GetOutputSchema());
+        case kMedian:
+            return std::make_unique<MedianAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema());
+        case kVarSamp:
+        case kVarPop:
+        case kStddev:
+        case kStddevPop:
+            return std::make_unique<VarianceAggregator>(agg_col_type_, *output_schemas_->GetOutputSchema(),
+                                                        agg_type_ == kVarSamp || agg_type_ == kStddev,
+                                                        agg_type_ == kStddev || agg_type_ == kStddevPop);
         default:
             LOG(ERROR) << "RequestAggUnionRunner does not support for op " << func_->GetName();
             return nullptr;
@@ -2724,16 +2842,21 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
     auto fail_ptr = std::shared_ptr<DataHandler>();
-    if (inputs.size() < 3u) {
-        LOG(WARNING) << "inputs size < 3";
+    // the window answered by the window aggregate cache has no agg table
+    if (inputs.size() < 2u) {
+        LOG(WARNING) << "inputs size < 2";
         return std::shared_ptr<DataHandler>();
     }
     auto request_handler = inputs[0];
     auto base_handler = inputs[1];
-    auto agg_handler = inputs[2];
-    if (!request_handler || !base_handler || !agg_handler) {
+    if (!request_handler || !base_handler) {
         return std::shared_ptr<DataHandler>();
     }
+    for (size_t i = 2; i < inputs.size(); i++) {
+        if (!inputs[i]) {
+            return std::shared_ptr<DataHandler>();
+        }
+    }
     if (kRowHandler != request_handler->GetHandlerType()) {
         return std::shared_ptr<DataHandler>();
     }
@@ -2753,15 +2876,30 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
 
     auto& key_gen = windows_union_gen_.windows_gen_[0].index_seek_gen_.index_key_gen_;
     std::string key = key_gen.Gen(request, ctx.GetParameterRow());
-    // do not use codegen to gen the union outputs for aggr segment
-    union_inputs.pop_back();
+    auto cached_window = RequestCachedWindow(request, key, union_inputs[0], ts_gen);
+    if (cached_window) {
+        if (ctx.is_debug()) {
+            std::ostringstream oss;
+            PrintData(oss, output_schemas(), cached_window);
+            LOG(INFO) << "Request AGG UNION output from window aggr cache: " << oss.str();
+        }
+        return cached_window;
+    }
+    // do not use codegen to gen the union outputs for aggr segments
+    std::vector<std::shared_ptr<DataHandler>> agg_inputs(union_inputs.begin() + 1, union_inputs.end());
+    union_inputs.resize(1);
 
     auto union_segments =
         windows_union_gen_.GetRequestWindows(request, ctx.GetParameterRow(), union_inputs);
     // code_gen result of agg_segment is not correct. we correct the result here
-    auto agg_segment = std::dynamic_pointer_cast<PartitionHandler>(union_inputs[1])->GetSegment(key);
-    if (agg_segment) {
-        union_segments.emplace_back(agg_segment);
+    bool has_agg_segment = false;
+    for (auto& agg_input : agg_inputs) {
+        auto agg_partition = std::dynamic_pointer_cast<PartitionHandler>(agg_input);
+        auto agg_segment = agg_partition ? agg_partition->GetSegment(key) : nullptr;
+        if (agg_segment) {
+            union_segments.emplace_back(agg_segment);
+            has_agg_segment = true;
+        }
     }
 
     if (ctx.is_debug()) {
@@ -2775,7 +2913,7 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
     }
 
     std::shared_ptr<TableHandler> window;
-    if (agg_segment) {
+    if (has_agg_segment || agg_inputs.empty()) {
         window = RequestUnionWindow(request, union_segments, ts_gen, range_gen_.window_range_, output_request_row_,
                                     exclude_current_time_);
     } else {
@@ -2794,13 +2932,105 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
     return window;
 }
 
+std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestCachedWindow(
+    const Row& request, const std::string& key, std::shared_ptr<DataHandler> base_handler, int64_t ts_gen) const {
+    // only a rows_range window ending at the current row slides with the requests
+    const auto& window_range = range_gen_.window_range_;
+    if (ts_gen < 0 || window_range.frame_type_ != Window::kFrameRowsRange || window_range.end_offset_ != 0 ||
+        window_range.max_size_ > 0) {
+        return nullptr;
+    }
+    auto base_partition = std::dynamic_pointer_cast<PartitionHandler>(base_handler);
+    if (!base_partition) {
+        return nullptr;
+    }
+    int64_t start = std::max<int64_t>(0, ts_gen + window_range.start_offset_);
+    int64_t end = exclude_current_time_ ? std::max<int64_t>(0, ts_gen - 1) : ts_gen;
+    std::string agg_val;
+    if (!base_partition->GetWindowAggr(key, func_->GetName(), agg_col_name_, start, end, &agg_val)) {
+        return nullptr;
+    }
+    auto aggregator = CreateAggregator();
+    if (!aggregator) {
+        return nullptr;
+    }
+    if (output_request_row_) {
+        UpdateBaseAggregator(aggregator.get(), request);
+    }
+    if (!agg_val.empty()) {
+        aggregator->Update(agg_val);
+    }
+    auto window_table = std::make_shared<MemTimeTableHandler>();
+    window_table->AddRow(start, aggregator->Output());
+    return window_table;
+}
+
+void RequestAggUnionRunner::UpdateBaseAggregator(BaseAggregator* aggregator, const Row& row) const {
+    const auto row_parser = producers_[1]->row_parser();
+    if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_name_)) {
+        return;
+    }
+
+    auto type = aggregator->type();
+    if (agg_type_ == kCount) {
+        dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
+        return;
+    }
+    if (agg_col_name_.empty()) {
+        return;
+    }
+    switch (type) {
+        case type::Type::kInt16: {
+            int16_t val = 0;
+            row_parser->GetValue(row, agg_col_name_, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::Type::kDate:
+        case type::Type::kInt32: {
+            int32_t val = 0;
+            row_parser->GetValue(row, agg_col_name_, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::Type::kTimestamp:
+        case type::Type::kInt64: {
+            int64_t val = 0;
+            row_parser->GetValue(row, agg_col_name_, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::Type::kFloat: {
+            float val = 0;
+            row_parser->GetValue(row, agg_col_name_, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::Type::kDouble: {
+            double val = 0;
+            row_parser->GetValue(row, agg_col_name_, type, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        case type::Type::kVarchar: {
+            std::string val;
+            row_parser->GetString(row, agg_col_name_, &val);
+            AggregatorUpdate(aggregator, val);
+            break;
+        }
+        default:
+            LOG(ERROR) << "Not support type: " << Type_Name(type);
+            break;
+    }
+}
+
 std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     const Row& request, std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
     const WindowRange& window_range, const bool output_request_row, const bool exclude_current_time) const {
-    // TOOD(zhanghao): for now, we only support AggUnion with 1 base table and 1 agg table
+    // union_segments are the base table and then the agg tables, from the coarsest bucket size to the finest one
     size_t unions_cnt = union_segments.size();
-    if (unions_cnt != 2) {
-        LOG(ERROR) << "Not support of RequestAggUnion with more than 2 unions";
+    if (unions_cnt < 1) {
+        LOG(ERROR) << "Not support of RequestAggUnion without base table";
         return nullptr;
     }
 
@@ -2808,13 +3038,14 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         LOG(ERROR) << "base table is empty";
         return nullptr;
     }
-    if (!union_segments[1]) {
-        LOG(ERROR) << "agg table is empty";
-        return nullptr;
+    for (size_t i = 1; i < unions_cnt; i++) {
+        if (!union_segments[i]) {
+            LOG(ERROR) << "agg table is empty";
+            return nullptr;
+        }
     }
 
-    const auto base_row_parser = producers_[1]->row_parser();
-    const auto agg_row_parser = producers_[2]->row_parser();
+    const auto agg_row_parser = producers_.size() > 2 ? producers_[2]->row_parser() : nullptr;
 
     int64_t start = 0;
     int64_t end = INT64_MAX;
@@ -2839,62 +3070,8 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     int64_t request_key = ts_gen > 0 ? ts_gen : 0;
 
     auto aggregator = CreateAggregator();
-    auto update_base_aggregator = [aggregator = aggregator.get(), row_parser = base_row_parser, this](const Row& row) {
-        if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_name_)) {
-            return;
-        }
-
-        auto type = aggregator->type();
-        if (agg_type_ == kCount) {
-            dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(1);
-            return;
-        }
-        if (agg_col_name_.empty()) {
-            return;
-        }
-        switch (type) {
-            case type::Type::kInt16: {
-                int16_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kDate:
-            case type::Type::kInt32: {
-                int32_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kTimestamp:
-            case type::Type::kInt64: {
-                int64_t val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kFloat: {
-                float val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kDouble: {
-                double val = 0;
-                row_parser->GetValue(row, agg_col_name_, type, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            case type::Type::kVarchar: {
-                std::string val;
-                row_parser->GetString(row, agg_col_name_, &val);
-                AggregatorUpdate(aggregator, val);
-                break;
-            }
-            default:
-                LOG(ERROR) << "Not support type: " << Type_Name(type);
-                break;
-        }
+    auto update_base_aggregator = [aggregator = aggregator.get(), this](const Row& row) {
+        UpdateBaseAggregator(aggregator, row);
     };
 
     auto update_agg_aggregator = [aggregator = aggregator.get(), row_parser = agg_row_parser](const Row& row) {
@@ -2926,121 +3103,104 @@ std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
         DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
         return window_table;
     }
-    base_it->Seek(end);
 
-    auto agg_it = union_segments[1]->GetIterator();
-    if (agg_it) {
-         agg_it->Seek(end);
-    } else {
-        LOG(WARNING) << "Agg window is empty. Use base window only";
-    }
-
-    // we'll iterate over the following ranges:
-    // - base(end_base, end] if end_base < end
-    // - agg[start_base, end_base]
-    // - base[start, start_base) if start < start_base
-    int64_t end_base = start;
-    int64_t start_base = start + 1;
-    if (agg_it && agg_it->Valid()) {
-        int64_t ts_start = agg_it->GetKey();
-        int64_t ts_end = -1;
-        agg_row_parser->GetValue(agg_it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end);
-
-        if (ts_end > end) {  // [ts_start, ts_end] covers beyond the [start, end] region
-            end_base = ts_start;
-            agg_it->Next();
-            if (agg_it->Valid()) {
-                agg_row_parser->GetValue(agg_it->GetValue(), "ts_end", type::Type::kTimestamp, &ts_end);
-                end_base = ts_end;
-            } else {
-                // only base table will be used
-                end_base = start;
-                start_base = start + 1;
-            }
-        } else {
-            end_base = ts_end;
+    std::vector<std::unique_ptr<RowIterator>> agg_its;
+    for (size_t i = 1; i < unions_cnt; i++) {
+        agg_its.push_back(union_segments[i]->GetIterator());
+        if (!agg_its.back()) {
+            LOG(WARNING) << "Agg window is empty. Use the finer agg windows or base window instead";
         }
     }
 
-    // iterate over base table from end (inclusive) to end_base (exclusive)
-    if (end_base < end) {
-        while (base_it->Valid()) {
-            if (max_size > 0 && cnt >= max_size) {
-                break;
+    // aggregate the rows within [lo, hi] in descending order with the agg tables from `level`, return false once
+    // the window is exceeded. For the agg table of each level, we'll iterate over the following ranges:
+    // - (end_agg, hi] with the finer levels, where end_agg is the ts_end of the first bucket within [lo, hi]
+    // - the buckets within [lo, hi]
+    // - [lo, start_agg) with the finer levels, where start_agg is the ts_start of the last bucket within [lo, hi]
+    // so that the coarse buckets answer the middle of the window and the finer ones answer the edges only
+    std::function<bool(size_t, int64_t, int64_t)> aggregate_range = [&](size_t level, int64_t lo, int64_t hi) {
+        if (lo > hi) {
+            return true;
+        }
+        if (level == agg_its.size()) {
+            base_it->Seek(hi);
+            while (base_it->Valid()) {
+                if (max_size > 0 && cnt >= max_size) {
+                    return false;
+                }
+                int64_t ts = base_it->GetKey();
+                if (ts < lo) {
+                    break;
+                }
+                auto range_status =
+                    window_range.GetWindowPositionStatus(cnt > rows_start_preceding, ts > end, ts < start);
+                if (WindowRange::kExceedWindow == range_status) {
+                    return false;
+                }
+                if (WindowRange::kInWindow == range_status) {
+                    update_base_aggregator(base_it->GetValue());
+                    cnt++;
+                }
+                base_it->Next();
             }
+            return true;
+        }
 
-            int64_t ts = base_it->GetKey();
-            if (ts <= end_base) break;
-
-            auto range_status = window_range.GetWindowPositionStatus(cnt > rows_start_preceding, ts > end, ts < start);
-            if (WindowRange::kExceedWindow == range_status) {
-                break;
+        auto& agg_it = agg_its[level];
+        if (!agg_it) {
+            return aggregate_range(level + 1, lo, hi);
+        }
+        agg_it->Seek(hi);
+        bool found_bucket = false;
+        int64_t rest_hi = hi;
+        int64_t last_ts_start = INT64_MAX;
+        while (agg_it->Valid()) {
+            int64_t ts_start = agg_it->GetKey();
+            // for mem-table, updating will inserts duplicate entries
+            if (last_ts_start == ts_start) {
+                DLOG(INFO) << "Found duplicate entries in agg table for ts_start = " << ts_start;
+                agg_it->Next();
+                continue;
             }
-            if (WindowRange::kInWindow == range_status) {
-                update_base_aggregator(base_it->GetValue());
-                cnt++;
+            const Row& row = agg_it->GetValue();
+            int64_t ts_end = -1;
+            agg_row_parser->GetValue(row, "ts_end", type::Type::kTimestamp, &ts_end);
+            if (ts_end > hi) {
+                // [ts_start, ts_end] covers beyond the [lo, hi] region
+                agg_it->Next();
+                continue;
             }
-
-            base_it->Next();
-        }
-    }
-
-    // iterate over agg table from end_base until start (both inclusive)
-    int64_t last_ts_start = INT64_MAX;
-    while (agg_it && agg_it->Valid()) {
-        if (max_size > 0 && cnt >= max_size) {
-            break;
-        }
-
-        int64_t ts_start = agg_it->GetKey();
-        // for mem-table, updating will inserts duplicate entries
-        if (last_ts_start == ts_start) {
-            DLOG(INFO) << "Found duplicate entries in agg table for ts_start = " << ts_start;
-            continue;
-        }
-        last_ts_start = ts_start;
-
-        const Row& row = agg_it->GetValue();
-        int64_t ts_end = -1;
-        agg_row_parser->GetValue(row, "ts_end", type::Type::kTimestamp, &ts_end);
-        int num_rows = 0;
-        agg_row_parser->GetValue(row, "num_rows", type::Type::kInt32, &num_rows);
-
-        // FIXME(zhanghao): check cnt and rows_start_preceding meanings
-        int next_incr = num_rows > 0 ? num_rows - 1 : 0;
-        auto range_status = window_range.GetWindowPositionStatus(cnt + next_incr > rows_start_preceding, ts_start > end,
-                                                                 ts_start < start);
-        if ((max_size > 0 && cnt + next_incr >= max_size) || WindowRange::kExceedWindow == range_status) {
-            start_base = ts_end + 1;
-            break;
-        }
-        if (WindowRange::kInWindow == range_status) {
-            update_agg_aggregator(row);
-            cnt += num_rows;
-        }
-
-        start_base = ts_start;
-        agg_it->Next();
-    }
-
-    if (start_base > 0) {
-        // iterate over base table from start_base (exclusive) to start (inclusive)
-        base_it->Seek(start_base - 1);
-        while (base_it->Valid()) {
-            int64_t ts = base_it->GetKey();
-            auto range_status = window_range.GetWindowPositionStatus(static_cast<int64_t>(cnt) > rows_start_preceding,
-                                                                     ts > end, static_cast<int64_t>(ts) < start);
-            if (WindowRange::kExceedWindow == range_status) {
+            if (ts_start < lo) {
                 break;
             }
+            if (!found_bucket) {
+                found_bucket = true;
+                if (!aggregate_range(level + 1, ts_end + 1, hi)) {
+                    return false;
+                }
+            }
+            last_ts_start = ts_start;
+
+            int num_rows = 0;
+            agg_row_parser->GetValue(row, "num_rows", type::Type::kInt32, &num_rows);
+            // FIXME(zhanghao): check cnt and rows_start_preceding meanings
+            int next_incr = num_rows > 0 ? num_rows - 1 : 0;
+            auto range_status = window_range.GetWindowPositionStatus(cnt + next_incr > rows_start_preceding,
+                                                                     ts_start > end, ts_start < start);
+            if ((max_size > 0 && cnt + next_incr >= max_size) || WindowRange::kExceedWindow == range_status) {
+                // the window ends within this bucket, leave it to the finer levels
+                return aggregate_range(level + 1, lo, ts_end);
+            }
             if (WindowRange::kInWindow == range_status) {
-                update_base_aggregator(base_it->GetValue());
-                cnt++;
+                update_agg_aggregator(row);
+                cnt += num_rows;
             }
-
-            base_it->Next();
+            rest_hi = ts_start - 1;
+            agg_it->Next();
         }
-    }
+        return aggregate_range(level + 1, lo, rest_hi);
+    };
+    aggregate_range(0, start, end);
 
     window_table->AddRow(start, aggregator->Output());
     DLOG(INFO) << "REQUEST AGG UNION cnt = " << window_table->GetCount();
@@ -3225,6 +3385,251 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     return window_table;
 }
 
+// merge the union segments in descending key order on demand, the merged rows
+// are kept so that the windows of all requests of the same key share them
+class UnionSegmentsMerger {
+ public:
+    UnionSegmentsMerger(
+        const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+        uint64_t end)
+        : iters_(union_segments.size()),
+          status_(union_segments.size()),
+          rows_(std::make_shared<MemTimeTable>()) {
+        for (size_t i = 0; i < union_segments.size(); i++) {
+            if (!union_segments[i]) {
+                continue;
+            }
+            iters_[i] = union_segments[i]->GetIterator();
+            if (!iters_[i]) {
+                continue;
+            }
+            iters_[i]->Seek(end);
+            if (iters_[i]->Valid()) {
+                status_[i] = IteratorStatus(iters_[i]->GetKey());
+            }
+        }
+    }
+    // position of the first row whose key <= end
+    size_t Seek(uint64_t end) {
+        while (rows_->empty() || rows_->back().first > end) {
+            if (!MergeNext()) {
+                break;
+            }
+        }
+        return std::lower_bound(rows_->begin(), rows_->end(), end,
+                                [](const std::pair<uint64_t, Row>& row,
+                                   uint64_t key) { return row.first > key; }) -
+               rows_->begin();
+    }
+    bool Valid(size_t pos) {
+        while (rows_->size() <= pos) {
+            if (!MergeNext()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    uint64_t GetKey(size_t pos) const { return (*rows_)[pos].first; }
+    // the merged rows, the windows are views over them
+    std::shared_ptr<const MemTimeTable> GetRows() const { return rows_; }
+
+ private:
+    bool MergeNext() {
+        int32_t pos = IteratorStatus::FindFirstIteratorWithMaximizeKey(status_);
+        if (-1 == pos) {
+            return false;
+        }
+        rows_->emplace_back(status_[pos].key_, iters_[pos]->GetValue());
+        iters_[pos]->Next();
+        if (!iters_[pos]->Valid()) {
+            status_[pos].MarkInValid();
+        } else {
+            status_[pos].set_key(iters_[pos]->GetKey());
+        }
+        return true;
+    }
+
+    std::vector<std::unique_ptr<RowIterator>> iters_;
+    std::vector<IteratorStatus> status_;
+    std::shared_ptr<MemTimeTable> rows_;
+};
+
+std::vector<std::shared_ptr<TableHandler>>
+RequestUnionRunner::RequestUnionWindows(
+    const std::vector<Row>& requests, const std::vector<int64_t>& ts_gens,
+    std::vector<std::shared_ptr<TableHandler>> union_segments,
+    const WindowRange& window_range, bool output_request_row,
+    bool exclude_current_time, bool exclude_current_row) {
+    // the same bounds as RequestUnionWindow
+    std::vector<uint64_t> starts(requests.size(), 0);
+    std::vector<uint64_t> ends(requests.size(), UINT64_MAX);
+    uint64_t max_end = 0;
+    for (size_t i = 0; i < requests.size(); i++) {
+        int64_t ts_gen = ts_gens[i];
+        if (ts_gen >= 0) {
+            starts[i] = (ts_gen + window_range.start_offset_) < 0
+                            ? 0
+                            : (ts_gen + window_range.start_offset_);
+            if (exclude_current_time && 0 == window_range.end_offset_) {
+                ends[i] = (ts_gen - 1) < 0 ? 0 : (ts_gen - 1);
+            } else {
+                ends[i] = (ts_gen + window_range.end_offset_) < 0
+                              ? 0
+                              : (ts_gen + window_range.end_offset_);
+            }
+        }
+        max_end = std::max(max_end, ends[i]);
+    }
+
+    UnionSegmentsMerger merger(union_segments, max_end);
+    // the window of a request is the request row and the merged rows
+    // [begins[i], ends[i]), only the positions are kept while merging
+    std::vector<size_t> begins(requests.size(), 0);
+    std::vector<size_t> row_ends(requests.size(), 0);
+    for (size_t i = 0; i < requests.size(); i++) {
+        uint64_t start = starts[i];
+        uint64_t end = ends[i];
+        uint64_t rows_start_preceding = 0;
+        uint64_t max_size = 0;
+        if (ts_gens[i] >= 0) {
+            rows_start_preceding = window_range.start_row_;
+            max_size = window_range.max_size_;
+            // see RequestUnionWindow for the extra row of exclude current_row
+            if (exclude_current_row && max_size > 0) {
+                max_size++;
+            }
+        }
+        uint64_t request_key =
+            ts_gens[i] > 0 ? static_cast<uint64_t>(ts_gens[i]) : 0;
+
+        uint64_t cnt = 0;
+        auto range_status = window_range.GetWindowPositionStatus(
+            cnt > rows_start_preceding, window_range.end_offset_ < 0,
+            request_key < start);
+        if (WindowRange::kInWindow == range_status) {
+            cnt++;
+        }
+        // the rows after the seek are not before the window, so the rows in
+        // the window are contiguous
+        size_t pos = merger.Seek(end);
+        begins[i] = pos;
+        for (; merger.Valid(pos); pos++) {
+            if (max_size > 0 && cnt >= max_size) {
+                break;
+            }
+            uint64_t key = merger.GetKey(pos);
+            auto range_status = window_range.GetWindowPositionStatus(
+                cnt > rows_start_preceding, key > end, key < start);
+            if (WindowRange::kExceedWindow == range_status) {
+                break;
+            }
+            cnt++;
+        }
+        row_ends[i] = pos;
+    }
+
+    auto rows = merger.GetRows();
+    std::vector<std::shared_ptr<TableHandler>> windows(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        std::shared_ptr<TableHandler> window_table =
+            std::make_shared<MemTimeTableSliceHandler>(rows, begins[i],
+                                                       row_ends[i]);
+        if (output_request_row) {
+            uint64_t request_key =
+                ts_gens[i] > 0 ? static_cast<uint64_t>(ts_gens[i]) : 0;
+            window_table = std::make_shared<RequestUnionTableHandler>(
+                request_key, requests[i], window_table);
+        }
+        windows[i] = window_table;
+    }
+    return windows;
+}
+
+std::shared_ptr<DataHandlerList> RequestUnionRunner::BatchRequestRun(
+    RunnerContext& ctx) {
+    // the common windows are computed once, fallback to the row by row way
+    if (need_batch_cache_ || ctx.GetRequestSize() <= 1 ||
+        producers_.size() < 2u) {
+        return Runner::BatchRequestRun(ctx);
+    }
+    if (need_cache_) {
+        auto cached = ctx.GetBatchCache(id_);
+        if (cached != nullptr) {
+            DLOG(INFO) << "RUNNER ID " << id_ << " HIT CACHE!";
+            return cached;
+        }
+    }
+    auto left = producers_[0]->BatchRequestRun(ctx);
+    auto right = producers_[1]->BatchRequestRun(ctx);
+    size_t request_size = ctx.GetRequestSize();
+    std::vector<Row> requests(request_size);
+    for (size_t idx = 0; idx < request_size; idx++) {
+        auto left_handler = left ? left->Get(idx) : nullptr;
+        auto right_handler = right ? right->Get(idx) : nullptr;
+        if (!left_handler || !right_handler ||
+            kRowHandler != left_handler->GetHandlerType()) {
+            return Runner::BatchRequestRun(ctx);
+        }
+        requests[idx] =
+            std::dynamic_pointer_cast<RowHandler>(left_handler)->GetValue();
+    }
+
+    // group the requests by the key of the union segments, so that each
+    // segment is seeked once and scanned once for all requests of the key
+    auto& parameter = ctx.GetParameterRow();
+    std::map<std::string, std::vector<size_t>> groups;
+    for (size_t idx = 0; idx < request_size; idx++) {
+        groups[windows_union_gen_.GetRequestWindowsKey(requests[idx],
+                                                       parameter)]
+            .push_back(idx);
+    }
+    auto union_inputs = windows_union_gen_.RunInputs(ctx);
+    std::vector<std::shared_ptr<DataHandler>> windows(request_size);
+    for (auto& group : groups) {
+        std::vector<Row> group_requests;
+        std::vector<int64_t> ts_gens;
+        group_requests.reserve(group.second.size());
+        ts_gens.reserve(group.second.size());
+        for (size_t idx : group.second) {
+            group_requests.push_back(requests[idx]);
+            ts_gens.push_back(range_gen_.Valid()
+                                  ? range_gen_.ts_gen_.Gen(requests[idx])
+                                  : -1);
+        }
+        auto union_segments = windows_union_gen_.GetRequestWindows(
+            group_requests[0], parameter, union_inputs);
+        auto group_windows = RequestUnionWindows(
+            group_requests, ts_gens, union_segments, range_gen_.window_range_,
+            output_request_row_, exclude_current_time_, exclude_current_row_);
+        for (size_t i = 0; i < group.second.size(); i++) {
+            windows[group.second[i]] = group_windows[i];
+        }
+    }
+
+    auto outputs = std::make_shared<DataHandlerVector>();
+    for (auto& window : windows) {
+        outputs->Add(window);
+    }
+    if (ctx.is_debug()) {
+        std::ostringstream oss;
+        oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_
+            << ", " << groups.size() << " keys of " << request_size
+            << " requests\n";
+        for (size_t idx = 0; idx < outputs->GetSize(); idx++) {
+            if (idx >= MAX_DEBUG_BATCH_SiZE) {
+                oss << ">= MAX_DEBUG_BATCH_SiZE...\n";
+                break;
+            }
+            Runner::PrintData(oss, output_schemas_, outputs->Get(idx));
+        }
+        LOG(INFO) << oss.str();
+    }
+    if (need_cache_) {
+        ctx.SetBatchCache(id_, outputs);
+    }
+    return outputs;
+}
+
 std::shared_ptr<DataHandler> PostRequestUnionRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -646,6 +646,26 @@ class RequestWindowUnionGenerator : public InputsGenerator {
         }
         return union_segments;
     }
+    // the requests of the same key get the same union segments
+    std::string GetRequestWindowsKey(const Row& row, const Row& parameter) {
+        std::string key;
+        for (auto& window_gen : windows_gen_) {
+            std::string index_key =
+                window_gen.index_seek_gen_.Valid()
+                    ? window_gen.index_seek_gen_.index_key_gen_.Gen(row,
+                                                                    parameter)
+                    : "";
+            std::string filter_key =
+                window_gen.filter_gen_.GetKey(row, parameter);
+            key.append(std::to_string(index_key.size()))
+                .append(":")
+                .append(index_key);
+            key.append(std::to_string(filter_key.size()))
+                .append(":")
+                .append(filter_key);
+        }
+        return key;
+    }
     std::vector<RequestWindowGenertor> windows_gen_;
 };
 class JoinGenerator {
@@ -677,6 +697,12 @@ class JoinGenerator {
 
     Row RowLastJoin(const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter);
     Row RowLastJoinDropLeftSlices(const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter);
+    // last join the left rows with the segments of the right partition,
+    // which are fetched at once by PartitionHandler::GetSegments
+    std::vector<Row> RowLastJoinBatch(const std::vector<Row>& left_rows,
+                                      std::shared_ptr<PartitionHandler> right,
+                                      const Row& parameter);
+    Row DropLeftSlices(const Row& joined);
     ConditionGenerator condition_gen_;
     KeyGenerator left_key_gen_;
     PartitionGenerator right_group_gen_;
@@ -977,6 +1003,15 @@ class RequestUnionRunner : public Runner {
                                                             int64_t request_ts, const WindowRange& window_range,
                                                             bool output_request_row, bool exclude_current_time,
                                                             bool exclude_current_row);
+    // build the windows of the requests sharing the same union segments with
+    // one sweep over the segments instead of seeking them for each request
+    static std::vector<std::shared_ptr<TableHandler>> RequestUnionWindows(
+        const std::vector<Row>& requests, const std::vector<int64_t>& ts_gens,
+        std::vector<std::shared_ptr<TableHandler>> union_segments,
+        const WindowRange& window_range, bool output_request_row,
+        bool exclude_current_time, bool exclude_current_row);
+    std::shared_ptr<DataHandlerList> BatchRequestRun(
+        RunnerContext& ctx) override;  // NOLINT
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
@@ -1016,12 +1051,25 @@ class RequestAggUnionRunner : public Runner {
     }
 
  private:
+    // answer the window with the aggregate the base partition keeps incrementally,
+    // return null if the window or the partition does not support it
+    std::shared_ptr<TableHandler> RequestCachedWindow(const Row& request, const std::string& key,
+                                                      std::shared_ptr<DataHandler> base_handler,
+                                                      int64_t ts_gen) const;
+    void UpdateBaseAggregator(BaseAggregator* aggregator, const Row& row) const;
+
     enum AggType {
         kSum,
         kCount,
         kAvg,
         kMin,
-        kMax
+        kMax,
+        kDistinctCount,
+        kMedian,
+        kVarSamp,
+        kVarPop,
+        kStddev,
+        kStddevPop,
     };
 
     RequestWindowUnionGenerator windows_union_gen_;
@@ -1041,6 +1089,8 @@ class RequestAggUnionRunner : public Runner {
     std::unique_ptr<BaseAggregator> CreateAggregator() const;
     static inline const std::unordered_map<std::string, AggType> agg_type_map_ = {
         {"sum", kSum}, {"count", kCount}, {"avg", kAvg}, {"min", kMin}, {"max", kMax},
+        {"distinct_count", kDistinctCount}, {"median", kMedian}, {"var_samp", kVarSamp},
+        {"var_pop", kVarPop}, {"stddev", kStddev}, {"stddev_pop", kStddevPop},
     };
 };
 
@@ -1088,6 +1138,11 @@ class RequestLastJoinRunner : public Runner {
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,                                        // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs);  // NOLINT
+    // look up the right partition for all requests at once. The LAST JOINs
+    // of one request are still separate runners, each one looks up its key
+    // alone in Run
+    std::shared_ptr<DataHandlerList> BatchRequestRun(
+        RunnerContext& ctx) override;  // NOLINT
     virtual void PrintRunnerInfo(std::ostream& output,
                                  const std::string& tab) const {
         output << tab << "[" << id_ << "]" << RunnerTypeName(type_);
@@ -224,6 +224,15 @@ std::vector<AggrTableInfo> SimpleCatalog::GetAggrTables(
     const std::string& aggr_col,
     const std::string& partition_cols,
     const std::string& order_col) {
+    std::vector<AggrTableInfo> infos;
+    for (const auto& info : aggr_tables_) {
+        if (info.base_db == base_db && info.base_table == base_table) {
+            infos.push_back(info);
+        }
+    }
+    if (!infos.empty()) {
+        return infos;
+    }
     ::hybridse::vm::AggrTableInfo info = {"aggr_" + base_table, "aggr_db", base_db, base_table,
                                            aggr_func, aggr_col, partition_cols, order_col, "1000"};
     return {info};
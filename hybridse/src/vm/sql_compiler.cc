@@ -179,7 +179,7 @@ Status SqlCompiler::BuildRequestModePhysicalPlan(SqlContext* ctx, const ::hybrid
     vm::RequestModeTransformer transformer(&ctx->nm, ctx->db, cl_, &ctx->parameter_types, llvm_module, library, {},
                                            ctx->is_cluster_optimized, false, ctx->enable_expr_optimize,
                                            enable_request_performance_sensitive, ctx->options.get());
-    if (ctx->options && ctx->options->count(LONG_WINDOWS)) {
+    if (ctx->options && (ctx->options->count(LONG_WINDOWS) || ctx->options->count(WINDOW_AGGR_CACHE))) {
         transformer.AddPass(passes::kPassSplitAggregationOptimized);
         transformer.AddPass(passes::kPassLongWindowOptimized);
     }
@@ -203,7 +203,7 @@ Status SqlCompiler::BuildBatchRequestModePhysicalPlan(SqlContext* ctx, const ::h
                                            ctx->batch_request_info.common_column_indices,
                                            ctx->is_cluster_optimized, ctx->is_batch_request_optimized,
                                            ctx->enable_expr_optimize, true, ctx->options.get());
-    if (ctx->options && ctx->options->count(LONG_WINDOWS)) {
+    if (ctx->options && (ctx->options->count(LONG_WINDOWS) || ctx->options->count(WINDOW_AGGR_CACHE))) {
         transformer.AddPass(passes::kPassSplitAggregationOptimized);
         transformer.AddPass(passes::kPassLongWindowOptimized);
     }
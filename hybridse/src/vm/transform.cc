@@ -282,8 +282,12 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                 dynamic_cast<PhysicalRequestAggUnionNode*>(node);
             CHECK_STATUS(GenRequestWindow(&request_union_op->window_,
                                           node->producers()[0]));
-            CHECK_STATUS(GenRequestWindow(&request_union_op->agg_window_,
-                                          node->producers()[2]));
+            for (size_t i = 0; i < request_union_op->agg_windows_.size();
+                 i++) {
+                CHECK_STATUS(
+                    GenRequestWindow(&request_union_op->agg_windows_[i],
+                                     node->producers()[i + 2]));
+            }
             break;
         }
         case kPhysicalOpPostRequestUnion: {
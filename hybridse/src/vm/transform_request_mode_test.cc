@@ -646,6 +646,138 @@ TEST_F(TransformRequestModePassOptimizedTest, LongWindowOptimizedTest) {
     PhysicalPlanCheck(catalog, sql, expected, extra_passes, &options);
 }
 
+
+TEST_F(TransformRequestModePassOptimizedTest, LongWindowOptimizedMultiLevelTest) {
+    const std::string sql =
+        "SELECT col1, sum(col2) OVER w1, col2+1, add(col2, col1), count(col2) OVER w1, "
+        "sum(col2) over w2 as w1_col2_sum , sum(col2) over w3 FROM t1\n"
+        "WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE BETWEEN 3m PRECEDING AND CURRENT ROW),"
+        "w2 AS (PARTITION BY col1,col2 ORDER BY col5 ROWS_RANGE BETWEEN 3 PRECEDING AND CURRENT ROW),"
+        "w3 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE BETWEEN 3 PRECEDING AND CURRENT ROW);";
+
+    const std::string expected =
+        "SIMPLE_PROJECT(sources=(col1, sum(col2)over w1, col2 + 1, add(col2, col1), count(col2)over w1, w1_col2_sum, "
+        "sum(col2)over w3))\n"
+        "  REQUEST_JOIN(type=kJoinTypeConcat)\n"
+        "    REQUEST_JOIN(type=kJoinTypeConcat)\n"
+        "      REQUEST_JOIN(type=kJoinTypeConcat)\n"
+        "        PROJECT(type=RowProject)\n"
+        "          DATA_PROVIDER(request=t1)\n"
+        "        SIMPLE_PROJECT(sources=(sum(col2)over w1, count(col2)over w1))\n"
+        "          REQUEST_JOIN(type=kJoinTypeConcat)\n"
+        "            PROJECT(type=ReduceAggregation: sum(col2)over w1 (range[180000 PRECEDING,0 CURRENT]))\n"
+        "              REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
+        "index_keys=(col1))\n"
+        "                DATA_PROVIDER(request=t1)\n"
+        "                DATA_PROVIDER(type=Partition, table=t1, index=index1)\n"
+        "                DATA_PROVIDER(type=Partition, table=aggr_t1_1m, index=index1_t2)\n"
+        "                DATA_PROVIDER(type=Partition, table=aggr_t1_1s, index=index1_t2)\n"
+        "            PROJECT(type=ReduceAggregation: count(col2)over w1 (range[180000 PRECEDING,0 CURRENT]))\n"
+        "              REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
+        "index_keys=(col1))\n"
+        "                DATA_PROVIDER(request=t1)\n"
+        "                DATA_PROVIDER(type=Partition, table=t1, index=index1)\n"
+        "                DATA_PROVIDER(type=Partition, table=aggr_t1_1m, index=index1_t2)\n"
+        "                DATA_PROVIDER(type=Partition, table=aggr_t1_1s, index=index1_t2)\n"
+        "      PROJECT(type=ReduceAggregation: sum(col2)over w2 (range[3 PRECEDING,0 CURRENT]))\n"
+        "        REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 3 PRECEDING, 0 CURRENT), "
+        "index_keys=(col1,col2))\n"
+        "          DATA_PROVIDER(request=t1)\n"
+        "          DATA_PROVIDER(type=Partition, table=t1, index=index12)\n"
+        "          DATA_PROVIDER(type=Partition, table=aggr_t1_1s, index=index1_t2)\n"
+        "    PROJECT(type=Aggregation)\n"
+        "      REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, 3 PRECEDING, 0 CURRENT), "
+        "index_keys=(col1))\n"
+        "        DATA_PROVIDER(request=t1)\n"
+        "        DATA_PROVIDER(type=Partition, table=t1, index=index1)";
+
+    std::shared_ptr<SimpleCatalog> catalog(new SimpleCatalog(true));
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    {
+        ::hybridse::type::IndexDef* index = table_def.add_indexes();
+        index->set_name("index12");
+        index->add_first_keys("col1");
+        index->add_first_keys("col2");
+        index->set_second_key("col5");
+    }
+    {
+        ::hybridse::type::IndexDef* index = table_def.add_indexes();
+        index->set_name("index1");
+        index->add_first_keys("col1");
+        index->set_second_key("col5");
+    }
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    // the buckets of 1d are too coarse for all the windows, the ones of 1m are too coarse for w2
+    hybridse::type::Database aggr_db;
+    aggr_db.set_name("aggr_db");
+    for (auto bucket_size : {"1s", "1d", "1m"}) {
+        std::string aggr_table = std::string("aggr_t1_") + bucket_size;
+        hybridse::type::TableDef table_def;
+        BuildAggTableDef(table_def, aggr_table, "aggr_db");
+        ::hybridse::type::IndexDef* index = table_def.add_indexes();
+        index->set_name("index1_t2");
+        index->add_first_keys("key");
+        index->set_second_key("ts_start");
+        AddTable(aggr_db, table_def);
+        catalog->AddAggrTable({aggr_table, "aggr_db", "db", "t1", "", "", "", "", bucket_size});
+    }
+    catalog->AddDatabase(aggr_db);
+
+    std::unordered_map<std::string, std::string> options;
+    options[LONG_WINDOWS] = "w1:1s|1m|1d, w2:1s|1m|1d";
+    std::vector<passes::PhysicalPlanPassType> extra_passes = {passes::kPassSplitAggregationOptimized,
+                                                              passes::kPassLongWindowOptimized};
+    PhysicalPlanCheck(catalog, sql, expected, extra_passes, &options);
+}
+
+TEST_F(TransformRequestModePassOptimizedTest, WindowAggrCacheOptimizedTest) {
+    std::shared_ptr<SimpleCatalog> catalog(new SimpleCatalog(true));
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    {
+        ::hybridse::type::IndexDef* index = table_def.add_indexes();
+        index->set_name("index1");
+        index->add_first_keys("col1");
+        index->set_second_key("col5");
+    }
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    std::unordered_map<std::string, std::string> options;
+    options[WINDOW_AGGR_CACHE] = "true";
+    std::vector<passes::PhysicalPlanPassType> extra_passes = {passes::kPassSplitAggregationOptimized,
+                                                              passes::kPassLongWindowOptimized};
+    // no pre-aggregation table, the raw table is unioned only
+    PhysicalPlanCheck(catalog,
+                      "SELECT sum(col2) OVER w1 FROM t1\n"
+                      "WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE BETWEEN 3m PRECEDING AND CURRENT ROW);",
+                      "PROJECT(type=ReduceAggregation: sum(col2)over w1 (range[180000 PRECEDING,0 CURRENT]))\n"
+                      "  REQUEST_AGG_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
+                      "index_keys=(col1))\n"
+                      "    DATA_PROVIDER(request=t1)\n"
+                      "    DATA_PROVIDER(type=Partition, table=t1, index=index1)",
+                      extra_passes, &options);
+    // the cache doesn't keep distinct_count
+    PhysicalPlanCheck(catalog,
+                      "SELECT distinct_count(col2) OVER w1 FROM t1\n"
+                      "WINDOW w1 AS (PARTITION BY col1 ORDER BY col5 ROWS_RANGE BETWEEN 3m PRECEDING AND CURRENT ROW);",
+                      "PROJECT(type=Aggregation)\n"
+                      "  REQUEST_UNION(partition_keys=(), orders=(ASC), range=(col5, 180000 PRECEDING, 0 CURRENT), "
+                      "index_keys=(col1))\n"
+                      "    DATA_PROVIDER(request=t1)\n"
+                      "    DATA_PROVIDER(type=Partition, table=t1, index=index1)",
+                      extra_passes, &options);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 int main(int argc, char** argv) {
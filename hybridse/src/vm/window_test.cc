@@ -448,6 +448,47 @@ TEST_F(WindowIteratorTest, InnerRangeIteratorTest) {
     }
 }
 
+TEST_F(WindowIteratorTest, InnerWindowNextBatchTest) {
+    int8_t* ptr = reinterpret_cast<int8_t*>(malloc(28));
+    *(reinterpret_cast<int32_t*>(ptr + 2)) = 1;
+    *(reinterpret_cast<int64_t*>(ptr + 2 + 4)) = 1;
+    Row row(base::RefCountedSlice::Create(ptr, 28));
+    vm::CurrentHistoryWindow window(vm::Window::kFrameRowsRange, -3600000L, 0);
+    for (uint64_t ts = 1590115410000; ts <= 1590115500000; ts += 10000) {
+        window.BufferData(ts, row);
+    }
+
+    const Row* values[4];
+    uint64_t keys[4];
+    // pull w[30s:80s] 4 rows at a time
+    {
+        uint64_t start = 1590115500000 - 30000L;
+        uint64_t end = 1590115500000 - 80000L;
+        auto iter = std::unique_ptr<RowIterator>(
+            new InnerRangeIterator<Row>(&window, start, end));
+        iter->SeekToFirst();
+        ASSERT_EQ(4u, iter->NextBatch(values, keys, 4));
+        ASSERT_EQ(1590115470000, keys[0]);
+        ASSERT_EQ(1590115440000, keys[3]);
+        ASSERT_EQ(row.buf(), values[0]->buf());
+        ASSERT_EQ(2u, iter->NextBatch(values, keys, 4));
+        ASSERT_EQ(1590115420000, keys[1]);
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_EQ(0u, iter->NextBatch(values, keys, 4));
+    }
+    // pull w[3:8] without the keys
+    {
+        auto iter = std::unique_ptr<RowIterator>(
+            new codec::InnerRowsIterator<Row>(&window, 3, 8));
+        iter->SeekToFirst();
+        ASSERT_EQ(4u, iter->NextBatch(values, nullptr, 4));
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(1590115430000, iter->GetKey());
+        ASSERT_EQ(2u, iter->NextBatch(values, nullptr, 4));
+        ASSERT_FALSE(iter->Valid());
+    }
+}
+
 TEST_F(WindowIteratorTest, InnerRowsWindowTest) {
     std::vector<std::pair<uint64_t, Row>> rows;
     int8_t* ptr = reinterpret_cast<int8_t*>(malloc(28));
@@ -1546,6 +1587,61 @@ TEST_F(RequestUnionWindowTest, RequestRowsMergeRowsRangeWindowTest) {
             window_range, keys, current_key, exp_keys, exclude_current_time));
     }
 }
+
+std::vector<uint64_t> GET_TABLE_KEYS(std::shared_ptr<TableHandler> table) {
+    std::vector<uint64_t> keys;
+    auto iter = table->GetIterator();
+    iter->SeekToFirst();
+    while (iter->Valid()) {
+        keys.push_back(iter->GetKey());
+        iter->Next();
+    }
+    return keys;
+}
+TEST_F(RequestUnionWindowTest, BatchRequestUnionWindowsTest) {
+    // two union segments with interleaved and duplicated keys
+    std::vector<std::shared_ptr<TableHandler>> segments;
+    for (uint64_t offset : {0, 3}) {
+        auto table = std::make_shared<MemTimeTableHandler>();
+        for (uint64_t key = 100 + offset; key >= 10; key -= 5) {
+            table->AddRow(key, Row());
+            if (key % 3 == 0) {
+                table->AddRow(key, Row());
+            }
+        }
+        segments.push_back(table);
+    }
+    std::vector<int64_t> ts_gens({-1, 0, 9, 10, 50, 63, 63, 64, 100, 200, 32});
+    std::vector<Row> requests(ts_gens.size());
+    std::vector<WindowRange> window_ranges(
+        {WindowRange::CreateRowsWindow(5),
+         WindowRange::CreateRowsRangeWindow(-20, 0),
+         WindowRange::CreateRowsRangeWindow(-20, -3),
+         WindowRange::CreateRowsRangeWindow(-30, 0, 4),
+         WindowRange::CreateRowsMergeRowsRangeWindow(-7, 5),
+         WindowRange::CreateRowsMergeRowsRangeWindow(-7, 5, 3)});
+    for (auto& window_range : window_ranges) {
+        for (int flags = 0; flags < 8; flags++) {
+            bool output_request_row = flags & 1;
+            bool exclude_current_time = flags & 2;
+            bool exclude_current_row = flags & 4;
+            auto windows = RequestUnionRunner::RequestUnionWindows(
+                requests, ts_gens, segments, window_range, output_request_row,
+                exclude_current_time, exclude_current_row);
+            ASSERT_EQ(ts_gens.size(), windows.size());
+            for (size_t i = 0; i < ts_gens.size(); i++) {
+                auto window = RequestUnionRunner::RequestUnionWindow(
+                    requests[i], segments, ts_gens[i], window_range,
+                    output_request_row, exclude_current_time,
+                    exclude_current_row);
+                ASSERT_EQ(GET_TABLE_KEYS(window), GET_TABLE_KEYS(windows[i]))
+                    << "request " << i << " flags " << flags;
+                ASSERT_EQ(window->GetCount(), windows[i]->GetCount())
+                    << "request " << i << " flags " << flags;
+            }
+        }
+    }
+}
 }  // namespace vm
 }  // namespace hybridse
 int main(int argc, char** argv) {
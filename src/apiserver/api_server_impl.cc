@@ -18,11 +18,16 @@
 
 #include <map>
 #include <memory>
-#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "apiserver/interface_provider.h"
 #include "brpc/server.h"
+#include "gflags/gflags.h"
+
+DECLARE_uint32(api_server_batch_wait_us);
+DECLARE_uint32(api_server_batch_max_rows);
 
 namespace openmldb {
 namespace apiserver {
@@ -81,7 +86,7 @@ void APIServerImpl::Process(google::protobuf::RpcController* cntl_base, const Ht
     JsonWriter writer;
     provider_.handle(unresolved_path, method, req_body, writer);
 
-    cntl->response_attachment().append(writer.GetString());
+    cntl->response_attachment().append(writer.GetString(), writer.GetSize());
 }
 
 struct ExecContext {
@@ -145,48 +150,6 @@ void APIServerImpl::RegisterQuery() {
                    });
 }
 
-bool APIServerImpl::Json2SQLRequestRow(const butil::rapidjson::Value& non_common_cols_v,
-                                       const butil::rapidjson::Value& common_cols_v,
-                                       std::shared_ptr<openmldb::sdk::SQLRequestRow> row) {
-    auto sch = row->GetSchema();
-
-    // scan all strings to init the total string length
-    decltype(common_cols_v.Size()) str_len_sum = 0;
-    decltype(common_cols_v.Size()) non_common_idx = 0, common_idx = 0;
-    for (decltype(sch->GetColumnCnt()) i = 0; i < sch->GetColumnCnt(); ++i) {
-        // if element is null, GetStringLength() will get 0
-        if (sch->IsConstant(i)) {
-            if (sch->GetColumnType(i) == hybridse::sdk::kTypeString) {
-                str_len_sum += common_cols_v[common_idx].GetStringLength();
-            }
-            ++common_idx;
-        } else {
-            if (sch->GetColumnType(i) == hybridse::sdk::kTypeString) {
-                str_len_sum += non_common_cols_v[non_common_idx].GetStringLength();
-            }
-            ++non_common_idx;
-        }
-    }
-    row->Init(static_cast<int32_t>(str_len_sum));
-
-    non_common_idx = 0, common_idx = 0;
-    for (decltype(sch->GetColumnCnt()) i = 0; i < sch->GetColumnCnt(); ++i) {
-        if (sch->IsConstant(i)) {
-            if (!AppendJsonValue(common_cols_v[common_idx], sch->GetColumnType(i), sch->IsColumnNotNull(i), row)) {
-                return false;
-            }
-            ++common_idx;
-        } else {
-            if (!AppendJsonValue(non_common_cols_v[non_common_idx], sch->GetColumnType(i), sch->IsColumnNotNull(i),
-                                 row)) {
-                return false;
-            }
-            ++non_common_idx;
-        }
-    }
-    return true;
-}
-
 template <typename T>
 bool APIServerImpl::AppendJsonValue(const butil::rapidjson::Value& v, hybridse::sdk::DataType type, bool is_not_null,
                                     T row) {
@@ -339,6 +302,9 @@ void APIServerImpl::RegisterExecDeployment() {
     provider_.post("/dbs/:db_name/deployments/:sp_name",
                    std::bind(&APIServerImpl::ExecuteProcedure, this, false, std::placeholders::_1,
                              std::placeholders::_2, std::placeholders::_3));
+    provider_.post("/dbs/:db_name/deployments/:sp_name/binary",
+                   std::bind(&APIServerImpl::ExecuteDeploymentBinary, this, std::placeholders::_1,
+                             std::placeholders::_2, std::placeholders::_3));
 }
 
 void APIServerImpl::RegisterExecSP() {
@@ -347,6 +313,22 @@ void APIServerImpl::RegisterExecSP() {
                              std::placeholders::_3));
 }
 
+std::shared_ptr<DeploymentPlan> APIServerImpl::GetDeploymentPlan(const std::string& db, const std::string& sp,
+                                                                 hybridse::sdk::Status* status) {
+    // We need to use ShowProcedure to get input schema(should know which column is constant).
+    // GetRequestRowByProcedure can't do that.
+    auto sp_info = sql_router_->ShowProcedure(db, sp, status);
+    if (!sp_info) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(plan_mu_);
+    auto& plan = plans_[db][sp];
+    if (!plan || plan->sp_info != sp_info) {
+        plan = std::make_shared<DeploymentPlan>(sp_info);
+    }
+    return plan;
+}
+
 void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvider::Params& param,
                                      const butil::IOBuf& req_body, JsonWriter& writer) {
     auto resp = GeneralResp();
@@ -359,97 +341,96 @@ void APIServerImpl::ExecuteProcedure(bool has_common_col, const InterfaceProvide
     auto db = db_it->second;
     auto sp = sp_it->second;
 
-    Document document;
-    if (document.Parse(req_body.to_string().c_str()).HasParseError()) {
-        writer << resp.Set("Json parse failed");
+    // the in-situ parsing writes the body, and the fields refer to it until the rows are built
+    std::string body = req_body.to_string();
+    JsonRequest request;
+    std::string msg;
+    if (!ParseJsonRequest(&body[0], has_common_col, &request, &msg)) {
+        writer << resp.Set(msg);
         return;
     }
 
-    butil::rapidjson::Value common_cols_v;
-    if (has_common_col) {
-        auto common_cols = document.FindMember("common_cols");
-        if (common_cols != document.MemberEnd()) {
-            common_cols_v = common_cols->value;  // move
-            if (!common_cols_v.IsArray()) {
-                writer << resp.Set("common_cols is not array");
-                return;
-            }
-        } else {
-            common_cols_v.SetArray();  // If there's no common cols, no need to add this field in request
-        }
-    } else {
-        common_cols_v.SetArray();
+    hybridse::sdk::Status status;
+    auto plan = GetDeploymentPlan(db, sp, &status);
+    if (!plan) {
+        writer << resp.Set(status.msg);
+        return;
+    }
+    std::shared_ptr<sdk::SQLRequestRowBatch> row_batch;
+    if (!BuildRequestRows(*plan, has_common_col, request, &row_batch, &msg)) {
+        writer << resp.Set(msg);
+        return;
     }
+    CallProcedure(db, sp, plan, row_batch, !has_common_col, request.need_schema, writer);
+}
 
-    auto input = document.FindMember("input");
-    if (input == document.MemberEnd() || !input->value.IsArray() || input->value.Empty()) {
-        writer << resp.Set("Invalid input");
+void APIServerImpl::ExecuteDeploymentBinary(const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
+                                            JsonWriter& writer) {
+    auto resp = GeneralResp();
+    auto db_it = param.find("db_name");
+    auto sp_it = param.find("sp_name");
+    if (db_it == param.end() || sp_it == param.end()) {
+        writer << resp.Set("Invalid path");
         return;
     }
-    const auto& rows = input->value;
+    auto db = db_it->second;
+    auto sp = sp_it->second;
 
     hybridse::sdk::Status status;
-    // We need to use ShowProcedure to get input schema(should know which column is constant).
-    // GetRequestRowByProcedure can't do that.
-    auto sp_info = sql_router_->ShowProcedure(db, sp, &status);
-    if (!sp_info) {
+    auto plan = GetDeploymentPlan(db, sp, &status);
+    if (!plan) {
         writer << resp.Set(status.msg);
         return;
     }
-
-    const auto& schema_impl = dynamic_cast<const ::hybridse::sdk::SchemaImpl&>(sp_info->GetInputSchema());
-    // Hard copy, and RequestRow needs shared schema
-    auto input_schema = std::make_shared<::hybridse::sdk::SchemaImpl>(schema_impl.GetSchema());
-    auto common_column_indices = std::make_shared<openmldb::sdk::ColumnIndicesSet>(input_schema);
-    decltype(common_cols_v.Size()) expected_common_size = 0;
-    if (has_common_col) {
-        for (int i = 0; i < input_schema->GetColumnCnt(); ++i) {
-            if (input_schema->IsConstant(i)) {
-                common_column_indices->AddCommonColumnIdx(i);
-                ++expected_common_size;
-            }
-        }
-        if (common_cols_v.Size() != expected_common_size) {
-            writer << resp.Set("Invalid common cols size");
-            return;
-        }
+    std::shared_ptr<sdk::SQLRequestRowBatch> row_batch;
+    std::string msg;
+    if (!ParseBinaryRequest(*plan, req_body, &row_batch, &msg)) {
+        writer << resp.Set(msg);
+        return;
     }
-    auto expected_input_size = input_schema->GetColumnCnt() - expected_common_size;
+    CallProcedure(db, sp, plan, row_batch, true, false, writer);
+}
 
-    // TODO(hw): SQLRequestRowBatch should add common & non-common cols directly
-    auto row_batch = std::make_shared<sdk::SQLRequestRowBatch>(input_schema, common_column_indices);
-    std::set<std::string> col_set;
-    for (decltype(rows.Size()) i = 0; i < rows.Size(); ++i) {
-        if (!rows[i].IsArray() || rows[i].Size() != expected_input_size) {
-            writer << resp.Set("Invalid input data row");
-            return;
-        }
-        auto row = std::make_shared<sdk::SQLRequestRow>(input_schema, col_set);
+std::shared_ptr<DeploymentBatcher> APIServerImpl::GetDeploymentBatcher(const std::string& db, const std::string& sp,
+                                                                       const std::shared_ptr<DeploymentPlan>& plan) {
+    std::lock_guard<std::mutex> lock(plan_mu_);
+    auto& batcher = batchers_[db][sp];
+    if (!batcher || batcher->plan() != plan) {
+        batcher = std::make_shared<DeploymentBatcher>(plan, FLAGS_api_server_batch_max_rows,
+                                                      FLAGS_api_server_batch_wait_us);
+    }
+    return batcher;
+}
 
-        // sizes have been checked
-        if (!Json2SQLRequestRow(rows[i], common_cols_v, row)) {
-            writer << resp.Set("Translate to request row failed");
+void APIServerImpl::CallProcedure(const std::string& db, const std::string& sp,
+                                  const std::shared_ptr<DeploymentPlan>& plan,
+                                  std::shared_ptr<sdk::SQLRequestRowBatch> row_batch, bool batching, bool need_schema,
+                                  JsonWriter& writer) {
+    DeploymentBatcher::Sender send = [this, &db, &sp](std::shared_ptr<sdk::SQLRequestRowBatch> batch,
+                                                      hybridse::sdk::Status* status) {
+        return sql_router_->CallSQLBatchRequestProcedure(db, sp, batch, status);
+    };
+    DeploymentBatcher::Done write = [&plan, need_schema, &writer](const std::shared_ptr<hybridse::sdk::ResultSet>& rs,
+                                                                  const hybridse::sdk::Status& status) {
+        if (!rs) {
+            writer << GeneralResp().Set(status.msg);
             return;
         }
-        row->Build();
-        row_batch->AddRow(row);
-    }
-
-    auto rs = sql_router_->CallSQLBatchRequestProcedure(db, sp, row_batch, &status);
-    if (!rs) {
-        writer << resp.Set(status.msg);
+        ExecSPResp sp_resp;
+        // output schema in sp_info is needed for encoding data, so we need a bool in ExecSPResp to know whether to
+        // print schema
+        sp_resp.sp_info = plan->sp_info;
+        sp_resp.need_schema = need_schema;
+        sp_resp.rs = rs;
+        writer << sp_resp;
+    };
+    if (batching && FLAGS_api_server_batch_wait_us > 0) {
+        GetDeploymentBatcher(db, sp, plan)->Call(row_batch, send, write);
         return;
     }
-
-    ExecSPResp sp_resp;
-    // output schema in sp_info is needed for encoding data, so we need a bool in ExecSPResp to know whether to
-    // print schema
-    sp_resp.sp_info = sp_info;
-    if (document.HasMember("need_schema") && document["need_schema"].IsBool() && document["need_schema"].GetBool()) {
-        sp_resp.need_schema = true;
-    }
-    sp_resp.rs = rs;
-    writer << sp_resp;
+    hybridse::sdk::Status status;
+    auto rs = send(row_batch, &status);
+    write(rs, status);
 }
 
 void APIServerImpl::RegisterGetSP() {
@@ -639,16 +620,17 @@ void WriteSchema(JsonWriter& ar, const std::string& name, const hybridse::sdk::S
     ar.EndArray();
 }
 
-void WriteValue(JsonWriter& ar, std::shared_ptr<hybridse::sdk::ResultSet> rs, int i) {  // NOLINT
-    auto schema = rs->GetSchema();
+void WriteValue(JsonWriter& ar, const std::shared_ptr<hybridse::sdk::ResultSet>& rs, int i,  // NOLINT
+                hybridse::sdk::DataType type) {
     if (rs->IsNULL(i)) {
+        auto schema = rs->GetSchema();
         if (schema->IsColumnNotNull(i)) {
             LOG(ERROR) << "Value in " << schema->GetColumnName(i) << " is null but it can't be null";
         }
         ar.SetNull();
         return;
     }
-    switch (schema->GetColumnType(i)) {
+    switch (type) {
         case hybridse::sdk::kTypeInt32: {
             int32_t value = 0;
             rs->GetInt32(i, &value);
@@ -695,10 +677,8 @@ void WriteValue(JsonWriter& ar, std::shared_ptr<hybridse::sdk::ResultSet> rs, in
             int32_t year = 0;
             int32_t month = 0;
             int32_t day = 0;
-            std::stringstream ss;
             rs->GetDate(i, &year, &month, &day);
-            ss << year << "-" << month << "-" << day;
-            ar& ss.str();
+            ar&(std::to_string(year) + "-" + std::to_string(month) + "-" + std::to_string(day));
             break;
         }
         case hybridse::sdk::kTypeBool: {
@@ -730,6 +710,14 @@ JsonWriter& operator&(JsonWriter& ar, ExecSPResp& s) {  // NOLINT
         WriteSchema(ar, "schema", schema, false);
     }
 
+    // the columns are split once, the rows are written to the buffer one by one
+    std::vector<std::pair<int, hybridse::sdk::DataType>> non_common_cols;
+    std::vector<std::pair<int, hybridse::sdk::DataType>> common_cols;
+    for (decltype(schema.GetColumnCnt()) i = 0; i < schema.GetColumnCnt(); i++) {
+        auto& cols = schema.IsConstant(i) ? common_cols : non_common_cols;
+        cols.emplace_back(i, schema.GetColumnType(i));
+    }
+
     // data-data: non common cols data
     ar.Member("data");
     ar.StartArray();
@@ -737,10 +725,8 @@ JsonWriter& operator&(JsonWriter& ar, ExecSPResp& s) {  // NOLINT
     rs->Reset();
     while (rs->Next()) {
         ar.StartArray();
-        for (decltype(schema.GetColumnCnt()) i = 0; i < schema.GetColumnCnt(); i++) {
-            if (!schema.IsConstant(i)) {
-                WriteValue(ar, rs, i);
-            }
+        for (const auto& col : non_common_cols) {
+            WriteValue(ar, rs, col.first, col.second);
         }
         ar.EndArray();  // one row end
     }
@@ -752,10 +738,8 @@ JsonWriter& operator&(JsonWriter& ar, ExecSPResp& s) {  // NOLINT
         rs->Reset();
         if (rs->Next()) {
             ar.StartArray();
-            for (decltype(schema.GetColumnCnt()) i = 0; i < schema.GetColumnCnt(); i++) {
-                if (schema.IsConstant(i)) {
-                    WriteValue(ar, rs, i);
-                }
+            for (const auto& col : common_cols) {
+                WriteValue(ar, rs, col.first, col.second);
             }
             ar.EndArray();  // one row end
         }
@@ -18,11 +18,15 @@
 #define SRC_APISERVER_API_SERVER_IMPL_H_
 
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "apiserver/deployment_batcher.h"
+#include "apiserver/deployment_request.h"
 #include "apiserver/interface_provider.h"
 #include "apiserver/json_helper.h"
 #include "json2pb/rapidjson.h"  // rapidjson's DOM-style API
@@ -40,7 +44,9 @@ using butil::rapidjson::Writer;
 // Every request is handled by `Process()`, we will choose the right method of the request by `InterfaceProvider`.
 // InterfaceProvider's url parser supports to parse urls like "/a/:arg1/b/:arg2/:arg3", but doesn't support wildcards.
 // Methods should be registered in `InterfaceProvider` in the init phase.
-// Both input and output are json data. We use rapidjson to handle it.
+// Both input and output are json data. We use rapidjson to handle it. Deployments also accept the input rows in the
+// row codec, see `ParseBinaryRequest`. The concurrent calls of a deployment can be merged into one request by
+// `DeploymentBatcher`, it's enabled by `api_server_batch_wait_us`.
 class APIServerImpl : public APIServer {
  public:
     APIServerImpl() = default;
@@ -65,10 +71,18 @@ class APIServerImpl : public APIServer {
 
     void ExecuteProcedure(bool has_common_col, const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
                           JsonWriter& writer);  // NOLINT
-
-    static bool Json2SQLRequestRow(const butil::rapidjson::Value& non_common_cols_v,
-                                   const butil::rapidjson::Value& common_cols_v,
-                                   std::shared_ptr<openmldb::sdk::SQLRequestRow> row);
+    void ExecuteDeploymentBinary(const InterfaceProvider::Params& param, const butil::IOBuf& req_body,
+                                 JsonWriter& writer);  // NOLINT
+    // the calls without common cols can be batched with the concurrent calls of the same deployment
+    void CallProcedure(const std::string& db, const std::string& sp, const std::shared_ptr<DeploymentPlan>& plan,
+                       std::shared_ptr<sdk::SQLRequestRowBatch> row_batch, bool batching, bool need_schema,
+                       JsonWriter& writer);  // NOLINT
+
+    // the plan is rebuilt if the procedure is recreated
+    std::shared_ptr<DeploymentPlan> GetDeploymentPlan(const std::string& db, const std::string& sp,
+                                                      hybridse::sdk::Status* status);
+    std::shared_ptr<DeploymentBatcher> GetDeploymentBatcher(const std::string& db, const std::string& sp,
+                                                            const std::shared_ptr<DeploymentPlan>& plan);
     template <typename T>
     static bool AppendJsonValue(const butil::rapidjson::Value& v, hybridse::sdk::DataType type, bool is_not_null,
                                 T row);
@@ -78,6 +92,11 @@ class APIServerImpl : public APIServer {
     InterfaceProvider provider_;
     // cluster_sdk_ is not owned by this class.
     ::openmldb::sdk::DBSDK* cluster_sdk_ = nullptr;
+    // guards plans_ and batchers_
+    std::mutex plan_mu_;
+    // db -> sp name -> plan
+    std::map<std::string, std::map<std::string, std::shared_ptr<DeploymentPlan>>> plans_;
+    std::map<std::string, std::map<std::string, std::shared_ptr<DeploymentBatcher>>> batchers_;
 };
 
 struct QueryReq {
@@ -106,7 +125,8 @@ struct ExecSPResp {
 void WriteSchema(JsonWriter& ar, const std::string& name, const hybridse::sdk::Schema& schema,  // NOLINT
                  bool only_const);
 
-void WriteValue(JsonWriter& ar, std::shared_ptr<hybridse::sdk::ResultSet> rs, int i);  // NOLINT
+void WriteValue(JsonWriter& ar, const std::shared_ptr<hybridse::sdk::ResultSet>& rs, int i,  // NOLINT
+                hybridse::sdk::DataType type);
 
 // ExecSPResp reading is unsupported now, cuz we decode ResultSet with Schema here, it's irreversible
 JsonWriter& operator&(JsonWriter& ar, ExecSPResp& s);  // NOLINT
@@ -561,6 +561,37 @@ TEST_F(APIServerTest, no_common) {
         ASSERT_EQ(0, document["data"]["common_cols_data"].Size());
     }
 
+    // call procedure with the rows in the row codec
+    {
+        brpc::Controller cntl;
+        cntl.http_request().set_method(brpc::HTTP_METHOD_POST);
+        cntl.http_request().uri() = "http://127.0.0.1:8010/dbs/" + env->db + "/deployments/" + sp_name + "/binary";
+        for (int64_t c4 : {123, 234}) {
+            auto row = env->cluster_remote->GetRequestRowByProcedure(env->db, sp_name, &status);
+            ASSERT_TRUE(row) << status.msg;
+            row->Init(2);
+            row->AppendString("bb");
+            row->AppendInt32(23);
+            row->AppendInt64(c4);
+            row->AppendFloat(5.1);
+            row->AppendDouble(6.1);
+            row->AppendTimestamp(1590738994000);
+            row->AppendDate(2021, 8, 1);
+            ASSERT_TRUE(row->Build());
+            cntl.request_attachment().append(row->GetRow());
+        }
+        env->http_channel.CallMethod(NULL, &cntl, NULL, NULL, NULL);
+        ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+
+        if (document.Parse(cntl.response_attachment().to_string().c_str()).HasParseError()) {
+            ASSERT_TRUE(false) << "response parse failed with code " << document.GetParseError()
+                               << ", raw resp: " << cntl.response_attachment().to_string();
+        }
+        ASSERT_EQ(0, document["code"].GetInt());
+        ASSERT_STREQ("ok", document["msg"].GetString());
+        ASSERT_EQ(2, document["data"]["data"].Size());
+    }
+
     // drop procedure and table
     std::string drop_sp_sql = "drop procedure " + sp_name + ";";
     ASSERT_TRUE(env->cluster_remote->ExecuteDDL(env->db, drop_sp_sql, &status));
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apiserver/deployment_batcher.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+
+#include "bvar/bvar.h"
+#include "common/timer.h"
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace apiserver {
+
+static bvar::IntRecorder g_batch_calls("api_server_deployment_batch_calls");
+static bvar::IntRecorder g_batch_rows("api_server_deployment_batch_rows");
+static bvar::LatencyRecorder g_queue_delay("api_server_deployment_queue_delay");
+
+bool ResultSetSlice::Reset() {
+    if (cursor_->position >= offset_) {
+        rs_->Reset();
+        cursor_->position = -1;
+    }
+    while (cursor_->position < offset_ - 1) {
+        if (!rs_->Next()) {
+            return false;
+        }
+        cursor_->position++;
+    }
+    index_ = -1;
+    return true;
+}
+
+bool ResultSetSlice::Next() {
+    if (index_ + 1 >= count_ || cursor_->position != offset_ + index_ || !rs_->Next()) {
+        return false;
+    }
+    cursor_->position++;
+    index_++;
+    return true;
+}
+
+DeploymentBatcher::DeploymentBatcher(std::shared_ptr<DeploymentPlan> plan, uint32_t max_rows, uint64_t wait_us)
+    : plan_(std::move(plan)), max_rows_(std::max(max_rows, 1u)), wait_us_(wait_us), queued_rows_(0) {}
+
+void DeploymentBatcher::Call(std::shared_ptr<sdk::SQLRequestRowBatch> row_batch, const Sender& sender,
+                             const Done& done) {
+    PendingCall call{std::move(row_batch), &done, ::baidu::common::timer::get_micros(), false};
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    queue_.push_back(&call);
+    queued_rows_ += call.row_batch->Size();
+    if (queued_rows_ >= max_rows_) {
+        // the leader needn't wait for the end of the window
+        cv_.notify_all();
+    }
+    while (!call.finished) {
+        if (queue_.front() != &call) {
+            cv_.wait(lock);
+            continue;
+        }
+        if (wait_us_ > 0 && queued_rows_ < max_rows_) {
+            // trade a bounded latency for a larger batch
+            cv_.wait_for(lock, wait_us_);
+        }
+        // lead the calls queued behind, a call is never split
+        uint64_t rows = 0;
+        auto end = queue_.begin();
+        while (end != queue_.end() && (end == queue_.begin() || rows + (*end)->row_batch->Size() <= max_rows_)) {
+            rows += (*end)->row_batch->Size();
+            ++end;
+        }
+        std::vector<PendingCall*> group(queue_.begin(), end);
+        lock.unlock();
+        SendGroup(group, rows, sender);
+        lock.lock();
+        for (size_t i = 0; i < group.size(); i++) {
+            queue_.front()->finished = true;
+            queue_.pop_front();
+        }
+        queued_rows_ -= rows;
+        cv_.notify_all();
+    }
+}
+
+void DeploymentBatcher::SendGroup(const std::vector<PendingCall*>& group, uint64_t rows, const Sender& sender) {
+    uint64_t now = ::baidu::common::timer::get_micros();
+    for (auto* call : group) {
+        g_queue_delay << now - call->queue_time;
+    }
+    g_batch_calls << group.size();
+    g_batch_rows << rows;
+
+    auto row_batch = group.front()->row_batch;
+    if (group.size() > 1) {
+        row_batch = std::make_shared<sdk::SQLRequestRowBatch>(plan_->input_schema, plan_->empty_column_indices);
+        for (auto* call : group) {
+            for (int i = 0; i < call->row_batch->Size(); i++) {
+                const auto* row = call->row_batch->GetNonCommonSlice(i);
+                row_batch->AddRow(reinterpret_cast<const int8_t*>(row->data()), row->size());
+            }
+        }
+    }
+    hybridse::sdk::Status status;
+    auto rs = sender(row_batch, &status);
+    if (rs && static_cast<uint64_t>(rs->Size()) != rows) {
+        LOG(WARNING) << "the result has " << rs->Size() << " rows, but " << rows << " rows are sent";
+        status.code = -1;
+        status.msg = "result size mismatch";
+        rs.reset();
+    }
+    if (!rs) {
+        for (auto* call : group) {
+            (*call->done)(nullptr, status);
+        }
+        return;
+    }
+    auto cursor = std::make_shared<ResultSetSlice::Cursor>(rs);
+    int32_t offset = 0;
+    for (auto* call : group) {
+        int32_t count = call->row_batch->Size();
+        (*call->done)(std::make_shared<ResultSetSlice>(cursor, offset, count), status);
+        offset += count;
+    }
+}
+
+}  // namespace apiserver
+}  // namespace openmldb
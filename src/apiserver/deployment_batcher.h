@@ -0,0 +1,119 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_APISERVER_DEPLOYMENT_BATCHER_H_
+#define SRC_APISERVER_DEPLOYMENT_BATCHER_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "apiserver/deployment_request.h"
+#include "bthread/bthread.h"
+#include "bthread/condition_variable.h"
+#include "sdk/result_set.h"
+
+namespace openmldb {
+namespace apiserver {
+
+// The rows [offset, offset + count) of a result set. The slices of one result set share its cursor, they must be
+// read one by one, and reading them in order doesn't go back to the first row.
+class ResultSetSlice : public hybridse::sdk::ResultSet {
+ public:
+    struct Cursor {
+        explicit Cursor(std::shared_ptr<hybridse::sdk::ResultSet> result_set) : rs(std::move(result_set)) {}
+        std::shared_ptr<hybridse::sdk::ResultSet> rs;
+        // the row the result set is on
+        int32_t position = -1;
+    };
+
+    ResultSetSlice(std::shared_ptr<Cursor> cursor, int32_t offset, int32_t count)
+        : cursor_(std::move(cursor)), rs_(cursor_->rs.get()), offset_(offset), count_(count), index_(-1) {}
+
+    bool Reset() override;
+    bool Next() override;
+
+    bool GetString(uint32_t index, std::string* val) override { return rs_->GetString(index, val); }
+    bool GetBool(uint32_t index, bool* result) override { return rs_->GetBool(index, result); }
+    bool GetChar(uint32_t index, char* result) override { return rs_->GetChar(index, result); }
+    bool GetInt16(uint32_t index, int16_t* result) override { return rs_->GetInt16(index, result); }
+    bool GetInt32(uint32_t index, int32_t* result) override { return rs_->GetInt32(index, result); }
+    bool GetInt64(uint32_t index, int64_t* result) override { return rs_->GetInt64(index, result); }
+    bool GetFloat(uint32_t index, float* result) override { return rs_->GetFloat(index, result); }
+    bool GetDouble(uint32_t index, double* result) override { return rs_->GetDouble(index, result); }
+    bool GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) override {
+        return rs_->GetDate(index, year, month, day);
+    }
+    bool GetDate(uint32_t index, int32_t* days) override { return rs_->GetDate(index, days); }
+    bool GetTime(uint32_t index, int64_t* mills) override { return rs_->GetTime(index, mills); }
+    const hybridse::sdk::Schema* GetSchema() override { return rs_->GetSchema(); }
+    bool IsNULL(int index) override { return rs_->IsNULL(index); }
+    int32_t Size() override { return count_; }
+
+ private:
+    std::shared_ptr<Cursor> cursor_;
+    hybridse::sdk::ResultSet* rs_;
+    int32_t offset_;
+    int32_t count_;
+    int32_t index_;
+};
+
+// DeploymentBatcher merges the concurrent calls of one deployment into one batch request. The first queued call
+// leads: it waits a window for more calls, sends the rows of the calls behind it in one request, then hands every
+// call the slice of its rows by the call's done. The others wait until their done is run. It's for the calls
+// without common cols, the rows of them are the whole input rows.
+class DeploymentBatcher {
+ public:
+    using Sender = std::function<std::shared_ptr<hybridse::sdk::ResultSet>(
+        std::shared_ptr<sdk::SQLRequestRowBatch> row_batch, hybridse::sdk::Status* status)>;
+    using Done = std::function<void(const std::shared_ptr<hybridse::sdk::ResultSet>& rs,
+                                    const hybridse::sdk::Status& status)>;
+
+    DeploymentBatcher(std::shared_ptr<DeploymentPlan> plan, uint32_t max_rows, uint64_t wait_us);
+
+    // done is run by the leader of the call's group, Call returns after that
+    void Call(std::shared_ptr<sdk::SQLRequestRowBatch> row_batch, const Sender& sender, const Done& done);
+
+    const std::shared_ptr<DeploymentPlan>& plan() const { return plan_; }
+
+ private:
+    struct PendingCall {
+        std::shared_ptr<sdk::SQLRequestRowBatch> row_batch;
+        const Done* done;
+        uint64_t queue_time;
+        bool finished;
+    };
+
+    void SendGroup(const std::vector<PendingCall*>& group, uint64_t rows, const Sender& sender);
+
+ private:
+    std::shared_ptr<DeploymentPlan> plan_;
+    uint32_t max_rows_;
+    uint64_t wait_us_;
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    std::deque<PendingCall*> queue_;
+    // the rows in queue_
+    uint64_t queued_rows_;
+};
+
+}  // namespace apiserver
+}  // namespace openmldb
+
+#endif  // SRC_APISERVER_DEPLOYMENT_BATCHER_H_
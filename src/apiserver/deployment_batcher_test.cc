@@ -0,0 +1,223 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apiserver/deployment_batcher.h"
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catalog/base.h"
+#include "codec/fe_row_codec.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace apiserver {
+
+// the result of a row is the value of its c1
+class FakeResultSet : public hybridse::sdk::ResultSet {
+ public:
+    explicit FakeResultSet(std::vector<int64_t> values) : values_(std::move(values)), index_(-1) {}
+    bool Reset() override {
+        index_ = -1;
+        return true;
+    }
+    bool Next() override { return ++index_ < static_cast<int32_t>(values_.size()); }
+    bool GetString(uint32_t, std::string*) override { return false; }
+    bool GetBool(uint32_t, bool*) override { return false; }
+    bool GetChar(uint32_t, char*) override { return false; }
+    bool GetInt16(uint32_t, int16_t*) override { return false; }
+    bool GetInt32(uint32_t, int32_t*) override { return false; }
+    bool GetInt64(uint32_t, int64_t* result) override {
+        *result = values_.at(index_);
+        return true;
+    }
+    bool GetFloat(uint32_t, float*) override { return false; }
+    bool GetDouble(uint32_t, double*) override { return false; }
+    bool GetDate(uint32_t, int32_t*, int32_t*, int32_t*) override { return false; }
+    bool GetDate(uint32_t, int32_t*) override { return false; }
+    bool GetTime(uint32_t, int64_t*) override { return false; }
+    const hybridse::sdk::Schema* GetSchema() override { return nullptr; }
+    bool IsNULL(int) override { return false; }
+    int32_t Size() override { return values_.size(); }
+
+ private:
+    std::vector<int64_t> values_;
+    int32_t index_;
+};
+
+class DeploymentBatcherTest : public ::testing::Test {
+ public:
+    DeploymentBatcherTest() : send_cnt_(0) {
+        ::openmldb::api::ProcedureInfo sp;
+        sp.set_db_name("db");
+        sp.set_sp_name("sp");
+        auto* column = sp.add_input_schema();
+        column->set_name("c1");
+        column->set_data_type(::openmldb::type::kBigInt);
+        plan_ = std::make_shared<DeploymentPlan>(std::make_shared<catalog::ProcedureInfoImpl>(sp));
+        sender_ = [this](std::shared_ptr<sdk::SQLRequestRowBatch> row_batch, hybridse::sdk::Status*) {
+            send_cnt_++;
+            ::hybridse::codec::RowView view(plan_->input_schema->GetSchema());
+            std::vector<int64_t> values;
+            for (int i = 0; i < row_batch->Size(); i++) {
+                const auto* row = row_batch->GetNonCommonSlice(i);
+                view.Reset(reinterpret_cast<const int8_t*>(row->data()), row->size());
+                values.push_back(view.GetInt64Unsafe(0));
+            }
+            return std::make_shared<FakeResultSet>(values);
+        };
+    }
+
+    std::shared_ptr<sdk::SQLRequestRowBatch> BuildBatch(int64_t begin, int64_t cnt) {
+        auto row_batch = std::make_shared<sdk::SQLRequestRowBatch>(plan_->input_schema, plan_->empty_column_indices);
+        sdk::SQLRequestRow row(plan_->input_schema, std::set<std::string>());
+        for (int64_t i = begin; i < begin + cnt; i++) {
+            row.Init(0);
+            row.AppendInt64(i);
+            row.Build();
+            row_batch->AddRow(reinterpret_cast<const int8_t*>(row.GetRow().data()), row.GetRow().size());
+        }
+        return row_batch;
+    }
+
+    // every call has rows_per_call rows, returns the count of the calls get their own results
+    int RunCalls(DeploymentBatcher* batcher, int call_cnt, int rows_per_call) {
+        std::atomic<int> ok_cnt(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < call_cnt; i++) {
+            threads.emplace_back([&, i] {
+                int64_t begin = i * 100;
+                std::vector<int64_t> result;
+                batcher->Call(BuildBatch(begin, rows_per_call), sender_,
+                              [&result](const std::shared_ptr<hybridse::sdk::ResultSet>& rs,
+                                        const hybridse::sdk::Status&) {
+                                  if (!rs || !rs->Reset()) {
+                                      return;
+                                  }
+                                  while (rs->Next()) {
+                                      int64_t val = 0;
+                                      rs->GetInt64(0, &val);
+                                      result.push_back(val);
+                                  }
+                              });
+                std::vector<int64_t> expected;
+                for (int64_t v = begin; v < begin + rows_per_call; v++) {
+                    expected.push_back(v);
+                }
+                if (result == expected) {
+                    ok_cnt++;
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        return ok_cnt;
+    }
+
+ protected:
+    std::shared_ptr<DeploymentPlan> plan_;
+    DeploymentBatcher::Sender sender_;
+    std::atomic<int> send_cnt_;
+};
+
+TEST_F(DeploymentBatcherTest, slice) {
+    auto cursor = std::make_shared<ResultSetSlice::Cursor>(std::make_shared<FakeResultSet>(std::vector<int64_t>{
+        0, 1, 2, 3, 4}));
+    ResultSetSlice first(cursor, 0, 2);
+    ResultSetSlice second(cursor, 2, 3);
+    int64_t val = 0;
+    ASSERT_EQ(3, second.Size());
+    ASSERT_TRUE(second.Reset());
+    ASSERT_TRUE(second.Next());
+    ASSERT_TRUE(second.GetInt64(0, &val));
+    ASSERT_EQ(2, val);
+    // go back
+    ASSERT_TRUE(first.Reset());
+    ASSERT_TRUE(first.Next());
+    ASSERT_TRUE(first.Next());
+    ASSERT_TRUE(first.GetInt64(0, &val));
+    ASSERT_EQ(1, val);
+    ASSERT_FALSE(first.Next());
+    ASSERT_TRUE(second.Reset());
+    for (int64_t i = 2; i < 5; i++) {
+        ASSERT_TRUE(second.Next());
+        ASSERT_TRUE(second.GetInt64(0, &val));
+        ASSERT_EQ(i, val);
+    }
+    ASSERT_FALSE(second.Next());
+}
+
+TEST_F(DeploymentBatcherTest, merge) {
+    // the leader waits until all the rows are queued
+    DeploymentBatcher batcher(plan_, 8, 10 * 1000 * 1000);
+    ASSERT_EQ(8, RunCalls(&batcher, 8, 1));
+    ASSERT_EQ(1, send_cnt_);
+}
+
+TEST_F(DeploymentBatcherTest, maxRows) {
+    // a call is never split, so every request has one call
+    DeploymentBatcher batcher(plan_, 3, 1000);
+    ASSERT_EQ(6, RunCalls(&batcher, 6, 2));
+    ASSERT_EQ(6, send_cnt_);
+}
+
+TEST_F(DeploymentBatcherTest, noWait) {
+    DeploymentBatcher batcher(plan_, 64, 0);
+    ASSERT_EQ(16, RunCalls(&batcher, 16, 3));
+    ASSERT_LE(send_cnt_, 16);
+}
+
+TEST_F(DeploymentBatcherTest, fail) {
+    DeploymentBatcher batcher(plan_, 64, 0);
+    int done_cnt = 0;
+    batcher.Call(BuildBatch(0, 2),
+                 [](std::shared_ptr<sdk::SQLRequestRowBatch>, hybridse::sdk::Status* status) {
+                     status->code = -1;
+                     status->msg = "request server error";
+                     return std::shared_ptr<hybridse::sdk::ResultSet>();
+                 },
+                 [&done_cnt](const std::shared_ptr<hybridse::sdk::ResultSet>& rs, const hybridse::sdk::Status& status) {
+                     ASSERT_FALSE(rs);
+                     ASSERT_EQ("request server error", status.msg);
+                     done_cnt++;
+                 });
+    ASSERT_EQ(1, done_cnt);
+
+    // the result doesn't match the rows
+    batcher.Call(BuildBatch(0, 2),
+                 [](std::shared_ptr<sdk::SQLRequestRowBatch>, hybridse::sdk::Status*) {
+                     return std::make_shared<FakeResultSet>(std::vector<int64_t>{0});
+                 },
+                 [&done_cnt](const std::shared_ptr<hybridse::sdk::ResultSet>& rs, const hybridse::sdk::Status& status) {
+                     ASSERT_FALSE(rs);
+                     ASSERT_EQ("result size mismatch", status.msg);
+                     done_cnt++;
+                 });
+    ASSERT_EQ(2, done_cnt);
+}
+
+}  // namespace apiserver
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
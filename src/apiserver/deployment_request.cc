@@ -0,0 +1,422 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apiserver/deployment_request.h"
+
+#include <cstring>
+#include <limits>
+#include <set>
+
+#include "boost/lexical_cast.hpp"
+#include "codec/fe_row_codec.h"
+#include "glog/logging.h"
+#include "json2pb/rapidjson.h"
+
+namespace openmldb {
+namespace apiserver {
+
+static uint32_t FixedTypeSize(hybridse::sdk::DataType type) {
+    switch (type) {
+        case hybridse::sdk::kTypeBool:
+            return sizeof(bool);
+        case hybridse::sdk::kTypeInt16:
+            return sizeof(int16_t);
+        case hybridse::sdk::kTypeInt32:
+        case hybridse::sdk::kTypeDate:
+            return sizeof(int32_t);
+        case hybridse::sdk::kTypeFloat:
+            return sizeof(float);
+        case hybridse::sdk::kTypeInt64:
+        case hybridse::sdk::kTypeTimestamp:
+            return sizeof(int64_t);
+        case hybridse::sdk::kTypeDouble:
+            return sizeof(double);
+        default:
+            return 0;
+    }
+}
+
+DeploymentPlan::DeploymentPlan(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& info) : sp_info(info) {
+    const auto& schema_impl = dynamic_cast<const ::hybridse::sdk::SchemaImpl&>(sp_info->GetInputSchema());
+    input_schema = std::make_shared<::hybridse::sdk::SchemaImpl>(schema_impl.GetSchema());
+    common_column_indices = std::make_shared<sdk::ColumnIndicesSet>(input_schema);
+    empty_column_indices = std::make_shared<sdk::ColumnIndicesSet>(input_schema);
+    fixed_row_size = ::hybridse::codec::GetStartOffset(input_schema->GetColumnCnt());
+    uint32_t non_common_col_cnt = 0;
+    for (int i = 0; i < input_schema->GetColumnCnt(); ++i) {
+        Column column;
+        column.type = input_schema->GetColumnType(i);
+        column.not_null = input_schema->IsColumnNotNull(i);
+        column.is_constant = input_schema->IsConstant(i);
+        if (column.is_constant) {
+            common_column_indices->AddCommonColumnIdx(i);
+            column.pos = common_col_cnt++;
+        } else {
+            column.pos = non_common_col_cnt++;
+        }
+        if (column.type == hybridse::sdk::kTypeString) {
+            str_col_cnt++;
+        } else {
+            fixed_row_size += FixedTypeSize(column.type);
+        }
+        columns.push_back(column);
+    }
+}
+
+namespace {
+
+// SAX handler of the execute request body. The fields are kept in JsonRequest, the rows are built after the whole
+// body is parsed, cuz common_cols may be behind input.
+class RequestHandler {
+ public:
+    enum Target { kNone, kInput, kCommonCols, kNeedSchema };
+
+    RequestHandler(bool has_common_col, JsonRequest* request, std::string* msg)
+        : has_common_col_(has_common_col), request_(request), msg_(msg) {}
+
+    bool Null() { return OnValue(JsonField()); }
+    bool Bool(bool b) {
+        JsonField field;
+        field.kind = JsonField::kBool;
+        field.b = b;
+        return OnValue(field);
+    }
+    bool Int(int i) { return OnInteger(i, true, true); }
+    bool Uint(unsigned u) { return OnInteger(u, u <= std::numeric_limits<int32_t>::max(), true); }
+    bool Int64(int64_t i) {
+        return OnInteger(i, i >= std::numeric_limits<int32_t>::min() && i <= std::numeric_limits<int32_t>::max(),
+                         true);
+    }
+    bool Uint64(uint64_t u) {
+        return OnInteger(static_cast<int64_t>(u), u <= std::numeric_limits<int32_t>::max(),
+                         u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()));
+    }
+    bool Double(double d) {
+        JsonField field;
+        field.kind = JsonField::kDouble;
+        field.d = d;
+        return OnValue(field);
+    }
+    bool String(const char* str, butil::rapidjson::SizeType length, bool copy) {
+        // the reader may pass the keys by String
+        if (depth_ == 1 && expect_key_) {
+            return Key(str, length, copy);
+        }
+        JsonField field;
+        field.kind = JsonField::kString;
+        field.s = str;
+        field.len = length;
+        return OnValue(field);
+    }
+    bool StartObject() {
+        JsonField field;
+        field.kind = JsonField::kOther;
+        if (!OnValue(field, false, depth_ == 0)) {
+            return false;
+        }
+        depth_++;
+        return true;
+    }
+    bool Key(const char* str, butil::rapidjson::SizeType, bool) {
+        if (depth_ == 1) {
+            expect_key_ = false;
+            if (strcmp(str, "input") == 0) {
+                target_ = kInput;
+            } else if (strcmp(str, "common_cols") == 0) {
+                target_ = kCommonCols;
+            } else if (strcmp(str, "need_schema") == 0) {
+                target_ = kNeedSchema;
+            } else {
+                target_ = kNone;
+            }
+        }
+        return true;
+    }
+    bool EndObject(butil::rapidjson::SizeType) {
+        depth_--;
+        return true;
+    }
+    bool StartArray() {
+        JsonField field;
+        field.kind = JsonField::kOther;
+        if (!OnValue(field, true)) {
+            return false;
+        }
+        depth_++;
+        return true;
+    }
+    bool EndArray(butil::rapidjson::SizeType) {
+        if (depth_ == 3 && target_ == kInput) {
+            // one input row end
+            request_->row_offsets.push_back(request_->input.size());
+        }
+        depth_--;
+        return true;
+    }
+
+    bool has_input() const { return has_input_; }
+
+ private:
+    bool OnInteger(int64_t i, bool is_int, bool is_int64) {
+        JsonField field;
+        field.kind = JsonField::kInteger;
+        field.i = i;
+        field.is_int = is_int;
+        field.is_int64 = is_int64;
+        return OnValue(field);
+    }
+
+    // depth_ is the depth of the parent
+    bool OnValue(const JsonField& field, bool is_array = false, bool is_object = false) {
+        switch (depth_) {
+            case 0:
+                if (!is_object) {
+                    *msg_ = "Json parse failed";
+                    return false;
+                }
+                expect_key_ = true;
+                return true;
+            case 1:
+                expect_key_ = true;
+                if (target_ == kInput) {
+                    if (!is_array) {
+                        *msg_ = "Invalid input";
+                        return false;
+                    }
+                    has_input_ = true;
+                    request_->input.clear();
+                    request_->row_offsets.assign(1, 0);
+                } else if (target_ == kCommonCols && has_common_col_) {
+                    if (!is_array) {
+                        *msg_ = "common_cols is not array";
+                        return false;
+                    }
+                    request_->common_cols.clear();
+                } else if (target_ == kNeedSchema) {
+                    request_->need_schema = field.kind == JsonField::kBool && field.b;
+                }
+                return true;
+            case 2:
+                if (target_ == kInput) {
+                    if (!is_array) {
+                        *msg_ = "Invalid input data row";
+                        return false;
+                    }
+                } else if (target_ == kCommonCols && has_common_col_) {
+                    request_->common_cols.push_back(field);
+                }
+                return true;
+            case 3:
+                if (target_ == kInput) {
+                    request_->input.push_back(field);
+                }
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    bool has_common_col_;
+    JsonRequest* request_;
+    std::string* msg_;
+    int depth_ = 0;
+    Target target_ = kNone;
+    bool expect_key_ = false;
+    bool has_input_ = false;
+};
+
+bool ParseDate(const JsonField& field, int32_t* year, int32_t* month, int32_t* day) {
+    int32_t* parts[3] = {year, month, day};
+    const char* begin = field.s;
+    const char* end = field.s + field.len;
+    for (int i = 0; i < 3; i++) {
+        const char* sep = i < 2 ? static_cast<const char*>(memchr(begin, '-', end - begin)) : end;
+        if (sep == nullptr || !boost::conversion::try_lexical_convert(begin, sep - begin, *parts[i])) {
+            return false;
+        }
+        begin = sep + 1;
+    }
+    return true;
+}
+
+// the same conversions as APIServerImpl::AppendJsonValue
+bool AppendField(const JsonField& field, const DeploymentPlan::Column& column, sdk::SQLRequestRow* row) {
+    if (field.kind == JsonField::kNull) {
+        if (column.not_null) {
+            return false;
+        }
+        return row->AppendNULL();
+    }
+    switch (column.type) {
+        case hybridse::sdk::kTypeBool:
+            return field.kind == JsonField::kBool && row->AppendBool(field.b);
+        case hybridse::sdk::kTypeInt16:
+            if (!field.is_int || field.i < std::numeric_limits<int16_t>::min() ||
+                field.i > std::numeric_limits<int16_t>::max()) {
+                return false;
+            }
+            return row->AppendInt16(static_cast<int16_t>(field.i));
+        case hybridse::sdk::kTypeInt32:
+            return field.is_int && row->AppendInt32(static_cast<int32_t>(field.i));
+        case hybridse::sdk::kTypeInt64:
+            return field.is_int64 && row->AppendInt64(field.i);
+        case hybridse::sdk::kTypeFloat:
+            return field.kind == JsonField::kDouble && row->AppendFloat(static_cast<float>(field.d));
+        case hybridse::sdk::kTypeDouble:
+            return field.kind == JsonField::kDouble && row->AppendDouble(field.d);
+        case hybridse::sdk::kTypeString:
+            return field.kind == JsonField::kString && row->AppendString(field.s, field.len);
+        case hybridse::sdk::kTypeDate: {
+            int32_t year = 0, month = 0, day = 0;
+            if (field.kind != JsonField::kString || !ParseDate(field, &year, &month, &day)) {
+                return false;
+            }
+            return row->AppendDate(year, month, day);
+        }
+        case hybridse::sdk::kTypeTimestamp:
+            return field.is_int64 && row->AppendTimestamp(field.i);
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+bool ParseJsonRequest(char* body, bool has_common_col, JsonRequest* request, std::string* msg) {
+    RequestHandler handler(has_common_col, request, msg);
+    butil::rapidjson::Reader reader;
+    butil::rapidjson::InsituStringStream stream(body);
+    reader.Parse<butil::rapidjson::kParseInsituFlag>(stream, handler);
+    if (reader.HasParseError()) {
+        if (msg->empty()) {
+            *msg = "Json parse failed";
+        }
+        return false;
+    }
+    if (!handler.has_input() || request->row_offsets.size() <= 1) {
+        *msg = "Invalid input";
+        return false;
+    }
+    return true;
+}
+
+bool BuildRequestRows(const DeploymentPlan& plan, bool has_common_col, const JsonRequest& request,
+                      std::shared_ptr<sdk::SQLRequestRowBatch>* batch, std::string* msg) {
+    uint32_t expected_common_size = has_common_col ? plan.common_col_cnt : 0;
+    if (has_common_col && request.common_cols.size() != expected_common_size) {
+        *msg = "Invalid common cols size";
+        return false;
+    }
+    uint32_t expected_input_size = plan.columns.size() - expected_common_size;
+    *batch = std::make_shared<sdk::SQLRequestRowBatch>(
+        plan.input_schema, has_common_col ? plan.common_column_indices : plan.empty_column_indices);
+    // the row is reused, the batch copies the encoded row
+    sdk::SQLRequestRow row(plan.input_schema, std::set<std::string>());
+    for (size_t r = 0; r + 1 < request.row_offsets.size(); r++) {
+        uint32_t begin = request.row_offsets[r];
+        if (request.row_offsets[r + 1] - begin != expected_input_size) {
+            *msg = "Invalid input data row";
+            return false;
+        }
+        auto get_field = [&](uint32_t idx) -> const JsonField& {
+            const auto& column = plan.columns[idx];
+            if (!has_common_col) {
+                return request.input[begin + idx];
+            }
+            return column.is_constant ? request.common_cols[column.pos] : request.input[begin + column.pos];
+        };
+        // scan all strings to init the total string length
+        uint32_t str_len_sum = 0;
+        for (uint32_t i = 0; i < plan.columns.size(); i++) {
+            const auto& field = get_field(i);
+            if (plan.columns[i].type == hybridse::sdk::kTypeString && field.kind == JsonField::kString) {
+                str_len_sum += field.len;
+            }
+        }
+        row.Init(static_cast<int32_t>(str_len_sum));
+        for (uint32_t i = 0; i < plan.columns.size(); i++) {
+            if (!AppendField(get_field(i), plan.columns[i], &row)) {
+                *msg = "Translate to request row failed";
+                return false;
+            }
+        }
+        if (!row.Build() ||
+            !(*batch)->AddRow(reinterpret_cast<const int8_t*>(row.GetRow().data()), row.GetRow().size())) {
+            *msg = "Translate to request row failed";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParseBinaryRequest(const DeploymentPlan& plan, const butil::IOBuf& body,
+                        std::shared_ptr<sdk::SQLRequestRowBatch>* batch, std::string* msg) {
+    if (body.empty()) {
+        *msg = "Invalid input";
+        return false;
+    }
+    std::string data = body.to_string();
+    *batch = std::make_shared<sdk::SQLRequestRowBatch>(plan.input_schema, plan.empty_column_indices);
+    ::hybridse::codec::RowView view(plan.input_schema->GetSchema());
+    const auto* buf = reinterpret_cast<const int8_t*>(data.data());
+    uint64_t offset = 0;
+    while (offset < data.size()) {
+        const int8_t* row = buf + offset;
+        uint64_t remain = data.size() - offset;
+        uint32_t size = 0;
+        if (remain > ::hybridse::codec::HEADER_LENGTH) {
+            memcpy(&size, row + ::hybridse::codec::VERSION_LENGTH, sizeof(size));
+        }
+        uint64_t str_start = plan.fixed_row_size + ::hybridse::codec::GetAddrLength(size) * plan.str_col_cnt;
+        if (size > remain || size < str_start || !view.Reset(row, size)) {
+            *msg = "Invalid input data row";
+            return false;
+        }
+        for (uint32_t i = 0; i < plan.columns.size(); i++) {
+            if (view.IsNULL(i)) {
+                if (plan.columns[i].not_null) {
+                    *msg = "Invalid input data row";
+                    return false;
+                }
+                continue;
+            }
+            if (plan.columns[i].type != hybridse::sdk::kTypeString) {
+                continue;
+            }
+            // the string offsets come from the client, they must be in the row
+            const char* val = nullptr;
+            uint32_t len = 0;
+            if (view.GetString(i, &val, &len) != 0) {
+                *msg = "Invalid input data row";
+                return false;
+            }
+            uint64_t val_offset = reinterpret_cast<const int8_t*>(val) - row;
+            if (val_offset < str_start || val_offset > size || len > size - val_offset) {
+                *msg = "Invalid input data row";
+                return false;
+            }
+        }
+        if (!(*batch)->AddRow(row, size)) {
+            *msg = "Translate to request row failed";
+            return false;
+        }
+        offset += size;
+    }
+    return true;
+}
+
+}  // namespace apiserver
+}  // namespace openmldb
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_APISERVER_DEPLOYMENT_REQUEST_H_
+#define SRC_APISERVER_DEPLOYMENT_REQUEST_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "butil/iobuf.h"
+#include "sdk/base.h"
+#include "sdk/base_impl.h"
+#include "sdk/sql_request_row.h"
+
+namespace openmldb {
+namespace apiserver {
+
+// The column plan of a procedure or deployment. It is computed once and reused by the requests until the
+// procedure is recreated.
+struct DeploymentPlan {
+    struct Column {
+        hybridse::sdk::DataType type;
+        bool not_null;
+        bool is_constant;
+        // the position in common_cols if the column is constant, otherwise in the input row. It's only used when
+        // the request has common cols, or the input row has all the columns.
+        uint32_t pos;
+    };
+
+    explicit DeploymentPlan(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& info);
+
+    std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info;
+    // hard copy of the input schema, RequestRow needs shared schema
+    std::shared_ptr<hybridse::sdk::SchemaImpl> input_schema;
+    std::vector<Column> columns;
+    uint32_t common_col_cnt = 0;
+    std::shared_ptr<sdk::ColumnIndicesSet> common_column_indices;
+    // no common column, used when the request has no common cols
+    std::shared_ptr<sdk::ColumnIndicesSet> empty_column_indices;
+    // the header, the bitmap and the non-string columns of a row
+    uint32_t fixed_row_size = 0;
+    uint32_t str_col_cnt = 0;
+};
+
+// A json scalar which refers to the in-situ parsed body.
+struct JsonField {
+    enum Kind { kNull, kBool, kInteger, kDouble, kString, kOther };
+    Kind kind = kNull;
+    // the same as rapidjson IsInt and IsInt64
+    bool is_int = false;
+    bool is_int64 = false;
+    bool b = false;
+    int64_t i = 0;
+    double d = 0;
+    const char* s = nullptr;
+    uint32_t len = 0;
+};
+
+// The body {"input": [[...], ...], "common_cols": [...], "need_schema": bool} of an execute request.
+struct JsonRequest {
+    // the fields of all the input rows, row i is [row_offsets[i], row_offsets[i + 1])
+    std::vector<JsonField> input;
+    std::vector<uint32_t> row_offsets;
+    std::vector<JsonField> common_cols;
+    bool need_schema = false;
+};
+
+// Parse the body in one pass without building a DOM. body must be null-terminated, it's modified by the in-situ
+// parsing and must outlive the request.
+bool ParseJsonRequest(char* body, bool has_common_col, JsonRequest* request, std::string* msg);
+
+// Write the fields into the request rows following the plan, the rows are added to the batch.
+bool BuildRequestRows(const DeploymentPlan& plan, bool has_common_col, const JsonRequest& request,
+                      std::shared_ptr<sdk::SQLRequestRowBatch>* batch, std::string* msg);
+
+// The binary body is the concatenation of the input rows encoded in the row codec, every row has all the columns
+// of the input schema. The rows are checked before they are added to the batch.
+bool ParseBinaryRequest(const DeploymentPlan& plan, const butil::IOBuf& body,
+                        std::shared_ptr<sdk::SQLRequestRowBatch>* batch, std::string* msg);
+
+}  // namespace apiserver
+}  // namespace openmldb
+
+#endif  // SRC_APISERVER_DEPLOYMENT_REQUEST_H_
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "apiserver/deployment_request.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/base.h"
+#include "codec/fe_row_codec.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace apiserver {
+
+class DeploymentRequestTest : public ::testing::Test {
+ public:
+    // c1 string, c2 int constant, c3 bigint, c4 date, c5 string constant
+    static std::shared_ptr<DeploymentPlan> CreatePlan() {
+        ::openmldb::api::ProcedureInfo sp;
+        sp.set_db_name("db");
+        sp.set_sp_name("sp");
+        auto add_column = [&sp](const std::string& name, ::openmldb::type::DataType type, bool is_constant) {
+            auto* column = sp.add_input_schema();
+            column->set_name(name);
+            column->set_data_type(type);
+            column->set_is_constant(is_constant);
+        };
+        add_column("c1", ::openmldb::type::kString, false);
+        add_column("c2", ::openmldb::type::kInt, true);
+        add_column("c3", ::openmldb::type::kBigInt, false);
+        add_column("c4", ::openmldb::type::kDate, false);
+        add_column("c5", ::openmldb::type::kString, true);
+        return std::make_shared<DeploymentPlan>(std::make_shared<catalog::ProcedureInfoImpl>(sp));
+    }
+
+    static bool Parse(const DeploymentPlan& plan, bool has_common_col, const std::string& json,
+                      std::shared_ptr<sdk::SQLRequestRowBatch>* batch, bool* need_schema, std::string* msg) {
+        std::string body = json;
+        JsonRequest request;
+        if (!ParseJsonRequest(&body[0], has_common_col, &request, msg) ||
+            !BuildRequestRows(plan, has_common_col, request, batch, msg)) {
+            return false;
+        }
+        *need_schema = request.need_schema;
+        return true;
+    }
+
+    static std::string BuildRow(const DeploymentPlan& plan, const std::string& c1, int32_t c2, int64_t c3,
+                                const std::string& c5) {
+        sdk::SQLRequestRow row(plan.input_schema, std::set<std::string>());
+        row.Init(c1.size() + c5.size());
+        row.AppendString(c1);
+        row.AppendInt32(c2);
+        row.AppendInt64(c3);
+        row.AppendDate(2021, 8, 1);
+        row.AppendString(c5);
+        row.Build();
+        return row.GetRow();
+    }
+};
+
+TEST_F(DeploymentRequestTest, plan) {
+    auto plan = CreatePlan();
+    ASSERT_EQ(5u, plan->columns.size());
+    ASSERT_EQ(2u, plan->common_col_cnt);
+    ASSERT_EQ(2u, plan->str_col_cnt);
+    ASSERT_TRUE(plan->columns[1].is_constant);
+    ASSERT_EQ(0u, plan->columns[1].pos);
+    ASSERT_EQ(1u, plan->columns[4].pos);
+    ASSERT_EQ(2u, plan->columns[3].pos);
+    // header 6, bitmap 1, int 4, bigint 8, date 4
+    ASSERT_EQ(23u, plan->fixed_row_size);
+}
+
+TEST_F(DeploymentRequestTest, json) {
+    auto plan = CreatePlan();
+    std::shared_ptr<sdk::SQLRequestRowBatch> batch;
+    bool need_schema = false;
+    std::string msg;
+    ASSERT_TRUE(Parse(*plan, true,
+                      R"({"other": {"input": 1, "x": [[1]]}, "input": [["a", 10, "2021-08-01"],
+                          ["bb", 4294967296, null]], "common_cols": [3, "cc"], "need_schema": true})",
+                      &batch, &need_schema, &msg))
+        << msg;
+    ASSERT_TRUE(need_schema);
+    ASSERT_EQ(2, batch->Size());
+
+    // the common slice has c2 and c5
+    ::hybridse::codec::Schema common_schema;
+    *common_schema.Add() = plan->input_schema->GetSchema().Get(1);
+    *common_schema.Add() = plan->input_schema->GetSchema().Get(4);
+    ::hybridse::codec::RowView common_view(common_schema);
+    const auto* common = batch->GetCommonSlice();
+    ASSERT_TRUE(common_view.Reset(reinterpret_cast<const int8_t*>(common->data()), common->size()));
+    ASSERT_EQ(3, common_view.GetInt32Unsafe(0));
+    ASSERT_EQ("cc", common_view.GetStringUnsafe(1));
+
+    ::hybridse::codec::Schema non_common_schema;
+    for (int i : {0, 2, 3}) {
+        *non_common_schema.Add() = plan->input_schema->GetSchema().Get(i);
+    }
+    ::hybridse::codec::RowView view(non_common_schema);
+    const auto* row = batch->GetNonCommonSlice(1);
+    ASSERT_TRUE(view.Reset(reinterpret_cast<const int8_t*>(row->data()), row->size()));
+    ASSERT_EQ("bb", view.GetStringUnsafe(0));
+    ASSERT_EQ(4294967296L, view.GetInt64Unsafe(1));
+    ASSERT_TRUE(view.IsNULL(2));
+
+    // without common cols, the input rows have all the columns
+    ASSERT_TRUE(Parse(*plan, false, R"({"input": [["a", 3, 10, "2021-08-01", "cc"]], "common_cols": 1})", &batch,
+                      &need_schema, &msg))
+        << msg;
+    ASSERT_FALSE(need_schema);
+    ASSERT_EQ(1, batch->Size());
+    ASSERT_EQ(BuildRow(*plan, "a", 3, 10, "cc"), *batch->GetNonCommonSlice(0));
+}
+
+TEST_F(DeploymentRequestTest, invalidJson) {
+    auto plan = CreatePlan();
+    std::shared_ptr<sdk::SQLRequestRowBatch> batch;
+    bool need_schema = false;
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {R"({"input": [["a", 10, "2021-08-01"]], )", "Json parse failed"},
+        {R"([1])", "Json parse failed"},
+        {R"({"input": [["a", 10, "2021-08-01"]], "common_cols": {}})", "common_cols is not array"},
+        {R"({"common_cols": [3, "cc"]})", "Invalid input"},
+        {R"({"input": [], "common_cols": [3, "cc"]})", "Invalid input"},
+        {R"({"input": {}, "common_cols": [3, "cc"]})", "Invalid input"},
+        {R"({"input": [["a", 10, "2021-08-01"]], "common_cols": [3]})", "Invalid common cols size"},
+        {R"({"input": ["a", 10, "2021-08-01"], "common_cols": [3, "cc"]})", "Invalid input data row"},
+        {R"({"input": [["a", 10]], "common_cols": [3, "cc"]})", "Invalid input data row"},
+        {R"({"input": [["a", 10, "2021-08"]], "common_cols": [3, "cc"]})", "Translate to request row failed"},
+        {R"({"input": [["a", 1.5, "2021-08-01"]], "common_cols": [3, "cc"]})", "Translate to request row failed"},
+        {R"({"input": [["a", 10, "2021-08-01"]], "common_cols": [4294967296, "cc"]})",
+         "Translate to request row failed"},
+        {R"({"input": [["a", 10, "2021-08-01"]], "common_cols": [[3], "cc"]})", "Translate to request row failed"},
+    };
+    for (const auto& c : cases) {
+        std::string msg;
+        ASSERT_FALSE(Parse(*plan, true, c.first, &batch, &need_schema, &msg)) << c.first;
+        ASSERT_EQ(c.second, msg) << c.first;
+    }
+}
+
+TEST_F(DeploymentRequestTest, binary) {
+    auto plan = CreatePlan();
+    auto row1 = BuildRow(*plan, "a", 3, 10, "cc");
+    auto row2 = BuildRow(*plan, "bb", 4, 20, "");
+    butil::IOBuf body;
+    body.append(row1);
+    body.append(row2);
+    std::shared_ptr<sdk::SQLRequestRowBatch> batch;
+    std::string msg;
+    ASSERT_TRUE(ParseBinaryRequest(*plan, body, &batch, &msg)) << msg;
+    ASSERT_EQ(2, batch->Size());
+    ASSERT_EQ(row1, *batch->GetNonCommonSlice(0));
+    ASSERT_EQ(row2, *batch->GetNonCommonSlice(1));
+
+    // truncated row
+    body.clear();
+    body.append(row1);
+    body.append(row2.substr(0, row2.size() - 1));
+    ASSERT_FALSE(ParseBinaryRequest(*plan, body, &batch, &msg));
+    ASSERT_EQ("Invalid input data row", msg);
+
+    // the string offset is out of the row
+    auto bad_row = row1;
+    bad_row[plan->fixed_row_size] = static_cast<char>(row1.size() + 1);
+    body.clear();
+    body.append(bad_row);
+    ASSERT_FALSE(ParseBinaryRequest(*plan, body, &batch, &msg));
+    ASSERT_EQ("Invalid input data row", msg);
+
+    body.clear();
+    ASSERT_FALSE(ParseBinaryRequest(*plan, body, &batch, &msg));
+    ASSERT_EQ("Invalid input", msg);
+}
+
+}  // namespace apiserver
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -252,6 +252,8 @@ JsonWriter::~JsonWriter() {
 
 const char* JsonWriter::GetString() const { return STREAM->GetString(); }
 
+size_t JsonWriter::GetSize() const { return STREAM->GetSize(); }
+
 JsonWriter& JsonWriter::StartObject() {
     WRITER->StartObject();
     return *this;
@@ -94,6 +94,8 @@ class JsonWriter {
 
     /// Obtains the serialized JSON string.
     const char* GetString() const;
+    /// The size of the serialized JSON string.
+    size_t GetSize() const;
 
     // Archive concept
 
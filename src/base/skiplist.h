@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <new>
 
 #include "base/random.h"
 
@@ -40,19 +41,31 @@ struct DefaultComparator {
 };
 
 // Skiplist node , a thread safe structure
+// The level links are laid out inline right after the node, so a node must be
+// allocated with its height, e.g. `new (height) Node<K, V>(key, value, height)`
 template <class K, class V>
 class Node {
  public:
     // Set data reference and Node height
     Node(const K& key, V& value, uint8_t height)  // NOLINT
         : height_(height), key_(key), value_(value) {
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+        InitNexts();
     }
 
     Node(uint8_t height) : height_(height), key_(), value_() {  // NOLINT
-        nexts_ = new std::atomic<Node<K, V>*>[height];
+        InitNexts();
     }
 
+    static void* operator new(size_t size, uint8_t height) {
+        uint8_t extra = height > 1 ? height - 1 : 0;
+        return ::operator new(size + extra * sizeof(std::atomic<Node<K, V>*>));
+    }
+
+    // the allocated size differs from sizeof(Node), so never use sized delete
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
+    static void operator delete(void* ptr, uint8_t) { ::operator delete(ptr); }
+
     // Set the next node with memory barrier
     void SetNext(uint8_t level, Node<K, V>* node) {
         assert(level < height_ && level >= 0);
@@ -81,13 +94,21 @@ class Node {
 
     const K& GetKey() const { return key_; }
 
-    ~Node() { delete[] nexts_; }
+    ~Node() {}
+
+ private:
+    void InitNexts() {
+        for (uint8_t i = 0; i < height_; i++) {
+            nexts_[i].store(NULL, std::memory_order_relaxed);
+        }
+    }
 
  private:
     uint8_t const height_;
     K const key_;
     V value_;
-    std::atomic<Node<K, V>*>* nexts_;
+    // must be the last member, the array has height_ elements actually
+    std::atomic<Node<K, V>*> nexts_[1];
 };
 
 template <class K, class V, class Comparator>
@@ -101,7 +122,7 @@ class Skiplist {
           rand_(0xdeadbeef),
           head_(NULL),
           tail_(NULL) {
-        head_ = new Node<K, V>(MaxHeight);
+        head_ = new (MaxHeight) Node<K, V>(MaxHeight);
         for (uint8_t i = 0; i < head_->Height(); i++) {
             head_->SetNext(i, NULL);
         }
@@ -364,7 +385,7 @@ class Skiplist {
 
  private:
     Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
-        Node<K, V>* node = new Node<K, V>(key, value, height);
+        Node<K, V>* node = new (height) Node<K, V>(key, value, height);
         return node;
     }
 
@@ -86,6 +86,7 @@ enum ReturnCode {
     kProcedureAlreadyExists = 157,
     kProcedureNotFound = 158,
     kCreateFunctionFailed = 159,
+    kAppendEntriesOutOfOrder = 160,
     kNameserverIsNotLeader = 300,
     kAutoFailoverIsEnabled = 301,
     kEndpointIsNotExist = 302,
@@ -120,6 +121,7 @@ enum ReturnCode {
     kCheckParameterFailed = 331,
     kCreateProcedureFailedOnTablet = 332,
     kCreateFunctionFailedOnTablet = 333,
+    kFailToUpdateStorageOptionsFromTablet = 334,
     kReplicaClusterAliasDuplicate = 400,
     kConnectRelicaClusterZkFailed = 401,
     kNotSameReplicaName = 402,
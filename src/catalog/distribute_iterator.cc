@@ -15,19 +15,130 @@
  */
 
 #include "catalog/distribute_iterator.h"
+
+#include <algorithm>
+
 #include "gflags/gflags.h"
 
 DECLARE_uint32(traverse_cnt_limit);
+DECLARE_uint32(traverse_prefetch_num);
+DECLARE_uint64(traverse_prefetch_max_bytes);
+DECLARE_int32(request_max_retry);
+DECLARE_int32(request_timeout_ms);
 
 namespace openmldb {
 namespace catalog {
 
 constexpr uint32_t INVALID_PID = UINT32_MAX;
 
+template <class Response>
+static void CancelCallback(openmldb::RpcCallback<Response>* callback) {
+    brpc::StartCancel(callback->GetController()->call_id());
+    callback->UnRef();
+}
+
+RemoteTraversePrefetcher::RemoteTraversePrefetcher(uint32_t tid,
+        const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
+    : tid_(tid), tablet_clients_(tablet_clients), next_iter_(tablet_clients_.begin()), pages_(),
+    max_page_bytes_(0), cur_pid_(INVALID_PID) {}
+
+RemoteTraversePrefetcher::~RemoteTraversePrefetcher() {
+    for (const auto& page : pages_) {
+        if (page.callback != nullptr) {
+            CancelCallback(page.callback);
+        }
+    }
+}
+
+RemoteTraversePrefetcher::Page RemoteTraversePrefetcher::Request(uint32_t pid, const std::string& pk,
+        uint64_t ts) {
+    ::openmldb::api::TraverseRequest request;
+    request.set_tid(tid_);
+    request.set_pid(pid);
+    request.set_limit(FLAGS_traverse_cnt_limit);
+    if (!pk.empty()) {
+        request.set_pk(pk);
+        request.set_ts(ts);
+    }
+    request.set_skip_current_pk(false);
+    auto cntl = std::make_shared<brpc::Controller>();
+    cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+    cntl->set_max_retry(FLAGS_request_max_retry);
+    auto callback = new openmldb::RpcCallback<openmldb::api::TraverseResponse>(
+            std::make_shared<openmldb::api::TraverseResponse>(), cntl);
+    // one reference for Run and one for the page
+    callback->Ref();
+    auto iter = tablet_clients_.find(pid);
+    if (iter == tablet_clients_.end() || !iter->second->AsyncTraverse(request, callback)) {
+        callback->UnRef();
+        callback->UnRef();
+        return {pid, nullptr};
+    }
+    DLOG(INFO) << "traverse pid " << pid << " last pk " << pk << " key " << ts;
+    return {pid, callback};
+}
+
+void RemoteTraversePrefetcher::Fill() {
+    uint32_t max_num = std::max(FLAGS_traverse_prefetch_num, 1u);
+    while (next_iter_ != tablet_clients_.end() && pages_.size() < max_num) {
+        if (!pages_.empty() && (pages_.size() + 1) * max_page_bytes_ > FLAGS_traverse_prefetch_max_bytes) {
+            break;
+        }
+        pages_.push_back(Request(next_iter_->first, "", 0));
+        next_iter_++;
+    }
+}
+
+std::shared_ptr<openmldb::api::TraverseResponse> RemoteTraversePrefetcher::Wait(const Page& page) {
+    if (page.callback == nullptr) {
+        return {};
+    }
+    auto cntl = page.callback->GetController();
+    brpc::Join(cntl->call_id());
+    std::shared_ptr<openmldb::api::TraverseResponse> response;
+    if (cntl->Failed()) {
+        LOG(WARNING) << "fail to traverse tid " << tid_ << " pid " << page.pid << ": " << cntl->ErrorText();
+    } else if (page.callback->GetResponse()->code() != 0) {
+        LOG(WARNING) << "fail to traverse tid " << tid_ << " pid " << page.pid << ": "
+            << page.callback->GetResponse()->msg();
+    } else {
+        response = page.callback->GetResponse();
+    }
+    page.callback->UnRef();
+    return response;
+}
+
+std::shared_ptr<::openmldb::base::TraverseKvIterator> RemoteTraversePrefetcher::Next() {
+    while (true) {
+        Fill();
+        if (pages_.empty()) {
+            return {};
+        }
+        Page page = pages_.front();
+        pages_.pop_front();
+        cur_pid_ = page.pid;
+        auto response = Wait(page);
+        if (!response) {
+            continue;
+        }
+        max_page_bytes_ = std::max<uint64_t>(max_page_bytes_, response->ByteSizeLong());
+        auto kv_it = std::make_shared<::openmldb::base::TraverseKvIterator>(response);
+        DLOG(INFO) << "pid " << page.pid << " count " << response->count();
+        if (!kv_it->Valid()) {
+            continue;
+        }
+        if (!kv_it->IsFinish()) {
+            // double buffer the partition
+            pages_.push_front(Request(page.pid, kv_it->GetLastPK(), kv_it->GetLastTS()));
+        }
+        return kv_it;
+    }
+}
+
 FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
         const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
     : tid_(tid), tables_(tables), tablet_clients_(tablet_clients), in_local_(true), cur_pid_(INVALID_PID),
-    it_(), kv_it_(), key_(0), last_ts_(0), last_pk_(), value_() {
+    it_(), kv_it_(), key_(0), value_() {
 }
 
 void FullTableIterator::SeekToFirst() {
@@ -49,6 +160,7 @@ void FullTableIterator::Next() {
 void FullTableIterator::Reset() {
     it_.reset();
     kv_it_.reset();
+    prefetcher_.reset();
     cur_pid_ = INVALID_PID;
     in_local_ = true;
 }
@@ -114,43 +226,16 @@ bool FullTableIterator::NextFromRemote() {
             return true;
         }
     }
-    auto iter = tablet_clients_.begin();
-    if (cur_pid_ == INVALID_PID) {
-        cur_pid_ = iter->first;
-    } else {
-        iter = tablet_clients_.find(cur_pid_);
+    if (!prefetcher_) {
+        prefetcher_.reset(new RemoteTraversePrefetcher(tid_, tablet_clients_));
     }
-    do {
-        if (iter == tablet_clients_.end()) {
-            return false;
-        }
-        cur_pid_ = iter->first;
-        uint32_t count = 0;
-        if (kv_it_) {
-            if (!kv_it_->IsFinish()) {
-                kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", last_pk_, last_ts_,
-                            FLAGS_traverse_cnt_limit, false, count);
-                DLOG(INFO) << "pid " << cur_pid_ << " last pk " << last_pk_ <<
-                    " key " << last_ts_ << " count " << count;
-            } else {
-                iter++;
-                kv_it_.reset();
-                continue;
-            }
-        } else {
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count);
-            DLOG(INFO) << "count " << count;
-        }
-        if (kv_it_ && kv_it_->Valid()) {
-            last_pk_ = kv_it_->GetLastPK();
-            last_ts_ = kv_it_->GetLastTS();
-            response_vec_.emplace_back(kv_it_->GetResponse());
-            key_ = kv_it_->GetKey();
-            break;
-        }
-        iter++;
-        kv_it_.reset();
-    } while (true);
+    kv_it_ = prefetcher_->Next();
+    if (!kv_it_) {
+        return false;
+    }
+    cur_pid_ = prefetcher_->GetCurPid();
+    response_vec_.emplace_back(kv_it_->GetResponse());
+    key_ = kv_it_->GetKey();
     return true;
 }
 
@@ -396,7 +481,8 @@ RemoteWindowIterator::RemoteWindowIterator(uint32_t tid, uint32_t pid, const std
         const std::shared_ptr<::openmldb::base::KvIterator>& kv_it,
         const std::shared_ptr<openmldb::client::TabletClient>& client)
     : tid_(tid), pid_(pid), index_name_(index_name), kv_it_(kv_it), tablet_client_(client),
-        is_traverse_data_(false), ts_(0), ts_cnt_(0) {
+        is_traverse_data_(false), ts_(0), ts_cnt_(0), page_pos_(0), prefetch_(nullptr), prefetch_ts_(0),
+        prefetch_ts_cnt_(0) {
     if (kv_it_ && kv_it_->Valid()) {
         pk_ = kv_it_->GetPK();
         ts_ = kv_it_->GetKey();
@@ -409,6 +495,8 @@ RemoteWindowIterator::RemoteWindowIterator(uint32_t tid, uint32_t pid, const std
     }
 }
 
+RemoteWindowIterator::~RemoteWindowIterator() { DiscardPrefetch(); }
+
 bool RemoteWindowIterator::Valid() const {
     if (!kv_it_ || !kv_it_->Valid()) {
         return false;
@@ -430,17 +518,88 @@ void RemoteWindowIterator::SetTs() {
 }
 
 void RemoteWindowIterator::ScanRemote(uint64_t key, uint32_t ts_cnt) {
-    std::string msg;
-    kv_it_ = tablet_client_->Scan(tid_, pid_, pk_, index_name_, key, 0,
-                FLAGS_traverse_cnt_limit, ts_cnt, msg);
-    DLOG(INFO) << "scan key " << pk_ << " ts " << key << " from remote. tid "
-        << tid_ << " pid " << pid_ << " ts_cnt " << ts_cnt;
+    if (prefetch_ != nullptr && prefetch_ts_ == key && prefetch_ts_cnt_ == ts_cnt) {
+        auto cntl = prefetch_->GetController();
+        brpc::Join(cntl->call_id());
+        auto response = prefetch_->GetResponse();
+        if (!cntl->Failed() && response->code() == 0) {
+            kv_it_ = std::make_shared<::openmldb::base::ScanKvIterator>(pk_, response);
+        } else {
+            kv_it_.reset();
+        }
+        prefetch_->UnRef();
+        prefetch_ = nullptr;
+        DLOG(INFO) << "scan key " << pk_ << " ts " << key << " from prefetch. tid " << tid_ << " pid " << pid_
+            << " ts_cnt " << ts_cnt;
+    } else {
+        DiscardPrefetch();
+        std::string msg;
+        kv_it_ = tablet_client_->Scan(tid_, pid_, pk_, index_name_, key, 0,
+                    FLAGS_traverse_cnt_limit, ts_cnt, msg);
+        DLOG(INFO) << "scan key " << pk_ << " ts " << key << " from remote. tid "
+            << tid_ << " pid " << pid_ << " ts_cnt " << ts_cnt;
+    }
+    page_pos_ = 0;
     if (kv_it_ && kv_it_->Valid()) {
         response_vec_.emplace_back(kv_it_->GetResponse());
         SetTs();
     }
 }
 
+void RemoteWindowIterator::Prefetch() {
+    if (prefetch_ != nullptr || !kv_it_ || kv_it_->IsFinish()) {
+        return;
+    }
+    auto response = std::dynamic_pointer_cast<::openmldb::api::ScanResponse>(kv_it_->GetResponse());
+    if (!response || page_pos_ * 2 < response->count()) {
+        return;
+    }
+    // the position ScanRemote will be called with once the page is consumed
+    uint64_t ts = ts_;
+    uint32_t ts_cnt = ts_cnt_;
+    ::openmldb::base::ScanKvIterator it(pk_, response);
+    for (uint32_t i = 0; i < page_pos_ && it.Valid(); i++) {
+        it.Next();
+    }
+    for (it.Next(); it.Valid(); it.Next()) {
+        if (it.GetKey() == ts) {
+            ts_cnt++;
+        } else {
+            ts = it.GetKey();
+            ts_cnt = 1;
+        }
+    }
+    ::openmldb::api::ScanRequest request;
+    request.set_pk(pk_);
+    request.set_st(ts);
+    request.set_et(0);
+    request.set_tid(tid_);
+    request.set_pid(pid_);
+    request.set_idx_name(index_name_);
+    request.set_limit(FLAGS_traverse_cnt_limit);
+    request.set_skip_record_num(ts_cnt);
+    auto cntl = std::make_shared<brpc::Controller>();
+    cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+    auto callback = new openmldb::RpcCallback<openmldb::api::ScanResponse>(
+            std::make_shared<openmldb::api::ScanResponse>(), cntl);
+    callback->Ref();
+    if (!tablet_client_->AsyncScan(request, callback)) {
+        callback->UnRef();
+        callback->UnRef();
+        return;
+    }
+    prefetch_ = callback;
+    prefetch_ts_ = ts;
+    prefetch_ts_cnt_ = ts_cnt;
+}
+
+void RemoteWindowIterator::DiscardPrefetch() {
+    if (prefetch_ != nullptr) {
+        CancelCallback(prefetch_);
+        prefetch_ = nullptr;
+    }
+}
+
 void RemoteWindowIterator::Seek(const uint64_t& key) {
     DLOG(INFO) << "RemoteWindowIterator seek " << key;
     if (!kv_it_) {
@@ -451,6 +610,7 @@ void RemoteWindowIterator::Seek(const uint64_t& key) {
             break;
         }
         kv_it_->Next();
+        page_pos_++;
     }
     if (kv_it_->Valid()) {
         ts_ = kv_it_->GetKey();
@@ -462,12 +622,14 @@ void RemoteWindowIterator::Seek(const uint64_t& key) {
 
 void RemoteWindowIterator::Next() {
     kv_it_->Next();
+    page_pos_++;
     if (kv_it_->Valid()) {
         if (is_traverse_data_ && kv_it_->GetPK() != pk_) {
             kv_it_.reset();
             return;
         }
         SetTs();
+        Prefetch();
     } else if (!kv_it_->IsFinish()) {
         ScanRemote(ts_, ts_cnt_);
     }
@@ -17,6 +17,7 @@
 #ifndef SRC_CATALOG_DISTRIBUTE_ITERATOR_H_
 #define SRC_CATALOG_DISTRIBUTE_ITERATOR_H_
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -33,6 +34,45 @@ namespace catalog {
 
 using Tables = std::map<uint32_t, std::shared_ptr<::openmldb::storage::Table>>;
 
+// Traverse the remote partitions in pid order with the pages fetched ahead of the consumer.
+// While a page is consumed, the next page of its partition and the first pages of the
+// following partitions are requested asynchronously, at most FLAGS_traverse_prefetch_num
+// pages in flight and FLAGS_traverse_prefetch_max_bytes estimated by the largest page.
+class RemoteTraversePrefetcher {
+ public:
+    RemoteTraversePrefetcher(uint32_t tid,
+            const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients);
+    ~RemoteTraversePrefetcher();
+    RemoteTraversePrefetcher(const RemoteTraversePrefetcher&) = delete;
+    RemoteTraversePrefetcher& operator=(const RemoteTraversePrefetcher&) = delete;
+
+    // return the next non-empty page, or nullptr at the end
+    std::shared_ptr<::openmldb::base::TraverseKvIterator> Next();
+
+    uint32_t GetCurPid() const { return cur_pid_; }
+
+ private:
+    struct Page {
+        uint32_t pid;
+        // null if the request is not sent
+        openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback;
+    };
+
+    Page Request(uint32_t pid, const std::string& pk, uint64_t ts);
+    void Fill();
+    std::shared_ptr<openmldb::api::TraverseResponse> Wait(const Page& page);
+
+ private:
+    uint32_t tid_;
+    const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients_;
+    // the partitions not requested yet
+    std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>::const_iterator next_iter_;
+    // the pages in flight in pid order, at most one per partition
+    std::deque<Page> pages_;
+    uint64_t max_page_bytes_;
+    uint32_t cur_pid_;
+};
+
 class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hybridse::codec::Row> {
  public:
     FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
@@ -64,10 +104,9 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
     std::unique_ptr<::openmldb::storage::TableIterator> it_;
     std::shared_ptr<::openmldb::base::TraverseKvIterator> kv_it_;
     uint64_t key_;
-    uint64_t last_ts_;
-    std::string last_pk_;
     ::hybridse::codec::Row value_;
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
+    std::unique_ptr<RemoteTraversePrefetcher> prefetcher_;
 };
 
 class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
@@ -75,6 +114,7 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
     RemoteWindowIterator(uint32_t tid, uint32_t pid, const std::string& index_name,
             const std::shared_ptr<::openmldb::base::KvIterator>& kv_it,
             const std::shared_ptr<openmldb::client::TabletClient>& client);
+    ~RemoteWindowIterator() override;
 
     bool Valid() const override;
 
@@ -96,6 +136,9 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
  private:
     void SetTs();
     void ScanRemote(uint64_t key, uint32_t ts_cnt);
+    // request the page after the current scan page once half of it is consumed
+    void Prefetch();
+    void DiscardPrefetch();
 
  private:
     uint32_t tid_;
@@ -109,6 +152,12 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
     std::string pk_;
     mutable uint64_t ts_;
     uint32_t ts_cnt_;
+    // the position of kv_it_ in its page
+    uint32_t page_pos_;
+    // the next page in flight, requested from prefetch_ts_ skipping prefetch_ts_cnt_ records
+    openmldb::RpcCallback<openmldb::api::ScanResponse>* prefetch_;
+    uint64_t prefetch_ts_;
+    uint32_t prefetch_ts_cnt_;
 };
 
 class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
@@ -16,6 +16,7 @@
 
 #include "catalog/distribute_iterator.h"
 
+#include <set>
 #include <string>
 #include <vector>
 #include <utility>
@@ -32,6 +33,8 @@
 
 DECLARE_string(db_root_path);
 DECLARE_uint32(traverse_cnt_limit);
+DECLARE_uint32(traverse_prefetch_num);
+DECLARE_uint64(traverse_prefetch_max_bytes);
 
 namespace openmldb {
 namespace catalog {
@@ -294,6 +297,64 @@ TEST_F(DistributeIteratorTest, TraverseLimit) {
     FLAGS_traverse_cnt_limit = old_limit;
 }
 
+TEST_F(DistributeIteratorTest, TraversePrefetch) {
+    uint32_t old_limit = FLAGS_traverse_cnt_limit;
+    uint32_t old_prefetch_num = FLAGS_traverse_prefetch_num;
+    uint64_t old_prefetch_max_bytes = FLAGS_traverse_prefetch_max_bytes;
+    FLAGS_traverse_cnt_limit = 7;
+    uint32_t tid = 3;
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    auto tables = std::make_shared<Tables>();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230", "127.0.0.1:9231"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    brpc::Server tablet2;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[1], &tablet2));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    auto client2 = std::make_shared<openmldb::client::TabletClient>(endpoints[1], endpoints[1]);
+    ASSERT_EQ(client2->Init(), 0);
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients;
+    std::vector<::openmldb::api::TableMeta> metas;
+    uint32_t total = 0;
+    for (uint32_t pid = 0; pid < 6; pid++) {
+        metas.push_back(CreateTableMeta(tid, pid));
+        tablet_clients.emplace(pid, pid % 2 == 0 ? client1 : client2);
+        ASSERT_TRUE(tablet_clients[pid]->CreateTable(metas[pid]));
+    }
+    for (int i = 0; i < 100; i++) {
+        std::string key = "card" + std::to_string(i);
+        uint32_t pid = static_cast<uint32_t>(::openmldb::base::hash64(key)) % 6;
+        // leave the partition 3 empty
+        if (pid == 3) {
+            continue;
+        }
+        PutKey(key, metas[pid], tablet_clients[pid], i % 3 + 1);
+        total += i % 3 + 1;
+    }
+    ASSERT_GT(total, FLAGS_traverse_cnt_limit * 6);
+    for (uint32_t prefetch_num : {0, 1, 2, 16}) {
+        for (uint64_t max_bytes : {1ul, 64ul * 1024 * 1024}) {
+            FLAGS_traverse_prefetch_num = prefetch_num;
+            FLAGS_traverse_prefetch_max_bytes = max_bytes;
+            FullTableIterator it(tid, tables, tablet_clients);
+            it.SeekToFirst();
+            std::set<std::string> rows;
+            uint32_t count = 0;
+            while (it.Valid()) {
+                rows.insert(it.GetValue().ToString());
+                count++;
+                it.Next();
+            }
+            ASSERT_EQ(rows.size(), count);
+            ASSERT_EQ(total, count);
+        }
+    }
+    FLAGS_traverse_cnt_limit = old_limit;
+    FLAGS_traverse_prefetch_num = old_prefetch_num;
+    FLAGS_traverse_prefetch_max_bytes = old_prefetch_max_bytes;
+}
+
 TEST_F(DistributeIteratorTest, WindowIterator) {
     uint32_t tid = 3;
     FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
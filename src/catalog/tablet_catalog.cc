@@ -27,8 +27,11 @@
 #include "glog/logging.h"
 #include "schema/index_util.h"
 #include "schema/schema_adapter.h"
+#include "storage/disk_table.h"
+#include "storage/mem_table.h"
 
 DECLARE_bool(enable_localtablet);
+DECLARE_bool(enable_window_aggr_cache);
 namespace openmldb {
 namespace catalog {
 
@@ -198,6 +201,87 @@ std::shared_ptr<::hybridse::vm::PartitionHandler> TabletTableHandler::GetPartiti
     return std::make_shared<TabletPartitionHandler>(shared_from_this(), index_name);
 }
 
+bool TabletTableHandler::GetWindowAggr(const std::string& index_name, const std::string& key,
+                                       const std::string& func, const std::string& col, int64_t start, int64_t end,
+                                       std::string* agg_val) {
+    if (!FLAGS_enable_window_aggr_cache) {
+        return false;
+    }
+    auto iter = index_hint_.find(index_name);
+    if (iter == index_hint_.end()) {
+        return false;
+    }
+    uint32_t pid_num = table_st_.GetPartitionNum();
+    uint32_t pid = 0;
+    if (pid_num > 0) {
+        pid = (uint32_t)(::openmldb::base::hash64(key) % pid_num);
+    }
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    auto table_iter = tables->find(pid);
+    if (table_iter == tables->end()) {
+        return false;
+    }
+    auto mem_table = std::dynamic_pointer_cast<::openmldb::storage::MemTable>(table_iter->second);
+    if (!mem_table) {
+        return false;
+    }
+    return mem_table->GetWindowAggr(iter->second.index, key, func, col, start, end, agg_val);
+}
+
+bool TabletTableHandler::GetLatestRows(const std::string& index_name, const std::vector<std::string>& keys,
+                                       std::vector<PrefetchedRow>* rows) {
+    auto iter = index_hint_.find(index_name);
+    if (iter == index_hint_.end()) {
+        return false;
+    }
+    rows->assign(keys.size(), PrefetchedRow());
+    uint32_t pid_num = table_st_.GetPartitionNum();
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    std::map<uint32_t, std::vector<size_t>> pid_keys;
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint32_t pid = 0;
+        if (pid_num > 0) {
+            pid = (uint32_t)(::openmldb::base::hash64(keys[i]) % pid_num);
+        }
+        pid_keys[pid].push_back(i);
+    }
+    bool prefetched = false;
+    for (const auto& kv : pid_keys) {
+        auto table_iter = tables->find(kv.first);
+        if (table_iter == tables->end()) {
+            continue;
+        }
+        auto disk_table = std::dynamic_pointer_cast<::openmldb::storage::DiskTable>(table_iter->second);
+        if (!disk_table) {
+            continue;
+        }
+        std::vector<std::string> pks;
+        pks.reserve(kv.second.size());
+        for (size_t i : kv.second) {
+            pks.push_back(keys[i]);
+        }
+        std::vector<bool> found;
+        std::vector<uint64_t> ts;
+        std::vector<std::string> values;
+        if (!disk_table->GetLatest(iter->second.index, pks, &found, &ts, &values)) {
+            continue;
+        }
+        for (size_t j = 0; j < kv.second.size(); j++) {
+            auto& row = (*rows)[kv.second[j]];
+            row.prefetched = true;
+            row.found = found[j];
+            if (found[j]) {
+                row.ts = ts[j];
+                int8_t* buf = reinterpret_cast<int8_t*>(malloc(values[j].size()));
+                memcpy(buf, values[j].data(), values[j].size());
+                row.row.Reset(::hybridse::base::RefCountedSlice::CreateManaged(buf, values[j].size()));
+            }
+        }
+        prefetched = true;
+    }
+    return prefetched;
+}
+
 void TabletTableHandler::AddTable(std::shared_ptr<::openmldb::storage::Table> table) {
     std::shared_ptr<Tables> old_tables;
     std::shared_ptr<Tables> new_tables;
@@ -557,6 +641,67 @@ void TabletCatalog::RefreshAggrTables(const std::vector<::hybridse::vm::AggrTabl
     atomic_store_explicit(&aggr_tables_, new_aggr_tables, std::memory_order_relaxed);
 }
 
+bool TabletPartitionHandler::GetWindowAggr(const std::string& key, const std::string& func, const std::string& col,
+                                           int64_t start, int64_t end, std::string* agg_val) {
+    auto table_handler = std::dynamic_pointer_cast<TabletTableHandler>(table_handler_);
+    return table_handler && table_handler->GetWindowAggr(index_name_, key, func, col, start, end, agg_val);
+}
+
+std::vector<std::shared_ptr<::hybridse::vm::TableHandler>> TabletPartitionHandler::GetSegments(
+    const std::vector<std::string>& keys) {
+    auto table_handler = std::dynamic_pointer_cast<TabletTableHandler>(table_handler_);
+    std::vector<PrefetchedRow> rows;
+    if (!table_handler || !table_handler->GetLatestRows(index_name_, keys, &rows)) {
+        return PartitionHandler::GetSegments(keys);
+    }
+    std::vector<std::shared_ptr<::hybridse::vm::TableHandler>> segments;
+    segments.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (rows[i].prefetched) {
+            segments.push_back(std::make_shared<TabletPrefetchedSegmentHandler>(shared_from_this(), keys[i], rows[i]));
+        } else {
+            segments.push_back(GetSegment(keys[i]));
+        }
+    }
+    return segments;
+}
+
+void PrefetchedRowIterator::Next() {
+    if (!on_head_) {
+        if (iter_) {
+            iter_->Next();
+        }
+        return;
+    }
+    // the segment is read later than the head, the rows put since then are newer than the head and the head
+    // may be expired meanwhile. So go on from the ts of the head and skip the row at it only, a disk table keeps
+    // one row per ts of a key
+    on_head_ = false;
+    if (!iter_) {
+        iter_ = segment_->GetIterator();
+    }
+    if (iter_) {
+        iter_->Seek(head_.ts);
+        if (iter_->Valid() && iter_->GetKey() == head_.ts) {
+            iter_->Next();
+        }
+    }
+}
+
+void PrefetchedRowIterator::Seek(const uint64_t& key) {
+    if (key >= head_.ts) {
+        on_head_ = true;
+        return;
+    }
+    on_head_ = false;
+    if (!iter_) {
+        iter_ = segment_->GetIterator();
+    }
+    if (iter_) {
+        iter_->Seek(key);
+    }
+}
+
 std::unique_ptr<::hybridse::vm::RowIterator> TabletSegmentHandler::GetIterator() {
     auto iter = partition_handler_->GetWindowIterator();
     if (iter) {
@@ -84,6 +84,69 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
     std::string key_;
 };
 
+// the latest row of a segment read by a batched lookup, see TabletTableHandler::GetLatestRows
+struct PrefetchedRow {
+    bool prefetched = false;
+    bool found = false;
+    uint64_t ts = 0;
+    ::hybridse::codec::Row row;
+};
+
+// iterate the prefetched latest row first, and the rest rows of the segment are read
+// only if the iterator goes beyond it
+class PrefetchedRowIterator : public ::hybridse::vm::RowIterator {
+ public:
+    PrefetchedRowIterator(std::shared_ptr<::hybridse::vm::TableHandler> segment, const PrefetchedRow &head)
+        : segment_(segment), head_(head), on_head_(true), iter_() {}
+
+    ~PrefetchedRowIterator() {}
+
+    bool Valid() const override { return on_head_ || (iter_ && iter_->Valid()); }
+
+    void Next() override;
+
+    const uint64_t &GetKey() const override { return on_head_ ? head_.ts : iter_->GetKey(); }
+
+    const ::hybridse::codec::Row &GetValue() override { return on_head_ ? head_.row : iter_->GetValue(); }
+
+    void Seek(const uint64_t &key) override;
+
+    void SeekToFirst() override { on_head_ = true; }
+
+    bool IsSeekable() const override { return true; }
+
+ private:
+    std::shared_ptr<::hybridse::vm::TableHandler> segment_;
+    PrefetchedRow head_;
+    bool on_head_;
+    std::unique_ptr<::hybridse::vm::RowIterator> iter_;
+};
+
+class TabletPrefetchedSegmentHandler : public TabletSegmentHandler {
+ public:
+    TabletPrefetchedSegmentHandler(std::shared_ptr<::hybridse::vm::PartitionHandler> partition_handler,
+                                   const std::string &key, const PrefetchedRow &head)
+        : TabletSegmentHandler(partition_handler, key),
+          segment_(std::make_shared<TabletSegmentHandler>(partition_handler, key)),
+          head_(head) {}
+
+    ~TabletPrefetchedSegmentHandler() {}
+
+    std::unique_ptr<::hybridse::vm::RowIterator> GetIterator() override {
+        return std::unique_ptr<::hybridse::vm::RowIterator>(GetRawIterator());
+    }
+
+    ::hybridse::vm::RowIterator *GetRawIterator() override {
+        return head_.found ? new PrefetchedRowIterator(segment_, head_) : nullptr;
+    }
+
+    const std::string GetHandlerTypeName() override { return "TabletPrefetchedSegmentHandler"; }
+
+ private:
+    std::shared_ptr<TabletSegmentHandler> segment_;
+    PrefetchedRow head_;
+};
+
 class TabletPartitionHandler : public ::hybridse::vm::PartitionHandler,
                                public std::enable_shared_from_this<hybridse::vm::PartitionHandler> {
  public:
@@ -124,6 +187,14 @@ class TabletPartitionHandler : public ::hybridse::vm::PartitionHandler,
     std::shared_ptr<::hybridse::vm::TableHandler> GetSegment(const std::string &key) override {
         return std::make_shared<TabletSegmentHandler>(shared_from_this(), key);
     }
+
+    bool GetWindowAggr(const std::string &key, const std::string &func, const std::string &col, int64_t start,
+                       int64_t end, std::string *agg_val) override;
+
+    // the latest rows of the keys on the local disk tables are read by one batched lookup
+    std::vector<std::shared_ptr<::hybridse::vm::TableHandler>> GetSegments(
+        const std::vector<std::string> &keys) override;
+
     const std::string GetHandlerTypeName() override { return "TabletPartitionHandler"; }
 
  private:
@@ -168,6 +239,15 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
     ::hybridse::codec::Row At(uint64_t pos) override;
 
     std::shared_ptr<::hybridse::vm::PartitionHandler> GetPartition(const std::string &index_name) override;
+
+    // aggregate by the window aggr cache of the local memory table of key, see MemTable::GetWindowAggr
+    bool GetWindowAggr(const std::string &index_name, const std::string &key, const std::string &func,
+                       const std::string &col, int64_t start, int64_t end, std::string *agg_val);
+
+    // read the latest row of every key on the local disk tables by one batched lookup per table,
+    // see DiskTable::GetLatest. rows[i].prefetched is false if keys[i] is not on a local disk table
+    bool GetLatestRows(const std::string &index_name, const std::vector<std::string> &keys,
+                       std::vector<PrefetchedRow> *rows);
     const std::string GetHandlerTypeName() override { return "TabletTableHandler"; }
 
     std::shared_ptr<::hybridse::vm::Tablet> GetTablet(const std::string &index_name, const std::string &pk) override;
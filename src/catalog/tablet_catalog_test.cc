@@ -20,11 +20,14 @@
 #include <vector>
 
 #include "base/fe_status.h"
+#include "base/file_util.h"
 #include "codec/fe_row_codec.h"
 #include "codec/schema_codec.h"
+#include "common/timer.h"
 #include "gtest/gtest.h"
 #include "proto/fe_common.pb.h"
 #include "schema/schema_adapter.h"
+#include "storage/disk_table.h"
 #include "storage/mem_table.h"
 #include "storage/table.h"
 #include "vm/engine.h"
@@ -332,6 +335,74 @@ TEST_F(TabletCatalogTest, segment_handler_pk_not_exist_test) {
     }
 }
 
+TEST_F(TabletCatalogTest, disk_segments_test) {
+    ::openmldb::api::TableMeta meta;
+    meta.set_name("t1");
+    meta.set_db("db1");
+    meta.set_tid(1);
+    meta.set_pid(0);
+    meta.add_table_partition();
+    meta.set_mode(::openmldb::api::TableMode::kTableLeader);
+    meta.set_storage_mode(::openmldb::common::StorageMode::kHDD);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "col1", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "col2", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(meta.add_column_key(), "index0", "col1", "col2", ::openmldb::type::kAbsoluteTime, 0, 0);
+    std::string table_path = "/tmp/disk_segments_test/" + std::to_string(::baidu::common::timer::get_micros());
+    auto table = std::make_shared<::openmldb::storage::DiskTable>(meta, table_path);
+    ASSERT_TRUE(table->Init());
+    ::hybridse::vm::Schema fe_schema;
+    schema::SchemaAdapter::ConvertSchema(meta.column_desc(), &fe_schema);
+    ::hybridse::codec::RowBuilder rb(fe_schema);
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        for (int64_t ts = 1; ts <= 3; ts++) {
+            std::string value;
+            value.resize(rb.CalTotalLength(pk.size()));
+            rb.SetBuffer(reinterpret_cast<int8_t *>(&(value[0])), value.size());
+            rb.AppendString(pk.c_str(), pk.size());
+            rb.AppendInt64(ts);
+            ASSERT_TRUE(table->Put(pk, ts, value.c_str(), value.size()));
+        }
+    }
+    auto handler = std::shared_ptr<TabletTableHandler>(
+        new TabletTableHandler(meta, std::shared_ptr<hybridse::vm::Tablet>()));
+    ClientManager client_manager;
+    ASSERT_TRUE(handler->Init(client_manager));
+    handler->AddTable(table);
+    auto partition = handler->GetPartition("index0");
+    std::vector<std::string> keys = {"pk3", "KEY_NOT_EXIST", "pk0", "pk9", "pk3"};
+    auto segments = partition->GetSegments(keys);
+    ASSERT_EQ(keys.size(), segments.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ("TabletPrefetchedSegmentHandler", segments[i]->GetHandlerTypeName());
+        auto iter = segments[i]->GetIterator();
+        auto expect_iter = partition->GetSegment(keys[i])->GetIterator();
+        if (keys[i] == "KEY_NOT_EXIST") {
+            ASSERT_FALSE(iter);
+            ASSERT_FALSE(expect_iter);
+            continue;
+        }
+        ASSERT_TRUE(iter && expect_iter);
+        iter->SeekToFirst();
+        expect_iter->SeekToFirst();
+        int cnt = 0;
+        while (expect_iter->Valid()) {
+            ASSERT_TRUE(iter->Valid());
+            ASSERT_EQ(expect_iter->GetKey(), iter->GetKey());
+            ASSERT_EQ(expect_iter->GetValue().ToString(), iter->GetValue().ToString());
+            expect_iter->Next();
+            iter->Next();
+            cnt++;
+        }
+        ASSERT_FALSE(iter->Valid());
+        ASSERT_EQ(3, cnt);
+        iter->Seek(2);
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(2u, iter->GetKey());
+    }
+    ::openmldb::base::RemoveDir(table_path);
+}
+
 TEST_F(TabletCatalogTest, sql_smoke_test) {
     std::shared_ptr<TabletCatalog> catalog(new TabletCatalog());
     ASSERT_TRUE(catalog->Init());
@@ -618,6 +618,22 @@ bool NsClient::UpdateTTL(const std::string& name, const ::openmldb::type::TTLTyp
     return false;
 }
 
+bool NsClient::UpdateStorageOptions(const std::string& name,
+                                    const ::openmldb::common::StorageOptions& storage_options, std::string& msg) {
+    ::openmldb::nameserver::UpdateStorageOptionsRequest request;
+    ::openmldb::nameserver::GeneralResponse response;
+    request.set_name(name);
+    request.set_db(GetDb());
+    request.mutable_storage_options()->CopyFrom(storage_options);
+    bool ok = client_.SendRequest(&::openmldb::nameserver::NameServer_Stub::UpdateStorageOptions, &request,
+                                  &response, FLAGS_request_timeout_ms, 1);
+    msg = response.msg();
+    if (ok && response.code() == 0) {
+        return true;
+    }
+    return false;
+}
+
 bool NsClient::DeleteOPTask(const std::vector<uint64_t>& op_id_vec) {
     ::openmldb::api::DeleteTaskRequest request;
     ::openmldb::api::GeneralResponse response;
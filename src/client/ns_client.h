@@ -188,6 +188,9 @@ class NsClient : public Client {
     bool UpdateTTL(const std::string& name, const ::openmldb::type::TTLType& type, uint64_t abs_ttl, uint64_t lat_ttl,
                    const std::string& ts_name, std::string& msg);  // NOLINT
 
+    bool UpdateStorageOptions(const std::string& name, const ::openmldb::common::StorageOptions& storage_options,
+                              std::string& msg);  // NOLINT
+
     bool AddReplicaClusterByNs(const std::string& alias, const std::string& name, uint64_t term,
                                std::string& msg);  // NOLINT
 
@@ -71,13 +71,15 @@ bool TabletClient::Query(const std::string& db, const std::string& sql, const st
 bool TabletClient::Query(const std::string& db, const std::string& sql,
                          const std::vector<openmldb::type::DataType>& parameter_types,
                          const std::string& parameter_row,
-                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug) {
+                         brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug,
+                         const bool columnar_result) {
     if (cntl == NULL || response == NULL) return false;
     ::openmldb::api::QueryRequest request;
     request.set_sql(sql);
     request.set_db(db);
     request.set_is_batch(true);
     request.set_is_debug(is_debug);
+    request.set_columnar_result(columnar_result);
     request.set_parameter_row_size(parameter_row.size());
     request.set_parameter_row_slices(1);
     for (auto& type : parameter_types) {
@@ -263,6 +265,48 @@ bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::str
     return false;
 }
 
+bool TabletClient::AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
+bool TabletClient::GetBulkLoadInfo(uint32_t tid, uint32_t pid, ::openmldb::api::BulkLoadInfoResponse* response) {
+    ::openmldb::api::BulkLoadInfoRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::GetBulkLoadInfo, &request, response,
+                                  FLAGS_request_timeout_ms, 1);
+    if (!ok || response->code() != 0) {
+        LOG(WARNING) << "fail to get bulk load info of table " << tid << "-" << pid << ": " << response->msg();
+        return false;
+    }
+    return true;
+}
+
+bool TabletClient::BulkLoad(const ::openmldb::api::BulkLoadRequest& request, const std::string& data,
+                            std::string* msg) {
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    if (!data.empty()) {
+        cntl.request_attachment().append(data);
+    }
+    ::openmldb::api::GeneralResponse response;
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::BulkLoad, &cntl, &request, &response);
+    if (!ok) {
+        *msg = cntl.ErrorText();
+        return false;
+    }
+    if (response.code() != 0) {
+        *msg = response.msg();
+        return false;
+    }
+    return true;
+}
+
 bool TabletClient::Put(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, const std::string& value) {
     ::openmldb::api::PutRequest request;
     auto dim = request.add_dimensions();
@@ -483,6 +527,21 @@ bool TabletClient::UpdateTTL(uint32_t tid, uint32_t pid, const ::openmldb::type:
     return false;
 }
 
+bool TabletClient::UpdateStorageOptions(uint32_t tid, uint32_t pid,
+                                        const ::openmldb::common::StorageOptions& storage_options) {
+    ::openmldb::api::UpdateStorageOptionsRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    request.mutable_storage_options()->CopyFrom(storage_options);
+    ::openmldb::api::GeneralResponse response;
+    bool ret = client_.SendRequest(&::openmldb::api::TabletServer_Stub::UpdateStorageOptions, &request, &response,
+                                   FLAGS_request_timeout_ms, FLAGS_request_max_retry);
+    if (ret && response.code() == 0) {
+        return true;
+    }
+    return false;
+}
+
 bool TabletClient::Refresh(uint32_t tid) {
     ::openmldb::api::RefreshRequest request;
     request.set_tid(tid);
@@ -1159,6 +1218,15 @@ bool TabletClient::AsyncScan(const ::openmldb::api::ScanRequest& request,
                                callback->GetResponse().get(), callback);
 }
 
+bool TabletClient::AsyncTraverse(const ::openmldb::api::TraverseRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::Scan(const ::openmldb::api::ScanRequest& request, brpc::Controller* cntl,
                         ::openmldb::api::ScanResponse* response) {
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Scan, cntl, &request, response);
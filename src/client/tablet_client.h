@@ -70,7 +70,8 @@ class TabletClient : public Client {
 
     bool Query(const std::string& db, const std::string& sql,
                const std::vector<openmldb::type::DataType>& parameter_types, const std::string& parameter_row,
-               brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false);
+               brpc::Controller* cntl, ::openmldb::api::QueryResponse* response, const bool is_debug = false,
+               const bool columnar_result = false);
 
     bool Query(const std::string& db, const std::string& sql, const std::string& row, brpc::Controller* cntl,
                ::openmldb::api::QueryResponse* response, const bool is_debug = false);
@@ -84,6 +85,14 @@ class TabletClient : public Client {
     bool Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
              const std::vector<std::pair<std::string, uint32_t>>& dimensions);
 
+    bool AsyncPutBatch(const ::openmldb::api::PutBatchRequest& request,
+                       openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback);
+
+    bool GetBulkLoadInfo(uint32_t tid, uint32_t pid, ::openmldb::api::BulkLoadInfoResponse* response);
+
+    // send a part of the bulk load, data is the attachment of the data region blocks
+    bool BulkLoad(const ::openmldb::api::BulkLoadRequest& request, const std::string& data, std::string* msg);
+
     bool Get(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, std::string& value,  // NOLINT
              uint64_t& ts,                                                                          // NOLINT
              std::string& msg);                        ;                                             // NOLINT
@@ -157,6 +166,8 @@ class TabletClient : public Client {
     bool UpdateTTL(uint32_t tid, uint32_t pid, const ::openmldb::type::TTLType& type, uint64_t abs_ttl,
                    uint64_t lat_ttl, const std::string& index_name);
 
+    bool UpdateStorageOptions(uint32_t tid, uint32_t pid, const ::openmldb::common::StorageOptions& storage_options);
+
     bool DeleteBinlog(uint32_t tid, uint32_t pid, ::openmldb::common::StorageMode storage_mode);
 
     bool GetTaskStatus(::openmldb::api::TaskStatusResponse& response);  // NOLINT
@@ -196,6 +207,9 @@ class TabletClient : public Client {
             const std::string& idx_name, const std::string& pk, uint64_t ts,
             uint32_t limit, bool skip_current_pk, uint32_t& count);  // NOLINT
 
+    bool AsyncTraverse(const ::openmldb::api::TraverseRequest& request,
+                       openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback);
+
     bool SetMode(bool mode);
 
     bool DeleteIndex(uint32_t tid, uint32_t pid, const std::string& idx_name, std::string* msg);
@@ -23,6 +23,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/random/random.h"
@@ -428,6 +429,48 @@ TEST_F(SqlCmdTest, LoadData) {
     unlink(file_name.c_str());
 }
 
+// load more rows than one chunk with the options and check every row is loaded once
+static void CheckLoadDataWithOptions(const std::string& options) {
+    sr = standalone_cli.sr;
+    cs = standalone_cli.cs;
+    HandleSQL("create database test1;");
+    HandleSQL("use test1;");
+    HandleSQL("create table trans (c1 string, c2 int);");
+    std::string file_name = "./myfile_options.csv";
+    int row_num = 25000;
+    std::ofstream ofile;
+    ofile.open(file_name);
+    ofile << "c1,c2" << std::endl;
+    for (int i = 0; i < row_num; i++) {
+        ofile << "aa" << i << "," << i << std::endl;
+    }
+    ofile.close();
+    absl::Cleanup clean = [&file_name]() {
+        HandleSQL("drop table trans;");
+        HandleSQL("drop database test1;");
+        unlink(file_name.c_str());
+    };
+    std::string load_sql = "LOAD DATA INFILE '" + file_name + "' INTO TABLE trans OPTIONS (" + options + ");";
+    hybridse::sdk::Status status;
+    sr->ExecuteSQL(load_sql, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    auto result = sr->ExecuteSQL("select c1, c2 from trans;", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    ASSERT_EQ(row_num, result->Size());
+    std::vector<bool> loaded(row_num, false);
+    while (result->Next()) {
+        int32_t c2 = result->GetInt32Unsafe(1);
+        ASSERT_TRUE(c2 >= 0 && c2 < row_num);
+        ASSERT_FALSE(loaded[c2]) << "duplicate row " << c2;
+        loaded[c2] = true;
+        ASSERT_EQ("aa" + std::to_string(c2), result->GetStringUnsafe(0));
+    }
+}
+
+TEST_F(SqlCmdTest, LoadDataMultiThread) { CheckLoadDataWithOptions("thread=4"); }
+
+TEST_F(SqlCmdTest, LoadDataBulkLoad) { CheckLoadDataWithOptions("load_mode='bulk_load', thread=2"); }
+
 TEST_P(DBSDKTest, Deploy) {
     auto cli = GetParam();
     cs = cli->cs;
@@ -1627,6 +1670,96 @@ TEST_P(DBSDKTest, DeployLongWindowsExecuteCountWhere) {
     ASSERT_TRUE(ok);
 }
 
+TEST_P(DBSDKTest, DeployLongWindowsMultiLevel) {
+    auto cli = GetParam();
+    cs = cli->cs;
+    sr = cli->sr;
+    ::hybridse::sdk::Status status;
+    sr->ExecuteSQL("SET @@execute_mode='online';", &status);
+    std::string base_table = "t_lw" + GenRand();
+    std::string base_db = "d_lw" + GenRand();
+    bool ok;
+    std::string msg;
+    CreateDBTableForLongWindow(base_db, base_table);
+
+    // the same windows with and without pre-aggregation, w1 is answered by 1d, 1h and 1m buckets and w2 by
+    // 100 and 10 rows buckets
+    std::string select_sql = " select col1, col2,"
+        " sum(i64_col) over w1 as w1_sum_i64_col,"
+        " sum(i64_col) over w2 as w2_sum_i64_col"
+        " from " + base_table +
+        " WINDOW w1 AS (PARTITION BY col1,col2 ORDER BY col3"
+        " ROWS_RANGE BETWEEN 2d PRECEDING AND CURRENT ROW), "
+        " w2 AS (PARTITION BY col1,col2 ORDER BY col3"
+        " ROWS BETWEEN 235 PRECEDING AND CURRENT ROW);";
+    sr->ExecuteSQL(base_db, "use " + base_db + ";", &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    sr->ExecuteSQL(base_db, "deploy test_aggr options(long_windows='w1:1d|1h|1m,w2:100|10')" + select_sql, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+    sr->ExecuteSQL(base_db, "deploy test_raw" + select_sql, &status);
+    ASSERT_TRUE(status.IsOK()) << status.msg;
+
+    // about three days of rows, so the windows cross the boundaries of the buckets of all sizes
+    int64_t base_ts = 1650000000000;
+    int64_t last_ts = 0;
+    for (int i = 0; i < 300; i++) {
+        last_ts = base_ts + i * 15 * 60 * 1000 + (i % 7) * 61 * 1000;
+        std::string insert = absl::StrCat("insert into ", base_table, " values('str1', 'str2', ", last_ts, ", ", i,
+                                          ", 1, 1, 1, 1, 1, '1', '1900-01-01', ", i % 2, ");");
+        ok = sr->ExecuteInsert(base_db, insert, &status);
+        ASSERT_TRUE(ok) << status.msg;
+    }
+
+    auto call = [&](const std::string& sp_name, int64_t ts, int64_t* w1_sum, int64_t* w2_sum) {
+        auto req = sr->GetRequestRowByProcedure(base_db, sp_name, &status);
+        ASSERT_TRUE(status.IsOK()) << status.msg;
+        ASSERT_TRUE(req->Init(strlen("str1") + strlen("str2") + strlen("1")));
+        ASSERT_TRUE(req->AppendString("str1"));
+        ASSERT_TRUE(req->AppendString("str2"));
+        ASSERT_TRUE(req->AppendTimestamp(ts));
+        ASSERT_TRUE(req->AppendInt64(1000));
+        ASSERT_TRUE(req->AppendInt16(1));
+        ASSERT_TRUE(req->AppendInt32(1));
+        ASSERT_TRUE(req->AppendFloat(1));
+        ASSERT_TRUE(req->AppendDouble(1));
+        ASSERT_TRUE(req->AppendTimestamp(1));
+        ASSERT_TRUE(req->AppendString("1"));
+        ASSERT_TRUE(req->AppendDate(1));
+        ASSERT_TRUE(req->Build());
+        auto res = sr->CallProcedure(base_db, sp_name, req, &status);
+        ASSERT_TRUE(status.IsOK()) << status.msg;
+        ASSERT_EQ(1, res->Size());
+        ASSERT_TRUE(res->Next());
+        *w1_sum = res->GetInt64Unsafe(2);
+        *w2_sum = res->GetInt64Unsafe(3);
+    };
+    for (int64_t ts : {last_ts + 1, last_ts, base_ts + 86400000, base_ts + 2 * 86400000 + 30 * 60 * 1000 + 17,
+                       base_ts + 3600000 - 1, base_ts}) {
+        int64_t exp_w1 = 0;
+        int64_t exp_w2 = 0;
+        ASSERT_NO_FATAL_FAILURE(call("test_raw", ts, &exp_w1, &exp_w2));
+        int64_t w1 = 0;
+        int64_t w2 = 0;
+        ASSERT_NO_FATAL_FAILURE(call("test_aggr", ts, &w1, &w2));
+        ASSERT_EQ(exp_w1, w1) << "ts " << ts;
+        ASSERT_EQ(exp_w2, w2) << "ts " << ts;
+    }
+
+    ASSERT_TRUE(cs->GetNsClient()->DropProcedure(base_db, "test_aggr", msg));
+    ASSERT_TRUE(cs->GetNsClient()->DropProcedure(base_db, "test_raw", msg));
+    std::string pre_aggr_db = openmldb::nameserver::PRE_AGG_DB;
+    for (const auto& table : {"w1_sum_i64_col_1d", "w1_sum_i64_col_1h", "w1_sum_i64_col_1m", "w2_sum_i64_col_100",
+                              "w2_sum_i64_col_10"}) {
+        std::string pre_aggr_table = absl::StrCat("pre_", base_db, "_test_aggr_", table);
+        ok = sr->ExecuteDDL(pre_aggr_db, "drop table " + pre_aggr_table + ";", &status);
+        ASSERT_TRUE(ok) << status.msg;
+    }
+    ok = sr->ExecuteDDL(base_db, "drop table " + base_table + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = sr->DropDB(base_db, &status);
+    ASSERT_TRUE(ok);
+}
+
 TEST_P(DBSDKTest, LongWindowsCleanup) {
     auto cli = GetParam();
     cs = cli->cs;
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/columnar_codec.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace codec {
+
+static constexpr size_t COLUMNAR_ALIGNMENT = 8;
+static constexpr size_t COLUMNAR_HEADER_LENGTH = 2 * sizeof(uint32_t);
+
+static inline size_t AlignColumnar(size_t size) {
+    return (size + COLUMNAR_ALIGNMENT - 1) / COLUMNAR_ALIGNMENT * COLUMNAR_ALIGNMENT;
+}
+
+// width of the fixed width types, 0 for string
+static bool GetColumnarWidth(hybridse::type::Type type, uint32_t* width) {
+    switch (type) {
+        case hybridse::type::kBool:
+            *width = 1;
+            return true;
+        case hybridse::type::kInt16:
+            *width = 2;
+            return true;
+        case hybridse::type::kInt32:
+        case hybridse::type::kDate:
+        case hybridse::type::kFloat:
+            *width = 4;
+            return true;
+        case hybridse::type::kInt64:
+        case hybridse::type::kTimestamp:
+        case hybridse::type::kDouble:
+            *width = 8;
+            return true;
+        case hybridse::type::kVarchar:
+            *width = 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <class T>
+static inline void SetColumnarValue(char* slot, T val) {
+    memcpy(slot, &val, sizeof(T));
+}
+
+bool EncodeColumnarRows(const hybridse::codec::Schema& schema, const std::vector<hybridse::codec::Row>& rows,
+                        size_t count, std::string* output) {
+    if (output == nullptr) {
+        return false;
+    }
+    count = std::min(count, rows.size());
+    uint32_t col_cnt = schema.size();
+    std::vector<uint32_t> widths(col_cnt);
+    for (uint32_t i = 0; i < col_cnt; i++) {
+        if (!GetColumnarWidth(schema.Get(i).type(), &widths[i])) {
+            LOG(WARNING) << "unsupported type " << hybridse::type::Type_Name(schema.Get(i).type())
+                         << " for columnar encoding";
+            return false;
+        }
+    }
+    size_t bitmap_size = AlignColumnar((count + 7) / 8);
+    std::vector<std::string> validity(col_cnt, std::string(bitmap_size, '\0'));
+    std::vector<std::string> values(col_cnt);
+    std::vector<std::vector<uint32_t>> offsets(col_cnt);
+    for (uint32_t i = 0; i < col_cnt; i++) {
+        if (widths[i] > 0) {
+            values[i].resize(count * widths[i], '\0');
+        } else {
+            offsets[i].reserve(count + 1);
+            offsets[i].push_back(0);
+        }
+    }
+
+    hybridse::codec::RowView row_view(schema);
+    for (size_t row = 0; row < count; row++) {
+        if (!row_view.Reset(rows[row].buf(), rows[row].size())) {
+            LOG(WARNING) << "fail to decode the " << row << "th row";
+            return false;
+        }
+        for (uint32_t i = 0; i < col_cnt; i++) {
+            if (row_view.IsNULL(i)) {
+                if (widths[i] == 0) {
+                    offsets[i].push_back(values[i].size());
+                }
+                continue;
+            }
+            validity[i][row >> 3] |= static_cast<char>(1 << (row & 0x07));
+            char* slot = widths[i] > 0 ? &values[i][row * widths[i]] : nullptr;
+            switch (schema.Get(i).type()) {
+                case hybridse::type::kBool: {
+                    bool val = false;
+                    row_view.GetBool(i, &val);
+                    *slot = val ? 1 : 0;
+                    break;
+                }
+                case hybridse::type::kInt16: {
+                    int16_t val = 0;
+                    row_view.GetInt16(i, &val);
+                    SetColumnarValue(slot, val);
+                    break;
+                }
+                case hybridse::type::kInt32: {
+                    int32_t val = 0;
+                    row_view.GetInt32(i, &val);
+                    SetColumnarValue(slot, val);
+                    break;
+                }
+                case hybridse::type::kDate: {
+                    // the null check is done above
+                    SetColumnarValue(slot, row_view.GetDateUnsafe(i));
+                    break;
+                }
+                case hybridse::type::kInt64: {
+                    int64_t val = 0;
+                    row_view.GetInt64(i, &val);
+                    SetColumnarValue(slot, val);
+                    break;
+                }
+                case hybridse::type::kTimestamp: {
+                    int64_t val = 0;
+                    row_view.GetTimestamp(i, &val);
+                    SetColumnarValue(slot, val);
+                    break;
+                }
+                case hybridse::type::kFloat: {
+                    float val = 0;
+                    row_view.GetFloat(i, &val);
+                    SetColumnarValue(slot, val);
+                    break;
+                }
+                case hybridse::type::kDouble: {
+                    double val = 0;
+                    row_view.GetDouble(i, &val);
+                    SetColumnarValue(slot, val);
+                    break;
+                }
+                default: {
+                    const char* val = nullptr;
+                    uint32_t length = 0;
+                    row_view.GetString(i, &val, &length);
+                    values[i].append(val, length);
+                    offsets[i].push_back(values[i].size());
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t total_size = COLUMNAR_HEADER_LENGTH;
+    for (uint32_t i = 0; i < col_cnt; i++) {
+        total_size += bitmap_size + AlignColumnar(values[i].size());
+        if (widths[i] == 0) {
+            total_size += AlignColumnar(offsets[i].size() * sizeof(uint32_t));
+        }
+    }
+    output->clear();
+    output->reserve(total_size);
+    uint32_t header[2] = {static_cast<uint32_t>(count), col_cnt};
+    output->append(reinterpret_cast<const char*>(header), COLUMNAR_HEADER_LENGTH);
+    auto append_aligned = [output](const char* data, size_t size) {
+        output->append(data, size);
+        output->append(AlignColumnar(size) - size, '\0');
+    };
+    for (uint32_t i = 0; i < col_cnt; i++) {
+        output->append(validity[i]);
+        if (widths[i] == 0) {
+            append_aligned(reinterpret_cast<const char*>(offsets[i].data()), offsets[i].size() * sizeof(uint32_t));
+        }
+        append_aligned(values[i].data(), values[i].size());
+    }
+    return true;
+}
+
+ColumnarView::ColumnarView(const hybridse::codec::Schema& schema) : schema_(schema), row_cnt_(0), columns_() {}
+
+bool ColumnarView::Reset(const char* data, size_t size) {
+    row_cnt_ = 0;
+    columns_.clear();
+    if (data == nullptr || size < COLUMNAR_HEADER_LENGTH) {
+        return false;
+    }
+    if (reinterpret_cast<uintptr_t>(data) % COLUMNAR_ALIGNMENT != 0) {
+        LOG(WARNING) << "columnar data is not aligned";
+        return false;
+    }
+    uint32_t header[2];
+    memcpy(header, data, COLUMNAR_HEADER_LENGTH);
+    if (header[1] != static_cast<uint32_t>(schema_.size())) {
+        LOG(WARNING) << "column count " << header[1] << " mismatch the schema size " << schema_.size();
+        return false;
+    }
+    size_t row_cnt = header[0];
+    size_t bitmap_size = AlignColumnar((row_cnt + 7) / 8);
+    size_t pos = COLUMNAR_HEADER_LENGTH;
+    for (int i = 0; i < schema_.size(); i++) {
+        uint32_t width = 0;
+        if (!GetColumnarWidth(schema_.Get(i).type(), &width)) {
+            LOG(WARNING) << "unsupported type " << hybridse::type::Type_Name(schema_.Get(i).type())
+                         << " for columnar encoding";
+            return false;
+        }
+        Column column;
+        if (pos + bitmap_size > size) {
+            return false;
+        }
+        column.validity = reinterpret_cast<const uint8_t*>(data + pos);
+        pos += bitmap_size;
+        size_t values_size = row_cnt * width;
+        if (width == 0) {
+            size_t offsets_size = (row_cnt + 1) * sizeof(uint32_t);
+            if (pos + offsets_size > size) {
+                return false;
+            }
+            column.offsets = reinterpret_cast<const uint32_t*>(data + pos);
+            pos += AlignColumnar(offsets_size);
+            values_size = column.offsets[row_cnt];
+        }
+        if (pos + values_size > size) {
+            LOG(WARNING) << "values of the " << i << "th column out of bound, buf size=" << size;
+            return false;
+        }
+        column.values = data + pos;
+        pos += AlignColumnar(values_size);
+        columns_.push_back(column);
+    }
+    row_cnt_ = row_cnt;
+    return true;
+}
+
+}  // namespace codec
+}  // namespace openmldb
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CODEC_COLUMNAR_CODEC_H_
+#define SRC_CODEC_COLUMNAR_CODEC_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "codec/row.h"
+
+namespace openmldb {
+namespace codec {
+
+/**
+ * Columnar encoding of the query result rows:
+ *
+ *   | uint32 row count | uint32 column count |
+ *   for each column in the schema order:
+ *     | validity bitmap, bit i is set if the value of row i is not null |
+ *     | fixed width types: the values of all rows, bool takes one byte and date is int32 |
+ *     | string: uint32 offsets of (row count + 1), then the concatenated bytes |
+ *
+ * All values are little endian and every buffer starts at a multiple of 8 bytes from the beginning, so
+ * that the reader accesses the values of a column as a typed array instead of decoding the rows.
+ */
+bool EncodeColumnarRows(const hybridse::codec::Schema& schema, const std::vector<hybridse::codec::Row>& rows,
+                        size_t count, std::string* output);
+
+class ColumnarView {
+ public:
+    explicit ColumnarView(const hybridse::codec::Schema& schema);
+    ~ColumnarView() = default;
+
+    // data should be aligned to 8 bytes and outlive the view
+    bool Reset(const char* data, size_t size);
+
+    uint32_t GetRowCnt() const { return row_cnt_; }
+
+    bool IsNULL(uint32_t col, uint32_t row) const {
+        return !(columns_[col].validity[row >> 3] & (1 << (row & 0x07)));
+    }
+
+    // the values of the column of fixed width type, T should match the column type
+    template <class T>
+    const T* GetValues(uint32_t col) const {
+        return reinterpret_cast<const T*>(columns_[col].values);
+    }
+
+    const uint8_t* GetValidity(uint32_t col) const { return columns_[col].validity; }
+
+    // the string of row is [offsets[row], offsets[row + 1]) of the data
+    const uint32_t* GetOffsets(uint32_t col) const { return columns_[col].offsets; }
+
+    const char* GetStringData(uint32_t col) const { return columns_[col].values; }
+
+    const hybridse::codec::Schema& GetSchema() const { return schema_; }
+
+ private:
+    struct Column {
+        const uint8_t* validity = nullptr;
+        const char* values = nullptr;
+        const uint32_t* offsets = nullptr;
+    };
+
+    hybridse::codec::Schema schema_;
+    uint32_t row_cnt_;
+    std::vector<Column> columns_;
+};
+
+}  // namespace codec
+}  // namespace openmldb
+#endif  // SRC_CODEC_COLUMNAR_CODEC_H_
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codec/columnar_codec.h"
+
+#include <string>
+#include <vector>
+
+#include "codec/fe_row_codec.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace codec {
+
+class ColumnarCodecTest : public ::testing::Test {};
+
+void InitColumnarSchema(hybridse::codec::Schema* schema) {
+    std::vector<hybridse::type::Type> types = {hybridse::type::kVarchar, hybridse::type::kBool,
+                                               hybridse::type::kInt16,   hybridse::type::kInt32,
+                                               hybridse::type::kInt64,   hybridse::type::kFloat,
+                                               hybridse::type::kDouble,  hybridse::type::kDate,
+                                               hybridse::type::kTimestamp};
+    for (size_t i = 0; i < types.size(); i++) {
+        hybridse::type::ColumnDef* column = schema->Add();
+        column->set_name("col_" + std::to_string(i));
+        column->set_type(types[i]);
+    }
+}
+
+// row i is null at the column i % 10, so that every column has null and non-null values
+std::vector<hybridse::codec::Row> BuildColumnarRows(const hybridse::codec::Schema& schema, int row_cnt) {
+    std::vector<hybridse::codec::Row> rows;
+    hybridse::codec::RowBuilder builder(schema);
+    for (int i = 0; i < row_cnt; i++) {
+        std::string str = "key" + std::to_string(i);
+        uint32_t buf_size = builder.CalTotalLength(str.size());
+        int8_t* buf = reinterpret_cast<int8_t*>(malloc(buf_size));
+        builder.SetBuffer(buf, buf_size);
+        int null_col = i % 10;
+        null_col == 0 ? builder.AppendNULL() : builder.AppendString(str.c_str(), str.size());
+        null_col == 1 ? builder.AppendNULL() : builder.AppendBool(i % 2 == 0);
+        null_col == 2 ? builder.AppendNULL() : builder.AppendInt16(i);
+        null_col == 3 ? builder.AppendNULL() : builder.AppendInt32(i * 10);
+        null_col == 4 ? builder.AppendNULL() : builder.AppendInt64(i * 100L);
+        null_col == 5 ? builder.AppendNULL() : builder.AppendFloat(i * 0.5f);
+        null_col == 6 ? builder.AppendNULL() : builder.AppendDouble(i * 0.25);
+        null_col == 7 ? builder.AppendNULL() : builder.AppendDate(2022, 1 + i % 12, 1 + i % 28);
+        null_col == 8 ? builder.AppendNULL() : builder.AppendTimestamp(1650000000000L + i);
+        rows.emplace_back(hybridse::base::RefCountedSlice::CreateManaged(buf, buf_size));
+    }
+    return rows;
+}
+
+TEST_F(ColumnarCodecTest, EncodeDecode) {
+    hybridse::codec::Schema schema;
+    InitColumnarSchema(&schema);
+    int row_cnt = 37;
+    auto rows = BuildColumnarRows(schema, row_cnt);
+    std::string buf;
+    ASSERT_TRUE(EncodeColumnarRows(schema, rows, rows.size(), &buf));
+    ASSERT_EQ(0u, buf.size() % 8);
+
+    ColumnarView view(schema);
+    ASSERT_TRUE(view.Reset(buf.data(), buf.size()));
+    ASSERT_EQ(static_cast<uint32_t>(row_cnt), view.GetRowCnt());
+    hybridse::codec::RowView row_view(schema);
+    for (int i = 0; i < row_cnt; i++) {
+        row_view.Reset(rows[i].buf(), rows[i].size());
+        for (int col = 0; col < schema.size(); col++) {
+            ASSERT_EQ(row_view.IsNULL(col), view.IsNULL(col, i)) << "row " << i << " col " << col;
+        }
+        if (i % 10 != 0) {
+            const uint32_t* offsets = view.GetOffsets(0);
+            ASSERT_EQ(row_view.GetStringUnsafe(0),
+                      std::string(view.GetStringData(0) + offsets[i], offsets[i + 1] - offsets[i]));
+        }
+        if (i % 10 != 1) {
+            ASSERT_EQ(row_view.GetBoolUnsafe(1), view.GetValues<uint8_t>(1)[i] != 0);
+        }
+        if (i % 10 != 2) {
+            ASSERT_EQ(row_view.GetInt16Unsafe(2), view.GetValues<int16_t>(2)[i]);
+        }
+        if (i % 10 != 3) {
+            ASSERT_EQ(row_view.GetInt32Unsafe(3), view.GetValues<int32_t>(3)[i]);
+        }
+        if (i % 10 != 4) {
+            ASSERT_EQ(row_view.GetInt64Unsafe(4), view.GetValues<int64_t>(4)[i]);
+        }
+        if (i % 10 != 5) {
+            ASSERT_EQ(row_view.GetFloatUnsafe(5), view.GetValues<float>(5)[i]);
+        }
+        if (i % 10 != 6) {
+            ASSERT_EQ(row_view.GetDoubleUnsafe(6), view.GetValues<double>(6)[i]);
+        }
+        if (i % 10 != 7) {
+            ASSERT_EQ(row_view.GetDateUnsafe(7), view.GetValues<int32_t>(7)[i]);
+        }
+        if (i % 10 != 8) {
+            ASSERT_EQ(row_view.GetTimestampUnsafe(8), view.GetValues<int64_t>(8)[i]);
+        }
+    }
+
+    // the result is truncated to the count
+    ASSERT_TRUE(EncodeColumnarRows(schema, rows, 5, &buf));
+    ASSERT_TRUE(view.Reset(buf.data(), buf.size()));
+    ASSERT_EQ(5u, view.GetRowCnt());
+    ASSERT_EQ(40, view.GetValues<int32_t>(3)[4]);
+}
+
+TEST_F(ColumnarCodecTest, Corrupted) {
+    hybridse::codec::Schema schema;
+    InitColumnarSchema(&schema);
+    auto rows = BuildColumnarRows(schema, 10);
+    std::string buf;
+    ASSERT_TRUE(EncodeColumnarRows(schema, rows, rows.size(), &buf));
+    ColumnarView view(schema);
+    ASSERT_FALSE(view.Reset(buf.data(), buf.size() - 8));
+    ASSERT_FALSE(view.Reset(buf.data(), 4));
+
+    hybridse::codec::Schema other_schema;
+    other_schema.Add()->set_type(hybridse::type::kInt64);
+    ColumnarView other_view(other_schema);
+    ASSERT_FALSE(other_view.Reset(buf.data(), buf.size()));
+
+    std::vector<hybridse::codec::Row> empty_rows;
+    ASSERT_TRUE(EncodeColumnarRows(schema, empty_rows, 0, &buf));
+    ASSERT_TRUE(view.Reset(buf.data(), buf.size()));
+    ASSERT_EQ(0u, view.GetRowCnt());
+}
+
+}  // namespace codec
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
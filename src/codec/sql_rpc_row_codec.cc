@@ -19,7 +19,24 @@
 namespace openmldb {
 namespace codec {
 
-bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row) {
+// the address of [offset, offset + size) in buf if it lies in one block, otherwise nullptr
+static const char* GetContinuousData(const butil::IOBuf& buf, size_t offset, size_t size) {
+    size_t block_offset = 0;
+    for (size_t i = 0; i < buf.backing_block_num(); ++i) {
+        auto block = buf.backing_block(i);
+        if (offset < block_offset + block.size()) {
+            if (offset + size <= block_offset + block.size()) {
+                return block.data() + (offset - block_offset);
+            }
+            return nullptr;
+        }
+        block_offset += block.size();
+    }
+    return nullptr;
+}
+
+bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row,
+                  bool in_place) {
     if (row == nullptr) {
         return false;
     }
@@ -53,12 +70,19 @@ bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t sl
                 row->Append(hybridse::base::RefCountedSlice());
             }
         } else {
-            int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
-            buf.copy_to(slice_buf, slice_size, cur_offset);
+            const char* data = in_place ? GetContinuousData(buf, cur_offset, slice_size) : nullptr;
+            hybridse::base::RefCountedSlice slice;
+            if (data != nullptr) {
+                slice = hybridse::base::RefCountedSlice::Create(data, slice_size);
+            } else {
+                int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
+                buf.copy_to(slice_buf, slice_size, cur_offset);
+                slice = hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size);
+            }
             if (i == 0) {
-                *row = hybridse::codec::Row(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                *row = hybridse::codec::Row(slice);
             } else {
-                row->Append(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                row->Append(slice);
             }
         }
         cur_offset = next_offset;
@@ -31,7 +31,10 @@
 namespace openmldb {
 namespace codec {
 
-bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row);
+// in_place: the slices that lie in one block of buf are referred to instead of copied, so the row is valid only
+// while buf is alive, e.g. the request attachment during the rpc
+bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t slice_num, hybridse::codec::Row* row,
+                  bool in_place = false);
 
 bool EncodeRpcRow(const hybridse::codec::Row& row, butil::IOBuf* buf, size_t* total_size);
 
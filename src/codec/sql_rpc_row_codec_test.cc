@@ -123,6 +123,45 @@ TEST_F(SqlRpcRowCodecTest, TestMultiSlice) {
     ASSERT_EQ(0, decoded.size(3));
 }
 
+TEST_F(SqlRpcRowCodecTest, TestDecodeInPlace) {
+    hybridse::codec::Schema schema;
+    InitSchema(&schema);
+
+    hybridse::codec::RowBuilder builder(schema);
+    size_t buf_size = builder.CalTotalLength(5);
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(buf_size));
+    builder.SetBuffer(buf, buf_size);
+    builder.AppendInt32(42);
+    builder.AppendFloat(3.14);
+    builder.AppendString("hello", 5);
+
+    butil::IOBuf iobuf;
+    iobuf.append("test prefix string");
+    ASSERT_TRUE(EncodeRpcRow(buf, buf_size, &iobuf));
+    hybridse::codec::Row decoded;
+    ASSERT_TRUE(DecodeRpcRow(iobuf, 18, buf_size, 1, &decoded, true));
+    // refer to the block of iobuf
+    ASSERT_EQ(reinterpret_cast<const int8_t*>(iobuf.backing_block(0).data()) + 18, decoded.buf(0));
+    hybridse::codec::RowView row_view(schema);
+    row_view.Reset(decoded.buf(0), decoded.size(0));
+    ASSERT_EQ(42, row_view.GetInt32Unsafe(0));
+    ASSERT_EQ("hello", row_view.GetStringUnsafe(2));
+
+    // the row spans two blocks, so it is copied
+    butil::IOBuf split_buf;
+    split_buf.append(buf, 10);
+    int8_t* rest = reinterpret_cast<int8_t*>(malloc(buf_size - 10));
+    memcpy(rest, buf + 10, buf_size - 10);
+    split_buf.append_user_data(rest, buf_size - 10, free);
+    ASSERT_EQ(2u, split_buf.backing_block_num());
+    ASSERT_TRUE(DecodeRpcRow(split_buf, 0, buf_size, 1, &decoded, true));
+    row_view.Reset(decoded.buf(0), decoded.size(0));
+    ASSERT_EQ(42, row_view.GetInt32Unsafe(0));
+    ASSERT_FLOAT_EQ(3.14, row_view.GetFloatUnsafe(1));
+    ASSERT_EQ("hello", row_view.GetStringUnsafe(2));
+    free(buf);
+}
+
 }  // namespace codec
 }  // namespace openmldb
 
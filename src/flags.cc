@@ -53,14 +53,32 @@ DEFINE_int32(gc_pool_size, 2, "the size of tablet gc thread pool");
 DEFINE_int32(gc_safe_offset, 1, "the safe offset of tablet gc in minute");
 DEFINE_uint64(gc_on_table_recover_count, 10000000, "make a gc on recover count");
 DEFINE_uint32(gc_deleted_pk_version_delta, 2, "config the gc version delta");
+DEFINE_uint32(gc_incremental_slice_time, 0,
+              "the max time(ms) of a gc slice. if it is greater than 0, the absolute ttl gc of memory table only "
+              "visits the keys with expired rows and runs in slices. 0 means disable");
+DEFINE_uint32(gc_incremental_slice_interval, 100, "the interval(ms) between two gc slices of a table");
 DEFINE_double(mem_release_rate, 5, "specify memory release rate, which should be in 0 ~ 10");
+DEFINE_uint32(cold_data_freeze_time, 0,
+              "freeze the rows older than this time(minute) into compressed cold blocks in gc, only for the memory "
+              "table with a single absolute ttl index. 0 means disable");
 DEFINE_int32(task_pool_size, 3, "the size of tablet task thread pool");
 DEFINE_int32(io_pool_size, 2, "the size of tablet io task thread pool");
 DEFINE_bool(use_name, false, "enable or disable use server name");
 DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
+DEFINE_string(jit_object_cache_dir, "",
+              "the dir to keep the compiled objects of sql and deployments across restarts, empty means disable");
 DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
+DEFINE_uint32(aggr_buffer_shard_cnt, 64,
+              "the number of shards of the buffers of a pre-aggregator, the writers of keys in different shards do not "
+              "contend on a lock");
+DEFINE_bool(enable_window_aggr_cache, false,
+            "keep the running aggregate of the sum/count/avg/min/max rows_range windows of deployments per key in "
+            "memory tables, so that a request is answered without scanning the window");
+DEFINE_uint32(window_aggr_cache_max_mb, 256,
+              "the max memory of the states of one window aggr cache, the keys beyond it are evicted. "
+              "0 means no limit");
 
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
@@ -70,14 +88,26 @@ DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview")
 // binlog configuration
 DEFINE_int32(binlog_single_file_max_size, 1024 * 4, "the max size of single binlog file");
 DEFINE_int32(binlog_sync_batch_size, 32, "the batch size of sync binlog");
+DEFINE_uint32(binlog_sync_batch_bytes, 0,
+              "the max bytes of entries in a sync binlog request, the batch is sized by bytes instead of "
+              "binlog_sync_batch_size if it is set");
+DEFINE_uint32(binlog_sync_max_inflight, 1,
+              "the max count of sync binlog requests in flight to a follower, more than 1 enables pipelined sync");
 DEFINE_bool(binlog_notify_on_put, false, "config the sync log to follower strategy");
 DEFINE_bool(binlog_enable_crc, false, "enable crc");
 DEFINE_int32(binlog_coffee_time, 1000, "config the coffee time");
 DEFINE_int32(binlog_sync_wait_time, 100, "config the sync log wait time");
 DEFINE_int32(binlog_sync_to_disk_interval, 20000, "config the interval of sync binlog to disk time");
+DEFINE_uint32(binlog_group_commit_max_size, 64, "the max count of entries committed by one binlog write");
+DEFINE_bool(binlog_sync_on_commit, false, "sync binlog to disk before put returns, a commit group shares one sync");
+DEFINE_uint32(binlog_group_commit_wait_us, 0,
+              "the max time in us a commit group waits for more entries before sync, "
+              "only works with binlog_sync_on_commit");
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset ");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
+DEFINE_string(binlog_compression, "off",
+              "Type of binlog compression, can be off, snappy, zlib. The binlog files written before keep their type");
 DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of check binlog sync progress");
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
@@ -94,9 +124,15 @@ DEFINE_int32(get_concurrency_limit, 0, "the limit of get concurrency");
 DEFINE_int32(request_max_retry, 3, "max retry time when request error");
 DEFINE_int32(request_timeout_ms, 20000, "request timeout(except the requests sent to taskmanager)");
 DEFINE_int32(request_sleep_time, 1000, "the sleep time when request error");
+DEFINE_uint32(put_batch_max_rows, 10000, "the max number of rows in a put batch request to a partition");
+DEFINE_uint32(put_batch_max_bytes, 8 * 1024 * 1024,
+              "the max bytes of rows in a put batch request to a partition, keep it below the max body size of rpc");
 
 DEFINE_uint32(max_traverse_cnt, 50000, "max traverse iter loop cnt");
 DEFINE_uint32(traverse_cnt_limit, 1000, "limit traverse cnt");
+DEFINE_uint32(traverse_prefetch_num, 4, "the max number of remote partition pages in flight for a full table traverse");
+DEFINE_uint64(traverse_prefetch_max_bytes, 64 * 1024 * 1024,
+              "the max bytes of remote partition pages prefetched for a full table traverse");
 DEFINE_string(ssd_root_path, "", "the root ssd path of db");
 DEFINE_string(hdd_root_path, "", "the root hdd path of db");
 
@@ -118,6 +154,8 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
+DEFINE_uint32(snapshot_thread_num, 1,
+              "the number of threads to make a memory table snapshot, each thread writes a separate snapshot file");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000, "config the max wait time of load index");
 
@@ -149,9 +187,17 @@ DEFINE_bool(verify_compression, false, "For debug");
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_bool(snapshot_recover_mmap, true,
+            "recover uncompressed snapshot files through mmap and decode the records in place");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000, "config the interval to sync replica cluster status time");
 
 DEFINE_uint32(sync_deploy_stats_timeout, 10000,
               "time interval in milliseconds to sync deploy response time stats into table");
+
+// api server
+DEFINE_uint32(api_server_batch_wait_us, 0,
+              "the max time in us a deployment call waits for the concurrent calls of the same deployment to be sent "
+              "in one request, 0 disables the batching");
+DEFINE_uint32(api_server_batch_max_rows, 64, "the max rows of a request merged from the concurrent deployment calls");
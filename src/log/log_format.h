@@ -56,10 +56,19 @@ static const uint32_t kHeaderSize = 4 + 2 + 1;
 // Header is checksum (4 bytes), length (4 bytes), type (1 byte).
 static const uint32_t kHeaderSizeForCompress = 4 + 4 + 1;
 
+// a compressed block could be larger than the raw block if the data is not
+// compressible, it is bounded by the max output size of snappy
+static const uint32_t kMaxCompressedBlockSize = 32 + kCompressBlockSize + kCompressBlockSize / 6;
+
 // kHeaderSizeOfCompressBlock should be multiple of 64 bytes
 // compress_len(4 bytes), compress_type(1 byte)
 static const uint32_t kHeaderSizeOfCompressBlock = 64;
 
+// a block of a binlog is often a single commit group, so it has a compact header instead:
+// compress_len(4 bytes), compress_type | kCompactBlockFlag(1 byte), reserved(3 bytes)
+static const uint32_t kCompactHeaderSizeOfCompressBlock = 8;
+static const uint8_t kCompactBlockFlag = 0x80;
+
 static const std::string ZLIB_COMPRESS_SUFFIX = ".zlib";      // NOLINT
 static const std::string SNAPPY_COMPRESS_SUFFIX = ".snappy";  // NOLINT
 
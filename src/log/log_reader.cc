@@ -43,7 +43,8 @@ namespace log {
 
 Reader::Reporter::~Reporter() {}
 
-Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t initial_offset, bool compressed)
+Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t initial_offset, bool compressed,
+               bool detect_compression)
     : file_(file),
       reporter_(reporter),
       checksum_(checksum),
@@ -54,29 +55,44 @@ Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t
       last_end_of_buffer_offset_(0),
       initial_offset_(initial_offset),
       resyncing_(initial_offset > 0),
-      compressed_(compressed),
-      uncompress_buf_(nullptr) {
+      compressed_(false),
+      detect_compression_(detect_compression),
+      compress_type_(kNoCompress),
+      uncompress_buf_(nullptr),
+      block_file_offset_(0),
+      file_offset_(0),
+      last_block_file_offset_(0) {
+    backing_store_ = nullptr;
+    SetCompressed(compressed);
+}
+
+Reader::~Reader() {
+    delete[] backing_store_;
+    if (uncompress_buf_) {
+        delete[] uncompress_buf_;
+    }
+}
+
+void Reader::SetCompressed(bool compressed) {
+    compressed_ = compressed;
+    delete[] backing_store_;
     if (compressed_) {
         block_size_ = kCompressBlockSize;
-        uncompress_buf_ = new char[block_size_];
+        if (uncompress_buf_ == nullptr) {
+            uncompress_buf_ = new char[block_size_];
+        }
         header_size_ = kHeaderSizeForCompress;
+        backing_store_ = new char[kMaxCompressedBlockSize];
     } else {
         block_size_ = kBlockSize;
         header_size_ = kHeaderSize;
+        backing_store_ = new char[block_size_];
     }
-    backing_store_ = new char[block_size_];
     DLOG(INFO) << "block_size_: " << block_size_ << ", "
                << "header_size_: " << header_size_ << ", "
                << "compressed_: " << compressed_;
 }
 
-Reader::~Reader() {
-    delete[] backing_store_;
-    if (uncompress_buf_) {
-        delete[] uncompress_buf_;
-    }
-}
-
 bool Reader::SkipToInitialBlock() {
     size_t offset_in_block = initial_offset_ % block_size_;
     uint64_t block_start_location = initial_offset_ - offset_in_block;
@@ -148,9 +164,10 @@ Status Reader::ReadRecord(Slice* record, std::string* scratch) {
                 scratch->clear();
                 *record = fragment;
                 last_record_offset_ = prospective_record_offset;
-                last_record_end_offset_ = end_of_buffer_offset_ - buffer_.size();
+                last_record_end_offset_ = compressed_ ? file_offset_ : end_of_buffer_offset_ - buffer_.size();
                 if (offset) {
                     last_end_of_buffer_offset_ = offset;
+                    last_block_file_offset_ = block_file_offset_;
                 }
                 return Status::OK();
 
@@ -201,9 +218,10 @@ Status Reader::ReadRecord(Slice* record, std::string* scratch) {
                     scratch->append(fragment.data(), fragment.size());
                     *record = Slice(*scratch);
                     last_record_offset_ = prospective_record_offset;
-                    last_record_end_offset_ = end_of_buffer_offset_ - buffer_.size();
+                    last_record_end_offset_ = compressed_ ? file_offset_ : end_of_buffer_offset_ - buffer_.size();
                     if (offset) {
                         last_end_of_buffer_offset_ = offset;
+                        last_block_file_offset_ = block_file_offset_;
                     }
                     return Status::OK();
                 }
@@ -254,6 +272,15 @@ void Reader::ReportDrop(uint64_t bytes, const Status& reason) {
 }
 
 void Reader::GoBackToLastBlock() {
+    if (compressed_) {
+        // the compressed blocks are not aligned, go back by the recorded offset
+        DEBUGLOG("go back block from[%lu] to [%lu]", file_offset_, last_block_file_offset_);
+        end_of_buffer_offset_ = last_end_of_buffer_offset_;
+        file_offset_ = last_block_file_offset_;
+        buffer_.clear();
+        file_->Seek(file_offset_);
+        return;
+    }
     size_t offset_in_block = last_end_of_buffer_offset_ % block_size_;
     uint64_t block_start_location = 0;
     if (last_end_of_buffer_offset_ > offset_in_block) {
@@ -269,6 +296,7 @@ void Reader::GoBackToStart() {
     uint64_t block_start_location = 0;
     PDLOG(WARNING, "go back block to start");
     end_of_buffer_offset_ = block_start_location;
+    file_offset_ = block_start_location;
     buffer_.clear();
     file_->Seek(block_start_location);
 }
@@ -278,24 +306,59 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
         // Last read was a full read, so this is a trailer to skip
         buffer_.clear();
         Status status;
+        if (detect_compression_) {
+            // a compressed file starts with the header of a block instead of a record,
+            // its byte at the place of the record type is zero which no record has
+            Slice head;
+            status = file_->Read(kHeaderSize, &head, backing_store_);
+            if (!status.ok() || head.size() < kHeaderSize) {
+                return kWaitRecord;
+            }
+            file_->Seek(0);
+            detect_compression_ = false;
+            if (head[kHeaderSize - 1] == kZeroType) {
+                SetCompressed(true);
+            }
+        }
         if (!compressed_) {
             status = file_->Read(block_size_, &buffer_, backing_store_);
         } else {
-            // read header of compressed data
+            // read header of compressed data, a compact header is told by the flag in the compress type
             Slice header_of_compress;
-            status = file_->Read(kHeaderSizeOfCompressBlock, &header_of_compress, backing_store_);
+            status = file_->Read(kCompactHeaderSizeOfCompressBlock, &header_of_compress, backing_store_);
             if (!status.ok()) {
                 PDLOG(WARNING, "fail to read file %s when reading header", status.ToString().c_str());
                 return kWaitRecord;
             }
+            if (header_of_compress.size() < kCompactHeaderSizeOfCompressBlock) {
+                // the block is being written
+                return kWaitRecord;
+            }
             const char* data = header_of_compress.data();
             uint32_t compress_len = 0;
             memcpy(static_cast<void*>(&compress_len), data, sizeof(uint32_t));
             memrev32ifbe(static_cast<void*>(&compress_len));
-            CompressType compress_type = kNoCompress;
-            memcpy(static_cast<void*>(&compress_type), data + sizeof(uint32_t), 1);
+            uint8_t type = static_cast<uint8_t>(data[sizeof(uint32_t)]);
+            uint32_t head_size = kCompactHeaderSizeOfCompressBlock;
+            if ((type & kCompactBlockFlag) == 0) {
+                head_size = kHeaderSizeOfCompressBlock;
+                Slice rest_of_header;
+                status = file_->Read(head_size - kCompactHeaderSizeOfCompressBlock, &rest_of_header, backing_store_);
+                if (!status.ok()) {
+                    PDLOG(WARNING, "fail to read file %s when reading header", status.ToString().c_str());
+                    return kWaitRecord;
+                }
+                if (rest_of_header.size() < head_size - kCompactHeaderSizeOfCompressBlock) {
+                    return kWaitRecord;
+                }
+            }
+            CompressType compress_type = static_cast<CompressType>(type & ~kCompactBlockFlag);
             DLOG(INFO) << "compress_len: " << compress_len << ", "
                        << "compress_type: " << compress_type;
+            if (compress_len > kMaxCompressedBlockSize) {
+                PDLOG(WARNING, "bad record when reading block, compress_len: %u", compress_len);
+                return kBadRecord;
+            }
             // read compressed data
             Slice block;
             status = file_->Read(compress_len, &block, backing_store_);
@@ -303,33 +366,31 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
                 PDLOG(WARNING, "fail to read file %s when reading block", status.ToString().c_str());
                 return kWaitRecord;
             }
+            if (block.size() < compress_len) {
+                return kWaitRecord;
+            }
             const char* block_data = block.data();
-            int32_t uncompress_len = 0;
+            size_t uncompress_len = 0;
             switch (compress_type) {
                 case kSnappy: {
-                    snappy::GetUncompressedLength(block_data, static_cast<size_t>(compress_len),
-                                                  reinterpret_cast<size_t*>(&uncompress_len));
-                    if (!snappy::RawUncompress(block_data, static_cast<size_t>(compress_len), uncompress_buf_)) {
+                    if (!snappy::GetUncompressedLength(block_data, compress_len, &uncompress_len) ||
+                        uncompress_len > block_size_ ||
+                        !snappy::RawUncompress(block_data, compress_len, uncompress_buf_)) {
                         PDLOG(WARNING, "bad record when uncompress block, compress type: %d", compress_type);
                         return kBadRecord;
                     }
                     break;
                 }
                 case kZlib: {
-                    uncompress_len = block_size_;
-#ifdef __APPLE__
-                    int res = uncompress((unsigned char*)uncompress_buf_, reinterpret_cast<uLongf*>(&uncompress_len),
-                                         (const unsigned char*)block_data, compress_len);
-#else
-                    // linux
-                    int res = uncompress((unsigned char*)uncompress_buf_, reinterpret_cast<uint64_t*>(&uncompress_len),
-                                         (const unsigned char*)block_data, compress_len);
-#endif
+                    uLongf dest_len = block_size_;
+                    int res = uncompress((unsigned char*)uncompress_buf_, &dest_len, (const unsigned char*)block_data,
+                                         compress_len);
                     if (res != Z_OK) {
                         PDLOG(WARNING, "bad record when uncompress block, error code: %d, compress type: %d", res,
                               compress_type);
                         return kBadRecord;
                     }
+                    uncompress_len = dest_len;
                     break;
                 }
                 default: {
@@ -337,13 +398,17 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
                     return kBadRecord;
                 }
             }
-            if (uncompress_len != static_cast<int32_t>(block_size_)) {
-                PDLOG(WARNING, "bad record when uncompress block, uncompress_len: %d, block_size_: %d", uncompress_len,
+            // a block flushed before it is full is shorter than block_size_
+            if (uncompress_len == 0 || uncompress_len > block_size_) {
+                PDLOG(WARNING, "bad record when uncompress block, uncompress_len: %lu, block_size_: %d", uncompress_len,
                       block_size_);
                 return kBadRecord;
             }
             DLOG(INFO) << "uncompress_len: " << uncompress_len;
-            buffer_ = Slice(uncompress_buf_, block_size_);
+            compress_type_ = compress_type;
+            block_file_offset_ = file_offset_;
+            file_offset_ += head_size + compress_len;
+            buffer_ = Slice(uncompress_buf_, uncompress_len);
         }
         offset = end_of_buffer_offset_;
         end_of_buffer_offset_ += buffer_.size();
@@ -462,6 +527,13 @@ void LogReader::GoBackToStart() {
 
 int LogReader::GetLogIndex() { return log_part_index_; }
 
+CompressType LogReader::GetCompressType() {
+    if (reader_ == NULL) {
+        return kNoCompress;
+    }
+    return reader_->GetCompressType();
+}
+
 uint64_t LogReader::GetLastRecordEndOffset() {
     if (reader_ == NULL) {
         PDLOG(WARNING, "reader is NULL");
@@ -558,7 +630,7 @@ int LogReader::RollRLogFile() {
         }
         delete reader_;
         // roll a new log part file, reset status
-        reader_ = new Reader(sf_, NULL, FLAGS_binlog_enable_crc, 0, compressed_);
+        reader_ = new Reader(sf_, NULL, FLAGS_binlog_enable_crc, 0, compressed_, true);
         PDLOG(INFO, "roll log file from index[%d] to index[%d]", log_part_index_, index);
         log_part_index_ = index;
         return 0;
@@ -60,7 +60,11 @@ class Reader {
     //
     // The Reader will start reading at the first record located at physical
     // position >= initial_offset within the file.
-    Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t initial_offset, bool compressed);
+    //
+    // If "detect_compression" is true, whether the file is compressed is
+    // decided by its first block instead of "compressed".
+    Reader(SequentialFile* file, Reporter* reporter, bool checksum, uint64_t initial_offset, bool compressed,
+           bool detect_compression = false);
 
     ~Reader();
 
@@ -76,6 +80,8 @@ class Reader {
     // Undefined before the first call to ReadRecord.
     uint64_t LastRecordOffset();
 
+    // Returns the end offset of the last record returned by ReadRecord. For a
+    // compressed file it is the end of the block holding the record.
     uint64_t LastRecordEndOffset();
 
     void GoBackToLastBlock();
@@ -83,6 +89,9 @@ class Reader {
 
     inline bool GetCompressed() { return compressed_; }
 
+    // the compress type of the last block read
+    inline CompressType GetCompressType() { return compress_type_; }
+
     inline uint32_t GetBlockSize() { return block_size_; }
 
     inline uint32_t GetHeaderSize() { return header_size_; }
@@ -111,10 +120,20 @@ class Reader {
     bool resyncing_;
 
     bool compressed_;
+    bool detect_compression_;
+    CompressType compress_type_;
     uint32_t block_size_;
     uint32_t header_size_;
     // buffer for uncompressed block
     char* uncompress_buf_;
+    // the offsets in the file of a compressed file, they differ from the
+    // offsets of the records as the blocks are compressed
+    // the offset of the block in buffer_
+    uint64_t block_file_offset_;
+    // the offset past the block in buffer_
+    uint64_t file_offset_;
+    // the offset of the block holding the end of the last record
+    uint64_t last_block_file_offset_;
 
     // Extend record types with the following special values
     enum {
@@ -129,6 +148,8 @@ class Reader {
         kWaitRecord = kMaxRecordType + 3
     };
 
+    void SetCompressed(bool compressed);
+
     // Skips all blocks that are completely before "initial_offset_".
     //
     // Returns true on success. Handles reporting.
@@ -161,6 +182,7 @@ class LogReader {
     int GetLogIndex();
     int GetEndLogIndex();
     uint64_t GetLastRecordEndOffset();
+    CompressType GetCompressType();
     void SetOffset(uint64_t start_offset);
     LogReader(const LogReader&) = delete;
     LogReader& operator=(const LogReader&) = delete;
@@ -31,6 +31,7 @@
 #include "log/crc32c.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
+#include "log/mmap_reader.h"
 #include "proto/tablet.pb.h"
 
 using ::openmldb::base::Slice;
@@ -388,6 +389,111 @@ TEST_F(LogWRTest, TestGoBack) {
     ASSERT_EQ("hello", value3.ToString());
 }
 
+TEST_F(LogWRTest, TestMmapReader) {
+    if (compressed_) {
+        return;
+    }
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = log_dir + "/" + fname;
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    std::vector<std::string> val_vec;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 100 == 0) {
+            // spans several blocks
+            val_vec.push_back(std::string(kBlockSize * 3 + i, 'a' + i % 26));
+        } else {
+            val_vec.push_back("value" + std::to_string(i));
+        }
+        ASSERT_TRUE(writer.AddRecord(val_vec.back()).ok());
+    }
+    wf->Sync();
+    MmapReader reader(full_path);
+    ASSERT_TRUE(reader.Open().ok());
+    std::string scratch;
+    Slice value;
+    for (const auto& expect : val_vec) {
+        Status status = reader.ReadRecord(&value, &scratch);
+        ASSERT_TRUE(status.ok());
+        ASSERT_EQ(expect, value.ToString());
+    }
+    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsWaitRecord());
+    delete wf;
+
+    MmapReader empty_reader(log_dir + "/empty.log");
+    ASSERT_FALSE(empty_reader.Open().ok());
+}
+
+TEST_F(LogWRTest, TestFlushBlock) {
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = log_dir + "/" + fname;
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf, 0, true);
+    FILE* fd_r = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd_r != NULL);
+    SequentialFile* rf = NewSeqFile(fname, fd_r);
+    // whether the file is compressed is told by the first block
+    Reader reader(rf, NULL, true, 0, false, true);
+    std::string scratch;
+    Slice value;
+    ASSERT_TRUE(reader.ReadRecord(&value, &scratch).IsWaitRecord());
+    std::vector<std::string> val_vec;
+    uint64_t read_cnt = 0;
+    // the reader goes back to the last block after waiting, the records read already are skipped
+    auto read_all = [&]() {
+        while (true) {
+            Status status = reader.ReadRecord(&value, &scratch);
+            if (!status.ok()) {
+                return status;
+            }
+            std::string val = value.ToString();
+            uint64_t idx = std::stoull(val.substr(0, val.find(':')));
+            if (idx == read_cnt) {
+                EXPECT_EQ(val_vec[idx], val);
+                read_cnt++;
+            }
+        }
+    };
+    uint32_t large_size = compressed_ ? kCompressBlockSize + 100 : kBlockSize * 3;
+    for (int i = 0; i < 100; i++) {
+        std::string val = std::to_string(i) + ":";
+        val.append(i % 10 == 9 ? std::string(large_size, 'a' + i % 26) : "value");
+        val_vec.push_back(val);
+        ASSERT_TRUE(writer.AddRecord(val).ok());
+        // a flushed record is readable at once even if its block is not full
+        ASSERT_TRUE(read_all().IsWaitRecord());
+        ASSERT_EQ(val_vec.size(), read_cnt);
+        if (compressed_ && i == 0) {
+            // a small flushed block has a compact header
+            ASSERT_LT(wf->GetSize(), kHeaderSizeOfCompressBlock);
+        }
+    }
+    ASSERT_EQ(compressed_, reader.GetCompressed());
+    for (int i = 100; i < 110; i++) {
+        val_vec.push_back(std::to_string(i) + ":batch");
+        ASSERT_TRUE(writer.AddRecord(val_vec.back(), false).ok());
+    }
+    if (compressed_) {
+        ASSERT_TRUE(read_all().IsWaitRecord());
+        ASSERT_EQ(100u, read_cnt);
+    }
+    ASSERT_TRUE(writer.Flush().ok());
+    ASSERT_TRUE(read_all().IsWaitRecord());
+    ASSERT_EQ(val_vec.size(), read_cnt);
+    ASSERT_TRUE(writer.EndLog().ok());
+    ASSERT_TRUE(read_all().IsEof());
+    delete rf;
+    delete wf;
+}
+
 TEST_F(LogWRTest, TestInit) {
     std::string log_dir = "/tmp/" + GenRand() + "/";
     ::openmldb::base::MkdirRecur(log_dir);
@@ -43,6 +43,7 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest)
     : dest_(dest),
       block_offset_(0),
       compress_type_(GetCompressType(compress_type)),
+      flush_block_(false),
       header_size_(compress_type_ != kNoCompress ? kHeaderSizeForCompress : kHeaderSize),
       buffer_(nullptr),
       compress_buf_(nullptr) {
@@ -50,7 +51,7 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest)
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
         buffer_ = new char[block_size_];
-        compress_buf_ = new char[block_size_];
+        compress_buf_ = new char[kMaxCompressedBlockSize];
     } else {
         block_size_ = kBlockSize;
     }
@@ -59,9 +60,10 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest)
                << "compress_type_: " << compress_type_;
 }
 
-Writer::Writer(const std::string& compress_type, WritableFile* dest, uint64_t dest_length)
+Writer::Writer(const std::string& compress_type, WritableFile* dest, uint64_t dest_length, bool flush_block)
     : dest_(dest),
       compress_type_(GetCompressType(compress_type)),
+      flush_block_(flush_block),
       header_size_(compress_type_ != kNoCompress ? kHeaderSizeForCompress : kHeaderSize),
       buffer_(nullptr),
       compress_buf_(nullptr) {
@@ -69,11 +71,13 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest, uint64_t de
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
         buffer_ = new char[block_size_];
-        compress_buf_ = new char[block_size_];
+        compress_buf_ = new char[kMaxCompressedBlockSize];
+        // the blocks of a compressed file are not aligned, a new block starts after the existing data
+        block_offset_ = 0;
     } else {
         block_size_ = kBlockSize;
+        block_offset_ = dest_length % block_size_;
     }
-    block_offset_ = dest_length % block_size_;
     DLOG(INFO) << "block_size_: " << block_size_ << ", "
                << "header_size_: " << header_size_ << ", "
                << "compress_type_: " << compress_type_;
@@ -126,7 +130,7 @@ Status Writer::EndLog() {
     return s;
 }
 
-Status Writer::AddRecord(const Slice& slice) {
+Status Writer::AddRecord(const Slice& slice, bool flush) {
     const char* ptr = slice.data();
     size_t left = slice.size();
 
@@ -172,7 +176,7 @@ Status Writer::AddRecord(const Slice& slice) {
         } else {
             type = kMiddleType;
         }
-        s = EmitPhysicalRecord(type, ptr, fragment_length);
+        s = EmitPhysicalRecord(type, ptr, fragment_length, flush);
         ptr += fragment_length;
         left -= fragment_length;
         begin = false;
@@ -180,7 +184,7 @@ Status Writer::AddRecord(const Slice& slice) {
     return s;
 }
 
-Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
+Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n, bool flush) {
     if (compress_type_ == kNoCompress) {
         assert(n <= 0xffff);  // Must fit in two bytes
     } else {
@@ -211,7 +215,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         Status s = dest_->Append(Slice(buf, header_size_));
         if (s.ok()) {
             s = dest_->Append(Slice(ptr, n));
-            if (s.ok()) {
+            if (s.ok() && flush) {
                 s = dest_->Flush();
             }
         }
@@ -225,37 +229,44 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         memcpy(buffer_ + block_offset_, &buf, header_size_);
         memcpy(buffer_ + block_offset_ + header_size_, ptr, n);
         block_offset_ += header_size_ + n;
-        // fill the trailer if kEofType
-        if (t == kEofType) {
+        // fill the trailer if kEofType, a flushed block is written as it is
+        if (t == kEofType && !flush_block_) {
             memset(buffer_ + block_offset_, 0, block_size_ - block_offset_);
             block_offset_ = block_size_;
         }
         if (block_offset_ == block_size_) {
-            return CompressRecord();
+            block_offset_ = 0;
+            return CompressRecord(block_size_);
+        }
+        if (flush_block_ && (flush || t == kEofType)) {
+            return Flush();
         }
         return Status::OK();
     }
 }
 
-Status Writer::CompressRecord() {
+Status Writer::Flush() {
+    if (compress_type_ != kNoCompress && flush_block_ && block_offset_ > 0) {
+        uint32_t length = block_offset_;
+        block_offset_ = 0;
+        return CompressRecord(length);
+    }
+    return dest_->Flush();
+}
+
+Status Writer::CompressRecord(uint32_t length) {
     Status s;
     int32_t compress_len = -1;
     switch (compress_type_) {
         case kSnappy: {
-            snappy::RawCompress(buffer_, block_size_, compress_buf_, reinterpret_cast<size_t*>(&compress_len));
+            size_t dest_len = 0;
+            snappy::RawCompress(buffer_, length, compress_buf_, &dest_len);
+            compress_len = static_cast<int32_t>(dest_len);
             break;
         }
         case kZlib: {
-            uint32_t dest_len = compressBound(block_size_);
-
-#ifdef __APPLE__
-            int res = compress((unsigned char*)compress_buf_, reinterpret_cast<uLongf*>(&dest_len),
-                               (const unsigned char*)buffer_, block_size_);
-#else
-
-            int res = compress((unsigned char*)compress_buf_, reinterpret_cast<uint64_t*>(&dest_len),
-                               (const unsigned char*)buffer_, block_size_);
-#endif
+            uLongf dest_len = kMaxCompressedBlockSize;
+            int res = compress((unsigned char*)compress_buf_, &dest_len, (const unsigned char*)buffer_, length);
             if (res != Z_OK) {
                 s = Status::InvalidRecord(Slice("compress failed, error code: " + res));
                 PDLOG(WARNING, "write error, compress_type: %d, msg: %s", compress_type_, s.ToString().c_str());
@@ -277,14 +288,19 @@ Status Writer::CompressRecord() {
     }
     DLOG(INFO) << "compress_len: " << compress_len << ", "
                << "compress_type: " << compress_type_;
-    // fill compressed data's header
+    // fill compressed data's header, the blocks flushed with commit groups have a compact one
     char head_of_compress[kHeaderSizeOfCompressBlock];
+    uint32_t head_size = flush_block_ ? kCompactHeaderSizeOfCompressBlock : kHeaderSizeOfCompressBlock;
+    uint8_t type = static_cast<uint8_t>(compress_type_);
+    if (flush_block_) {
+        type |= kCompactBlockFlag;
+    }
     memrev32ifbe(static_cast<void*>(&compress_len));
     memcpy(head_of_compress, static_cast<void*>(&compress_len), sizeof(int32_t));
-    memcpy(head_of_compress + sizeof(int32_t), static_cast<void*>(&compress_type_), 1);
-    memset(head_of_compress + sizeof(int32_t) + 1, 0, kHeaderSizeOfCompressBlock - sizeof(int32_t) - 1);
+    memcpy(head_of_compress + sizeof(int32_t), static_cast<void*>(&type), 1);
+    memset(head_of_compress + sizeof(int32_t) + 1, 0, head_size - sizeof(int32_t) - 1);
     // write header and compressed data
-    s = dest_->Append(Slice(head_of_compress, kHeaderSizeOfCompressBlock));
+    s = dest_->Append(Slice(head_of_compress, head_size));
     if (s.ok()) {
         s = dest_->Append(Slice(compress_buf_, compress_len));
         if (s.ok()) {
@@ -314,7 +330,7 @@ Status Writer::AppendInternal(WritableFile* wf, int32_t leftover) {
         return Status::OK();
     } else {
         memcpy(buffer_ + block_offset_, fill_slice.data(), leftover);
-        return CompressRecord();
+        return CompressRecord(block_size_);
     }
 }
 
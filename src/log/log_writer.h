@@ -45,12 +45,17 @@ class Writer {
     // Create a writer that will append data to "*dest".
     // "*dest" must have initial length "dest_length".
     // "*dest" must remain live while this Writer is in use.
-    Writer(const std::string& compress_type, WritableFile* dest, uint64_t dest_length);
+    // If flush_block is true, a compressed writer writes out the pending block
+    // on flush even if it is not full, so the records can be read at once.
+    Writer(const std::string& compress_type, WritableFile* dest, uint64_t dest_length, bool flush_block = false);
 
     ~Writer();
 
-    Status AddRecord(const Slice& slice);
+    // if flush is false the record may stay in the buffer of dest until the
+    // next flushed record or an explicit flush of dest
+    Status AddRecord(const Slice& slice, bool flush = true);
     Status EndLog();
+    Status Flush();
 
     inline CompressType GetCompressType() { return compress_type_; }
 
@@ -70,16 +75,18 @@ class Writer {
     uint32_t type_crc_[kMaxRecordType + 1];
 
     CompressType compress_type_;
+    bool flush_block_;
     uint32_t block_size_;
     const uint32_t header_size_;
     // buffer of kCompressBlockSize
     char* buffer_;
     // buffer for compressed block
     char* compress_buf_;
-    Status CompressRecord();
+    // compress the first length bytes of buffer_ as a block and write it
+    Status CompressRecord(uint32_t length);
     Status AppendInternal(WritableFile* wf, int leftover);
 
-    Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
+    Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length, bool flush = true);
 
     // No copying allowed
     Writer(const Writer&);
@@ -90,15 +97,24 @@ struct WriteHandle {
     FILE* fd_;
     WritableFile* wf_;
     Writer* lw_;
-    WriteHandle(const std::string& compress_type, const std::string& fname, FILE* fd, uint64_t dest_length = 0)
+    WriteHandle(const std::string& compress_type, const std::string& fname, FILE* fd, uint64_t dest_length = 0,
+                bool flush_block = false)
         : fd_(fd), wf_(NULL), lw_(NULL) {
         wf_ = ::openmldb::log::NewWritableFile(fname, fd);
-        lw_ = new Writer(compress_type, wf_, dest_length);
+        lw_ = new Writer(compress_type, wf_, dest_length, flush_block);
     }
 
-    Status Write(const ::openmldb::base::Slice& slice) { return lw_->AddRecord(slice); }
+    Status Write(const ::openmldb::base::Slice& slice, bool flush = true) { return lw_->AddRecord(slice, flush); }
 
-    Status Sync() { return wf_->Sync(); }
+    Status Flush() { return lw_->Flush(); }
+
+    Status Sync() {
+        Status s = lw_->Flush();
+        if (!s.ok()) {
+            return s;
+        }
+        return wf_->Sync();
+    }
 
     Status EndLog() { return lw_->EndLog(); }
 
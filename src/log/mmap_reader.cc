@@ -0,0 +1,175 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log/mmap_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/glog_wapper.h"
+
+using ::openmldb::base::Slice;
+
+namespace openmldb {
+namespace log {
+
+MmapReader::MmapReader(const std::string& path) : path_(path), fd_(-1), base_(NULL), size_(0), offset_(0) {}
+
+MmapReader::~MmapReader() {
+    if (base_ != NULL) {
+        munmap(const_cast<char*>(base_), size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+Status MmapReader::Open() {
+    fd_ = open(path_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        return Status::IOError(path_, strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        return Status::IOError(path_, strerror(errno));
+    }
+    size_ = st.st_size;
+    if (size_ == 0) {
+        return Status::OK();
+    }
+    void* addr = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (addr == MAP_FAILED) {
+        size_ = 0;
+        return Status::IOError(path_, strerror(errno));
+    }
+    // the file is scanned once from the head, let the kernel read ahead aggressively
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    base_ = reinterpret_cast<const char*>(addr);
+    return Status::OK();
+}
+
+Status MmapReader::ReadRecord(Slice* record, std::string* scratch) {
+    scratch->clear();
+    record->clear();
+    bool in_fragmented_record = false;
+    Slice fragment;
+    while (true) {
+        const unsigned int record_type = ReadPhysicalRecord(&fragment);
+        switch (record_type) {
+            case kFullType:
+                if (in_fragmented_record && !scratch->empty()) {
+                    DEBUGLOG("partial record without end(1)");
+                }
+                scratch->clear();
+                *record = fragment;
+                return Status::OK();
+
+            case kFirstType:
+                if (in_fragmented_record && !scratch->empty()) {
+                    DEBUGLOG("partial record without end(2)");
+                }
+                scratch->assign(fragment.data(), fragment.size());
+                in_fragmented_record = true;
+                break;
+
+            case kMiddleType:
+                if (!in_fragmented_record) {
+                    DEBUGLOG("missing start of fragmented record(1). fragment size %u", fragment.size());
+                } else {
+                    scratch->append(fragment.data(), fragment.size());
+                }
+                break;
+
+            case kLastType:
+                if (!in_fragmented_record) {
+                    DEBUGLOG("missing start of fragmented record(2). fragment size %u", fragment.size());
+                } else {
+                    scratch->append(fragment.data(), fragment.size());
+                    *record = Slice(*scratch);
+                    return Status::OK();
+                }
+                break;
+
+            case kEof:
+                scratch->clear();
+                return Status::Eof();
+
+            case kWaitRecord:
+                scratch->clear();
+                return Status::WaitRecord();
+
+            case kBadRecord:
+                scratch->clear();
+                return Status::InvalidRecord(Slice("kBadRecord"));
+
+            default: {
+                char buf[40];
+                snprintf(buf, sizeof(buf), "unknown record type %u", record_type);
+                PDLOG(WARNING, "%s in %s", buf, path_.c_str());
+                in_fragmented_record = false;
+                scratch->clear();
+                return Status::Corruption(Slice(buf));
+            }
+        }
+    }
+}
+
+unsigned int MmapReader::ReadPhysicalRecord(Slice* result) {
+    while (true) {
+        // a block never leaves less than a header at its tail, the writer fills it as trailer
+        uint64_t block_left = kBlockSize - offset_ % kBlockSize;
+        if (block_left < kHeaderSize) {
+            offset_ += block_left;
+            continue;
+        }
+        if (offset_ + kHeaderSize > size_) {
+            return kWaitRecord;
+        }
+        const char* header = base_ + offset_;
+        const uint32_t a = static_cast<uint32_t>(header[4]) & 0xff;
+        const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
+        const unsigned int type = header[6];
+        const uint32_t length = a | (b << 8);
+        if (kHeaderSize + length > block_left) {
+            // the length is corrupted, drop the rest of the block as Reader does
+            offset_ += block_left;
+            return kBadRecord;
+        }
+        if (offset_ + kHeaderSize + length > size_) {
+            DEBUGLOG("end of file %lu, header size %u data length %u", size_, kHeaderSize, length);
+            return kWaitRecord;
+        }
+        if (type == kEofType && length == 0) {
+            PDLOG(INFO, "end of file");
+            return kEof;
+        }
+        if (type == kZeroType && length == 0) {
+            offset_ += block_left;
+            PDLOG(WARNING, "bad record with zero type");
+            return kBadRecord;
+        }
+        *result = Slice(header + kHeaderSize, length);
+        offset_ += kHeaderSize + length;
+        return type;
+    }
+}
+
+}  // namespace log
+}  // namespace openmldb
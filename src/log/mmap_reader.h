@@ -0,0 +1,66 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_LOG_MMAP_READER_H_
+#define SRC_LOG_MMAP_READER_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "base/slice.h"
+#include "log/log_format.h"
+#include "log/status.h"
+
+namespace openmldb {
+namespace log {
+
+// Reads the records of an uncompressed log file through a read only mapping of
+// the whole file. Unlike Reader the records are not copied into a block buffer,
+// a record which is not fragmented points into the mapping directly and stays
+// valid until the MmapReader is destroyed
+class MmapReader {
+ public:
+    explicit MmapReader(const std::string& path);
+    ~MmapReader();
+    MmapReader(const MmapReader&) = delete;
+    MmapReader& operator=(const MmapReader&) = delete;
+
+    Status Open();
+
+    // Read the next record into *record. A fragmented record is assembled in
+    // *scratch, so it is only valid until the next mutation of *scratch
+    Status ReadRecord(::openmldb::base::Slice* record, std::string* scratch);
+
+    inline uint64_t GetSize() const { return size_; }
+
+ private:
+    enum { kEof = kMaxRecordType + 1, kBadRecord = kMaxRecordType + 2, kWaitRecord = kMaxRecordType + 3 };
+
+    unsigned int ReadPhysicalRecord(::openmldb::base::Slice* result);
+
+ private:
+    std::string path_;
+    int fd_;
+    const char* base_;
+    uint64_t size_;
+    uint64_t offset_;
+};
+
+}  // namespace log
+}  // namespace openmldb
+
+#endif  // SRC_LOG_MMAP_READER_H_
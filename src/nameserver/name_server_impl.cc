@@ -2310,6 +2310,9 @@ int NameServerImpl::CreateTableOnTablet(const std::shared_ptr<::openmldb::namese
     table_meta.set_format_version(table_info->format_version());
     table_meta.set_storage_mode(table_info->storage_mode());
     table_meta.set_base_table_tid(table_info->base_table_tid());
+    if (table_info->has_storage_options()) {
+        table_meta.mutable_storage_options()->CopyFrom(table_info->storage_options());
+    }
     if (table_info->has_key_entry_max_height()) {
         table_meta.set_key_entry_max_height(table_info->key_entry_max_height());
     }
@@ -7847,6 +7850,65 @@ void NameServerImpl::UpdateTTL(RpcController* controller, const ::openmldb::name
     response->set_msg("ok");
 }
 
+void NameServerImpl::UpdateStorageOptions(RpcController* controller,
+                                          const ::openmldb::nameserver::UpdateStorageOptionsRequest* request,
+                                          GeneralResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (!running_.load(std::memory_order_acquire) || (mode_.load(std::memory_order_acquire) == kFOLLOWER)) {
+        response->set_code(::openmldb::base::ReturnCode::kNameserverIsNotLeader);
+        response->set_msg("nameserver is not leader");
+        PDLOG(WARNING, "cur nameserver is not leader");
+        return;
+    }
+    std::shared_ptr<::openmldb::nameserver::TableInfo> table;
+    if (!GetTableInfo(request->name(), request->db(), &table)) {
+        PDLOG(WARNING, "table with name %s does not exist", request->name().c_str());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (table->storage_mode() == ::openmldb::common::kMemory) {
+        response->set_code(::openmldb::base::ReturnCode::kTableTypeMismatch);
+        response->set_msg("storage options are only for disk table");
+        return;
+    }
+    bool all_ok = true;
+    for (int32_t i = 0; i < table->table_partition_size(); i++) {
+        if (!all_ok) {
+            break;
+        }
+        const TablePartition& table_partition = table->table_partition(i);
+        for (int32_t j = 0; j < table_partition.partition_meta_size(); j++) {
+            const PartitionMeta& meta = table_partition.partition_meta(j);
+            all_ok = all_ok && UpdateStorageOptionsOnTablet(meta.endpoint(), table->tid(), table_partition.pid(),
+                                                            request->storage_options());
+        }
+    }
+    if (!all_ok) {
+        response->set_code(::openmldb::base::ReturnCode::kFailToUpdateStorageOptionsFromTablet);
+        response->set_msg("fail to update storage options from tablet");
+        return;
+    }
+    TableInfo table_info;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        table_info.CopyFrom(*table);
+    }
+    table_info.mutable_storage_options()->CopyFrom(request->storage_options());
+    // update zookeeper
+    if (!UpdateZkTableNodeWithoutNotify(&table_info)) {
+        response->set_code(::openmldb::base::ReturnCode::kSetZkFailed);
+        response->set_msg("set zk failed");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        table->CopyFrom(table_info);
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_msg("ok");
+}
+
 void NameServerImpl::UpdateLeaderInfo(std::shared_ptr<::openmldb::api::TaskInfo> task_info) {
     std::shared_ptr<OPData> op_data = FindRunningOP(task_info->op_id());
     if (!op_data) {
@@ -8023,6 +8085,26 @@ bool NameServerImpl::UpdateTTLOnTablet(const std::string& endpoint, int32_t tid,
     return ok;
 }
 
+bool NameServerImpl::UpdateStorageOptionsOnTablet(const std::string& endpoint, int32_t tid, int32_t pid,
+                                                  const ::openmldb::common::StorageOptions& storage_options) {
+    std::shared_ptr<TabletInfo> tablet = GetTabletInfo(endpoint);
+    if (!tablet) {
+        PDLOG(WARNING, "tablet with endpoint %s is not found", endpoint.c_str());
+        return false;
+    }
+    if (!tablet->client_) {
+        PDLOG(WARNING, "tablet with endpoint %s has not client", endpoint.c_str());
+        return false;
+    }
+    bool ok = tablet->client_->UpdateStorageOptions(tid, pid, storage_options);
+    if (!ok) {
+        PDLOG(WARNING, "fail to update storage options with tid %d, pid %d, endpoint %s", tid, pid, endpoint.c_str());
+    } else {
+        PDLOG(INFO, "update storage options with tid %d pid %d endpoint %s ok", tid, pid, endpoint.c_str());
+    }
+    return ok;
+}
+
 void NameServerImpl::AddReplicaCluster(RpcController* controller, const ClusterAddress* request,
                                        GeneralResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -242,6 +242,10 @@ class NameServerImpl : public NameServer {
     void UpdateTTL(RpcController* controller, const ::openmldb::nameserver::UpdateTTLRequest* request,
                    ::openmldb::nameserver::UpdateTTLResponse* response, Closure* done);
 
+    void UpdateStorageOptions(RpcController* controller,
+                              const ::openmldb::nameserver::UpdateStorageOptionsRequest* request,
+                              GeneralResponse* response, Closure* done);
+
     void Migrate(RpcController* controller, const MigrateRequest* request, GeneralResponse* response, Closure* done);
 
     void RecoverEndpoint(RpcController* controller, const RecoverEndpointRequest* request, GeneralResponse* response,
@@ -707,6 +711,10 @@ class NameServerImpl : public NameServer {
     bool UpdateTTLOnTablet(const std::string& endpoint, int32_t tid, int32_t pid, const std::string& index_name,
                            const ::openmldb::common::TTLSt& ttl);
 
+    // update storage options for partition
+    bool UpdateStorageOptionsOnTablet(const std::string& endpoint, int32_t tid, int32_t pid,
+                                      const ::openmldb::common::StorageOptions& storage_options);
+
     void CheckSyncExistTable(const std::string& alias,
                              const std::vector<::openmldb::nameserver::TableInfo>& tables_remote,
                              const std::shared_ptr<::openmldb::client::NsClient> ns_client);
@@ -25,16 +25,23 @@
 #include <algorithm>
 #include <chrono>  // NOLINT
 #include <cstring>
+#include <functional>
 #include <utility>
 
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
 #include "base/strings.h"
+#include "bvar/bvar.h"
 #include "log/log_format.h"
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_uint32(binlog_group_commit_max_size);
+DECLARE_bool(binlog_sync_on_commit);
+DECLARE_uint32(binlog_group_commit_wait_us);
+DECLARE_uint32(binlog_sync_max_inflight);
+DECLARE_string(binlog_compression);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -42,6 +49,28 @@ namespace replica {
 
 static const ::openmldb::base::DefaultComparator scmp;
 
+// the commit latency of entries of all replicators, exposed on /vars.
+static bvar::LatencyRecorder g_commit_latency("binlog_group_commit");
+// the entry counts of the commit groups of all replicators. The p50/p99/max over the last 10 seconds are exposed
+// as binlog_group_commit_batch_{p50,p99,max} next to the latency percentiles.
+static const time_t COMMIT_BATCH_WINDOW_S = 10;
+static bvar::Percentile g_commit_batch_size;
+static bvar::Window<bvar::Percentile, bvar::SERIES_IN_SECOND> g_commit_batch_size_window(&g_commit_batch_size,
+                                                                                          COMMIT_BATCH_WINDOW_S);
+static bvar::Maxer<int64_t> g_commit_batch_max;
+static bvar::Window<bvar::Maxer<int64_t>, bvar::SERIES_IN_SECOND> g_commit_batch_max_window(
+    "binlog_group_commit_batch_max", &g_commit_batch_max, COMMIT_BATCH_WINDOW_S);
+
+template <int P>
+static uint32_t GetCommitBatchPercentile(void*) {
+    return g_commit_batch_size_window.get_value().get_number(P / 100.0);
+}
+
+static bvar::PassiveStatus<uint32_t> g_commit_batch_p50("binlog_group_commit_batch_p50",
+                                                        GetCommitBatchPercentile<50>, NULL);
+static bvar::PassiveStatus<uint32_t> g_commit_batch_p99("binlog_group_commit_batch_p99",
+                                                        GetCommitBatchPercentile<99>, NULL);
+
 LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
                              const std::map<std::string, std::string>& real_ep_map,
                              const ReplicatorRole& role)
@@ -52,6 +81,7 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       log_offset_(0),
       logs_(NULL),
       wh_(NULL),
+      wh_path_(),
       role_(role),
       real_ep_map_(real_ep_map),
       nodes_(),
@@ -59,7 +89,11 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      commit_mu_(),
+      commit_cv_(),
+      commit_queue_(),
+      arriving_writers_(0) {
     binlog_index_ = 0;
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
@@ -198,7 +232,8 @@ bool LogReplicator::Recover() {
             break;
         }
         ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(full_path, fd);
-        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, false);
+        // a binlog written with binlog_compression is told by its first block
+        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, false, true);
         ::openmldb::base::Slice record;
         ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
         delete seq_file;
@@ -229,10 +264,29 @@ bool LogReplicator::Recover() {
 
 LogParts* LogReplicator::GetLogPart() { return logs_; }
 
-void LogReplicator::SetOffset(uint64_t offset) { log_offset_.store(offset, std::memory_order_relaxed); }
+void LogReplicator::SetOffset(uint64_t offset) {
+    {
+        std::lock_guard<bthread::Mutex> lock(offset_mu_);
+        log_offset_.store(offset, std::memory_order_relaxed);
+    }
+    offset_cv_.notify_all();
+}
 
 uint64_t LogReplicator::GetOffset() { return log_offset_.load(std::memory_order_relaxed); }
 
+uint64_t LogReplicator::WaitOffset(uint64_t offset, uint64_t timeout_us) {
+    std::unique_lock<bthread::Mutex> lock(offset_mu_);
+    uint64_t deadline = ::baidu::common::timer::get_micros() + timeout_us;
+    while (log_offset_.load(std::memory_order_relaxed) < offset) {
+        uint64_t now = ::baidu::common::timer::get_micros();
+        if (now >= deadline) {
+            break;
+        }
+        offset_cv_.wait_for(lock, deadline - now);
+    }
+    return log_offset_.load(std::memory_order_relaxed);
+}
+
 void LogReplicator::SetSnapshotLogPartIndex(uint64_t offset) {
     snapshot_last_offset_.store(offset, std::memory_order_relaxed);
     ::openmldb::log::LogReader log_reader(logs_, log_path_, false);
@@ -289,7 +343,7 @@ uint64_t LogReplicator::GetLeaderTerm() { return term_.load(std::memory_order_re
 
 void LogReplicator::SetLeaderTerm(uint64_t term) { term_.store(term, std::memory_order_relaxed); }
 
-bool LogReplicator::ApplyEntry(const LogEntry& entry) {
+bool LogReplicator::ApplyEntry(const LogEntry& entry, bool flush) {
     std::lock_guard<std::mutex> lock(wmu_);
     uint64_t last_log_offset = GetOffset();
     if (wh_ == NULL || (wh_->GetSize() / (1024 * 1024)) > (uint32_t)FLAGS_binlog_single_file_max_size) {
@@ -306,12 +360,17 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
     std::string buffer;
     entry.SerializeToString(&buffer);
     ::openmldb::base::Slice slice(buffer.c_str(), buffer.size());
-    ::openmldb::log::Status status = wh_->Write(slice);
+    ::openmldb::log::Status status = wh_->Write(slice, flush);
     if (!status.ok()) {
         PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
         return false;
     }
-    log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    {
+        // under offset_mu_ so that a waiter can not miss the notify between its check and wait
+        std::lock_guard<bthread::Mutex> lock(offset_mu_);
+        log_offset_.store(entry.log_index(), std::memory_order_relaxed);
+    }
+    offset_cv_.notify_all();
     DEBUGLOG("sync log entry to offset %lu for %s", GetOffset(), path_.c_str());
     return true;
 }
@@ -434,29 +493,143 @@ bool LogReplicator::DelAllReplicateNode() {
 }
 
 bool LogReplicator::AppendEntry(LogEntry& entry) {
-    std::lock_guard<std::mutex> lock(wmu_);
-    if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
-        bool ok = RollWLogFile();
-        if (!ok) {
-            return false;
+    PendingEntry pending(&entry);
+    return Commit(&pending, 1);
+}
+
+bool LogReplicator::AppendEntries(std::vector<LogEntry>* entries) {
+    if (entries->empty()) {
+        return true;
+    }
+    std::vector<PendingEntry> pendings;
+    pendings.reserve(entries->size());
+    for (auto& entry : *entries) {
+        pendings.emplace_back(&entry);
+    }
+    return Commit(pendings.data(), pendings.size());
+}
+
+bool LogReplicator::Commit(PendingEntry* pendings, size_t cnt) {
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    PendingEntry* last = pendings + cnt - 1;
+    // the entries of this writer are an array, tell them from the ones of other writers by address
+    std::less<PendingEntry*> less;
+    auto is_own = [&](PendingEntry* pending) { return !less(pending, pendings) && !less(last, pending); };
+    uint32_t max_size = std::max(FLAGS_binlog_group_commit_max_size, 1u);
+    arriving_writers_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock<bthread::Mutex> lock(commit_mu_);
+    for (size_t i = 0; i < cnt; i++) {
+        commit_queue_.push_back(pendings + i);
+    }
+    if (arriving_writers_.fetch_sub(1, std::memory_order_relaxed) == 1 || commit_queue_.size() >= max_size) {
+        // the waiting leader has got all the writers in flight or a full group
+        if (!is_own(commit_queue_.front())) {
+            commit_cv_.notify_all();
         }
     }
-    uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
-    entry.set_log_index(1 + cur_offset);
+    // the entries are queued together and committed in order, so all of them are done with the last one
+    while (!last->done) {
+        if (!is_own(commit_queue_.front())) {
+            commit_cv_.wait(lock);
+            continue;
+        }
+        // lead the entries queued behind as a commit group
+        if (FLAGS_binlog_sync_on_commit && FLAGS_binlog_group_commit_wait_us > 0) {
+            // trade a bounded latency for a larger group to share the sync, there is nothing to wait for if no
+            // other writer is on the way
+            uint64_t deadline = ::baidu::common::timer::get_micros() + FLAGS_binlog_group_commit_wait_us;
+            while (commit_queue_.size() < max_size && arriving_writers_.load(std::memory_order_relaxed) > 0) {
+                uint64_t now = ::baidu::common::timer::get_micros();
+                if (now >= deadline) {
+                    break;
+                }
+                commit_cv_.wait_for(lock, deadline - now);
+            }
+        }
+        size_t group_size = std::min(commit_queue_.size(), static_cast<size_t>(max_size));
+        std::vector<PendingEntry*> group(commit_queue_.begin(), commit_queue_.begin() + group_size);
+        lock.unlock();
+        WriteGroup(group);
+        lock.lock();
+        for (size_t i = 0; i < group_size; i++) {
+            commit_queue_.front()->done = true;
+            commit_queue_.pop_front();
+        }
+        commit_cv_.notify_all();
+        g_commit_batch_size << static_cast<int64_t>(group_size);
+        g_commit_batch_max << static_cast<int64_t>(group_size);
+    }
+    lock.unlock();
+    g_commit_latency << ::baidu::common::timer::get_micros() - start_time;
+    bool ok = true;
+    for (size_t i = 0; i < cnt; i++) {
+        ok = ok && pendings[i].ok;
+    }
+    return ok;
+}
+
+void LogReplicator::WriteGroup(const std::vector<PendingEntry*>& group) {
+    std::lock_guard<std::mutex> lock(wmu_);
     std::string buffer;
-    entry.SerializeToString(&buffer);
-    ::openmldb::base::Slice slice(buffer);
-    ::openmldb::log::Status status = wh_->Write(slice);
+    std::vector<PendingEntry*> written;
+    written.reserve(group.size());
+    uint64_t offset = log_offset_.load(std::memory_order_relaxed);
+    // the size of the binlog before the group, a failed group is cut off from it
+    uint64_t start_size = wh_ == NULL ? 0 : wh_->GetSize();
+    for (auto* pending : group) {
+        if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
+            // the new file starts from log_offset_, publish the entries written to the old one first
+            FlushGroup(offset, start_size, &written);
+            offset = log_offset_.load(std::memory_order_relaxed);
+            bool ok = RollWLogFile();
+            if (!ok) {
+                continue;
+            }
+            start_size = 0;
+        }
+        pending->entry->set_log_index(offset + 1);
+        buffer.clear();
+        pending->entry->SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        // the group is flushed at once
+        ::openmldb::log::Status status = wh_->Write(slice, false);
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(),
+                  status.ToString().c_str());
+            continue;
+        }
+        offset++;
+        written.push_back(pending);
+    }
+    FlushGroup(offset, start_size, &written);
+}
+
+void LogReplicator::FlushGroup(uint64_t offset, uint64_t start_size, std::vector<PendingEntry*>* written) {
+    if (wh_ == NULL || written->empty()) {
+        return;
+    }
+    ::openmldb::log::Status status = FLAGS_binlog_sync_on_commit ? wh_->Sync() : wh_->Flush();
+    for (auto* pending : *written) {
+        pending->ok = status.ok();
+    }
+    written->clear();
     if (!status.ok()) {
-        PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
-        return false;
+        // the writers of the group get the failure, so the entries must not be replicated. The offset stays and
+        // the entries that may have reached the file are cut off, the next group is written in their place
+        PDLOG(WARNING, "fail to flush replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+        TruncateWLogFile(start_size);
+        return;
     }
-    log_offset_.fetch_add(1, std::memory_order_relaxed);
+    // the replicate nodes read up to log_offset_, so it moves only after the entries reach the file
+    log_offset_.store(offset, std::memory_order_relaxed);
     if (local_endpoints_.empty()) {  // if local replica are dead, leader direct
                                      // sync to remote replica
-        follower_offset_.store(cur_offset + 1, std::memory_order_relaxed);
+        follower_offset_.store(offset, std::memory_order_relaxed);
+    }
+    if (FLAGS_binlog_sync_max_inflight > 1) {
+        // wake up the pipelined replicate nodes instead of letting them poll
+        Notify();
     }
-    return true;
 }
 
 bool LogReplicator::RollWLogFile() {
@@ -474,11 +647,32 @@ bool LogReplicator::RollWLogFile() {
         PDLOG(WARNING, "fail to create file %s", full_path.c_str());
         return false;
     }
+    wh_path_ = full_path;
     uint64_t offset = log_offset_.load(std::memory_order_relaxed);
     logs_->Insert(binlog_index_.load(std::memory_order_relaxed), offset);
     binlog_index_.fetch_add(1, std::memory_order_relaxed);
     PDLOG(INFO, "roll write log for name %s and start offset %lld", name.c_str(), offset);
-    wh_ = new WriteHandle("off", name, fd);
+    // a flush writes out the pending compressed block, so the replicate nodes can read the entries at once
+    wh_ = new WriteHandle(FLAGS_binlog_compression, name, fd, 0, true);
+    return true;
+}
+
+bool LogReplicator::TruncateWLogFile(uint64_t size) {
+    // closing the handle writes out what is left in its buffer, so the file is cut after it
+    delete wh_;
+    wh_ = NULL;
+    if (truncate(wh_path_.c_str(), size) != 0) {
+        PDLOG(WARNING, "fail to truncate %s to %lu for %s, roll a new binlog", wh_path_.c_str(), size,
+              strerror(errno));
+        return false;
+    }
+    FILE* fd = fopen(wh_path_.c_str(), "ab+");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open file %s", wh_path_.c_str());
+        return false;
+    }
+    wh_ = new WriteHandle(FLAGS_binlog_compression, wh_path_, fd, size, true);
+    PDLOG(INFO, "truncate %s to %lu", wh_path_.c_str(), size);
     return true;
 }
 
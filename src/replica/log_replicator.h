@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -61,11 +62,19 @@ class LogReplicator {
     bool StartSyncing();
 
     // the slave node receives master log entries
-    bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
+    // the entry may stay in the write buffer if flush is false, a batch of
+    // entries is flushed with the last one
+    bool ApplyEntry(const ::openmldb::api::LogEntry& entry, bool flush = true);
 
-    // the master node append entry
+    // the master node append entry. concurrent entries are committed in groups,
+    // each group is written to the binlog with one flush
     bool AppendEntry(::openmldb::api::LogEntry& entry);  // NOLINT
 
+    // the master node append a batch of entries, they are committed in order
+    // without the entries of other writers in between. return false if any of
+    // them fails to write
+    bool AppendEntries(std::vector<::openmldb::api::LogEntry>* entries);
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -94,6 +103,9 @@ class LogReplicator {
 
     uint64_t GetOffset();
 
+    // wait at most timeout_us until the log offset reaches offset on a follower, return the log offset
+    uint64_t WaitOffset(uint64_t offset, uint64_t timeout_us);
+
     LogParts* GetLogPart();
 
     inline uint64_t GetLogOffset() { return log_offset_.load(std::memory_order_relaxed); }
@@ -111,8 +123,29 @@ class LogReplicator {
     const std::string& GetLogPath() {return log_path_;}
 
  private:
+    struct PendingEntry {
+        explicit PendingEntry(LogEntry* e) : entry(e), done(false), ok(false) {}
+        LogEntry* entry;
+        bool done;
+        bool ok;
+    };
+
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    // queue the entries and wait until they are committed, the writer whose
+    // entry is at the front of the queue leads the next commit group
+    bool Commit(PendingEntry* pendings, size_t cnt);
+
+    // write a commit group to binlog and set the result of each entry
+    void WriteGroup(const std::vector<PendingEntry*>& group);
+
+    // flush the written entries of a group and publish offset to the replicate nodes, the binlog is truncated
+    // to start_size if the flush fails
+    void FlushGroup(uint64_t offset, uint64_t start_size, std::vector<PendingEntry*>* written);
+
+    // cut the binlog written by wh_ to size and reopen it, wh_ is NULL if it fails
+    bool TruncateWLogFile(uint64_t size);
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -125,6 +158,7 @@ class LogReplicator {
     std::atomic<uint32_t> binlog_index_;
     LogParts* logs_;
     WriteHandle* wh_;
+    std::string wh_path_;
     ReplicatorRole role_;
     std::map<std::string, std::string> real_ep_map_;
     std::vector<std::shared_ptr<ReplicateNode> > nodes_;
@@ -139,6 +173,16 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+    // signalled when the log offset moves on a follower, see WaitOffset
+    bthread::Mutex offset_mu_;
+    bthread::ConditionVariable offset_cv_;
+
+    // entries waiting for commit, the front one leads the next commit group
+    bthread::Mutex commit_mu_;
+    bthread::ConditionVariable commit_cv_;
+    std::deque<PendingEntry*> commit_queue_;
+    // the writers in Commit that have not queued their entries yet, a commit group waits only for them
+    std::atomic<uint32_t> arriving_writers_;
 };
 
 }  // namespace replica
@@ -24,19 +24,34 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wapper.h"
 #include "base/status.h"
+#include "base/strings.h"
 #include "common/thread_pool.h"
 #include "common/timer.h"
+#include "log/log_reader.h"
 #include "proto/tablet.pb.h"
 #include "replica/replicate_node.h"
+#include "storage/binlog.h"
 #include "storage/mem_table.h"
 #include "storage/segment.h"
 #include "storage/ticket.h"
 #include "test/util.h"
 
+DECLARE_string(binlog_compression);
+DECLARE_bool(binlog_sync_on_commit);
+DECLARE_uint32(binlog_group_commit_max_size);
+DECLARE_uint32(binlog_group_commit_wait_us);
+DECLARE_uint32(binlog_sync_batch_bytes);
+DECLARE_uint32(binlog_sync_max_inflight);
+DECLARE_int32(binlog_sync_wait_time);
+
 using ::baidu::common::ThreadPool;
 using ::google::protobuf::Closure;
 using ::google::protobuf::RpcController;
@@ -83,6 +98,19 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
         uint64_t last_log_offset = replicator_.GetOffset();
+        if (request->pipelined() && request->pre_log_index() > last_log_offset) {
+            for (int32_t i = 0; i < FLAGS_binlog_sync_wait_time && request->pre_log_index() > last_log_offset; i++) {
+                bthread_usleep(1000);
+                last_log_offset = replicator_.GetOffset();
+            }
+            if (request->pre_log_index() > last_log_offset) {
+                response->set_code(::openmldb::base::ReturnCode::kAppendEntriesOutOfOrder);
+                response->set_msg("append entries out of order");
+                response->set_log_offset(last_log_offset);
+                done->Run();
+                return;
+            }
+        }
         for (int32_t i = 0; i < request->entries_size(); i++) {
             if (request->entries(i).log_index() <= last_log_offset) {
                 continue;
@@ -147,6 +175,217 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, GroupCommit) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    uint32_t thread_num = 8;
+    uint64_t entry_num = 1000;
+    for (bool sync : {false, true}) {
+        FLAGS_binlog_sync_on_commit = sync;
+        FLAGS_binlog_group_commit_wait_us = sync ? 100 : 0;
+        uint64_t start_offset = replicator.GetOffset();
+        std::vector<std::vector<uint64_t>> indexes(thread_num);
+        std::vector<std::thread> threads;
+        for (uint32_t i = 0; i < thread_num; i++) {
+            threads.emplace_back([&, i] {
+                for (uint64_t j = 0; j < entry_num; j++) {
+                    ::openmldb::api::LogEntry entry;
+                    entry.set_term(1);
+                    entry.set_pk("test" + std::to_string(i));
+                    entry.set_value("value" + std::to_string(j));
+                    entry.set_ts(j);
+                    if (replicator.AppendEntry(entry)) {
+                        indexes[i].push_back(entry.log_index());
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(start_offset + thread_num * entry_num, replicator.GetOffset());
+        std::vector<uint64_t> all;
+        for (const auto& index : indexes) {
+            ASSERT_EQ(entry_num, index.size());
+            ASSERT_TRUE(std::is_sorted(index.begin(), index.end()));
+            all.insert(all.end(), index.begin(), index.end());
+        }
+        std::sort(all.begin(), all.end());
+        for (uint64_t i = 0; i < all.size(); i++) {
+            ASSERT_EQ(start_offset + i + 1, all[i]);
+        }
+    }
+    FLAGS_binlog_sync_on_commit = false;
+    FLAGS_binlog_group_commit_wait_us = 0;
+
+    // every entry reaches the binlog in order of log index
+    std::string full_path = folder + "/binlog/" + ::openmldb::base::FormatToString(0, 8) + ".log";
+    FILE* fd = fopen(full_path.c_str(), "rb");
+    ASSERT_TRUE(fd != NULL);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(full_path, fd);
+    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, false);
+    std::string buffer;
+    uint64_t expect_index = 1;
+    while (true) {
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (!status.ok()) {
+            break;
+        }
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(expect_index, entry.log_index());
+        expect_index++;
+    }
+    ASSERT_EQ(2 * thread_num * entry_num + 1, expect_index);
+    delete seq_file;
+}
+
+TEST_F(LogReplicatorTest, RecoverCompressedBinlog) {
+    std::map<std::string, std::string> map;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    uint64_t entry_num = 100;
+    uint32_t restart_num = 3;
+    for (const std::string& compression : {"snappy", "zlib"}) {
+        FLAGS_binlog_compression = compression;
+        std::string folder = "/tmp/" + GenRand() + "/";
+        // every restart recovers the binlogs written before and appends to a new one
+        for (uint32_t i = 0; i <= restart_num; i++) {
+            LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+            ASSERT_TRUE(replicator.Init());
+            ASSERT_EQ(i, replicator.GetLogPart()->GetSize());
+            std::shared_ptr<MemTable> table =
+                std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+            table->Init();
+            ::openmldb::storage::Binlog binlog(replicator.GetLogPart(), folder + "/binlog/");
+            uint64_t latest_offset = 0;
+            ASSERT_TRUE(binlog.RecoverFromBinlog(table, 0, latest_offset));
+            ASSERT_EQ(i * entry_num, latest_offset);
+            ASSERT_EQ(i * entry_num, table->GetRecordCnt());
+            Ticket ticket;
+            TableIterator* it = table->NewIterator("test_pk", ticket);
+            it->SeekToFirst();
+            for (uint64_t ts = i * entry_num; ts > 0; ts--) {
+                ASSERT_TRUE(it->Valid());
+                ASSERT_EQ(ts, it->GetKey());
+                ASSERT_EQ("value" + std::to_string(ts),
+                          ::openmldb::test::DecodeV(it->GetValue().ToString()));
+                it->Next();
+            }
+            ASSERT_FALSE(it->Valid());
+            delete it;
+            if (i == restart_num) {
+                break;
+            }
+            replicator.SetOffset(latest_offset);
+            for (uint64_t j = 1; j <= entry_num; j++) {
+                uint64_t ts = latest_offset + j;
+                ::openmldb::api::LogEntry entry;
+                ::openmldb::test::AddDimension(0, "test_pk", &entry);
+                entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(ts)));
+                entry.set_ts(ts);
+                ASSERT_TRUE(replicator.AppendEntry(entry));
+                ASSERT_EQ(ts, entry.log_index());
+            }
+            ASSERT_EQ((i + 1) * entry_num, replicator.GetOffset());
+        }
+    }
+    FLAGS_binlog_compression = "off";
+}
+
+TEST_F(LogReplicatorTest, AppendEntries) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    FLAGS_binlog_group_commit_max_size = 16;
+    uint32_t thread_num = 4;
+    uint64_t batch_num = 50;
+    uint64_t batch_size = 40;
+    std::vector<std::thread> threads;
+    std::atomic<bool> ok(true);
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([&, i] {
+            for (uint64_t j = 0; j < batch_num; j++) {
+                std::vector<::openmldb::api::LogEntry> entries(batch_size);
+                for (uint64_t k = 0; k < batch_size; k++) {
+                    entries[k].set_term(1);
+                    entries[k].set_pk("test" + std::to_string(i));
+                    entries[k].set_ts(k);
+                }
+                if (!replicator.AppendEntries(&entries)) {
+                    ok = false;
+                }
+                // a batch is not interleaved with the entries of other writers
+                for (uint64_t k = 1; k < batch_size; k++) {
+                    if (entries[k].log_index() != entries[0].log_index() + k) {
+                        ok = false;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    FLAGS_binlog_group_commit_max_size = 64;
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(thread_num * batch_num * batch_size, replicator.GetOffset());
+    std::vector<::openmldb::api::LogEntry> empty;
+    ASSERT_TRUE(replicator.AppendEntries(&empty));
+}
+
+TEST_F(LogReplicatorTest, LeaderAndFollowerPipelined) {
+    FLAGS_binlog_sync_max_inflight = 4;
+    FLAGS_binlog_sync_batch_bytes = 1024;
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string follower_addr = "127.0.0.1:18530";
+    MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, "/tmp/" + GenRand() + "/", g_endpoints, table);
+    ASSERT_TRUE(follower->Init());
+    ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+    ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+
+    LogReplicator leader(1, 1, "/tmp/" + GenRand() + "/", g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair(follower_addr, ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    uint64_t entry_num = 5000;
+    for (uint64_t i = 0; i < entry_num; i++) {
+        ::openmldb::api::LogEntry entry;
+        ::openmldb::test::AddDimension(0, "test_pk", &entry);
+        entry.set_value(::openmldb::test::EncodeKV("test_pk", "value" + std::to_string(i)));
+        entry.set_ts(i + 1);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    leader.Notify();
+    for (int i = 0; i < 100 && table->GetRecordCnt() < entry_num; i++) {
+        sleep(1);
+    }
+    ASSERT_EQ(entry_num, table->GetRecordCnt());
+    Ticket ticket;
+    TableIterator* it = table->NewIterator("test_pk", ticket);
+    it->SeekToFirst();
+    for (uint64_t ts = entry_num; ts > 0; ts--) {
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(ts, it->GetKey());
+        it->Next();
+    }
+    delete it;
+    leader.DelAllReplicateNode();
+    FLAGS_binlog_sync_max_inflight = 1;
+    FLAGS_binlog_sync_batch_bytes = 0;
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     brpc::ServerOptions options;
     brpc::Server server0;
@@ -22,8 +22,11 @@
 
 #include "base/glog_wapper.h"
 #include "base/strings.h"
+#include "brpc/controller.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_uint32(binlog_sync_batch_bytes);
+DECLARE_uint32(binlog_sync_max_inflight);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -42,10 +45,37 @@ static void* RunSyncTask(void* args) {
     }
     ::openmldb::replica::ReplicateNode* rn = static_cast<::openmldb::replica::ReplicateNode*>(args);
     rn->MatchLogOffset();
-    rn->SyncData();
+    if (FLAGS_binlog_sync_max_inflight > 1) {
+        rn->SyncDataPipelined();
+    } else {
+        rn->SyncData();
+    }
     return NULL;
 }
 
+// an append entries request sent asynchronously, it is done when the response arrives
+struct ReplicateNode::InflightRequest : public ::google::protobuf::Closure {
+    InflightRequest(bthread::Mutex* mu, bthread::ConditionVariable* cv)
+        : mu(mu), cv(cv), cntl(), request(), response(), end_offset(0), done(false) {}
+
+    void Run() override {
+        std::lock_guard<bthread::Mutex> lock(*mu);
+        done = true;
+        cv->notify_all();
+    }
+
+    inline bool IsOk() const { return !cntl.Failed() && response.code() == 0; }
+
+    bthread::Mutex* mu;
+    bthread::ConditionVariable* cv;
+    brpc::Controller cntl;
+    ::openmldb::api::AppendEntriesRequest request;
+    ::openmldb::api::AppendEntriesResponse response;
+    // the log index of the last entry in request
+    uint64_t end_offset;
+    bool done;
+};
+
 ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid,
                              uint32_t pid, std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset,
                              bthread::Mutex* mu, bthread::ConditionVariable* cv, bool rep_follower,
@@ -66,7 +96,9 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       cv_(cv),
       go_back_cnt_(0),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      inflight_(),
+      lag_(GetLagFn, this) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -78,6 +110,7 @@ int ReplicateNode::Init() {
         PDLOG(WARNING, "fail to open rpc client with errno %d", ok);
     }
     PDLOG(INFO, "open rpc client for endpoint %s done", endpoint_.c_str());
+    lag_.expose("binlog_replicate_lag_" + std::to_string(tid_) + "_" + std::to_string(pid_) + "_" + endpoint_);
     return ok;
 }
 
@@ -117,7 +150,8 @@ void ReplicateNode::SyncData() {
         {
             std::unique_lock<bthread::Mutex> lock(*mu_);
             // no new data append and wait
-            while (last_sync_offset_ >= leader_log_offset_->load(std::memory_order_relaxed)) {
+            while (last_sync_offset_.load(std::memory_order_relaxed) >=
+                   leader_log_offset_->load(std::memory_order_relaxed)) {
                 cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
                 if (!is_running_.load(std::memory_order_relaxed)) {
                     PDLOG(INFO,
@@ -141,15 +175,118 @@ void ReplicateNode::SyncData() {
     PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
 }
 
+void ReplicateNode::SyncDataPipelined() {
+    uint64_t sent_offset = last_sync_offset_.load(std::memory_order_relaxed);
+    bool broken = false;
+    std::unique_lock<bthread::Mutex> lock(*mu_);
+    while (is_running_.load(std::memory_order_relaxed)) {
+        // handle the responses in the order of requests
+        while (!inflight_.empty() && inflight_.front()->done) {
+            InflightRequest* request = inflight_.front();
+            inflight_.pop_front();
+            if (!broken && request->IsOk()) {
+                OnSyncDone(request->end_offset);
+                delete request;
+                continue;
+            }
+            if (!broken) {
+                PDLOG(WARNING, "fail to sync log to node %s. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
+                broken = true;
+            }
+            // the requests from the failed one are resent one by one
+            cache_.push_back(request->request);
+            delete request;
+        }
+        if (broken) {
+            if (inflight_.empty()) {
+                broken = false;
+            } else {
+                cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
+            }
+            continue;
+        }
+        uint64_t log_offset = rep_node_.load(std::memory_order_relaxed)
+                                  ? follower_offset_->load(std::memory_order_relaxed)
+                                  : leader_log_offset_->load(std::memory_order_relaxed);
+        if (!cache_.empty()) {
+            lock.unlock();
+            int ret = SyncData(log_offset);
+            lock.lock();
+            if (ret == 1) {
+                // woken up by Notify
+                cv_->wait_for(lock, FLAGS_binlog_coffee_time * 1000);
+            }
+            continue;
+        }
+        if (inflight_.size() >= FLAGS_binlog_sync_max_inflight || sent_offset >= log_offset) {
+            cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
+            continue;
+        }
+        lock.unlock();
+        auto* request = new InflightRequest(mu_, cv_);
+        request->request.set_tid(tid_);
+        request->request.set_pid(pid_);
+        request->request.set_pre_log_index(sent_offset);
+        request->request.set_pipelined(true);
+        if (!FLAGS_zk_cluster.empty()) {
+            request->request.set_term(term_->load(std::memory_order_relaxed));
+        }
+        uint64_t end_offset = sent_offset;
+        bool need_wait = ReadEntries(log_offset, &end_offset, &request->request);
+        if (request->request.entries_size() == 0) {
+            delete request;
+            lock.lock();
+            if (need_wait) {
+                cv_->wait_for(lock, FLAGS_binlog_coffee_time * 1000);
+            }
+            continue;
+        }
+        request->end_offset = end_offset;
+        sent_offset = end_offset;
+        request->cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+        // a retried request could overtake the later ones, resend it through cache instead
+        request->cntl.set_max_retry(0);
+        lock.lock();
+        inflight_.push_back(request);
+        lock.unlock();
+        if (!rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request->cntl,
+                                     &request->request, &request->response, request)) {
+            request->cntl.SetFailed("fail to send request");
+            request->Run();
+        }
+        lock.lock();
+    }
+    // the requests reference to mu_ and cv_, wait them before exit
+    while (!inflight_.empty()) {
+        if (inflight_.front()->done) {
+            delete inflight_.front();
+            inflight_.pop_front();
+        } else {
+            cv_->wait_for(lock, FLAGS_binlog_sync_wait_time * 1000);
+        }
+    }
+    PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
+}
+
 int ReplicateNode::GetLogIndex() { return log_reader_.GetLogIndex(); }
 
+uint64_t ReplicateNode::GetLag() {
+    uint64_t leader_offset = leader_log_offset_->load(std::memory_order_relaxed);
+    uint64_t sync_offset = last_sync_offset_.load(std::memory_order_relaxed);
+    return leader_offset > sync_offset ? leader_offset - sync_offset : 0;
+}
+
+uint64_t ReplicateNode::GetLagFn(void* arg) { return static_cast<ReplicateNode*>(arg)->GetLag(); }
+
 bool ReplicateNode::IsLogMatched() { return log_matched_; }
 
 std::string ReplicateNode::GetEndPoint() { return endpoint_; }
 
-uint64_t ReplicateNode::GetLastSyncOffset() { return last_sync_offset_; }
+uint64_t ReplicateNode::GetLastSyncOffset() { return last_sync_offset_.load(std::memory_order_relaxed); }
 
-void ReplicateNode::SetLastSyncOffset(uint64_t offset) { last_sync_offset_ = offset; }
+void ReplicateNode::SetLastSyncOffset(uint64_t offset) {
+    last_sync_offset_.store(offset, std::memory_order_relaxed);
+}
 
 int ReplicateNode::MatchLogOffsetFromNode() {
     ::openmldb::api::AppendEntriesRequest request;
@@ -161,11 +298,11 @@ int ReplicateNode::MatchLogOffsetFromNode() {
     bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
                                        FLAGS_request_timeout_ms, FLAGS_request_max_retry);
     if (ret && response.code() == 0) {
-        last_sync_offset_ = response.log_offset();
+        last_sync_offset_.store(response.log_offset(), std::memory_order_relaxed);
         log_matched_ = true;
-        log_reader_.SetOffset(last_sync_offset_);
-        PDLOG(INFO, "match node %s log offset %lu for table tid %u pid %u", endpoint_.c_str(), last_sync_offset_, tid_,
-              pid_);
+        log_reader_.SetOffset(response.log_offset());
+        PDLOG(INFO, "match node %s log offset %lu for table tid %u pid %u", endpoint_.c_str(), response.log_offset(),
+              tid_, pid_);
         return 0;
     }
     PDLOG(WARNING, "match node %s log offset failed. tid %u pid %u", endpoint_.c_str(), tid_, pid_);
@@ -173,28 +310,29 @@ int ReplicateNode::MatchLogOffsetFromNode() {
 }
 
 int ReplicateNode::SyncData(uint64_t log_offset) {
-    DEBUGLOG("node[%s] offset[%lu] log offset[%lu]", endpoint_.c_str(), last_sync_offset_, log_offset);
-    if (log_offset <= last_sync_offset_) {
-        PDLOG(WARNING, "log offset [%lu] le last sync offset [%lu], do nothing", log_offset, last_sync_offset_);
+    uint64_t last_sync_offset = last_sync_offset_.load(std::memory_order_relaxed);
+    DEBUGLOG("node[%s] offset[%lu] log offset[%lu]", endpoint_.c_str(), last_sync_offset, log_offset);
+    if (log_offset <= last_sync_offset) {
+        PDLOG(WARNING, "log offset [%lu] le last sync offset [%lu], do nothing", log_offset, last_sync_offset);
         return 1;
     }
     ::openmldb::api::AppendEntriesRequest request;
     ::openmldb::api::AppendEntriesResponse response;
-    uint64_t sync_log_offset = last_sync_offset_;
+    uint64_t sync_log_offset = last_sync_offset;
     bool request_from_cache = false;
     bool need_wait = false;
     if (cache_.size() > 0) {
         request_from_cache = true;
         request = cache_[0];
         if (request.entries_size() <= 0) {
-            cache_.clear();
+            cache_.erase(cache_.begin());
             PDLOG(WARNING, "empty append entry request from node %s cache", endpoint_.c_str());
             return -1;
         }
         const ::openmldb::api::LogEntry& entry = request.entries(request.entries_size() - 1);
-        if (entry.log_index() <= last_sync_offset_) {
+        if (entry.log_index() <= last_sync_offset) {
             DEBUGLOG("duplicate log index from node %s cache", endpoint_.c_str());
-            cache_.clear();
+            cache_.erase(cache_.begin());
             return -1;
         }
         PDLOG(INFO, "use cached request to send last index %lu. tid %u pid %u", entry.log_index(), tid_, pid_);
@@ -202,85 +340,20 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     } else {
         request.set_tid(tid_);
         request.set_pid(pid_);
-        request.set_pre_log_index(last_sync_offset_);
+        request.set_pre_log_index(last_sync_offset);
         if (!FLAGS_zk_cluster.empty()) {
             request.set_term(term_->load(std::memory_order_relaxed));
         }
-        uint32_t batchSize = log_offset - last_sync_offset_;
-        batchSize = std::min(batchSize, (uint32_t)FLAGS_binlog_sync_batch_size);
-        for (uint64_t i = 0; i < batchSize;) {
-            std::string buffer;
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
-            if (status.ok()) {
-                ::openmldb::api::LogEntry* entry = request.add_entries();
-                if (!entry->ParseFromString(record.ToString())) {
-                    PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
-                          ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_,
-                          pid_);
-                    request.mutable_entries()->RemoveLast();
-                    break;
-                }
-                DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
-                if (entry->log_index() <= sync_log_offset) {
-                    DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
-                    request.mutable_entries()->RemoveLast();
-                    continue;
-                }
-                // the log index should incr by 1
-                if ((sync_log_offset + 1) != entry->log_index()) {
-                    PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
-                          entry->log_index(), tid_, pid_);
-                    request.mutable_entries()->RemoveLast();
-                    if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                        log_reader_.GoBackToStart();
-                        go_back_cnt_ = 0;
-                        PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                    } else {
-                        log_reader_.GoBackToLastBlock();
-                        go_back_cnt_++;
-                    }
-                    need_wait = true;
-                    break;
-                }
-                sync_log_offset = entry->log_index();
-            } else if (status.IsWaitRecord()) {
-                DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
-                need_wait = true;
-                break;
-            } else if (status.IsInvalidRecord()) {
-                DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                    log_reader_.GoBackToStart();
-                    go_back_cnt_ = 0;
-                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                } else {
-                    log_reader_.GoBackToLastBlock();
-                    go_back_cnt_++;
-                }
-                break;
-            } else {
-                PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
-                need_wait = true;
-                break;
-            }
-            i++;
-            go_back_cnt_ = 0;
-        }
+        need_wait = ReadEntries(log_offset, &sync_log_offset, &request);
     }
     if (request.entries_size() > 0) {
         bool ret = rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &request, &response,
                                            FLAGS_request_timeout_ms, FLAGS_request_max_retry);
         if (ret && response.code() == 0) {
             DEBUGLOG("sync log to node[%s] to offset %lld", endpoint_.c_str(), sync_log_offset);
-            last_sync_offset_ = sync_log_offset;
-            if (!rep_node_.load(std::memory_order_relaxed) &&
-                (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
-                follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
-            }
+            OnSyncDone(sync_log_offset);
             if (request_from_cache) {
-                cache_.clear();
+                cache_.erase(cache_.begin());
             }
         } else {
             if (!request_from_cache) {
@@ -296,6 +369,89 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     return 0;
 }
 
+void ReplicateNode::OnSyncDone(uint64_t sync_log_offset) {
+    last_sync_offset_.store(sync_log_offset, std::memory_order_relaxed);
+    if (!rep_node_.load(std::memory_order_relaxed) &&
+        (sync_log_offset > follower_offset_->load(std::memory_order_relaxed))) {
+        follower_offset_->store(sync_log_offset, std::memory_order_relaxed);
+    }
+}
+
+bool ReplicateNode::ReadEntries(uint64_t log_offset, uint64_t* sync_log_offset,
+                                ::openmldb::api::AppendEntriesRequest* request) {
+    uint32_t batch_size = log_offset - *sync_log_offset;
+    if (FLAGS_binlog_sync_batch_bytes == 0) {
+        batch_size = std::min(batch_size, (uint32_t)FLAGS_binlog_sync_batch_size);
+    }
+    uint64_t batch_bytes = 0;
+    bool need_wait = false;
+    for (uint64_t i = 0; i < batch_size;) {
+        // the batch is sized by bytes if binlog_sync_batch_bytes is set
+        if (FLAGS_binlog_sync_batch_bytes > 0 && batch_bytes >= FLAGS_binlog_sync_batch_bytes) {
+            break;
+        }
+        std::string buffer;
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            ::openmldb::api::LogEntry* entry = request->add_entries();
+            if (!entry->ParseFromString(record.ToString())) {
+                PDLOG(WARNING, "bad protobuf format %s size %ld. tid %u pid %u",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size(), tid_, pid_);
+                request->mutable_entries()->RemoveLast();
+                break;
+            }
+            DEBUGLOG("entry val %s log index %lld", entry->value().c_str(), entry->log_index());
+            if (entry->log_index() <= *sync_log_offset) {
+                DEBUGLOG("skip duplicate log offset %lld", entry->log_index());
+                request->mutable_entries()->RemoveLast();
+                continue;
+            }
+            // the log index should incr by 1
+            if ((*sync_log_offset + 1) != entry->log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", *sync_log_offset + 1,
+                      entry->log_index(), tid_, pid_);
+                request->mutable_entries()->RemoveLast();
+                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                    log_reader_.GoBackToStart();
+                    go_back_cnt_ = 0;
+                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+                } else {
+                    log_reader_.GoBackToLastBlock();
+                    go_back_cnt_++;
+                }
+                need_wait = true;
+                break;
+            }
+            *sync_log_offset = entry->log_index();
+            batch_bytes += record.size();
+        } else if (status.IsWaitRecord()) {
+            DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
+            need_wait = true;
+            break;
+        } else if (status.IsInvalidRecord()) {
+            DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            need_wait = true;
+            if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+                log_reader_.GoBackToStart();
+                go_back_cnt_ = 0;
+                PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+            } else {
+                log_reader_.GoBackToLastBlock();
+                go_back_cnt_++;
+            }
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            need_wait = true;
+            break;
+        }
+        i++;
+        go_back_cnt_ = 0;
+    }
+    return need_wait;
+}
+
 void ReplicateNode::Stop() {
     is_running_.store(false, std::memory_order_relaxed);
     if (worker_ == 0) {
@@ -18,12 +18,14 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <deque>
 #include <string>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
+#include "bvar/bvar.h"
 #include "log/log_reader.h"
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
@@ -53,6 +55,9 @@ class ReplicateNode {
 
     int SyncData(uint64_t log_offset);
 
+    // keep up to binlog_sync_max_inflight requests in flight to the follower
+    void SyncDataPipelined();
+
     void SetLastSyncOffset(uint64_t offset);
 
     bool IsLogMatched();
@@ -63,6 +68,9 @@ class ReplicateNode {
 
     int GetLogIndex();
 
+    // the count of entries the follower is behind the leader
+    uint64_t GetLag();
+
     void Stop();
 
     ReplicateNode(const ReplicateNode&) = delete;
@@ -70,13 +78,24 @@ class ReplicateNode {
     ReplicateNode& operator=(const ReplicateNode&) = delete;
 
  private:
+    struct InflightRequest;
+
     int MatchLogOffsetFromNode();
 
+    // read the entries after *sync_log_offset into request, returns true if the
+    // reader has to wait for more data
+    bool ReadEntries(uint64_t log_offset, uint64_t* sync_log_offset, ::openmldb::api::AppendEntriesRequest* request);
+
+    void OnSyncDone(uint64_t sync_log_offset);
+
+    static uint64_t GetLagFn(void* arg);
+
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
     std::string endpoint_;
-    uint64_t last_sync_offset_;
+    // written by the sync thread, read by GetLag from the bvar sampler
+    std::atomic<uint64_t> last_sync_offset_;
     bool log_matched_;
     uint32_t tid_;
     uint32_t pid_;
@@ -90,6 +109,9 @@ class ReplicateNode {
     uint32_t go_back_cnt_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    // the requests sent in pipelined mode in order, guarded by mu_
+    std::deque<InflightRequest*> inflight_;
+    bvar::PassiveStatus<uint64_t> lag_;
 };
 
 }  // namespace replica
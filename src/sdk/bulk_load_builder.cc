@@ -0,0 +1,282 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sdk/bulk_load_builder.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/hash.h"
+#include "glog/logging.h"
+
+namespace openmldb {
+namespace sdk {
+
+// the same seed as MemTable uses to choose the segment
+static constexpr uint32_t SEG_SEED = 0xe17a1465;
+// the reserved size of the tags and lengths of a repeated field
+static constexpr uint32_t REPEATED_RESERVED_SIZE = 8;
+// a time entry is two varints with their tags
+static constexpr uint32_t TIME_ENTRY_SIZE = 20;
+
+static ::openmldb::codec::Schema BuildSchema(const ::openmldb::nameserver::TableInfo& table_info) {
+    ::openmldb::codec::Schema schema;
+    schema.CopyFrom(table_info.column_desc());
+    for (const auto& column : table_info.added_column_desc()) {
+        *schema.Add() = column;
+    }
+    return schema;
+}
+
+BulkLoadBuilder::BulkLoadBuilder(uint32_t tid, uint32_t pid, const ::openmldb::nameserver::TableInfo& table_info,
+                                 const ::openmldb::api::BulkLoadInfoResponse& info, uint32_t rpc_size_limit,
+                                 Sender sender)
+    : tid_(tid),
+      pid_(pid),
+      info_(info),
+      rpc_size_limit_(rpc_size_limit),
+      sender_(std::move(sender)),
+      schema_(BuildSchema(table_info)),
+      row_view_(schema_),
+      data_request_(),
+      data_(),
+      data_size_(0),
+      data_offset_(0),
+      block_id_(0),
+      part_id_(0),
+      eof_sent_(false),
+      segments_() {
+    for (const auto& inner_segments : info_.inner_segments()) {
+        segments_.emplace_back(inner_segments.segment_size());
+    }
+}
+
+bool BulkLoadBuilder::AddRow(const std::string& row, const std::vector<std::pair<std::string, uint32_t>>& dimensions,
+                             uint64_t time, std::string* msg) {
+    if (dimensions.empty()) {
+        *msg = "no dimension";
+        return false;
+    }
+    const auto* data = reinterpret_cast<const int8_t*>(row.data());
+    // the keys of the inner indexes and the ts of the ts columns, as MemTable::Put does
+    std::map<int32_t, std::string> inner_index_key_map;
+    for (const auto& dim : dimensions) {
+        if (static_cast<int>(dim.second) >= info_.inner_index_pos_size()) {
+            *msg = "invalid index " + std::to_string(dim.second);
+            return false;
+        }
+        inner_index_key_map.emplace(info_.inner_index_pos(dim.second), dim.first);
+    }
+    std::map<uint32_t, uint64_t> ts_map;
+    uint32_t ref_cnt = 0;
+    for (const auto& kv : inner_index_key_map) {
+        if (kv.first < 0 || kv.first >= info_.inner_index_size() ||
+            kv.first >= static_cast<int>(segments_.size())) {
+            *msg = "invalid inner index pos " + std::to_string(kv.first);
+            return false;
+        }
+        for (const auto& index_def : info_.inner_index(kv.first).index_def()) {
+            // -1 is the auto generated ts column
+            uint32_t ts_col = static_cast<uint32_t>(index_def.ts_idx());
+            int64_t ts = time;
+            if (index_def.ts_idx() >= 0) {
+                if (index_def.ts_idx() >= schema_.size() ||
+                    row_view_.GetInteger(data, ts_col, schema_.Get(index_def.ts_idx()).data_type(), &ts) != 0) {
+                    *msg = "get ts failed";
+                    return false;
+                }
+            }
+            ts_map.emplace(ts_col, ts);
+            if (index_def.is_ready()) {
+                ref_cnt++;
+            }
+        }
+    }
+    if (ts_map.empty()) {
+        *msg = "no ts";
+        return false;
+    }
+    uint32_t block_id = block_id_++;
+    for (const auto& kv : inner_index_key_map) {
+        const auto& index_defs = info_.inner_index(kv.first).index_def();
+        if (std::none_of(index_defs.begin(), index_defs.end(), [](const auto& def) { return def.is_ready(); })) {
+            continue;
+        }
+        uint32_t seg_idx = 0;
+        if (info_.seg_cnt() > 1) {
+            seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEG_SEED) % info_.seg_cnt();
+        }
+        const auto& seg_info = info_.inner_segments(kv.first).segment(seg_idx);
+        auto& entries = segments_[kv.first][seg_idx][kv.second];
+        if (entries.empty()) {
+            entries.resize(std::max(seg_info.ts_cnt(), 1u));
+        }
+        if (seg_info.ts_cnt() <= 1) {
+            // Segment::Put takes the ts of the first ts column of the segment
+            auto iter = ts_map.begin();
+            if (seg_info.ts_idx_map_size() > 0) {
+                iter = ts_map.find(seg_info.ts_idx_map(0).key());
+            }
+            if (iter != ts_map.end()) {
+                entries[0].emplace_back(iter->second, block_id);
+            }
+            continue;
+        }
+        for (const auto& ts_idx : seg_info.ts_idx_map()) {
+            auto iter = ts_map.find(ts_idx.key());
+            if (iter != ts_map.end() && ts_idx.value() < entries.size()) {
+                entries[ts_idx.value()].emplace_back(iter->second, block_id);
+            }
+        }
+    }
+
+    auto* block_info = data_request_.add_block_info();
+    block_info->set_ref_cnt(ref_cnt);
+    block_info->set_offset(data_offset_ + data_.size());
+    block_info->set_length(row.size());
+    auto* binlog_info = data_request_.add_binlog_info();
+    for (const auto& dim : dimensions) {
+        auto* d = binlog_info->add_dimensions();
+        d->set_key(dim.first);
+        d->set_idx(dim.second);
+    }
+    binlog_info->set_time(time);
+    binlog_info->set_block_id(block_id);
+    data_.append(row);
+    data_size_ += row.size() + block_info->ByteSizeLong() + binlog_info->ByteSizeLong() + 2 * REPEATED_RESERVED_SIZE;
+    if (data_size_ >= rpc_size_limit_) {
+        return SendData(msg);
+    }
+    return true;
+}
+
+bool BulkLoadBuilder::Finish(std::string* msg) {
+    if (block_id_ == 0) {
+        // nothing is sent, the tablet has no receiver to clean up
+        return true;
+    }
+    if (data_request_.block_info_size() > 0 && !SendData(msg)) {
+        return false;
+    }
+    return SendEof(msg);
+}
+
+bool BulkLoadBuilder::Abort(std::string* msg) {
+    if (block_id_ == 0 || eof_sent_) {
+        return true;
+    }
+    return SendEof(msg);
+}
+
+bool BulkLoadBuilder::SendEof(std::string* msg) {
+    ::openmldb::api::BulkLoadRequest request;
+    request.set_eof(true);
+    if (!SendPart(&request, "", msg)) {
+        return false;
+    }
+    eof_sent_ = true;
+    return true;
+}
+
+bool BulkLoadBuilder::SendData(std::string* msg) {
+    bool ok = SendPart(&data_request_, data_, msg);
+    data_offset_ += data_.size();
+    data_request_.Clear();
+    data_.clear();
+    data_size_ = 0;
+    return ok && SendIndex(msg);
+}
+
+bool BulkLoadBuilder::SendIndex(std::string* msg) {
+    ::openmldb::api::BulkLoadRequest request;
+    uint64_t size = 0;
+    for (size_t inner_idx = 0; inner_idx < segments_.size(); inner_idx++) {
+        // the messages are created again after a part is sent
+        ::openmldb::api::BulkLoadIndex* index = nullptr;
+        for (size_t seg_idx = 0; seg_idx < segments_[inner_idx].size(); seg_idx++) {
+            ::openmldb::api::Segment* segment = nullptr;
+            for (const auto& kv : segments_[inner_idx][seg_idx]) {
+                ::openmldb::api::Segment::KeyEntries* key_entries = nullptr;
+                for (size_t entry_id = 0; entry_id < kv.second.size(); entry_id++) {
+                    ::openmldb::api::Segment::KeyEntries::KeyEntry* key_entry = nullptr;
+                    for (const auto& time_entry : kv.second[entry_id]) {
+                        if (size >= rpc_size_limit_) {
+                            if (!SendPart(&request, "", msg)) {
+                                return false;
+                            }
+                            request.Clear();
+                            size = 0;
+                            index = nullptr;
+                            segment = nullptr;
+                            key_entries = nullptr;
+                            key_entry = nullptr;
+                        }
+                        if (index == nullptr) {
+                            index = request.add_index_region();
+                            index->set_inner_index_id(inner_idx);
+                            size += REPEATED_RESERVED_SIZE;
+                        }
+                        if (segment == nullptr) {
+                            segment = index->add_segment();
+                            segment->set_id(seg_idx);
+                            size += REPEATED_RESERVED_SIZE;
+                        }
+                        if (key_entries == nullptr) {
+                            key_entries = segment->add_key_entries();
+                            key_entries->set_key(kv.first);
+                            size += kv.first.size() + REPEATED_RESERVED_SIZE;
+                        }
+                        if (key_entry == nullptr) {
+                            key_entry = key_entries->add_key_entry();
+                            key_entry->set_key_entry_id(entry_id);
+                            size += REPEATED_RESERVED_SIZE;
+                        }
+                        auto* entry = key_entry->add_time_entry();
+                        entry->set_time(time_entry.first);
+                        entry->set_block_id(time_entry.second);
+                        size += TIME_ENTRY_SIZE;
+                    }
+                }
+            }
+        }
+    }
+    for (auto& inner_segments : segments_) {
+        for (auto& segment : inner_segments) {
+            segment.clear();
+        }
+    }
+    if (request.index_region_size() == 0) {
+        return true;
+    }
+    return SendPart(&request, "", msg);
+}
+
+bool BulkLoadBuilder::SendPart(::openmldb::api::BulkLoadRequest* request, const std::string& data, std::string* msg) {
+    request->set_tid(tid_);
+    request->set_pid(pid_);
+    request->set_part_id(part_id_);
+    DLOG(INFO) << "send bulk load part " << part_id_ << " to " << tid_ << "-" << pid_ << ", blocks "
+               << request->block_info_size() << ", index region " << request->index_region_size();
+    if (!sender_(*request, data, msg)) {
+        LOG(WARNING) << "fail to send bulk load part " << part_id_ << " to " << tid_ << "-" << pid_ << ": " << *msg;
+        return false;
+    }
+    part_id_++;
+    return true;
+}
+
+}  // namespace sdk
+}  // namespace openmldb
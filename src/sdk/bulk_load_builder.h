@@ -0,0 +1,99 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_SDK_BULK_LOAD_BUILDER_H_
+#define SRC_SDK_BULK_LOAD_BUILDER_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codec/codec.h"
+#include "proto/name_server.pb.h"
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace sdk {
+
+// BulkLoadBuilder turns the rows of one partition into the parts of the tablet BulkLoad rpc, the same
+// layout as the java importer builds.
+// The data region parts carry the rows and their binlog, they are sent once the pending rows reach the size
+// limit, and each one is followed by the index region parts that put its rows into the segments. So only the
+// rows and the index of about one rpc are kept in memory. Finish sends the rest rows and their index, the
+// last part sets eof. It is not thread safe.
+class BulkLoadBuilder {
+ public:
+    // send one part, data is the attachment of the blocks in the data region
+    using Sender = std::function<bool(const ::openmldb::api::BulkLoadRequest& request, const std::string& data,
+                                      std::string* msg)>;
+
+    BulkLoadBuilder(uint32_t tid, uint32_t pid, const ::openmldb::nameserver::TableInfo& table_info,
+                    const ::openmldb::api::BulkLoadInfoResponse& info, uint32_t rpc_size_limit, Sender sender);
+
+    // dimensions are the index keys of this partition, time is used by the indexes without ts column
+    bool AddRow(const std::string& row, const std::vector<std::pair<std::string, uint32_t>>& dimensions,
+                uint64_t time, std::string* msg);
+
+    bool Finish(std::string* msg);
+
+    // send eof after a failed load, so that the tablet drops its receiver and the table accepts the next bulk
+    // load. The rows whose index has been sent stay in the table
+    bool Abort(std::string* msg);
+
+    uint64_t GetRowCnt() const { return block_id_; }
+
+ private:
+    // (time, block id) of a key entry
+    using TimeEntries = std::vector<std::pair<uint64_t, uint32_t>>;
+    // key -> the time entries of each key entry id
+    using SegmentEntries = std::map<std::string, std::vector<TimeEntries>>;
+
+    // send the pending rows and then their index
+    bool SendData(std::string* msg);
+    bool SendIndex(std::string* msg);
+    bool SendEof(std::string* msg);
+    bool SendPart(::openmldb::api::BulkLoadRequest* request, const std::string& data, std::string* msg);
+
+ private:
+    uint32_t tid_;
+    uint32_t pid_;
+    ::openmldb::api::BulkLoadInfoResponse info_;
+    uint32_t rpc_size_limit_;
+    Sender sender_;
+    ::openmldb::codec::Schema schema_;
+    ::openmldb::codec::RowView row_view_;
+
+    // the pending data region
+    ::openmldb::api::BulkLoadRequest data_request_;
+    std::string data_;
+    // the estimated size of the pending data region
+    uint64_t data_size_;
+    // the offset of the pending blocks in the whole data region
+    uint64_t data_offset_;
+    // the block id of the next row, the ids go on through the data region parts
+    uint32_t block_id_;
+    int32_t part_id_;
+    bool eof_sent_;
+    // the index of the pending rows, [inner index][segment]
+    std::vector<std::vector<SegmentEntries>> segments_;
+};
+
+}  // namespace sdk
+}  // namespace openmldb
+
+#endif  // SRC_SDK_BULK_LOAD_BUILDER_H_
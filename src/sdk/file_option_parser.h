@@ -145,7 +145,32 @@ class FileOptionsParser {
 
 class ReadFileOptionsParser : public FileOptionsParser {
  public:
-    ReadFileOptionsParser() { quote_ = '\0'; }
+    ReadFileOptionsParser() {
+        quote_ = '\0';
+        check_map_.emplace("thread", std::make_pair(CheckThread(), hybridse::node::kInt32));
+        check_map_.emplace("load_mode", std::make_pair(CheckLoadMode(), hybridse::node::kVarchar));
+    }
+    int32_t GetThread() const { return thread_; }
+    const std::string& GetLoadMode() const { return load_mode_; }
+
+ private:
+    // the threads to parse and load the lines
+    int32_t thread_ = 4;
+    // insert: put the rows, bulk_load: build the segments of memory tables in the client and load them by BulkLoad
+    std::string load_mode_ = "insert";
+    std::function<bool(const hybridse::node::ConstNode* node)> CheckThread() {
+        return [this](const hybridse::node::ConstNode* node) {
+            thread_ = node->GetInt();
+            return thread_ > 0;
+        };
+    }
+    std::function<bool(const hybridse::node::ConstNode* node)> CheckLoadMode() {
+        return [this](const hybridse::node::ConstNode* node) {
+            load_mode_ = node->GetAsString();
+            boost::to_lower(load_mode_);
+            return load_mode_ == "insert" || load_mode_ == "bulk_load";
+        };
+    }
 };
 
 class WriteFileOptionsParser : public FileOptionsParser {
@@ -76,6 +76,14 @@ std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
         *status = {::hybridse::common::StatusCode::kCmdError, "request error, fail to decodec schema"};
         return {};
     }
+    if (response->columnar()) {
+        auto rs = std::make_shared<openmldb::sdk::ResultSetColumnar>(schema, cntl);
+        if (!rs->Init()) {
+            *status = {::hybridse::common::StatusCode::kCmdError, "request error, ResultSetColumnar init failed"};
+            return {};
+        }
+        return rs;
+    }
     auto rs = std::make_shared<openmldb::sdk::ResultSetSQL>(schema, response->count(), response->byte_size(), cntl);
     if (!rs->Init()) {
         *status = {::hybridse::common::StatusCode::kCmdError, "request error, ResultSetSQL init failed"};
@@ -141,5 +149,70 @@ std::shared_ptr<::hybridse::sdk::ResultSet> ResultSetSQL::MakeResultSet(
     return {};
 }
 
+ResultSetColumnar::ResultSetColumnar(const ::hybridse::vm::Schema& schema,
+                                     const std::shared_ptr<brpc::Controller>& cntl)
+    : cntl_(cntl), buf_(), view_(schema), schema_(), index_(-1) {
+    schema_.SetSchema(schema);
+}
+
+bool ResultSetColumnar::Init() {
+    if (!cntl_) {
+        return false;
+    }
+    const butil::IOBuf& buf = cntl_->response_attachment();
+    // read the attachment in place if it is a single aligned block, which is the usual case of small results
+    if (buf.backing_block_num() == 1 && reinterpret_cast<uintptr_t>(buf.backing_block(0).data()) % 8 == 0) {
+        auto block = buf.backing_block(0);
+        return view_.Reset(block.data(), block.size());
+    }
+    buf.copy_to(&buf_);
+    return view_.Reset(buf_.data(), buf_.size());
+}
+
+bool ResultSetColumnar::IsValid(uint32_t index, ::hybridse::type::Type type) const {
+    if (index_ < 0 || index_ >= static_cast<int32_t>(view_.GetRowCnt()) ||
+        index >= static_cast<uint32_t>(view_.GetSchema().size())) {
+        return false;
+    }
+    return view_.GetSchema().Get(index).type() == type && !view_.IsNULL(index, index_);
+}
+
+bool ResultSetColumnar::IsNULL(int index) {
+    if (index_ < 0 || index_ >= static_cast<int32_t>(view_.GetRowCnt()) || index < 0 ||
+        index >= view_.GetSchema().size()) {
+        return false;
+    }
+    return view_.IsNULL(index, index_);
+}
+
+bool ResultSetColumnar::GetString(uint32_t index, std::string* str) {
+    if (str == nullptr || !IsValid(index, ::hybridse::type::kVarchar)) {
+        return false;
+    }
+    const uint32_t* offsets = view_.GetOffsets(index);
+    str->assign(view_.GetStringData(index) + offsets[index_], offsets[index_ + 1] - offsets[index_]);
+    return true;
+}
+
+bool ResultSetColumnar::GetBool(uint32_t index, bool* result) {
+    if (result == nullptr || !IsValid(index, ::hybridse::type::kBool)) {
+        return false;
+    }
+    *result = view_.GetValues<uint8_t>(index)[index_] != 0;
+    return true;
+}
+
+bool ResultSetColumnar::GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) {
+    int32_t date = 0;
+    if (year == nullptr || month == nullptr || day == nullptr || !GetDate(index, &date)) {
+        return false;
+    }
+    *day = date & 0x0000000FF;
+    date = date >> 8;
+    *month = 1 + (date & 0x0000FF);
+    *year = 1900 + (date >> 8);
+    return true;
+}
+
 }  // namespace sdk
 }  // namespace openmldb
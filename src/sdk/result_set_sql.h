@@ -23,6 +23,7 @@
 
 #include "brpc/controller.h"
 #include "butil/iobuf.h"
+#include "codec/columnar_codec.h"
 #include "proto/tablet.pb.h"
 #include "sdk/base_impl.h"
 #include "sdk/codec_sdk.h"
@@ -100,6 +101,81 @@ class ResultSetSQL : public ::hybridse::sdk::ResultSet {
     std::shared_ptr<butil::IOBuf> io_buf_;
 };
 
+// the result of the query response in columnar encoding, the getters read the current row from the column
+// arrays in place instead of decoding the rows
+class ResultSetColumnar : public ::hybridse::sdk::ResultSet {
+ public:
+    ResultSetColumnar(const ::hybridse::vm::Schema& schema, const std::shared_ptr<brpc::Controller>& cntl);
+
+    ~ResultSetColumnar() {}
+
+    bool Init();
+
+    bool Reset() override {
+        index_ = -1;
+        return true;
+    }
+
+    bool Next() override { return ++index_ < static_cast<int32_t>(view_.GetRowCnt()); }
+
+    bool IsNULL(int index) override;
+
+    bool GetString(uint32_t index, std::string* str) override;
+
+    bool GetBool(uint32_t index, bool* result) override;
+
+    bool GetChar(uint32_t index, char* result) override { return false; }
+
+    bool GetInt16(uint32_t index, int16_t* result) override {
+        return GetValue(index, ::hybridse::type::kInt16, result);
+    }
+
+    bool GetInt32(uint32_t index, int32_t* result) override {
+        return GetValue(index, ::hybridse::type::kInt32, result);
+    }
+
+    bool GetInt64(uint32_t index, int64_t* result) override {
+        return GetValue(index, ::hybridse::type::kInt64, result);
+    }
+
+    bool GetFloat(uint32_t index, float* result) override { return GetValue(index, ::hybridse::type::kFloat, result); }
+
+    bool GetDouble(uint32_t index, double* result) override {
+        return GetValue(index, ::hybridse::type::kDouble, result);
+    }
+
+    bool GetDate(uint32_t index, int32_t* date) override { return GetValue(index, ::hybridse::type::kDate, date); }
+
+    bool GetDate(uint32_t index, int32_t* year, int32_t* month, int32_t* day) override;
+
+    bool GetTime(uint32_t index, int64_t* mills) override {
+        return GetValue(index, ::hybridse::type::kTimestamp, mills);
+    }
+
+    const ::hybridse::sdk::Schema* GetSchema() override { return &schema_; }
+
+    int32_t Size() override { return view_.GetRowCnt(); }
+
+ private:
+    bool IsValid(uint32_t index, ::hybridse::type::Type type) const;
+
+    template <class T>
+    bool GetValue(uint32_t index, ::hybridse::type::Type type, T* result) {
+        if (result == nullptr || !IsValid(index, type)) {
+            return false;
+        }
+        *result = view_.GetValues<T>(index)[index_];
+        return true;
+    }
+
+    std::shared_ptr<brpc::Controller> cntl_;
+    // the contiguous copy of the attachment if it is split into blocks
+    std::string buf_;
+    ::openmldb::codec::ColumnarView view_;
+    ::hybridse::sdk::SchemaImpl schema_;
+    int32_t index_;
+};
+
 class MultipleResultSetSQL : public ::hybridse::sdk::ResultSet {
  public:
     explicit MultipleResultSetSQL(const std::vector<std::shared_ptr<ResultSetSQL>>& result_set_list,
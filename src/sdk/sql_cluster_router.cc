@@ -17,9 +17,14 @@
 #include "sdk/sql_cluster_router.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -28,6 +33,7 @@
 #include "absl/strings/strip.h"
 #include "base/ddl_parser.h"
 #include "base/file_util.h"
+#include "boost/algorithm/string.hpp"
 #include "boost/none.hpp"
 #include "boost/property_tree/ini_parser.hpp"
 #include "boost/property_tree/ptree.hpp"
@@ -43,12 +49,15 @@
 #include "sdk/base.h"
 #include "sdk/base_impl.h"
 #include "sdk/batch_request_result_set_sql.h"
+#include "sdk/bulk_load_builder.h"
 #include "sdk/file_option_parser.h"
 #include "sdk/node_adapter.h"
 #include "sdk/result_set_sql.h"
 #include "sdk/split.h"
 
 DECLARE_int32(request_timeout_ms);
+DECLARE_uint32(put_batch_max_rows);
+DECLARE_uint32(put_batch_max_bytes);
 DECLARE_string(bucket_size);
 DEFINE_string(spark_conf, "", "The config file of Spark job");
 DECLARE_uint32(replica_num);
@@ -1040,26 +1049,84 @@ std::shared_ptr<TableReader> SQLClusterRouter::GetTableReader() {
 std::shared_ptr<openmldb::client::TabletClient> SQLClusterRouter::GetTablet(const std::string& db,
                                                                             const std::string& sp_name,
                                                                             hybridse::sdk::Status* status) {
+    return GetTablet(db, sp_name, std::shared_ptr<SQLRequestRow>(), status);
+}
+
+std::shared_ptr<openmldb::client::TabletClient> SQLClusterRouter::GetTablet(const std::string& db,
+                                                                            const std::string& sp_name,
+                                                                            const std::shared_ptr<SQLRequestRow>& row,
+                                                                            hybridse::sdk::Status* status) {
     if (status == nullptr) return nullptr;
-    std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info = cluster_sdk_->GetProcedureInfo(db, sp_name, &status->msg);
-    if (!sp_info) {
-        status->code = -1;
-        status->msg = "procedure not found, msg: " + status->msg;
-        LOG(WARNING) << status->msg;
+    auto route = GetProcedureRoute(db, sp_name, status);
+    if (!route) {
         return nullptr;
     }
-    const std::string& table = sp_info->GetMainTable();
-    const std::string& db_name = sp_info->GetMainDb().empty() ? db : sp_info->GetMainDb();
-    auto tablet = cluster_sdk_->GetTablet(db_name, table);
+    std::shared_ptr<::openmldb::catalog::TabletAccessor> tablet;
+    std::string val;
+    if (row && !route->router_col.empty() && row->GetRecordVal(route->router_col, &val)) {
+        tablet = cluster_sdk_->GetTablet(route->main_db, route->main_table, val);
+    }
+    if (!tablet) {
+        tablet = cluster_sdk_->GetTablet(route->main_db, route->main_table);
+    }
     if (!tablet) {
         status->code = -1;
-        status->msg = "fail to get tablet, table " + db_name + "." + table;
+        status->msg = "fail to get tablet, table " + route->main_db + "." + route->main_table;
         LOG(WARNING) << status->msg;
         return nullptr;
     }
     return tablet->GetClient();
 }
 
+std::shared_ptr<ProcedureRoute> SQLClusterRouter::GetProcedureRoute(const std::string& db, const std::string& sp_name,
+                                                                    hybridse::sdk::Status* status) {
+    std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info = cluster_sdk_->GetProcedureInfo(db, sp_name, &status->msg);
+    if (!sp_info) {
+        status->code = -1;
+        status->msg = "procedure not found, msg: " + status->msg;
+        LOG(WARNING) << status->msg;
+        return nullptr;
+    }
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+        auto db_iter = procedure_route_.find(db);
+        if (db_iter != procedure_route_.end()) {
+            auto iter = db_iter->second.find(sp_name);
+            // the info is replaced if the procedure is recreated
+            if (iter != db_iter->second.end() && iter->second->sp_info == sp_info) {
+                return iter->second;
+            }
+        }
+    }
+    auto route = std::make_shared<ProcedureRoute>();
+    route->sp_info = sp_info;
+    route->main_table = sp_info->GetMainTable();
+    route->main_db = sp_info->GetMainDb().empty() ? db : sp_info->GetMainDb();
+    // the router column is recorded by the request rows of the procedure, see GetRequestRowByProcedure
+    const std::string& sql = sp_info->GetSql();
+    std::shared_ptr<SQLCache> cache = GetCache(db, sql, hybridse::vm::kRequestMode);
+    if (!cache) {
+        ::hybridse::vm::ExplainOutput explain;
+        ::hybridse::base::Status vm_status;
+        if (cluster_sdk_->GetEngine()->Explain(sql, db, ::hybridse::vm::kRequestMode, &explain, &vm_status)) {
+            cache = std::make_shared<SQLCache>(std::make_shared<::hybridse::sdk::SchemaImpl>(explain.input_schema),
+                                               explain.router);
+            SetCache(db, sql, hybridse::vm::kRequestMode, cache);
+        } else {
+            LOG(WARNING) << "fail to explain procedure " << db << "." << sp_name << ", " << vm_status.msg;
+        }
+    }
+    if (cache) {
+        const std::string& router_db = cache->router.GetMainDb().empty() ? db : cache->router.GetMainDb();
+        if (router_db == route->main_db && cache->router.GetMainTable() == route->main_table) {
+            route->router_col = cache->router.GetRouterCol();
+        }
+    }
+    std::lock_guard<::openmldb::base::SpinMutex> lock(mu_);
+    procedure_route_[db][sp_name] = route;
+    return route;
+}
+
 bool SQLClusterRouter::IsConstQuery(::hybridse::vm::PhysicalOpNode* node) {
     if (node->GetOpType() == ::hybridse::vm::kPhysicalOpConstProject) {
         return true;
@@ -1149,7 +1216,7 @@ std::shared_ptr<::hybridse::sdk::ResultSet> SQLClusterRouter::ExecuteSQLParamete
     DLOG(INFO) << " send query to tablet " << client->GetEndpoint();
     auto response = std::make_shared<::openmldb::api::QueryResponse>();
     if (!client->Query(db, sql, parameter_types, parameter ? parameter->GetRow() : "", cntl.get(), response.get(),
-                       options_.enable_debug)) {
+                       options_.enable_debug, options_.columnar_result)) {
         status->msg = response->msg();
         status->code = -1;
         return {};
@@ -1215,7 +1282,9 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
         LOG(WARNING) << status->msg;
         return false;
     }
-    size_t cnt = 0;
+    std::vector<std::shared_ptr<SQLInsertRow>> rows;
+    // the position of each row in the statement
+    std::vector<size_t> row_idx;
     for (size_t i = 0; i < default_maps.size(); i++) {
         auto row = std::make_shared<SQLInsertRow>(table_info, schema, default_maps[i], str_lengths[i]);
         if (!row) {
@@ -1230,8 +1299,15 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             LOG(WARNING) << "fail to build row[" << i << "]";
             continue;
         }
-        if (!PutRow(table_info->tid(), row, tablets, status)) {
-            LOG(WARNING) << "fail to put row[" << i << "] due to: " << status->msg;
+        rows.push_back(row);
+        row_idx.push_back(i);
+    }
+    size_t cnt = 0;
+    std::vector<::hybridse::sdk::Status> row_status;
+    PutRows(table_info->tid(), rows, tablets, &row_status);
+    for (size_t i = 0; i < row_status.size(); i++) {
+        if (!row_status[i].IsOK()) {
+            LOG(WARNING) << "fail to put row[" << row_idx[i] << "] due to: " << row_status[i].msg;
             continue;
         }
         cnt++;
@@ -1279,6 +1355,116 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
     return true;
 }
 
+bool SQLClusterRouter::PutRows(uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+                               const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                               std::vector<::hybridse::sdk::Status>* row_status) {
+    if (row_status == nullptr) {
+        return false;
+    }
+    row_status->assign(rows.size(), ::hybridse::sdk::Status());
+    auto set_fail = [row_status](const std::vector<size_t>& row_idx, const std::string& msg) {
+        for (auto idx : row_idx) {
+            (*row_status)[idx] = ::hybridse::sdk::Status(1, msg);
+        }
+    };
+    struct PutBatch {
+        ::openmldb::api::PutBatchRequest request;
+        // the row of each entry
+        std::vector<size_t> rows;
+        uint64_t bytes = 0;
+        openmldb::RpcCallback<openmldb::api::PutBatchResponse>* callback = nullptr;
+    };
+    uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+    // the rows of a partition are split into batches by put_batch_max_rows and put_batch_max_bytes, so that a
+    // request does not exceed the max body size of rpc
+    uint32_t max_rows = std::max(FLAGS_put_batch_max_rows, 1u);
+    std::map<uint32_t, std::deque<PutBatch>> batches;
+    for (size_t i = 0; i < rows.size(); i++) {
+        for (const auto& kv : rows[i]->GetDimensions()) {
+            auto& pid_batches = batches[kv.first];
+            if (pid_batches.empty() || pid_batches.back().rows.size() >= max_rows ||
+                pid_batches.back().bytes >= FLAGS_put_batch_max_bytes) {
+                pid_batches.emplace_back();
+            }
+            auto& batch = pid_batches.back();
+            auto entry = batch.request.add_entries();
+            entry->set_time(cur_ts);
+            entry->set_value(rows[i]->GetRow());
+            batch.bytes += rows[i]->GetRow().size();
+            for (const auto& dim : kv.second) {
+                auto d = entry->add_dimensions();
+                d->set_key(dim.first);
+                d->set_idx(dim.second);
+                batch.bytes += dim.first.size() + sizeof(dim.second);
+            }
+            batch.rows.push_back(i);
+        }
+    }
+    for (auto& kv : batches) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        for (auto& batch : kv.second) {
+            if (!client) {
+                LOG(WARNING) << "fail to get tablet client. pid " << pid;
+                set_fail(batch.rows, "fail to get tablet client. pid " + std::to_string(pid));
+                continue;
+            }
+            DLOG(INFO) << "put " << batch.rows.size() << " rows to endpoint " << client->GetEndpoint();
+            batch.request.set_tid(tid);
+            batch.request.set_pid(pid);
+            auto cntl = std::make_shared<brpc::Controller>();
+            cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+            batch.callback = new openmldb::RpcCallback<openmldb::api::PutBatchResponse>(
+                std::make_shared<openmldb::api::PutBatchResponse>(), cntl);
+            // the rpc releases one reference when it is done, the other one is released after the join below
+            batch.callback->Ref();
+            if (!client->AsyncPutBatch(batch.request, batch.callback)) {
+                batch.callback->UnRef();
+                batch.callback->UnRef();
+                batch.callback = nullptr;
+                set_fail(batch.rows, "fail to make a put request to table. tid " + std::to_string(tid));
+            }
+        }
+    }
+    for (auto& kv : batches) {
+        for (auto& batch : kv.second) {
+            if (batch.callback == nullptr) {
+                continue;
+            }
+            auto cntl = batch.callback->GetController();
+            auto response = batch.callback->GetResponse();
+            brpc::Join(cntl->call_id());
+            std::string prefix = "fail to make a put request to table. tid " + std::to_string(tid) + ", pid " +
+                                 std::to_string(kv.first) + ". ";
+            if (cntl->Failed()) {
+                LOG(WARNING) << prefix << cntl->ErrorText();
+                set_fail(batch.rows, prefix + cntl->ErrorText());
+            } else if (response->codes_size() != static_cast<int>(batch.rows.size())) {
+                // the request is rejected as a whole, e.g. the partition is not a leader
+                LOG(WARNING) << prefix << response->msg();
+                set_fail(batch.rows, prefix + response->msg());
+            } else {
+                for (size_t i = 0; i < batch.rows.size(); i++) {
+                    if (response->codes(i) != ::openmldb::base::ReturnCode::kOk) {
+                        (*row_status)[batch.rows[i]] =
+                            ::hybridse::sdk::Status(1, prefix + "error code " + std::to_string(response->codes(i)));
+                    }
+                }
+            }
+            batch.callback->UnRef();
+        }
+    }
+    for (const auto& status : *row_status) {
+        if (!status.IsOK()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
     if (!rows || !status) {
@@ -1294,11 +1480,19 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             status->msg = "fail to get table " + table_info->name() + " tablet";
             return false;
         }
+        std::vector<std::shared_ptr<SQLInsertRow>> insert_rows;
         for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
-            std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
-            if (!PutRow(table_info->tid(), row, tablets, status)) {
-                return false;
+            insert_rows.push_back(rows->GetRow(i));
+        }
+        std::vector<::hybridse::sdk::Status> row_status;
+        if (!PutRows(table_info->tid(), insert_rows, tablets, &row_status)) {
+            for (const auto& row_st : row_status) {
+                if (!row_st.IsOK()) {
+                    status->msg = row_st.msg;
+                    break;
+                }
             }
+            return false;
         }
         return true;
     } else {
@@ -1307,6 +1501,43 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
     }
 }
 
+bool SQLClusterRouter::ExecuteInsertBatch(const std::string& db, const std::string& sql,
+                                          std::shared_ptr<SQLInsertRows> rows,
+                                          std::vector<hybridse::sdk::Status>* row_status,
+                                          hybridse::sdk::Status* status) {
+    if (!rows || !row_status || !status) {
+        LOG(WARNING) << "input is invalid";
+        return false;
+    }
+    std::shared_ptr<SQLCache> cache = GetCache(db, sql, hybridse::vm::kBatchMode);
+    if (!cache) {
+        status->code = 1;
+        status->msg = "please use getInsertRows with " + sql + " first";
+        return false;
+    }
+    std::shared_ptr<::openmldb::nameserver::TableInfo> table_info = cache->table_info;
+    std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>> tablets;
+    bool ret = cluster_sdk_->GetTablet(db, table_info->name(), &tablets);
+    if (!ret || tablets.empty()) {
+        status->code = 1;
+        status->msg = "fail to get table " + table_info->name() + " tablet";
+        return false;
+    }
+    std::vector<std::shared_ptr<SQLInsertRow>> insert_rows;
+    for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
+        insert_rows.push_back(rows->GetRow(i));
+    }
+    if (!PutRows(table_info->tid(), insert_rows, tablets, row_status)) {
+        size_t fail_cnt = std::count_if(row_status->begin(), row_status->end(),
+                                        [](const hybridse::sdk::Status& st) { return !st.IsOK(); });
+        status->code = 1;
+        status->msg = "fail to insert " + std::to_string(fail_cnt) + " of " + std::to_string(insert_rows.size()) +
+                      " rows";
+        return false;
+    }
+    return true;
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRow> row,
                                      hybridse::sdk::Status* status) {
     if (!row || !status) {
@@ -1381,7 +1612,7 @@ std::shared_ptr<hybridse::sdk::ResultSet> SQLClusterRouter::CallProcedure(const
         LOG(WARNING) << "make sure the request row is built before execute sql";
         return nullptr;
     }
-    auto tablet = GetTablet(db, sp_name, status);
+    auto tablet = GetTablet(db, sp_name, row, status);
     if (!tablet) {
         return nullptr;
     }
@@ -2049,7 +2280,7 @@ std::shared_ptr<openmldb::sdk::QueryFuture> SQLClusterRouter::CallProcedure(cons
         LOG(WARNING) << "make sure the request row is built before execute sql";
         return {};
     }
-    auto tablet = GetTablet(db, sp_name, status);
+    auto tablet = GetTablet(db, sp_name, row, status);
     if (!tablet) {
         return {};
     }
@@ -2762,7 +2993,45 @@ void SQLClusterRouter::SetInteractive(bool value) { interactive_ = value; }
     return {};
 }
 
+// the lines are parsed and loaded in chunks
+static constexpr size_t LOAD_DATA_CHUNK_LINES = 10000;
+// the size limit of a BulkLoad rpc, below the default max body size of brpc
+static constexpr uint32_t BULK_LOAD_RPC_SIZE_LIMIT = 32 * 1024 * 1024;
+static constexpr uint64_t LOAD_DATA_REPORT_INTERVAL_MS = 10000;
+
+static hybridse::sdk::Status FillLoadDataRow(const std::vector<int>& str_col_idx, const std::string& null_value,
+                                             const std::vector<std::string>& cols,
+                                             const std::shared_ptr<SQLInsertRow>& row) {
+    auto& schema = row->GetSchema();
+    auto cnt = schema->GetColumnCnt();
+    if (cnt != static_cast<int>(cols.size())) {
+        return {::hybridse::common::StatusCode::kCmdError, "col size mismatch"};
+    }
+    // scan all strings , calc the sum, to init SQLInsertRow's string length
+    std::string::size_type str_len_sum = 0;
+    for (auto idx : str_col_idx) {
+        if (cols[idx] != null_value) {
+            str_len_sum += cols[idx].length();
+        }
+    }
+    row->Init(static_cast<int>(str_len_sum));
+
+    for (int i = 0; i < cnt; ++i) {
+        if (!::openmldb::codec::AppendColumnValue(cols[i], schema->GetColumnType(i), schema->IsColumnNotNull(i),
+                                                  null_value, row)) {
+            return {::hybridse::common::StatusCode::kCmdError, "translate to insert row failed"};
+        }
+    }
+    if (!row->IsComplete()) {
+        return {::hybridse::common::StatusCode::kCmdError, "translate to insert row failed"};
+    }
+    return {};
+}
+
 // Only csv format
+// The main thread reads the file into chunks of lines, the workers parse the chunks and load the rows. In insert
+// mode a chunk is put to the partitions in parallel, in bulk_load mode the rows are added to the builder of each
+// partition and the builders send the parts by the BulkLoad rpc.
 hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     const std::string& database, const std::string& table, const std::string& file_path,
     const std::shared_ptr<hybridse::node::OptionsMap>& options) {
@@ -2774,10 +3043,6 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     if (!st.OK()) {
         return {::hybridse::common::StatusCode::kCmdError, st.msg};
     }
-    /*std::cout << "Load " << file_path << " to " << real_db << "-" << table << ", options: delimiter ["
-              << options_parse.GetDelimiter() << "], has header[" << (options_parse.GetHeader() ? "true" : "false")
-              << "], null_value[" << options_parse.GetNullValue() << "], format[" << options_parse.GetFormat()
-              << "], quote[" << options_parse.GetQuote() << "]" << std::endl;*/
     // read csv
     if (!base::IsExists(file_path)) {
         return {::hybridse::common::StatusCode::kCmdError, "file not exist"};
@@ -2795,13 +3060,15 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     ::openmldb::sdk::SplitLineWithDelimiterForStrings(line, options_parse.GetDelimiter(), &cols,
                                                       options_parse.GetQuote());
     auto schema = GetTableSchema(database, table);
-    if (!schema) {
+    auto table_info = cluster_sdk_->GetTableInfo(database, table);
+    if (!schema || !table_info) {
         return {::hybridse::common::StatusCode::kCmdError, "table is not exist"};
     }
     if (static_cast<int>(cols.size()) != schema->GetColumnCnt()) {
         return {::hybridse::common::StatusCode::kCmdError, "mismatch column size"};
     }
 
+    std::vector<std::string> chunk;
     if (options_parse.GetHeader()) {
         // the first line is the column names, check if equal with table schema
         for (int i = 0; i < schema->GetColumnCnt(); ++i) {
@@ -2809,8 +3076,16 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
                 return {::hybridse::common::StatusCode::kCmdError, "mismatch column name"};
             }
         }
-        // then read the first row of data
-        std::getline(file, line);
+    } else {
+        chunk.push_back(std::move(line));
+    }
+    bool bulk_load = options_parse.GetLoadMode() == "bulk_load";
+    if (bulk_load && table_info->storage_mode() != ::openmldb::common::kMemory) {
+        return {::hybridse::common::StatusCode::kCmdError, "bulk_load only supports memory table"};
+    }
+    std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>> tablets;
+    if (!cluster_sdk_->GetTablet(database, table, &tablets) || tablets.empty()) {
+        return {::hybridse::common::StatusCode::kCmdError, "fail to get tablets of table " + table};
     }
 
     // build placeholder
@@ -2820,66 +3095,215 @@ hybridse::sdk::Status SQLClusterRouter::HandleLoadDataInfile(
     }
     hybridse::sdk::Status status;
     std::string insert_placeholder = "insert into " + table + " values(" + holders + ");";
+    // prepare the insert cache before the workers start
+    if (!GetInsertRows(database, insert_placeholder, &status)) {
+        return {::hybridse::common::StatusCode::kCmdError, "prepare insert failed, " + status.msg};
+    }
     std::vector<int> str_cols_idx;
     for (int i = 0; i < schema->GetColumnCnt(); ++i) {
         if (schema->GetColumnType(i) == hybridse::sdk::kTypeString) {
             str_cols_idx.emplace_back(i);
         }
     }
-    uint64_t i = 0;
-    do {
-        cols.clear();
-        std::string error;
-        ::openmldb::sdk::SplitLineWithDelimiterForStrings(line, options_parse.GetDelimiter(), &cols,
-                                                          options_parse.GetQuote());
-        auto ret = InsertOneRow(database, insert_placeholder, str_cols_idx, options_parse.GetNullValue(), cols);
-        if (!ret.IsOK()) {
-            return {::hybridse::common::StatusCode::kCmdError, "line [" + line + "] insert failed, " + ret.msg};
+
+    // one builder for each partition leader, the rows of a partition are added under its lock
+    std::vector<std::unique_ptr<BulkLoadBuilder>> builders;
+    std::vector<std::mutex> builder_mu(bulk_load ? tablets.size() : 0);
+    if (bulk_load) {
+        for (uint32_t pid = 0; pid < tablets.size(); pid++) {
+            auto client = tablets[pid] ? tablets[pid]->GetClient() : nullptr;
+            if (!client) {
+                return {::hybridse::common::StatusCode::kCmdError,
+                        "fail to get tablet client. pid " + std::to_string(pid)};
+            }
+            ::openmldb::api::BulkLoadInfoResponse info;
+            if (!client->GetBulkLoadInfo(table_info->tid(), pid, &info)) {
+                return {::hybridse::common::StatusCode::kCmdError,
+                        "fail to get bulk load info. pid " + std::to_string(pid) + ", " + info.msg()};
+            }
+            builders.emplace_back(std::make_unique<BulkLoadBuilder>(
+                table_info->tid(), pid, *table_info, info, BULK_LOAD_RPC_SIZE_LIMIT,
+                [client](const ::openmldb::api::BulkLoadRequest& request, const std::string& data, std::string* msg) {
+                    return client->BulkLoad(request, data, msg);
+                }));
+        }
+    }
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::vector<std::string>> chunks;
+    bool read_done = false;
+    std::atomic<bool> failed(false);
+    std::atomic<uint64_t> loaded_rows(0);
+    hybridse::sdk::Status error;
+    auto set_error = [&](const hybridse::sdk::Status& st) {
+        std::lock_guard<std::mutex> lock(mu);
+        if (!failed.exchange(true)) {
+            error = st;
+        }
+        cv.notify_all();
+    };
+    auto load_chunk = [&](const std::vector<std::string>& lines) {
+        hybridse::sdk::Status status;
+        auto rows = GetInsertRows(database, insert_placeholder, &status);
+        if (!rows) {
+            set_error({::hybridse::common::StatusCode::kCmdError, "get insert rows failed, " + status.msg});
+            return;
         }
-        ++i;
-    } while (std::getline(file, line));
-    return {0, "Load " + std::to_string(i) + " rows"};
-}
+        std::vector<std::string> cols;
+        for (const auto& cur : lines) {
+            cols.clear();
+            ::openmldb::sdk::SplitLineWithDelimiterForStrings(cur, options_parse.GetDelimiter(), &cols,
+                                                              options_parse.GetQuote());
+            auto ret = FillLoadDataRow(str_cols_idx, options_parse.GetNullValue(), cols, rows->NewRow());
+            if (!ret.IsOK()) {
+                set_error({::hybridse::common::StatusCode::kCmdError, "line [" + cur + "] insert failed, " + ret.msg});
+                return;
+            }
+        }
+        if (!bulk_load) {
+            std::vector<hybridse::sdk::Status> row_status;
+            if (!ExecuteInsertBatch(database, insert_placeholder, rows, &row_status, &status)) {
+                for (size_t i = 0; i < row_status.size(); i++) {
+                    if (!row_status[i].IsOK()) {
+                        status.msg = "line [" + lines[i] + "] insert failed, " + row_status[i].msg;
+                        break;
+                    }
+                }
+                set_error({::hybridse::common::StatusCode::kCmdError, status.msg});
+                return;
+            }
+        } else {
+            // group the rows by partition to take each lock once
+            std::map<uint32_t, std::vector<std::pair<uint32_t, const std::vector<std::pair<std::string, uint32_t>>*>>>
+                pid_rows;
+            for (uint32_t i = 0; i < rows->GetCnt(); i++) {
+                for (const auto& kv : rows->GetRow(i)->GetDimensions()) {
+                    pid_rows[kv.first].emplace_back(i, &kv.second);
+                }
+            }
+            uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+            std::string msg;
+            for (const auto& kv : pid_rows) {
+                if (kv.first >= builders.size()) {
+                    set_error({::hybridse::common::StatusCode::kCmdError, "invalid pid " + std::to_string(kv.first)});
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(builder_mu[kv.first]);
+                for (const auto& row : kv.second) {
+                    if (!builders[kv.first]->AddRow(rows->GetRow(row.first)->GetRow(), *row.second, cur_ts, &msg)) {
+                        set_error({::hybridse::common::StatusCode::kCmdError,
+                                   "line [" + lines[row.first] + "] bulk load failed, " + msg});
+                        return;
+                    }
+                }
+            }
+        }
+        loaded_rows.fetch_add(lines.size(), std::memory_order_relaxed);
+    };
 
-hybridse::sdk::Status SQLClusterRouter::InsertOneRow(const std::string& database, const std::string& insert_placeholder,
-                                                     const std::vector<int>& str_col_idx, const std::string& null_value,
-                                                     const std::vector<std::string>& cols) {
-    if (cols.empty()) {
-        return {::hybridse::common::StatusCode::kCmdError, "cols is empty"};
-    }
-    if (database.empty()) {
-        return {::hybridse::common::StatusCode::kCmdError, "database is empty"};
+    uint32_t thread_num = options_parse.GetThread();
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        workers.emplace_back([&]() {
+            while (true) {
+                std::vector<std::string> lines;
+                {
+                    std::unique_lock<std::mutex> lock(mu);
+                    cv.wait(lock, [&]() { return !chunks.empty() || read_done || failed.load(); });
+                    if (chunks.empty() || failed.load()) {
+                        return;
+                    }
+                    lines = std::move(chunks.front());
+                    chunks.pop_front();
+                }
+                cv.notify_all();
+                load_chunk(lines);
+            }
+        });
+    }
+
+    uint64_t start_time = ::baidu::common::timer::get_micros() / 1000;
+    uint64_t last_report_time = start_time;
+    auto push_chunk = [&]() {
+        std::unique_lock<std::mutex> lock(mu);
+        // bound the lines in memory
+        cv.wait(lock, [&]() { return chunks.size() < thread_num * 2 || failed.load(); });
+        chunks.push_back(std::move(chunk));
+        chunk.clear();
+        cv.notify_all();
+    };
+    while (!failed.load() && std::getline(file, line)) {
+        chunk.push_back(std::move(line));
+        if (chunk.size() < LOAD_DATA_CHUNK_LINES) {
+            continue;
+        }
+        push_chunk();
+        uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+        if (now - last_report_time >= LOAD_DATA_REPORT_INTERVAL_MS) {
+            last_report_time = now;
+            uint64_t rows = loaded_rows.load(std::memory_order_relaxed);
+            uint64_t speed = rows * 1000 / (now - start_time);
+            LOG(INFO) << "load " << file_path << " to " << database << "." << table << ": " << rows << " rows, "
+                      << speed << " rows/s";
+            if (interactive_) {
+                printf("Loaded %lu rows, %lu rows/s\n", rows, speed);
+            }
+        }
     }
-    hybridse::sdk::Status status;
-    auto row = GetInsertRow(database, insert_placeholder, &status);
-    if (!row) {
-        return status;
+    if (!chunk.empty() && !failed.load()) {
+        push_chunk();
     }
-    // build row from cols
-    auto& schema = row->GetSchema();
-    auto cnt = schema->GetColumnCnt();
-    if (cnt != static_cast<int>(cols.size())) {
-        return {::hybridse::common::StatusCode::kCmdError, "col size mismatch"};
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        read_done = true;
     }
-    // scan all strings , calc the sum, to init SQLInsertRow's string length
-    std::string::size_type str_len_sum = 0;
-    for (auto idx : str_col_idx) {
-        if (cols[idx] != null_value) {
-            str_len_sum += cols[idx].length();
-        }
+    cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
     }
-    row->Init(static_cast<int>(str_len_sum));
+    workers.clear();
 
-    for (int i = 0; i < cnt; ++i) {
-        if (!::openmldb::codec::AppendColumnValue(cols[i], schema->GetColumnType(i), schema->IsColumnNotNull(i),
-                                                  null_value, row)) {
-            return {::hybridse::common::StatusCode::kCmdError, "translate to insert row failed"};
+    if (bulk_load && !failed.load()) {
+        // send the rest rows and the index of the partitions in parallel
+        std::atomic<uint32_t> next_pid(0);
+        for (uint32_t i = 0; i < std::min<uint32_t>(thread_num, builders.size()); i++) {
+            workers.emplace_back([&]() {
+                std::string msg;
+                for (uint32_t pid = next_pid++; pid < builders.size() && !failed.load(); pid = next_pid++) {
+                    if (!builders[pid]->Finish(&msg)) {
+                        set_error({::hybridse::common::StatusCode::kCmdError,
+                                   "bulk load failed. pid " + std::to_string(pid) + ", " + msg});
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
         }
     }
-    if (!ExecuteInsert(database, insert_placeholder, row, &status)) {
-        return {::hybridse::common::StatusCode::kCmdError, "insert row failed"};
+    if (failed.load()) {
+        if (bulk_load) {
+            // the tablets keep the receiver until eof and refuse the next bulk load, so end the sent partitions
+            std::string abort_msg;
+            for (uint32_t pid = 0; pid < builders.size(); pid++) {
+                std::string msg;
+                if (!builders[pid]->Abort(&msg)) {
+                    abort_msg.append(" pid " + std::to_string(pid) + ": " + msg);
+                }
+            }
+            error.msg.append(". The rows whose index has been sent are kept in the table");
+            if (!abort_msg.empty()) {
+                error.msg.append(", and fail to end the bulk load of" + abort_msg +
+                                 ", the next bulk load of the table may be refused");
+            }
+        }
+        return error;
     }
-    return {};
+    uint64_t rows = loaded_rows.load();
+    uint64_t cost = ::baidu::common::timer::get_micros() / 1000 - start_time;
+    return {0, "Load " + std::to_string(rows) + " rows in " + std::to_string(cost / 1000.0) + "s, " +
+                   std::to_string(rows * 1000 / std::max<uint64_t>(cost, 1)) + " rows/s"};
 }
 
 hybridse::sdk::Status SQLClusterRouter::HandleCreateFunction(const hybridse::node::CreateFunctionPlanNode* node) {
@@ -3276,6 +3700,27 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
         for (const auto& info : long_window_infos) {
             distinct_long_window.insert(info.window_name_);
         }
+        // a window with bucket sizes like 1d|1h|1m is pre-aggregated by one table per bucket size,
+        // the coarse levels answer the middle of the window and the fine levels answer its edges
+        std::set<std::string> multi_level_windows;
+        openmldb::base::LongWindowInfos level_infos;
+        for (const auto& info : long_window_infos) {
+            std::vector<std::string> bucket_sizes;
+            boost::split(bucket_sizes, info.bucket_size_, boost::is_any_of("|"));
+            if (bucket_sizes.size() > 1) {
+                multi_level_windows.insert(info.window_name_);
+            }
+            for (auto& bucket_size : bucket_sizes) {
+                boost::trim(bucket_size);
+                if (bucket_size.empty()) {
+                    return {base::ReturnCode::kError, "illegal bucket size of long window " + info.window_name_};
+                }
+                auto level_info = info;
+                level_info.bucket_size_ = bucket_size;
+                level_infos.push_back(std::move(level_info));
+            }
+        }
+        long_window_infos = std::move(level_infos);
         if (distinct_long_window.size() != long_window_map.size()) {
             return {base::ReturnCode::kError, "long_windows option doesn't match window in sql"};
         }
@@ -3303,7 +3748,8 @@ hybridse::sdk::Status SQLClusterRouter::HandleLongWindows(
             std::string aggr_col = lw.aggr_col_ == "*" ? "" : lw.aggr_col_;
             auto aggr_table =
                 absl::StrCat("pre_", base_db, "_", deploy_node->Name(), "_", lw.window_name_, "_", lw.aggr_func_, "_",
-                             aggr_col, lw.filter_col_.empty() ? "" : "_" + lw.filter_col_);
+                             aggr_col, lw.filter_col_.empty() ? "" : "_" + lw.filter_col_,
+                             multi_level_windows.count(lw.window_name_) ? "_" + lw.bucket_size_ : "");
             std::string insert_sql = absl::StrCat(
                 "insert into ", meta_db, ".", meta_table, " values('" + aggr_table, "', '", aggr_db, "', '", base_db,
                 "', '", base_table, "', '", lw.aggr_func_, "', '", lw.aggr_col_, "', '", lw.partition_col_, "', '",
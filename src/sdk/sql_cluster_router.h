@@ -115,6 +115,15 @@ struct SQLCache {
     ::hybridse::vm::Router router;
 };
 
+// the routing plan of a deployment, built on the first call and rebuilt once the procedure is recreated
+struct ProcedureRoute {
+    std::shared_ptr<hybridse::sdk::ProcedureInfo> sp_info;
+    std::string main_db;
+    std::string main_table;
+    // the request row goes to the partition of its value in this column, or a random partition if it is empty
+    std::string router_col;
+};
+
 class SQLClusterRouter : public SQLRouter {
  public:
     explicit SQLClusterRouter(const SQLRouterOptions& options);
@@ -145,6 +154,9 @@ class SQLClusterRouter : public SQLRouter {
     bool ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                        hybridse::sdk::Status* status) override;
 
+    bool ExecuteInsertBatch(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
+                            std::vector<hybridse::sdk::Status>* row_status, hybridse::sdk::Status* status) override;
+
     std::shared_ptr<TableReader> GetTableReader() override;
 
     std::shared_ptr<ExplainInfo> Explain(const std::string& db, const std::string& sql,
@@ -319,6 +331,12 @@ class SQLClusterRouter : public SQLRouter {
                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
                 ::hybridse::sdk::Status* status);
 
+    // put the rows bucketed by partition, one request is sent to each partition leader and the requests
+    // run in parallel. a row fails if the put to any of its partitions fails
+    bool PutRows(uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                 std::vector<::hybridse::sdk::Status>* row_status);
+
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql,
                                        hybridse::vm::EngineMode engine_mode);
@@ -346,6 +364,14 @@ class SQLClusterRouter : public SQLRouter {
     std::shared_ptr<openmldb::client::TabletClient> GetTablet(const std::string& db, const std::string& sp_name,
                                                               hybridse::sdk::Status* status);
 
+    // get the tablet that holds the partition of the request row in the main table of the procedure
+    std::shared_ptr<openmldb::client::TabletClient> GetTablet(const std::string& db, const std::string& sp_name,
+                                                              const std::shared_ptr<SQLRequestRow>& row,
+                                                              hybridse::sdk::Status* status);
+
+    std::shared_ptr<ProcedureRoute> GetProcedureRoute(const std::string& db, const std::string& sp_name,
+                                                      hybridse::sdk::Status* status);
+
     bool ExtractDBTypes(const std::shared_ptr<hybridse::sdk::Schema>& schema,
                         std::vector<openmldb::type::DataType>* parameter_types);
 
@@ -364,10 +390,6 @@ class SQLClusterRouter : public SQLRouter {
                                                const std::string& file_path,
                                                const std::shared_ptr<hybridse::node::OptionsMap>& options);
 
-    hybridse::sdk::Status InsertOneRow(const std::string& database, const std::string& insert_placeholder,
-                                       const std::vector<int>& str_col_idx, const std::string& null_value,
-                                       const std::vector<std::string>& cols);
-
     hybridse::sdk::Status HandleDeploy(const std::string& db, const hybridse::node::DeployPlanNode* deploy_node);
 
     hybridse::sdk::Status HandleIndex(const std::string& db,
@@ -414,6 +436,8 @@ class SQLClusterRouter : public SQLRouter {
     DBSDK* cluster_sdk_;
     std::map<std::string, std::map<hybridse::vm::EngineMode, base::lru_cache<std::string, std::shared_ptr<SQLCache>>>>
         input_lru_cache_;
+    // db -> sp name -> route
+    std::map<std::string, std::map<std::string, std::shared_ptr<ProcedureRoute>>> procedure_route_;
     ::openmldb::base::SpinMutex mu_;
     ::openmldb::base::Random rand_;
 };
@@ -30,6 +30,9 @@
 #include "sdk/sql_sdk_test.h"
 #include "vm/catalog.h"
 
+DECLARE_uint32(put_batch_max_rows);
+DECLARE_uint32(put_batch_max_bytes);
+
 namespace openmldb::sdk {
 
 static void SetOnlineMode(const std::shared_ptr<SQLRouter>& router) {
@@ -303,6 +306,147 @@ TEST_F(SQLClusterTest, ClusterInsert) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(SQLClusterTest, ClusterInsertBatch) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    std::string name = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    bool ok = router->CreateDB(db, &status);
+    ASSERT_TRUE(ok);
+    std::string ddl = "create table " + name +
+                      "("
+                      "col1 string, col2 string, col3 bigint,"
+                      "index(key=col1, ts=col3), index(key=col2, ts=col3)) options(partitionnum=8);";
+    ok = router->ExecuteDDL(db, ddl, &status);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(router->RefreshCatalog());
+    std::string insert = "insert into " + name + " values(?, ?, ?);";
+    auto rows = router->GetInsertRows(db, insert, &status);
+    ASSERT_EQ(0, status.code);
+    for (int i = 0; i < 200; i++) {
+        std::string key1 = "hello" + std::to_string(i);
+        std::string key2 = "world" + std::to_string(i % 10);
+        auto row = rows->NewRow();
+        ASSERT_TRUE(row->Init(key1.size() + key2.size()));
+        ASSERT_TRUE(row->AppendString(key1));
+        ASSERT_TRUE(row->AppendString(key2));
+        ASSERT_TRUE(row->AppendInt64(1590 + i));
+        ASSERT_TRUE(row->Build());
+    }
+    std::vector<::hybridse::sdk::Status> row_status;
+    ok = router->ExecuteInsertBatch(db, insert, rows, &row_status, &status);
+    ASSERT_TRUE(ok) << status.msg;
+    ASSERT_EQ(200u, row_status.size());
+    for (const auto& row_st : row_status) {
+        ASSERT_TRUE(row_st.IsOK());
+    }
+
+    // the rows of a partition are split into several requests by rows and by bytes
+    for (auto limit : {std::make_pair(7u, 8u * 1024 * 1024), std::make_pair(10000u, 256u)}) {
+        FLAGS_put_batch_max_rows = limit.first;
+        FLAGS_put_batch_max_bytes = limit.second;
+        auto more_rows = router->GetInsertRows(db, insert, &status);
+        ASSERT_EQ(0, status.code);
+        for (int i = 0; i < 200; i++) {
+            std::string key1 = "hello" + std::to_string(i);
+            std::string key2 = "world" + std::to_string(i % 10);
+            auto row = more_rows->NewRow();
+            ASSERT_TRUE(row->Init(key1.size() + key2.size()));
+            ASSERT_TRUE(row->AppendString(key1));
+            ASSERT_TRUE(row->AppendString(key2));
+            ASSERT_TRUE(row->AppendInt64(limit.first + i));
+            ASSERT_TRUE(row->Build());
+        }
+        ok = router->ExecuteInsertBatch(db, insert, more_rows, &row_status, &status);
+        ASSERT_TRUE(ok) << status.msg;
+        ASSERT_EQ(200u, row_status.size());
+    }
+    FLAGS_put_batch_max_rows = 10000;
+    FLAGS_put_batch_max_bytes = 8 * 1024 * 1024;
+    auto rs = router->ExecuteSQL(db, "select * from " + name + ";", &status);
+    ASSERT_TRUE(rs != nullptr);
+    ASSERT_EQ(600, rs->Size());
+    rs = router->ExecuteSQL(db, "select col1 from " + name + " where col2 = 'world3';", &status);
+    ASSERT_TRUE(rs != nullptr);
+    ASSERT_EQ(60, rs->Size());
+
+    // the insert statement has to be prepared by GetInsertRows first
+    ok = router->ExecuteInsertBatch(db, "insert into " + name + " values('a', ?, ?);", rows, &row_status, &status);
+    ASSERT_FALSE(ok);
+    ok = router->ExecuteDDL(db, "drop table " + name + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = router->DropDB(db, &status);
+    ASSERT_TRUE(ok);
+}
+
+TEST_F(SQLClusterTest, ClusterSelectColumnar) {
+    SQLRouterOptions sql_opt;
+    sql_opt.zk_cluster = mc_->GetZkCluster();
+    sql_opt.zk_path = mc_->GetZkPath();
+    auto router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(router != nullptr);
+    SetOnlineMode(router);
+    sql_opt.columnar_result = true;
+    auto columnar_router = NewClusterSQLRouter(sql_opt);
+    ASSERT_TRUE(columnar_router != nullptr);
+    SetOnlineMode(columnar_router);
+    std::string name = "test" + GenRand();
+    std::string db = "db" + GenRand();
+    ::hybridse::sdk::Status status;
+    bool ok = router->CreateDB(db, &status);
+    ASSERT_TRUE(ok);
+    std::string ddl = "create table " + name +
+                      "(col1 string, col2 bigint, col3 int, col4 double, col5 bool, col6 date,"
+                      "index(key=col1, ts=col2)) options(partitionnum=1);";
+    ok = router->ExecuteDDL(db, ddl, &status);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(router->RefreshCatalog());
+    ASSERT_TRUE(columnar_router->RefreshCatalog());
+    for (int i = 0; i < 20; i++) {
+        std::string col3 = i % 3 == 0 ? "null" : std::to_string(i);
+        std::string insert = "insert into " + name + " values('key', " + std::to_string(1590 + i) + ", " + col3 +
+                             ", " + std::to_string(i * 0.5) + ", " + (i % 2 == 0 ? "true" : "false") +
+                             ", '2022-04-" + std::to_string(10 + i) + "');";
+        ok = router->ExecuteInsert(db, insert, &status);
+        ASSERT_TRUE(ok);
+    }
+    std::string select = "select * from " + name + ";";
+    auto rs = router->ExecuteSQL(db, select, &status);
+    ASSERT_TRUE(rs != nullptr);
+    auto columnar_rs = columnar_router->ExecuteSQL(db, select, &status);
+    ASSERT_TRUE(columnar_rs != nullptr);
+    ASSERT_EQ(20, rs->Size());
+    ASSERT_EQ(rs->Size(), columnar_rs->Size());
+    while (rs->Next()) {
+        ASSERT_TRUE(columnar_rs->Next());
+        for (int i = 0; i < 6; i++) {
+            ASSERT_EQ(rs->IsNULL(i), columnar_rs->IsNULL(i));
+        }
+        ASSERT_EQ(rs->GetStringUnsafe(0), columnar_rs->GetStringUnsafe(0));
+        ASSERT_EQ(rs->GetInt64Unsafe(1), columnar_rs->GetInt64Unsafe(1));
+        if (!rs->IsNULL(2)) {
+            ASSERT_EQ(rs->GetInt32Unsafe(2), columnar_rs->GetInt32Unsafe(2));
+        }
+        ASSERT_EQ(rs->GetDoubleUnsafe(3), columnar_rs->GetDoubleUnsafe(3));
+        ASSERT_EQ(rs->GetBoolUnsafe(4), columnar_rs->GetBoolUnsafe(4));
+        int32_t year = 0, month = 0, day = 0;
+        ASSERT_TRUE(columnar_rs->GetDate(5, &year, &month, &day));
+        ASSERT_EQ(2022, year);
+        ASSERT_EQ(4, month);
+        ASSERT_EQ(rs->GetDateUnsafe(5), columnar_rs->GetDateUnsafe(5));
+    }
+    ASSERT_FALSE(columnar_rs->Next());
+    ok = router->ExecuteDDL(db, "drop table " + name + ";", &status);
+    ASSERT_TRUE(ok);
+    ok = router->DropDB(db, &status);
+    ASSERT_TRUE(ok);
+}
+
 TEST_F(SQLClusterTest, ClusterInsertWithColumnDefaultValue) {
     SQLRouterOptions sql_opt;
     sql_opt.zk_cluster = mc_->GetZkCluster();
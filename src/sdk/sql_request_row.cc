@@ -437,8 +437,11 @@ bool SQLRequestRowBatch::AddRow(std::shared_ptr<SQLRequestRow> row) {
         return false;
     }
     const std::string& row_str = row->GetRow();
-    int8_t* input_buf = reinterpret_cast<int8_t*>(const_cast<char*>(&row_str[0]));
-    size_t input_size = row_str.size();
+    return AddRow(reinterpret_cast<const int8_t*>(row_str.data()), row_str.size());
+}
+
+bool SQLRequestRowBatch::AddRow(const int8_t* buf, size_t input_size) {
+    int8_t* input_buf = const_cast<int8_t*>(buf);
 
     // non-common
     if (common_column_indices_.empty() ||
@@ -40,6 +40,8 @@ struct BasicRouterOptions {
     bool enable_debug = false;
     uint32_t max_sql_cache_size = 10;
     uint32_t request_timeout = 60000;
+    // read the results of the batch queries in columnar encoding, which saves decoding the rows one by one
+    bool columnar_result = false;
 };
 
 struct SQLRouterOptions : BasicRouterOptions {
@@ -98,6 +100,13 @@ class SQLRouter {
     virtual bool ExecuteInsert(const std::string& db, const std::string& sql,
                                std::shared_ptr<openmldb::sdk::SQLInsertRows> row, hybridse::sdk::Status* status) = 0;
 
+    // insert the rows with one put request to each partition leader, the requests are sent in parallel.
+    // row_status gets the result of each row, the call fails if any row fails
+    virtual bool ExecuteInsertBatch(const std::string& db, const std::string& sql,
+                                    std::shared_ptr<openmldb::sdk::SQLInsertRows> rows,
+                                    std::vector<hybridse::sdk::Status>* row_status,
+                                    hybridse::sdk::Status* status) = 0;
+
     virtual std::shared_ptr<openmldb::sdk::TableReader> GetTableReader() = 0;
 
     virtual std::shared_ptr<ExplainInfo> Explain(const std::string& db, const std::string& sql,
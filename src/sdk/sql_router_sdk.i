@@ -81,3 +81,4 @@ using openmldb::sdk::TableReader;
 %template(ColumnDescVector) std::vector<std::pair<std::string, hybridse::sdk::DataType>>;
 %template(TableColumnDescPair) std::pair<std::string, std::vector<std::pair<std::string, hybridse::sdk::DataType>>>;
 %template(TableColumnDescPairVector) std::vector<std::pair<std::string, std::vector<std::pair<std::string, hybridse::sdk::DataType>>>>;
+%template(VectorStatus) std::vector<hybridse::sdk::Status>;
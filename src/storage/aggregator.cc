@@ -21,6 +21,7 @@
 
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
+#include "base/hash.h"
 #include "base/slice.h"
 #include "base/strings.h"
 #include "common/timer.h"
@@ -28,11 +29,28 @@
 #include "storage/table.h"
 
 DECLARE_bool(binlog_notify_on_put);
+DECLARE_uint32(aggr_buffer_shard_cnt);
 namespace openmldb {
 namespace storage {
 
 using ::openmldb::base::StringCompare;
 
+static const uint32_t SEED = 0xe17a1465;
+
+static bool IsSketchAggrType(AggrType type) {
+    switch (type) {
+        case AggrType::kDistinctCount:
+        case AggrType::kMedian:
+        case AggrType::kVarSamp:
+        case AggrType::kVarPop:
+        case AggrType::kStddev:
+        case AggrType::kStddevPop:
+            return true;
+        default:
+            return false;
+    }
+}
+
 std::string AggrStatToString(AggrStat type) {
     std::string output;
     switch (type) {
@@ -73,6 +91,10 @@ Aggregator::Aggregator(const ::openmldb::api::TableMeta& base_meta, const ::open
       base_row_view_(base_table_schema_),
       aggr_row_view_(aggr_table_schema_),
       row_builder_(aggr_table_schema_) {
+    uint32_t shard_cnt = std::max(FLAGS_aggr_buffer_shard_cnt, 1u);
+    for (uint32_t i = 0; i < shard_cnt; i++) {
+        buffer_shards_.emplace_back(std::make_unique<BufferShard>());
+    }
     for (int i = 0; i < base_meta.column_desc().size(); i++) {
         if (base_meta.column_desc(i).name() == aggr_col_) {
             aggr_col_idx_ = i;
@@ -122,24 +144,7 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
         base_row_view_.GetStrValue(row_ptr, filter_col_idx_, &filter_key);
     }
 
-    AggrBufferLocked* aggr_buffer_lock;
-    {
-        std::lock_guard<std::mutex> lock(mu_);
-        auto it = aggr_buffer_map_.find(key);
-        if (it == aggr_buffer_map_.end()) {
-            auto insert_pair = aggr_buffer_map_[key].insert(std::make_pair(filter_key, AggrBufferLocked{}));
-            aggr_buffer_lock = &insert_pair.first->second;
-        } else {
-            auto filter_it = it->second.find(filter_key);
-            if (filter_it == it->second.end()) {
-                auto insert_pair = it->second.emplace(filter_key, AggrBufferLocked{});
-                aggr_buffer_lock = &insert_pair.first->second;
-            } else {
-                aggr_buffer_lock = &filter_it->second;
-            }
-        }
-    }
-
+    AggrBufferLocked* aggr_buffer_lock = GetOrCreateAggrBuffer(key, filter_key);
     std::unique_lock<std::mutex> lock(*aggr_buffer_lock->mu_);
     AggrBuffer& aggr_buffer = aggr_buffer_lock->buffer_;
 
@@ -155,6 +160,11 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
     if (CheckBufferFilled(cur_ts, aggr_buffer.ts_end_, aggr_buffer.aggr_cnt_)) {
         AggrBuffer flush_buffer = aggr_buffer;
         int64_t latest_ts = aggr_buffer.ts_end_ + 1;
+        if (window_type_ == WindowType::kRowsRange && cur_ts > latest_ts) {
+            // skip the empty buckets, so that the new bucket covers the current row and the buckets of
+            // all sizes stay aligned, e.g. an 1h bucket never crosses the boundary of an 1d one
+            latest_ts += (cur_ts - latest_ts) / window_size_ * window_size_;
+        }
         uint64_t latest_binlog = aggr_buffer.binlog_offset_ + 1;
         aggr_buffer.clear();
         aggr_buffer.ts_begin_ = latest_ts;
@@ -205,18 +215,21 @@ bool Aggregator::Update(const std::string& key, const std::string& row, const ui
 
 bool Aggregator::FlushAll() {
     // TODO(nauta): optimize the flush process
-    std::unique_lock<std::mutex> lock(mu_);
     std::unordered_map<std::string, std::unordered_map<std::string, AggrBuffer>> flushed_buffer_map;
-    for (auto& it : aggr_buffer_map_) {
-        for (auto& filter_it : it.second) {
-            auto& aggr_buffer = filter_it.second.buffer_;
-            if (aggr_buffer.aggr_cnt_ == 0) {
-                continue;
+    for (auto& shard : buffer_shards_) {
+        std::lock_guard<std::mutex> lock(shard->mu);
+        for (auto& it : shard->aggr_buffer_map) {
+            for (auto& filter_it : it.second) {
+                // Update modifies the buffer and its sketch with only the lock of the buffer held
+                std::lock_guard<std::mutex> buffer_lock(*filter_it.second.mu_);
+                auto& aggr_buffer = filter_it.second.buffer_;
+                if (aggr_buffer.aggr_cnt_ == 0) {
+                    continue;
+                }
+                flushed_buffer_map[it.first].emplace(filter_it.first, aggr_buffer);
             }
-            flushed_buffer_map[it.first].emplace(filter_it.first, aggr_buffer);
         }
     }
-    lock.unlock();
     for (auto& it : flushed_buffer_map) {
         for (auto& filter_it : it.second) {
             if (!FlushAggrBuffer(it.first, filter_it.first, filter_it.second)) {
@@ -257,8 +270,7 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
         if (is_null == 1) {
             filter_key.clear();
         }
-        auto insert_pair = aggr_buffer_map_[pk].insert(std::make_pair(filter_key, AggrBufferLocked{}));
-        auto& buffer = insert_pair.first->second.buffer_;
+        auto& buffer = GetOrCreateAggrBuffer(pk, filter_key)->buffer_;
         auto val = it->GetValue();
         int8_t* aggr_row_ptr = reinterpret_cast<int8_t*>(const_cast<char*>(val.data()));
         bool ok = GetAggrBufferFromRowView(aggr_row_view_, aggr_row_ptr, &buffer);
@@ -350,15 +362,32 @@ bool Aggregator::Init(std::shared_ptr<LogReplicator> base_replicator) {
 bool Aggregator::GetAggrBuffer(const std::string& key, AggrBuffer** buffer) { return GetAggrBuffer(key, "", buffer); }
 
 bool Aggregator::GetAggrBuffer(const std::string& key, const std::string& filter_key, AggrBuffer** buffer) {
-    std::lock_guard<std::mutex> lock(mu_);
-    auto it = aggr_buffer_map_.find(key);
-    if (it == aggr_buffer_map_.end()) {
+    auto shard = GetBufferShard(key);
+    std::lock_guard<std::mutex> lock(shard->mu);
+    auto it = shard->aggr_buffer_map.find(key);
+    if (it == shard->aggr_buffer_map.end()) {
         return false;
     }
-    *buffer = &aggr_buffer_map_[key][filter_key].buffer_;
+    *buffer = &it->second[filter_key].buffer_;
     return true;
 }
 
+Aggregator::BufferShard* Aggregator::GetBufferShard(const std::string& key) {
+    uint32_t idx = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % buffer_shards_.size();
+    return buffer_shards_[idx].get();
+}
+
+AggrBufferLocked* Aggregator::GetOrCreateAggrBuffer(const std::string& key, const std::string& filter_key) {
+    auto shard = GetBufferShard(key);
+    std::lock_guard<std::mutex> lock(shard->mu);
+    auto& filter_map = shard->aggr_buffer_map[key];
+    auto it = filter_map.find(filter_key);
+    if (it == filter_map.end()) {
+        it = filter_map.emplace(filter_key, AggrBufferLocked{}).first;
+    }
+    return &it->second;
+}
+
 bool Aggregator::GetAggrBufferFromRowView(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* buffer) {
     if (buffer == nullptr) {
         return false;
@@ -390,7 +419,8 @@ bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filt
     row_builder_.SetTimestamp(row_ptr, 1, buffer.ts_begin_);
     row_builder_.SetTimestamp(row_ptr, 2, buffer.ts_end_);
     row_builder_.SetInt32(row_ptr, 3, buffer.aggr_cnt_);
-    if ((aggr_type_ == AggrType::kMax || aggr_type_ == AggrType::kMin) && buffer.AggrValEmpty()) {
+    bool null_if_empty = aggr_type_ == AggrType::kMax || aggr_type_ == AggrType::kMin || IsSketchAggrType(aggr_type_);
+    if (null_if_empty && buffer.AggrValEmpty()) {
         row_builder_.SetNULL(row_ptr, row_size, 4);
     } else {
         row_builder_.SetString(row_ptr, row_size, 4, aggr_val.c_str(), aggr_val.size());
@@ -403,8 +433,10 @@ bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filt
     }
 
     int64_t time = ::baidu::common::timer::get_micros() / 1000;
-    dimensions_.Mutable(0)->set_key(key);
-    bool ok = aggr_table_->Put(time, encoded_row, dimensions_);
+    // the buffers of different keys are flushed concurrently
+    Dimensions dimensions = dimensions_;
+    dimensions.Mutable(0)->set_key(key);
+    bool ok = aggr_table_->Put(time, encoded_row, dimensions);
     if (!ok) {
         PDLOG(ERROR, "Aggregator put failed");
         return false;
@@ -415,7 +447,7 @@ bool Aggregator::FlushAggrBuffer(const std::string& key, const std::string& filt
     entry.set_ts(time);
     entry.set_value(encoded_row);
     entry.set_term(aggr_replicator_->GetLeaderTerm());
-    entry.mutable_dimensions()->CopyFrom(dimensions_);
+    entry.mutable_dimensions()->CopyFrom(dimensions);
     aggr_replicator_->AppendEntry(entry);
     if (FLAGS_binlog_notify_on_put) {
         aggr_replicator_->Notify();
@@ -981,6 +1013,154 @@ bool AvgAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
     return true;
 }
 
+SketchAggregator::SketchAggregator(const ::openmldb::api::TableMeta& base_meta,
+                                   const ::openmldb::api::TableMeta& aggr_meta, std::shared_ptr<Table> aggr_table,
+                                   std::shared_ptr<LogReplicator> aggr_replicator, const uint32_t& index_pos,
+                                   const std::string& aggr_col, const AggrType& aggr_type, const std::string& ts_col,
+                                   WindowType window_tpye, uint32_t window_size)
+    : Aggregator(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos, aggr_col, aggr_type, ts_col, window_tpye,
+                 window_size) {}
+
+std::unique_ptr<::hybridse::base::Sketch> SketchAggregator::NewSketch() const {
+    switch (GetAggrType()) {
+        case AggrType::kDistinctCount:
+            return std::make_unique<::hybridse::base::HyperLogLog>();
+        case AggrType::kMedian:
+            return std::make_unique<::hybridse::base::TDigest>();
+        default:
+            return std::make_unique<::hybridse::base::Moments>();
+    }
+}
+
+bool SketchAggregator::UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) {
+    if (row_view.IsNULL(row_ptr, aggr_col_idx_)) {
+        return true;
+    }
+    if (!aggr_buffer->sketch_) {
+        aggr_buffer->sketch_ = NewSketch();
+    }
+    if (GetAggrType() == AggrType::kDistinctCount) {
+        // the values are hashed as the same types as the query side does, see vm/aggregator.h
+        auto hll = static_cast<::hybridse::base::HyperLogLog*>(aggr_buffer->sketch_.get());
+        switch (aggr_col_type_) {
+            case DataType::kSmallInt: {
+                int16_t val;
+                row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+                hll->AddValue(val);
+                break;
+            }
+            case DataType::kDate:
+            case DataType::kInt: {
+                int32_t val;
+                row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+                hll->AddValue(val);
+                break;
+            }
+            case DataType::kTimestamp:
+            case DataType::kBigInt: {
+                int64_t val;
+                row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+                hll->AddValue(val);
+                break;
+            }
+            case DataType::kFloat: {
+                float val;
+                row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+                hll->AddValue(val);
+                break;
+            }
+            case DataType::kDouble: {
+                double val;
+                row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+                hll->AddValue(val);
+                break;
+            }
+            case DataType::kString:
+            case DataType::kVarchar: {
+                char* ch = NULL;
+                uint32_t ch_length = 0;
+                row_view.GetValue(row_ptr, aggr_col_idx_, &ch, &ch_length);
+                hll->AddString(ch, ch_length);
+                break;
+            }
+            default: {
+                PDLOG(ERROR, "Unsupported data type");
+                return false;
+            }
+        }
+        aggr_buffer->non_null_cnt_++;
+        return true;
+    }
+
+    double val;
+    switch (aggr_col_type_) {
+        case DataType::kSmallInt: {
+            int16_t origin_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &origin_val);
+            val = origin_val;
+            break;
+        }
+        case DataType::kInt: {
+            int32_t origin_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &origin_val);
+            val = origin_val;
+            break;
+        }
+        case DataType::kBigInt: {
+            int64_t origin_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &origin_val);
+            val = origin_val;
+            break;
+        }
+        case DataType::kFloat: {
+            float origin_val;
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &origin_val);
+            val = origin_val;
+            break;
+        }
+        case DataType::kDouble: {
+            row_view.GetValue(row_ptr, aggr_col_idx_, aggr_col_type_, &val);
+            break;
+        }
+        default: {
+            PDLOG(ERROR, "Unsupported data type");
+            return false;
+        }
+    }
+    if (GetAggrType() == AggrType::kMedian) {
+        static_cast<::hybridse::base::TDigest*>(aggr_buffer->sketch_.get())->Add(val);
+    } else {
+        static_cast<::hybridse::base::Moments*>(aggr_buffer->sketch_.get())->Add(val);
+    }
+    aggr_buffer->non_null_cnt_++;
+    return true;
+}
+
+bool SketchAggregator::EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) {
+    if (!buffer.sketch_) {
+        aggr_val->clear();
+        return true;
+    }
+    buffer.sketch_->Encode(aggr_val);
+    return true;
+}
+
+bool SketchAggregator::DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) {
+    char* aggr_val = NULL;
+    uint32_t ch_length = 0;
+    if (aggr_row_view_.GetValue(row_ptr, 4, &aggr_val, &ch_length) == 1) {  // null value
+        return true;
+    }
+    if (!buffer->sketch_) {
+        buffer->sketch_ = NewSketch();
+    }
+    if (!buffer->sketch_->Decode(aggr_val, ch_length)) {
+        PDLOG(ERROR, "Decode sketch failed");
+        return false;
+    }
+    return true;
+}
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              const ::openmldb::api::TableMeta& aggr_meta,
                                              std::shared_ptr<Table> aggr_table,
@@ -1050,6 +1230,18 @@ std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& b
         return std::make_shared<CountWhereAggregator>(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos,
                                                       aggr_col, AggrType::kCountWhere, ts_col, window_type, window_size,
                                                       filter_col);
+    } else if (aggr_type == "distinct_count" || aggr_type == "median" || aggr_type == "var_samp" ||
+               aggr_type == "var_pop" || aggr_type == "stddev" || aggr_type == "stddev_pop") {
+        static const std::unordered_map<std::string, AggrType> sketch_types = {
+            {"distinct_count", AggrType::kDistinctCount},
+            {"median", AggrType::kMedian},
+            {"var_samp", AggrType::kVarSamp},
+            {"var_pop", AggrType::kVarPop},
+            {"stddev", AggrType::kStddev},
+            {"stddev_pop", AggrType::kStddevPop}};
+        return std::make_shared<SketchAggregator>(base_meta, aggr_meta, aggr_table, aggr_replicator, index_pos,
+                                                  aggr_col, sketch_types.at(aggr_type), ts_col, window_type,
+                                                  window_size);
     } else {
         PDLOG(ERROR, "Unsupported aggregate function type");
         return std::shared_ptr<Aggregator>();
@@ -23,6 +23,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "base/fe_sketch.h"
 #include "codec/codec.h"
 #include "proto/tablet.pb.h"
 #include "proto/type.pb.h"
@@ -44,6 +45,12 @@ enum class AggrType {
     kCount = 4,
     kAvg = 5,
     kCountWhere = 6,
+    kDistinctCount = 7,
+    kMedian = 8,
+    kVarSamp = 9,
+    kVarPop = 10,
+    kStddev = 11,
+    kStddevPop = 12,
 };
 
 enum class WindowType {
@@ -76,6 +83,8 @@ class AggrBuffer {
     int64_t non_null_cnt_;
     int32_t aggr_cnt_;
     DataType data_type_;
+    // the aggr val of distinct_count, median and the variances, created by the first update
+    std::unique_ptr<::hybridse::base::Sketch> sketch_;
     AggrBuffer() : aggr_val_(), ts_begin_(-1), ts_end_(0), binlog_offset_(0), non_null_cnt_(0), aggr_cnt_(0) {}
     AggrBuffer(const AggrBuffer& buffer) {
         memcpy(&aggr_val_, &buffer.aggr_val_, sizeof(aggr_val_));
@@ -85,6 +94,9 @@ class AggrBuffer {
         binlog_offset_ = buffer.binlog_offset_;
         non_null_cnt_ = buffer.non_null_cnt_;
         data_type_ = buffer.data_type_;
+        if (buffer.sketch_) {
+            sketch_ = buffer.sketch_->Clone();
+        }
         if (data_type_ == DataType::kString || data_type_ == DataType::kVarchar) {
             if (buffer.aggr_val_.vstring.data != NULL) {
                 aggr_val_.vstring.data = new char[buffer.aggr_val_.vstring.len];
@@ -101,13 +113,16 @@ class AggrBuffer {
             }
         }
         memset(&aggr_val_, 0, sizeof(aggr_val_));
+        if (sketch_) {
+            sketch_->Clear();
+        }
         ts_begin_ = -1;
         ts_end_ = 0;
         aggr_cnt_ = 0;
         binlog_offset_ = 0;
         non_null_cnt_ = 0;
     }
-    bool AggrValEmpty() const { return non_null_cnt_ == 0; }
+    bool AggrValEmpty() const { return non_null_cnt_ == 0 && (!sketch_ || sketch_->Empty()); }
 };
 struct AggrBufferLocked {
     std::unique_ptr<std::mutex> mu_;
@@ -153,7 +168,13 @@ class Aggregator {
     codec::Schema aggr_table_schema_;
 
     using FilterMap = std::unordered_map<std::string, AggrBufferLocked>;  // filter_column -> aggregator buffer
-    std::unordered_map<std::string, FilterMap> aggr_buffer_map_;          // key -> filter_map
+    // the buffers are sharded by key into aggr_buffer_shard_cnt shards, so that the writers of different keys only
+    // contend on the lock of a shard while looking up their buffers
+    struct BufferShard {
+        std::mutex mu;
+        std::unordered_map<std::string, FilterMap> aggr_buffer_map;  // key -> filter_map
+    };
+    std::vector<std::unique_ptr<BufferShard>> buffer_shards_;
     std::mutex mu_;
     DataType aggr_col_type_;
     DataType ts_col_type_;
@@ -168,6 +189,9 @@ class Aggregator {
     bool UpdateFlushedBuffer(const std::string& key, const std::string& filter_key, const int8_t* base_row_ptr,
                              int64_t cur_ts, uint64_t offset);
     bool CheckBufferFilled(int64_t cur_ts, int64_t buffer_end, int32_t buffer_cnt);
+    BufferShard* GetBufferShard(const std::string& key);
+    // find or create the buffer of the key and filter_key, the pointer stays valid until the aggregator is destroyed
+    AggrBufferLocked* GetOrCreateAggrBuffer(const std::string& key, const std::string& filter_key);
 
  private:
     virtual bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) = 0;
@@ -299,6 +323,27 @@ class AvgAggregator : public Aggregator {
     bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
 };
 
+// the aggr val is an encoded sketch of the non-null values in the bucket, which is merged with the other buckets
+// at query time, see base/fe_sketch.h
+class SketchAggregator : public Aggregator {
+ public:
+    SketchAggregator(const ::openmldb::api::TableMeta& base_meta, const ::openmldb::api::TableMeta& aggr_meta,
+                     std::shared_ptr<Table> aggr_table, std::shared_ptr<LogReplicator> aggr_replicator,
+                     const uint32_t& index_pos, const std::string& aggr_col, const AggrType& aggr_type,
+                     const std::string& ts_col, WindowType window_tpye, uint32_t window_size);
+
+    ~SketchAggregator() = default;
+
+ private:
+    bool UpdateAggrVal(const codec::RowView& row_view, const int8_t* row_ptr, AggrBuffer* aggr_buffer) override;
+
+    bool EncodeAggrVal(const AggrBuffer& buffer, std::string* aggr_val) override;
+
+    bool DecodeAggrVal(const int8_t* row_ptr, AggrBuffer* buffer) override;
+
+    std::unique_ptr<::hybridse::base::Sketch> NewSketch() const;
+};
+
 std::shared_ptr<Aggregator> CreateAggregator(const ::openmldb::api::TableMeta& base_meta,
                                              const ::openmldb::api::TableMeta& aggr_meta,
                                              std::shared_ptr<Table> aggr_table,
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/file_util.h"
+#include "benchmark/benchmark.h"
+#include "codec/codec.h"
+#include "codec/schema_codec.h"
+#include "gflags/gflags.h"
+#include "storage/aggregator.h"
+#include "storage/mem_table.h"
+
+DECLARE_uint32(aggr_buffer_shard_cnt);
+
+namespace openmldb {
+namespace storage {
+
+using ::openmldb::codec::SchemaCodec;
+
+static std::shared_ptr<Aggregator> aggr;
+static std::string folder;
+
+static void CreateSumAggregator(uint32_t shard_cnt) {
+    ::openmldb::api::TableMeta base_meta;
+    base_meta.set_name("t0");
+    base_meta.set_tid(1);
+    base_meta.set_pid(0);
+    base_meta.set_mode(::openmldb::api::TableMode::kTableLeader);
+    SchemaCodec::SetColumnDesc(base_meta.add_column_desc(), "id", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(base_meta.add_column_desc(), "ts_col", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(base_meta.add_column_desc(), "col", openmldb::type::DataType::kBigInt);
+    SchemaCodec::SetIndex(base_meta.add_column_key(), "idx", "id", "ts_col", ::openmldb::type::kAbsoluteTime, 0, 0);
+    ::openmldb::api::TableMeta aggr_meta;
+    aggr_meta.set_name("pre_aggr_1");
+    aggr_meta.set_tid(2);
+    aggr_meta.set_pid(0);
+    aggr_meta.set_mode(::openmldb::api::TableMode::kTableLeader);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "key", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "ts_start", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "ts_end", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "num_rows", openmldb::type::DataType::kInt);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "agg_val", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "binlog_offset", openmldb::type::DataType::kBigInt);
+    SchemaCodec::SetColumnDesc(aggr_meta.add_column_desc(), "filter_key", openmldb::type::DataType::kString);
+    SchemaCodec::SetIndex(aggr_meta.add_column_key(), "key", "key", "ts_start", ::openmldb::type::kAbsoluteTime, 0,
+                          0);
+
+    std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_meta);
+    aggr_table->Init();
+    std::map<std::string, std::string> map;
+    folder = "/tmp/aggregator_bm_" + std::to_string(::getpid()) + "/";
+    auto replicator = std::make_shared<LogReplicator>(aggr_table->GetId(), aggr_table->GetPid(), folder, map,
+                                                      ::openmldb::replica::kLeaderNode);
+    replicator->Init();
+    // a shard count of 1 is the aggregator wide lock the buffers were looked up under before sharding
+    FLAGS_aggr_buffer_shard_cnt = shard_cnt;
+    aggr = CreateAggregator(base_meta, aggr_meta, aggr_table, replicator, 0, "col", "sum", "ts_col", "1000");
+    auto base_replicator = std::make_shared<LogReplicator>(base_meta.tid(), base_meta.pid(), folder, map,
+                                                           ::openmldb::replica::kLeaderNode);
+    base_replicator->Init();
+    aggr->Init(base_replicator);
+}
+
+// range(0): the number of shards of the aggregator buffers
+static void BM_AggregatorUpdate(benchmark::State& state) {  // NOLINT
+    if (state.thread_index == 0) {
+        CreateSumAggregator(state.range(0));
+    }
+    ::openmldb::api::TableMeta meta;
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "id", openmldb::type::DataType::kString);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "ts_col", openmldb::type::DataType::kTimestamp);
+    SchemaCodec::SetColumnDesc(meta.add_column_desc(), "col", openmldb::type::DataType::kBigInt);
+    codec::RowBuilder row_builder(meta.column_desc());
+    std::string encoded_row;
+    // every writer puts to keys of its own
+    uint32_t key_num = 8;
+    uint64_t ts = 0;
+    for (auto _ : state) {
+        std::string key = "key" + std::to_string(state.thread_index) + "_" + std::to_string(ts % key_num);
+        uint32_t row_size = row_builder.CalTotalLength(key.size());
+        encoded_row.resize(row_size);
+        row_builder.SetBuffer(reinterpret_cast<int8_t*>(&(encoded_row[0])), row_size);
+        row_builder.AppendString(key.c_str(), key.size());
+        row_builder.AppendTimestamp(ts);
+        row_builder.AppendInt64(ts);
+        aggr->Update(key, encoded_row, ts);
+        ts++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        aggr.reset();
+        ::openmldb::base::RemoveDirRecursive(folder);
+        FLAGS_aggr_buffer_shard_cnt = 64;
+    }
+}
+
+BENCHMARK(BM_AggregatorUpdate)->ArgName("shards")->Arg(1)->Arg(64)->ThreadRange(1, 32)->UseRealTime();
+
+}  // namespace storage
+}  // namespace openmldb
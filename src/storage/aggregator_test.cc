@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <functional>
 #include <map>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "base/file_util.h"
@@ -696,6 +699,86 @@ TEST_F(AggregatorTest, CountWhereAggregatorUpdate) {
     ASSERT_EQ(last_buffer->non_null_cnt_, 0);
 }
 
+template <typename T>
+void CheckSketchAggrResult(std::shared_ptr<Table> aggr_table, AggrBuffer* last_buffer,
+                           const std::function<void(int, const T&)>& check) {
+    ASSERT_EQ(aggr_table->GetRecordCnt(), 50);
+    auto it = aggr_table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    T merged;
+    for (int i = 50 - 1; i >= 0; --i) {
+        ASSERT_TRUE(it->Valid());
+        auto tmp_val = it->GetValue();
+        std::string origin_data = tmp_val.ToString();
+        codec::RowView origin_row_view(aggr_table->GetTableMeta()->column_desc(),
+                                       reinterpret_cast<int8_t*>(const_cast<char*>(origin_data.c_str())),
+                                       origin_data.size());
+        char* ch = NULL;
+        uint32_t ch_length = 0;
+        origin_row_view.GetString(4, &ch, &ch_length);
+        T sketch;
+        ASSERT_TRUE(sketch.Decode(ch, ch_length));
+        check(i, sketch);
+        ASSERT_TRUE(merged.Merge(sketch));
+        it->Next();
+    }
+    ASSERT_TRUE(last_buffer->sketch_ != nullptr);
+    ASSERT_TRUE(merged.Merge(*last_buffer->sketch_));
+    check(-1, merged);
+}
+
+TEST_F(AggregatorTest, SketchAggregatorUpdate) {
+    std::shared_ptr<Aggregator> aggregator;
+    AggrBuffer* last_buffer;
+    std::shared_ptr<Table> aggr_table;
+    // each bucket of 1s holds the values 2i and 2i + 1
+    ASSERT_TRUE(GetUpdatedResult(counter, "col3", "distinct_count", "1s", aggregator, aggr_table, &last_buffer));
+    ASSERT_EQ(aggregator->GetAggrType(), AggrType::kDistinctCount);
+    CheckSketchAggrResult<::hybridse::base::HyperLogLog>(
+        aggr_table, last_buffer, [](int i, const ::hybridse::base::HyperLogLog& hll) {
+            ASSERT_EQ(hll.Estimate(), i < 0 ? 101 : 2);
+        });
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col9", "distinct_count", "1s", aggregator, aggr_table, &last_buffer));
+    CheckSketchAggrResult<::hybridse::base::HyperLogLog>(
+        aggr_table, last_buffer, [](int, const ::hybridse::base::HyperLogLog& hll) {
+            ASSERT_EQ(hll.Estimate(), 2);
+        });
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col5", "median", "1s", aggregator, aggr_table, &last_buffer));
+    ASSERT_EQ(aggregator->GetAggrType(), AggrType::kMedian);
+    CheckSketchAggrResult<::hybridse::base::TDigest>(
+        aggr_table, last_buffer, [](int i, const ::hybridse::base::TDigest& digest) {
+            ASSERT_DOUBLE_EQ(digest.Quantile(0.5), i < 0 ? 50 : i * 2 + 0.5);
+        });
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col7", "var_pop", "1s", aggregator, aggr_table, &last_buffer));
+    ASSERT_EQ(aggregator->GetAggrType(), AggrType::kVarPop);
+    CheckSketchAggrResult<::hybridse::base::Moments>(
+        aggr_table, last_buffer, [](int i, const ::hybridse::base::Moments& moments) {
+            if (i < 0) {
+                ASSERT_EQ(moments.Count(), 101);
+                ASSERT_NEAR(moments.VarPop(), 850, 1e-6);
+            } else {
+                ASSERT_DOUBLE_EQ(moments.Mean(), i * 2 + 0.5);
+                ASSERT_DOUBLE_EQ(moments.VarPop(), 0.25);
+            }
+        });
+    counter += 2;
+    ASSERT_TRUE(GetUpdatedResult(counter, "col_null", "stddev", "1s", aggregator, aggr_table, &last_buffer));
+    ASSERT_EQ(aggregator->GetAggrType(), AggrType::kStddev);
+    ASSERT_EQ(aggr_table->GetRecordCnt(), 50);
+    auto it = aggr_table->NewTraverseIterator(0);
+    it->SeekToFirst();
+    ASSERT_TRUE(it->Valid());
+    std::string origin_data = it->GetValue().ToString();
+    codec::RowView origin_row_view(aggr_table->GetTableMeta()->column_desc(),
+                                   reinterpret_cast<int8_t*>(const_cast<char*>(origin_data.c_str())),
+                                   origin_data.size());
+    ASSERT_TRUE(origin_row_view.IsNULL(4));
+    ASSERT_TRUE(last_buffer->AggrValEmpty());
+}
+
 TEST_F(AggregatorTest, OutOfOrder) {
     std::map<std::string, std::string> map;
     std::string folder = "/tmp/" + GenRand() + "/";
@@ -772,6 +855,72 @@ TEST_F(AggregatorTest, FlushAll) {
     ASSERT_EQ(last_buffer->aggr_cnt_, 1);
 }
 
+TEST_F(AggregatorTest, ConcurrentUpdate) {
+    uint32_t key_num = 8;
+    uint32_t put_num = 8000;
+    for (uint32_t thread_num : {1, 8, 32}) {
+        ::openmldb::api::TableMeta base_table_meta;
+        base_table_meta.set_tid(counter++);
+        AddDefaultAggregatorBaseSchema(&base_table_meta);
+        ::openmldb::api::TableMeta aggr_table_meta;
+        aggr_table_meta.set_tid(counter++);
+        AddDefaultAggregatorSchema(&aggr_table_meta);
+        std::shared_ptr<Table> aggr_table = std::make_shared<MemTable>(aggr_table_meta);
+        aggr_table->Init();
+        std::map<std::string, std::string> map;
+        std::string folder = "/tmp/" + GenRand() + "/";
+        std::shared_ptr<LogReplicator> replicator = std::make_shared<LogReplicator>(
+            aggr_table->GetId(), aggr_table->GetPid(), folder, map, ::openmldb::replica::kLeaderNode);
+        replicator->Init();
+        auto aggr = CreateAggregator(base_table_meta, aggr_table_meta, aggr_table, replicator, 0, "col3", "sum",
+                                     "ts_col", "100");
+        std::shared_ptr<LogReplicator> base_replicator = std::make_shared<LogReplicator>(
+            base_table_meta.tid(), base_table_meta.pid(), folder, map, ::openmldb::replica::kLeaderNode);
+        base_replicator->Init();
+        ASSERT_TRUE(aggr->Init(base_replicator));
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 0; i < thread_num; i++) {
+            workers.emplace_back([&, i]() {
+                codec::RowBuilder row_builder(base_table_meta.column_desc());
+                std::string encoded_row;
+                for (uint32_t j = 0; j < put_num; j++) {
+                    std::string key = "key" + std::to_string(i) + "_" + std::to_string(j % key_num);
+                    uint32_t row_size = row_builder.CalTotalLength(6 + 3);
+                    encoded_row.resize(row_size);
+                    row_builder.SetBuffer(reinterpret_cast<int8_t*>(&(encoded_row[0])), row_size);
+                    row_builder.AppendString("id1", 3);
+                    row_builder.AppendString("id2", 3);
+                    row_builder.AppendTimestamp(j);
+                    row_builder.AppendInt32(j);
+                    row_builder.AppendInt16(j);
+                    row_builder.AppendInt64(j);
+                    row_builder.AppendFloat(static_cast<float>(j));
+                    row_builder.AppendDouble(static_cast<double>(j));
+                    row_builder.AppendDate(j);
+                    row_builder.AppendString("abc", 3);
+                    row_builder.AppendNULL();
+                    row_builder.AppendInt32(j % 2);
+                    aggr->Update(key, encoded_row, j);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        // every key has put_num / key_num rows, all of the full buckets of 100 rows are flushed
+        ASSERT_EQ(aggr_table->GetRecordCnt(), thread_num * key_num * ((put_num / key_num - 1) / 100));
+        for (uint32_t i = 0; i < thread_num; i++) {
+            for (uint32_t k = 0; k < key_num; k++) {
+                AggrBuffer* buffer;
+                ASSERT_TRUE(aggr->GetAggrBuffer("key" + std::to_string(i) + "_" + std::to_string(k), &buffer));
+                ASSERT_EQ(buffer->aggr_cnt_, 100);
+            }
+        }
+        ::openmldb::base::RemoveDirRecursive(folder);
+    }
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
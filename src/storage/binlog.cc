@@ -148,7 +148,14 @@ bool Binlog::RecoverFromBinlog(std::shared_ptr<Table> table, uint64_t offset, ui
             PDLOG(WARNING, "fail to seek. file[%s] pos[%lu]", full_path.c_str(), pos);
             return false;
         }
-        ::openmldb::log::WriteHandle wh("off", full_path, fd, pos);
+        // the end of a compressed binlog is written in a compressed block
+        std::string compress_type = "off";
+        if (log_reader.GetCompressType() == ::openmldb::log::kZlib) {
+            compress_type = "zlib";
+        } else if (log_reader.GetCompressType() == ::openmldb::log::kSnappy) {
+            compress_type = "snappy";
+        }
+        ::openmldb::log::WriteHandle wh(compress_type, full_path, fd, pos, true);
         wh.EndLog();
         PDLOG(INFO, "append endlog record ok. file[%s]", full_path.c_str());
     }
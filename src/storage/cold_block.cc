@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/cold_block.h"
+
+#include <snappy.h>
+
+namespace openmldb {
+namespace storage {
+
+static void PutVarint64(std::string* dst, uint64_t v) {
+    while (v >= 0x80) {
+        dst->push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    dst->push_back(static_cast<char>(v));
+}
+
+static bool GetVarint64(const char** p, const char* limit, uint64_t* v) {
+    uint64_t result = 0;
+    for (uint32_t shift = 0; shift <= 63 && *p < limit; shift += 7) {
+        uint64_t byte = static_cast<unsigned char>(**p);
+        (*p)++;
+        if (byte & 0x80) {
+            result |= ((byte & 0x7f) << shift);
+        } else {
+            result |= (byte << shift);
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+ColdBlock* ColdBlock::Pack(const std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>& rows) {
+    if (rows.empty()) {
+        return NULL;
+    }
+    // layout: [ts delta][row size][row] ... the first delta is based on max ts
+    std::string raw;
+    uint64_t last_ts = rows.front().first;
+    for (const auto& row : rows) {
+        PutVarint64(&raw, last_ts - row.first);
+        PutVarint64(&raw, row.second.size());
+        raw.append(row.second.data(), row.second.size());
+        last_ts = row.first;
+    }
+    auto* block = new ColdBlock(rows.front().first, rows.back().first, rows.size());
+    snappy::Compress(raw.data(), raw.size(), &block->compressed_);
+    block->compressed_.shrink_to_fit();
+    return block;
+}
+
+bool ColdBlock::Unpack(std::string* buf, std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>* rows) const {
+    if (buf == NULL || rows == NULL) {
+        return false;
+    }
+    if (!snappy::Uncompress(compressed_.data(), compressed_.size(), buf)) {
+        return false;
+    }
+    rows->reserve(rows->size() + count_);
+    const char* p = buf->data();
+    const char* limit = p + buf->size();
+    uint64_t ts = max_ts_;
+    for (uint32_t i = 0; i < count_; i++) {
+        uint64_t delta = 0;
+        uint64_t size = 0;
+        if (!GetVarint64(&p, limit, &delta) || !GetVarint64(&p, limit, &size) ||
+            size > static_cast<uint64_t>(limit - p)) {
+            return false;
+        }
+        ts -= delta;
+        rows->emplace_back(ts, ::openmldb::base::Slice(p, size));
+        p += size;
+    }
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_COLD_BLOCK_H_
+#define SRC_STORAGE_COLD_BLOCK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+// the max row count of a cold block, the newest block of a key is merged with
+// the rows frozen later until it is full
+static const uint32_t MAX_COLD_BLOCK_ROW_CNT = 4096;
+
+// An immutable block holding the frozen rows of a key. The rows are sorted by
+// ts in desc order, the ts are delta encoded and the payload is compressed
+// with snappy. The blocks of a key are linked by next
+class ColdBlock {
+ public:
+    // rows must be sorted by ts in desc order and not empty
+    static ColdBlock* Pack(const std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>& rows);
+
+    // decompress the rows, the returned slices reference to buf
+    bool Unpack(std::string* buf, std::vector<std::pair<uint64_t, ::openmldb::base::Slice>>* rows) const;
+
+    ColdBlock(const ColdBlock&) = delete;
+    ColdBlock& operator=(const ColdBlock&) = delete;
+
+    inline uint64_t GetMaxTs() const { return max_ts_; }
+    inline uint64_t GetMinTs() const { return min_ts_; }
+    inline uint32_t GetCount() const { return count_; }
+    // the memory occupied by the block
+    inline uint64_t GetByteSize() const { return sizeof(ColdBlock) + compressed_.capacity(); }
+
+ public:
+    ColdBlock* next;
+
+ private:
+    ColdBlock(uint64_t max_ts, uint64_t min_ts, uint32_t count)
+        : next(NULL), max_ts_(max_ts), min_ts_(min_ts), count_(count), compressed_() {}
+
+ private:
+    uint64_t max_ts_;
+    uint64_t min_ts_;
+    uint32_t count_;
+    std::string compressed_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_COLD_BLOCK_H_
@@ -15,6 +15,7 @@
  */
 
 #include "storage/disk_table.h"
+#include <algorithm>
 #include <utility>
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
@@ -35,8 +36,19 @@ namespace storage {
 
 static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
+static rocksdb::BlockBasedTableOptions table_option_template;
 static bool options_template_initialized = false;
 
+// the names of StorageOptions.compression_per_level and the names of rocksdb
+static const std::map<std::string, std::pair<rocksdb::CompressionType, std::string>> COMPRESSION_MAP = {
+    {"none", {rocksdb::kNoCompression, "kNoCompression"}},
+    {"snappy", {rocksdb::kSnappyCompression, "kSnappyCompression"}},
+    {"zlib", {rocksdb::kZlibCompression, "kZlibCompression"}},
+    {"lz4", {rocksdb::kLZ4Compression, "kLZ4Compression"}},
+    {"lz4hc", {rocksdb::kLZ4HCCompression, "kLZ4HCCompression"}},
+    {"zstd", {rocksdb::kZSTD, "kZSTD"}},
+};
+
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
                      uint64_t ttl, ::openmldb::type::TTLType ttl_type, ::openmldb::common::StorageMode storage_mode,
                      const std::string& table_path)
@@ -122,6 +134,7 @@ void DiskTable::initOptionTemplate() {
     }
     if (FLAGS_verify_compression) table_options.verify_compression = true;
 #endif
+    table_option_template = table_options;
     ssd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
     // HDD options template
     hdd_option_template.max_open_files = -1;
@@ -146,10 +159,59 @@ void DiskTable::initOptionTemplate() {
     options_template_initialized = true;
 }
 
+bool DiskTable::CheckStorageOptions(const ::openmldb::common::StorageOptions& storage_options, std::string* msg) {
+    for (const auto& name : storage_options.compression_per_level()) {
+        if (COMPRESSION_MAP.find(name) == COMPRESSION_MAP.end()) {
+            *msg = "unknown compression " + name;
+            return false;
+        }
+    }
+    return true;
+}
+
 bool DiskTable::InitColumnFamilyDescriptor() {
     cf_ds_.clear();
     cf_ds_.push_back(
         rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions()));
+    const auto& storage_options = table_meta_->storage_options();
+    std::string msg;
+    if (!CheckStorageOptions(storage_options, &msg)) {
+        PDLOG(WARNING, "ignore the compression of the storage options, %s. tid %u pid %u", msg.c_str(), id_, pid_);
+    }
+    std::vector<rocksdb::CompressionType> compression_per_level;
+    for (const auto& name : storage_options.compression_per_level()) {
+        auto it = COMPRESSION_MAP.find(name);
+        if (it == COMPRESSION_MAP.end()) {
+            compression_per_level.clear();
+            break;
+        }
+        compression_per_level.push_back(it->second.first);
+    }
+    rocksdb::BlockBasedTableOptions table_options = table_option_template;
+    bool custom_table_options = false;
+    if (storage_options.block_cache_mb() > 0) {
+        block_cache_ = rocksdb::NewLRUCache(static_cast<size_t>(storage_options.block_cache_mb()) << 20,
+                                            FLAGS_block_cache_shardbits);
+        table_options.block_cache = block_cache_;
+        custom_table_options = true;
+    }
+    if (storage_options.bloom_bits_per_key() > 0) {
+        // whole_key_filtering is false, so the filter is built on the prefix of KeyTsPrefixTransform
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(storage_options.bloom_bits_per_key(), false));
+        custom_table_options = true;
+    }
+    if (storage_options.partition_index_filters()) {
+        table_options.index_type = rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+        table_options.partition_filters = storage_options.bloom_bits_per_key() > 0;
+        table_options.cache_index_and_filter_blocks = true;
+        table_options.cache_index_and_filter_blocks_with_high_priority = true;
+        table_options.pin_top_level_index_and_filter = true;
+        custom_table_options = true;
+    }
+    if (storage_options.row_cache_mb() > 0) {
+        row_cache_ = rocksdb::NewLRUCache(static_cast<size_t>(storage_options.row_cache_mb()) << 20,
+                                          FLAGS_block_cache_shardbits);
+    }
     auto inner_indexs = table_index_.GetAllInnerIndex();
     for (const auto& inner_index : *inner_indexs) {
         rocksdb::ColumnFamilyOptions cfo;
@@ -162,6 +224,12 @@ bool DiskTable::InitColumnFamilyDescriptor() {
         }
         cfo.comparator = &cmp_;
         cfo.prefix_extractor.reset(new KeyTsPrefixTransform());
+        if (custom_table_options) {
+            cfo.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+        }
+        if (!compression_per_level.empty()) {
+            cfo.compression_per_level = compression_per_level;
+        }
         const auto& indexs = inner_index->GetIndex();
         auto index_def = indexs.front();
         if (index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsoluteTime ||
@@ -191,6 +259,7 @@ bool DiskTable::Init() {
     options_.create_if_missing = true;
     options_.error_if_exists = false;
     options_.create_missing_column_families = true;
+    options_.row_cache = row_cache_;
     rocksdb::Status s = rocksdb::DB::Open(options_, path, cf_ds_, &cf_hs_, &db_);
     if (!s.ok()) {
         PDLOG(WARNING, "rocksdb open failed. tid %u pid %u error %s", id_, pid_, s.ToString().c_str());
@@ -315,6 +384,63 @@ bool DiskTable::Get(uint32_t idx, const std::string& pk, uint64_t ts, std::strin
 
 bool DiskTable::Get(const std::string& pk, uint64_t ts, std::string& value) { return Get(0, pk, ts, value); }
 
+bool DiskTable::GetLatest(uint32_t idx, const std::vector<std::string>& pks, std::vector<bool>* found,
+                          std::vector<uint64_t>* ts, std::vector<std::string>* values) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx);
+    if (!index_def || !index_def->IsReady()) {
+        PDLOG(WARNING, "index %u not found in table, tid %u pid %u", idx, id_, pid_);
+        return false;
+    }
+    uint32_t inner_pos = index_def->GetInnerPos();
+    auto inner_index = table_index_.GetInnerIndex(inner_pos);
+    bool has_ts_idx = false;
+    uint32_t ts_idx = 0;
+    if (inner_index && inner_index->GetIndex().size() > 1) {
+        auto ts_col = index_def->GetTsColumn();
+        if (ts_col) {
+            has_ts_idx = true;
+            ts_idx = ts_col->GetId();
+        }
+    }
+    auto ttl = index_def->GetTTL();
+    TTLSt expire_value(GetExpireTime(*ttl), ttl->lat_ttl, ttl->ttl_type);
+    found->assign(pks.size(), false);
+    ts->assign(pks.size(), 0);
+    values->assign(pks.size(), "");
+    std::vector<size_t> order(pks.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&pks](size_t a, size_t b) { return pks[a] < pks[b]; });
+
+    rocksdb::ReadOptions ro = rocksdb::ReadOptions();
+    const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
+    ro.snapshot = snapshot;
+    ro.prefix_same_as_start = true;
+    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(ro, cf_hs_[inner_pos + 1]));
+    std::string cur_pk;
+    for (size_t i : order) {
+        const std::string& pk = pks[i];
+        std::string combine = has_ts_idx ? CombineKeyTs(pk, UINT64_MAX, ts_idx) : CombineKeyTs(pk, UINT64_MAX);
+        it->Seek(rocksdb::Slice(combine));
+        if (!it->Valid()) {
+            continue;
+        }
+        uint64_t cur_ts = 0;
+        uint32_t cur_ts_idx = UINT32_MAX;
+        ParseKeyAndTs(has_ts_idx, it->key(), cur_pk, cur_ts, cur_ts_idx);
+        if (cur_pk != pk || (has_ts_idx && cur_ts_idx != ts_idx) || expire_value.IsExpired(cur_ts, 1)) {
+            continue;
+        }
+        (*found)[i] = true;
+        (*ts)[i] = cur_ts;
+        (*values)[i].assign(it->value().data(), it->value().size());
+    }
+    it.reset();
+    db_->ReleaseSnapshot(snapshot);
+    return true;
+}
+
 void DiskTable::SchedGc() {
     GcHead();
     UpdateTTL();
@@ -1091,6 +1217,58 @@ void DiskTableRowIterator::SeekToFirst() {
 }
 inline bool DiskTableRowIterator::IsSeekable() const { return true; }
 
+bool DiskTable::UpdateStorageOptions(const ::openmldb::common::StorageOptions& storage_options, std::string* msg) {
+    if (!CheckStorageOptions(storage_options, msg)) {
+        return false;
+    }
+    auto table_meta = GetTableMeta();
+    const auto& cur_options = table_meta->storage_options();
+    auto join_compression = [](const ::openmldb::common::StorageOptions& options) {
+        std::string compression;
+        for (int i = 0; i < options.compression_per_level_size(); i++) {
+            if (i > 0) {
+                compression.append(":");
+            }
+            compression.append(COMPRESSION_MAP.at(options.compression_per_level(i)).second);
+        }
+        return compression;
+    };
+    std::string compression = join_compression(storage_options);
+    std::string cur_compression = join_compression(cur_options);
+    if (compression != cur_compression) {
+        // the default column family is not used
+        for (size_t i = 1; i < cf_hs_.size(); i++) {
+            rocksdb::Status s = db_->SetOptions(cf_hs_[i], {{"compression_per_level", compression}});
+            if (s.ok()) {
+                continue;
+            }
+            PDLOG(WARNING, "fail to set compression %s. tid %u pid %u error %s", compression.c_str(), id_, pid_,
+                  s.ToString().c_str());
+            *msg = "fail to set compression: " + s.ToString();
+            // restore the column families set before, the meta is left unchanged
+            for (size_t j = 1; j < i && !cur_compression.empty(); j++) {
+                s = db_->SetOptions(cf_hs_[j], {{"compression_per_level", cur_compression}});
+                if (!s.ok()) {
+                    PDLOG(WARNING, "fail to restore compression %s. tid %u pid %u error %s", cur_compression.c_str(),
+                          id_, pid_, s.ToString().c_str());
+                }
+            }
+            return false;
+        }
+    }
+    if (block_cache_ && storage_options.block_cache_mb() > 0) {
+        block_cache_->SetCapacity(static_cast<size_t>(storage_options.block_cache_mb()) << 20);
+    }
+    if (row_cache_ && storage_options.row_cache_mb() > 0) {
+        row_cache_->SetCapacity(static_cast<size_t>(storage_options.row_cache_mb()) << 20);
+    }
+    auto new_table_meta = std::make_shared<::openmldb::api::TableMeta>(*table_meta);
+    new_table_meta->mutable_storage_options()->CopyFrom(storage_options);
+    std::atomic_store_explicit(&table_meta_, new_table_meta, std::memory_order_release);
+    PDLOG(INFO, "update storage options %s. tid %u pid %u", storage_options.ShortDebugString().c_str(), id_, pid_);
+    return true;
+}
+
 bool DiskTable::DeleteIndex(const std::string& idx_name) {
     // TODO(litongxin)
     return true;
@@ -374,6 +374,13 @@ class DiskTable : public Table {
 
     bool Get(const std::string& pk, uint64_t ts, std::string& value);  // NOLINT
 
+    // get the latest unexpired record of every pk of index idx with one snapshot and one
+    // iterator. The pks are seeked in key order, so that the prefix bloom filter skips the
+    // files without the pk and the consecutive seeks share the cached data blocks.
+    // ts[i] and values[i] are valid only if found[i] is true
+    bool GetLatest(uint32_t idx, const std::vector<std::string>& pks, std::vector<bool>* found,
+                   std::vector<uint64_t>* ts, std::vector<std::string>* values);
+
     bool Delete(const std::string& pk, uint32_t idx) override;
 
     uint64_t GetExpireTime(const TTLSt& ttl_st) override;
@@ -425,12 +432,23 @@ class DiskTable : public Table {
 
     int GetCount(uint32_t index, const std::string& pk, uint64_t& count) override; // NOLINT
 
+    // check the compression names of the storage options
+    static bool CheckStorageOptions(const ::openmldb::common::StorageOptions& storage_options, std::string* msg);
+
+    // apply the storage options online. The dedicated block cache and row cache are resized and
+    // the compression of the column families is changed by SetOptions. The other options, and the
+    // caches which are not created when the table is opened, take effect when the table is loaded again
+    bool UpdateStorageOptions(const ::openmldb::common::StorageOptions& storage_options, std::string* msg);
+
  private:
     rocksdb::DB* db_;
     rocksdb::WriteOptions write_opts_;
     std::vector<rocksdb::ColumnFamilyDescriptor> cf_ds_;
     std::vector<rocksdb::ColumnFamilyHandle*> cf_hs_;
     rocksdb::Options options_;
+    // the dedicated caches of the storage options, null if not configured
+    std::shared_ptr<rocksdb::Cache> block_cache_;
+    std::shared_ptr<rocksdb::Cache> row_cache_;
     KeyTSComparator cmp_;
     std::atomic<uint64_t> offset_;
     std::string table_path_;
@@ -784,6 +784,103 @@ TEST_F(DiskTableTest, CompactFilter) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, GetLatest) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/20_1";
+    DiskTable* table = new DiskTable("t1", 20, 1, mapping, 10, ::openmldb::type::TTLType::kAbsoluteTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    for (int idx = 0; idx < 50; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        for (int k = 0; k < 3; k++) {
+            std::string value = "value" + std::to_string(idx * 10 + k);
+            ASSERT_TRUE(table->Put(key, cur_time - idx - k, value.c_str(), value.size()));
+        }
+    }
+    // the records of test_expired are all expired
+    ASSERT_TRUE(table->Put("test_expired", cur_time - 20 * 60 * 1000, "value", 5));
+    std::vector<std::string> pks = {"test7", "test_none", "test49", "test0", "test_expired", "test7", "test4"};
+    std::vector<bool> found;
+    std::vector<uint64_t> ts;
+    std::vector<std::string> values;
+    ASSERT_TRUE(table->GetLatest(0, pks, &found, &ts, &values));
+    ASSERT_EQ(pks.size(), found.size());
+    for (size_t i = 0; i < pks.size(); i++) {
+        if (pks[i] == "test_none" || pks[i] == "test_expired") {
+            ASSERT_FALSE(found[i]);
+            continue;
+        }
+        ASSERT_TRUE(found[i]) << pks[i];
+        int idx = std::stoi(pks[i].substr(4));
+        ASSERT_EQ(cur_time - idx, ts[i]);
+        ASSERT_EQ("value" + std::to_string(idx * 10), values[i]);
+        std::string value;
+        ASSERT_TRUE(table->Get(pks[i], ts[i], value));
+        ASSERT_EQ(value, values[i]);
+    }
+    ASSERT_FALSE(table->GetLatest(1, pks, &found, &ts, &values));
+    delete table;
+    RemoveData(table_path);
+}
+
+TEST_F(DiskTableTest, StorageOptions) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(21);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsoluteTime, 0, 0);
+    auto storage_options = table_meta.mutable_storage_options();
+    storage_options->set_block_cache_mb(8);
+    storage_options->set_bloom_bits_per_key(10);
+    storage_options->add_compression_per_level("none");
+    storage_options->add_compression_per_level("none");
+    storage_options->set_row_cache_mb(4);
+    storage_options->set_partition_index_filters(true);
+
+    std::string table_path = FLAGS_hdd_root_path + "/21_1";
+    DiskTable* table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    codec::SDKCodec codec(table_meta);
+    for (int idx = 0; idx < 100; idx++) {
+        Dimensions dims;
+        ::openmldb::api::Dimension* dim = dims.Add();
+        dim->set_key("card" + std::to_string(idx));
+        dim->set_idx(0);
+        std::vector<std::string> row = {"card" + std::to_string(idx), std::to_string(1000 + idx)};
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        ASSERT_TRUE(table->Put(1000 + idx, value, dims));
+    }
+    // the records are read from the sst files with the bloom filter
+    table->CompactDB();
+    for (int idx = 0; idx < 100; idx++) {
+        std::string value;
+        ASSERT_TRUE(table->Get(0, "card" + std::to_string(idx), 1000 + idx, value));
+        ASSERT_FALSE(table->Get(0, "card_none" + std::to_string(idx), 1000 + idx, value));
+    }
+
+    std::string msg;
+    ::openmldb::common::StorageOptions new_options;
+    new_options.set_block_cache_mb(16);
+    new_options.add_compression_per_level("none");
+    ASSERT_TRUE(table->UpdateStorageOptions(new_options, &msg));
+    ASSERT_EQ(16u, table->GetTableMeta()->storage_options().block_cache_mb());
+    ASSERT_EQ(1, table->GetTableMeta()->storage_options().compression_per_level_size());
+    new_options.add_compression_per_level("gzip");
+    ASSERT_FALSE(DiskTable::CheckStorageOptions(new_options, &msg));
+    ASSERT_FALSE(table->UpdateStorageOptions(new_options, &msg));
+    ASSERT_EQ(1, table->GetTableMeta()->storage_options().compression_per_level_size());
+    std::string value;
+    ASSERT_TRUE(table->Get(0, "card10", 1010, value));
+    delete table;
+    RemoveData(table_path);
+}
+
 TEST_F(DiskTableTest, CompactFilterMulTs) {
     ::openmldb::api::TableMeta table_meta;
     table_meta.set_tid(11);
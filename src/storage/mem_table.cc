@@ -32,12 +32,24 @@ DECLARE_uint32(key_entry_max_height);
 DECLARE_uint32(absolute_default_skiplist_height);
 DECLARE_uint32(latest_default_skiplist_height);
 DECLARE_uint32(max_traverse_cnt);
+DECLARE_uint32(cold_data_freeze_time);
+DECLARE_uint32(window_aggr_cache_max_mb);
+DECLARE_uint32(gc_incremental_slice_time);
 
 namespace openmldb {
 namespace storage {
 
 static const uint32_t SEED = 0xe17a1465;
 
+// only IncrementalGc of an absolute ttl drains the expire wheel of a segment
+static bool NeedTrackExpire(const std::vector<std::shared_ptr<IndexDef>>& real_index) {
+    if (FLAGS_gc_incremental_slice_time == 0 || real_index.size() != 1) {
+        return false;
+    }
+    auto ttl = real_index[0]->GetTTL();
+    return ttl->ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime && ttl->abs_ttl > 0;
+}
+
 MemTable::MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t seg_cnt,
                    const std::map<std::string, uint32_t>& mapping, uint64_t ttl, ::openmldb::type::TTLType ttl_type)
     : Table(::openmldb::common::StorageMode::kMemory, name, id, pid, ttl * 60 * 1000, true, 60 * 1000, mapping,
@@ -47,18 +59,26 @@ MemTable::MemTable(const std::string& name, uint32_t id, uint32_t pid, uint32_t
       enable_gc_(true),
       record_cnt_(0),
       segment_released_(false),
-      record_byte_size_(0) {}
+      record_byte_size_(0),
+      gc_slice_pos_(0),
+      gc_slicing_(false),
+      has_window_aggr_cache_(false),
+      window_aggr_caches_(std::make_shared<std::vector<std::shared_ptr<WindowAggrCache>>>()) {}
 
 MemTable::MemTable(const ::openmldb::api::TableMeta& table_meta)
     : Table(table_meta.storage_mode(), table_meta.name(), table_meta.tid(), table_meta.pid(), 0, true, 60 * 1000,
             std::map<std::string, uint32_t>(), ::openmldb::type::TTLType::kAbsoluteTime,
             ::openmldb::type::CompressType::kNoCompress),
-      segments_(MAX_INDEX_NUM, NULL) {
+      segments_(MAX_INDEX_NUM, NULL),
+      has_window_aggr_cache_(false),
+      window_aggr_caches_(std::make_shared<std::vector<std::shared_ptr<WindowAggrCache>>>()) {
     seg_cnt_ = 8;
     enable_gc_ = true;
     record_cnt_ = 0;
     segment_released_ = false;
     record_byte_size_ = 0;
+    gc_slice_pos_ = 0;
+    gc_slicing_ = false;
     diskused_ = 0;
     table_meta_ = std::make_shared<::openmldb::api::TableMeta>(table_meta);
 }
@@ -107,12 +127,14 @@ bool MemTable::Init() {
         if (!ts_vec.empty()) {
             for (uint32_t j = 0; j < seg_cnt_; j++) {
                 seg_arr[j] = new Segment(cur_key_entry_max_height, ts_vec);
+                seg_arr[j]->SetTrackExpire(NeedTrackExpire(inner_indexs->at(i)->GetIndex()));
                 PDLOG(INFO, "init %u, %u segment. height %u, ts col num %u. tid %u pid %u", i, j,
                       cur_key_entry_max_height, ts_vec.size(), id_, pid_);
             }
         } else {
             for (uint32_t j = 0; j < seg_cnt_; j++) {
                 seg_arr[j] = new Segment(cur_key_entry_max_height);
+                seg_arr[j]->SetTrackExpire(NeedTrackExpire(inner_indexs->at(i)->GetIndex()));
                 PDLOG(INFO, "init %u, %u segment. height %u tid %u pid %u", i, j, cur_key_entry_max_height, id_, pid_);
             }
         }
@@ -159,8 +181,34 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
         }
         inner_index_key_map.emplace(inner_pos, iter->key());
     }
+    return PutRow(time, value.data(), value.length(), inner_index_key_map);
+}
+
+bool MemTable::Put(uint64_t time, const Slice& value, const std::vector<std::pair<uint32_t, Slice>>& dimensions) {
+    if (dimensions.empty()) {
+        PDLOG(WARNING, "empty dimension. tid %u pid %u", id_, pid_);
+        return false;
+    }
+    if (value.size() < codec::HEADER_LENGTH) {
+        PDLOG(WARNING, "invalid value. tid %u pid %u", id_, pid_);
+        return false;
+    }
+    std::map<int32_t, Slice> inner_index_key_map;
+    for (const auto& dimension : dimensions) {
+        int32_t inner_pos = table_index_.GetInnerIndexPos(dimension.first);
+        if (inner_pos < 0) {
+            PDLOG(WARNING, "invalid dimension. dimension idx %u, tid %u pid %u", dimension.first, id_, pid_);
+            return false;
+        }
+        inner_index_key_map.emplace(inner_pos, dimension.second);
+    }
+    return PutRow(time, value.data(), value.size(), inner_index_key_map);
+}
+
+bool MemTable::PutRow(uint64_t time, const char* value, uint32_t size,
+                      const std::map<int32_t, Slice>& inner_index_key_map) {
     uint32_t real_ref_cnt = 0;
-    const int8_t* data = reinterpret_cast<const int8_t*>(value.data());
+    const int8_t* data = reinterpret_cast<const int8_t*>(value);
     uint8_t version = codec::RowView::GetSchemaVersion(data);
     auto decoder = GetVersionDecoder(version);
     if (decoder == nullptr) {
@@ -194,7 +242,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
     if (ts_map.empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    auto* block = DataBlock::NewBlock(real_ref_cnt, value, size);
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -214,11 +262,31 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
             segment->Put(::openmldb::base::Slice(kv.second), ts_map, block);
         }
     }
+    // read after the row is inserted under the lock of its key, see WaitPut in GetWindowAggr
+    if (has_window_aggr_cache_.load(std::memory_order_relaxed)) {
+        PutWindowAggrCache(inner_index_key_map, ts_map, block->data, *decoder);
+    }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
-    record_byte_size_.fetch_add(GetRecordSize(value.length()));
+    record_byte_size_.fetch_add(GetRecordSize(size));
     return true;
 }
 
+void MemTable::PutWindowAggrCache(const std::map<int32_t, Slice>& inner_index_key_map,
+                                  const std::map<int32_t, uint64_t>& ts_map, const char* data,
+                                  const codec::RowView& decoder) {
+    auto caches = std::atomic_load(&window_aggr_caches_);
+    for (const auto& cache : *caches) {
+        auto key_iter = inner_index_key_map.find(cache->GetInnerPos());
+        auto ts_iter = ts_map.find(cache->GetTsColId());
+        if (key_iter == inner_index_key_map.end() || ts_iter == ts_map.end()) {
+            continue;
+        }
+        std::string pk(key_iter->second.data(), key_iter->second.size());
+        std::lock_guard<std::mutex> lock(cache->GetMutex(pk));
+        cache->Put(pk, ts_iter->second, data, decoder);
+    }
+}
+
 bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     std::shared_ptr<IndexDef> index_def = GetIndex(idx);
     if (!index_def || !index_def->IsReady()) {
@@ -231,7 +299,16 @@ bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     }
     uint32_t real_idx = index_def->GetInnerPos();
     Segment* segment = segments_[real_idx][seg_idx];
-    return segment->Delete(spk);
+    bool ok = segment->Delete(spk);
+    if (ok && has_window_aggr_cache_.load()) {
+        for (const auto& cache : *std::atomic_load(&window_aggr_caches_)) {
+            if (cache->GetInnerPos() == real_idx) {
+                std::lock_guard<std::mutex> lock(cache->GetMutex(pk));
+                cache->Erase(pk);
+            }
+        }
+    }
+    return ok;
 }
 
 uint64_t MemTable::Release() {
@@ -299,16 +376,38 @@ void MemTable::SchedGc() {
         if (deleted_num == real_index.size() || ttl_st_map.empty()) {
             continue;
         }
+        // a row is shared by all indexes, so only the rows of a single index table can be frozen
+        uint64_t freeze_time = 0;
+        if (FLAGS_cold_data_freeze_time > 0 && table_index_.Size() == 1 && ttl_st_map.size() == 1 &&
+            ttl_st_map.begin()->second.ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime) {
+            freeze_time = ::baidu::common::timer::get_micros() / 1000 - FLAGS_cold_data_freeze_time * 60 * 1000;
+        }
         for (uint32_t j = 0; j < seg_cnt_; j++) {
             uint64_t seg_gc_time = ::baidu::common::timer::get_micros() / 1000;
             Segment* segment = segments_[i][j];
+            // the ttl may be changed since the last gc
+            segment->SetTrackExpire(NeedTrackExpire(real_index));
             segment->IncrGcVersion();
             segment->GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             if (ttl_st_map.size() == 1) {
-                segment->ExecuteGc(ttl_st_map.begin()->second, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+                // the absolute ttl of a tracked segment is handled by IncrementalGc
+                if (!segment->IsTrackingExpire() ||
+                    ttl_st_map.begin()->second.ttl_type != ::openmldb::storage::TTLType::kAbsoluteTime) {
+                    segment->ExecuteGc(ttl_st_map.begin()->second, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+                }
             } else {
                 segment->ExecuteGc(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
+            if (freeze_time > 0) {
+                uint64_t freeze_record_cnt = 0;
+                uint64_t released_byte_size = 0;
+                uint64_t cold_byte_size = 0;
+                segment->Freeze(freeze_time, freeze_record_cnt, released_byte_size, cold_byte_size);
+                record_byte_size_.fetch_add(cold_byte_size, std::memory_order_relaxed);
+                record_byte_size_.fetch_sub(released_byte_size, std::memory_order_relaxed);
+                PDLOG(INFO, "freeze segment[%u][%u] %lu records, released %lu bytes, cold %lu bytes. tid %u pid %u", i,
+                      j, freeze_record_cnt, released_byte_size, cold_byte_size, id_, pid_);
+            }
             seg_gc_time = ::baidu::common::timer::get_micros() / 1000 - seg_gc_time;
             PDLOG(INFO, "gc segment[%u][%u] done consumed %lu for table %s tid %u pid %u", i, j, seg_gc_time,
                   name_.c_str(), id_, pid_);
@@ -321,9 +420,55 @@ void MemTable::SchedGc() {
           "gc finished, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu ms for "
           "table %s tid %u pid %u",
           gc_idx_cnt, gc_record_cnt, consumed / 1000, name_.c_str(), id_, pid_);
+    if (has_window_aggr_cache_.load()) {
+        for (const auto& cache : *std::atomic_load(&window_aggr_caches_)) {
+            auto index_def = table_index_.GetIndex(cache->GetIndexId());
+            cache->Gc(index_def ? GetExpireTime(*(index_def->GetTTL())) : 0);
+        }
+    }
     UpdateTTL();
 }
 
+bool MemTable::IncrementalGc(uint32_t slice_time) {
+    if (!enable_gc_.load(std::memory_order_relaxed)) {
+        gc_slice_pos_.store(0, std::memory_order_relaxed);
+        gc_slicing_.store(false, std::memory_order_release);
+        return true;
+    }
+    uint64_t start = ::baidu::common::timer::get_micros();
+    uint64_t deadline = start + slice_time * 1000;
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    bool finished = true;
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    uint32_t total = inner_indexs->size() * seg_cnt_;
+    uint32_t pos = gc_slice_pos_.load(std::memory_order_relaxed);
+    for (; pos < total; pos++) {
+        uint32_t i = pos / seg_cnt_;
+        const std::vector<std::shared_ptr<IndexDef>>& real_index = inner_indexs->at(i)->GetIndex();
+        if (real_index.size() != 1 || !real_index[0]->IsReady() || segments_[i] == NULL) {
+            continue;
+        }
+        Segment* segment = segments_[i][pos % seg_cnt_];
+        if (!segment->IncrementalGc(*(real_index[0]->GetTTL()), deadline, gc_idx_cnt, gc_record_cnt,
+                                    gc_record_byte_size)) {
+            finished = false;
+            break;
+        }
+    }
+    gc_slice_pos_.store(finished ? 0 : pos, std::memory_order_relaxed);
+    record_cnt_.fetch_sub(gc_record_cnt, std::memory_order_relaxed);
+    record_byte_size_.fetch_sub(gc_record_byte_size, std::memory_order_relaxed);
+    DEBUGLOG("gc slice done, gc_idx_cnt %lu, gc_record_cnt %lu consumed %lu us for table %s tid %u pid %u",
+             gc_idx_cnt, gc_record_cnt, ::baidu::common::timer::get_micros() - start, name_.c_str(), id_, pid_);
+    if (finished) {
+        gc_slicing_.store(false, std::memory_order_release);
+        PDLOG(INFO, "incremental gc finished for table %s tid %u pid %u", name_.c_str(), id_, pid_);
+    }
+    return finished;
+}
+
 // tll as ms
 uint64_t MemTable::GetExpireTime(const TTLSt& ttl_st) {
     if (!enable_gc_.load(std::memory_order_relaxed) || ttl_st.abs_ttl == 0 ||
@@ -481,6 +626,11 @@ uint64_t MemTable::GetRecordIdxByteSize() {
             }
         }
     }
+    if (has_window_aggr_cache_.load(std::memory_order_relaxed)) {
+        for (const auto& cache : *std::atomic_load(&window_aggr_caches_)) {
+            record_idx_byte_size += cache->GetByteSize();
+        }
+    }
     return record_idx_byte_size;
 }
 
@@ -648,6 +798,146 @@ bool MemTable::DeleteIndex(const std::string& idx_name) {
     return true;
 }
 
+std::shared_ptr<WindowAggrCache> MemTable::GetWindowAggrCache(const std::shared_ptr<IndexDef>& index_def,
+                                                              const std::string& func, const std::string& col) {
+    WindowAggrFunc aggr_func;
+    if (!GetWindowAggrFunc(func, &aggr_func)) {
+        return nullptr;
+    }
+    auto ts_col = index_def->GetTsColumn();
+    if (!ts_col) {
+        return nullptr;
+    }
+    int32_t col_idx = -1;
+    ::openmldb::type::DataType col_type = ::openmldb::type::kBigInt;
+    if (!col.empty()) {
+        auto table_meta = GetTableMeta();
+        int32_t pos = 0;
+        for (const auto& column : table_meta->column_desc()) {
+            if (column.name() == col) {
+                col_idx = pos;
+                col_type = column.data_type();
+                break;
+            }
+            pos++;
+        }
+        for (const auto& column : table_meta->added_column_desc()) {
+            if (col_idx >= 0) {
+                break;
+            }
+            if (column.name() == col) {
+                col_idx = pos;
+                col_type = column.data_type();
+            }
+            pos++;
+        }
+        if (col_idx < 0) {
+            return nullptr;
+        }
+    }
+    auto match = [&](const std::shared_ptr<WindowAggrCache>& cache) {
+        return cache->GetIndexId() == index_def->GetId() && cache->GetTsColId() == ts_col->GetId() &&
+               cache->GetColIdx() == col_idx && cache->GetFunc() == aggr_func;
+    };
+    auto caches = std::atomic_load(&window_aggr_caches_);
+    for (const auto& cache : *caches) {
+        if (match(cache)) {
+            return cache;
+        }
+    }
+    if (!WindowAggrCache::IsSupported(aggr_func, col_idx, col_type)) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(window_aggr_cache_mu_);
+    caches = std::atomic_load(&window_aggr_caches_);
+    for (const auto& cache : *caches) {
+        if (match(cache)) {
+            return cache;
+        }
+    }
+    auto cache = std::make_shared<WindowAggrCache>(index_def->GetId(), index_def->GetInnerPos(), ts_col->GetId(),
+                                                   col_idx, col_type, aggr_func, seg_cnt_,
+                                                   static_cast<uint64_t>(FLAGS_window_aggr_cache_max_mb) * 1024 * 1024);
+    auto new_caches = std::make_shared<std::vector<std::shared_ptr<WindowAggrCache>>>(*caches);
+    new_caches->push_back(cache);
+    // set before the cache is published, see GetWindowAggr
+    has_window_aggr_cache_.store(true);
+    std::atomic_store(&window_aggr_caches_, new_caches);
+    PDLOG(INFO, "create window aggr cache of index %u col %s func %s. tid %u pid %u", index_def->GetId(), col.c_str(),
+          func.c_str(), id_, pid_);
+    return cache;
+}
+
+bool MemTable::GetWindowAggr(uint32_t index, const std::string& pk, const std::string& func, const std::string& col,
+                             int64_t start, int64_t end, std::string* aggr_val) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(index);
+    if (!index_def || !index_def->IsReady()) {
+        return false;
+    }
+    auto ttl = index_def->GetTTL();
+    uint64_t expire_time = 0;
+    uint64_t expire_cnt = 0;
+    if (enable_gc_.load(std::memory_order_relaxed)) {
+        if (ttl->ttl_type == ::openmldb::storage::TTLType::kAbsAndLat) {
+            // a row is kept by either of the ttl, it does not slide with the window
+            return false;
+        }
+        expire_time = GetExpireTime(*ttl);
+        if (ttl->ttl_type != ::openmldb::storage::TTLType::kAbsoluteTime) {
+            expire_cnt = ttl->lat_ttl;
+        }
+    }
+    auto cache = GetWindowAggrCache(index_def, func, col);
+    if (!cache) {
+        return false;
+    }
+    start = std::max(start, static_cast<int64_t>(expire_time));
+    uint64_t build_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(cache->GetMutex(pk));
+        if (cache->Get(pk, start, end, expire_cnt, aggr_val)) {
+            return true;
+        }
+        build_id = cache->StartBuild(pk);
+    }
+    // a put of pk running now either inserts its row before the scan, or puts it
+    // into the cache after it sees has_window_aggr_cache_ and the build
+    uint32_t seg_idx = 0;
+    if (seg_cnt_ > 1) {
+        seg_idx = ::openmldb::base::hash(pk.data(), pk.size(), SEED) % seg_cnt_;
+    }
+    segments_[index_def->GetInnerPos()][seg_idx]->WaitPut(Slice(pk));
+    auto cancel = [&cache, &pk, build_id]() {
+        std::lock_guard<std::mutex> lock(cache->GetMutex(pk));
+        cache->CancelBuild(pk, build_id);
+        return false;
+    };
+    Ticket ticket;
+    std::unique_ptr<TableIterator> it(NewIterator(index, pk, ticket));
+    if (!it) {
+        return cancel();
+    }
+    it->SeekToFirst();
+    if (it->Valid() && static_cast<int64_t>(it->GetKey()) > end) {
+        return cancel();
+    }
+    WindowAggrCache::Builder builder(*cache, start, expire_cnt);
+    uint64_t cnt = 0;
+    while (it->Valid() && static_cast<int64_t>(it->GetKey()) >= start && (expire_cnt == 0 || cnt < expire_cnt)) {
+        const int8_t* data = reinterpret_cast<const int8_t*>(it->GetValue().data());
+        auto decoder = GetVersionDecoder(codec::RowView::GetSchemaVersion(data));
+        if (decoder == nullptr) {
+            return cancel();
+        }
+        builder.Add(it->GetKey(), it->GetValue().data(), *decoder);
+        cnt++;
+        it->Next();
+    }
+    builder.Finish();
+    std::lock_guard<std::mutex> lock(cache->GetMutex(pk));
+    return cache->Install(pk, build_id, &builder) && cache->Get(pk, start, end, expire_cnt, aggr_val);
+}
+
 ::hybridse::vm::WindowIterator* MemTable::NewWindowIterator(uint32_t index) {
     std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(index);
     if (!index_def || !index_def->IsReady()) {
@@ -772,6 +1062,12 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
             }
         }
     }
+    // the rows are not put one by one, so the states are scanned again by the next requests
+    if (has_window_aggr_cache_.load(std::memory_order_relaxed)) {
+        for (const auto& cache : *std::atomic_load(&window_aggr_caches_)) {
+            cache->Clear();
+        }
+    }
 
     return true;
 }
@@ -837,14 +1133,14 @@ bool MemTableKeyIterator::Valid() {
 void MemTableKeyIterator::Next() { NextPK(); }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = NULL;
+    KeyEntryIterator* it = NULL;
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
         KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
+        it = entry->NewIterator();
         ticket_.Push(entry);
     } else {
         it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
+                 ->NewIterator();
         ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
     }
     it->SeekToFirst();
@@ -951,11 +1247,11 @@ void MemTableTraverseIterator::NextPK() {
         }
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[0];  // NOLINT
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
             ticket_.Push(entry);
         } else {
             it_ = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                      ->entries.NewIterator();
+                      ->NewIterator();
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
         }
         it_->SeekToFirst();
@@ -987,11 +1283,11 @@ void MemTableTraverseIterator::Seek(const std::string& key, uint64_t ts) {
         if (segments_[seg_idx_]->GetTsCnt() > 1) {
             KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
             ticket_.Push(entry);
-            it_ = entry->entries.NewIterator();
+            it_ = entry->NewIterator();
         } else {
             ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
             it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                      ->entries.NewIterator();
+                      ->NewIterator();
         }
         if (spk.compare(pk_it_->GetKey()) != 0 || ts == 0) {
             it_->SeekToFirst();
@@ -1064,11 +1360,11 @@ void MemTableTraverseIterator::SeekToFirst() {
             if (segments_[seg_idx_]->GetTsCnt() > 1) {
                 KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
                 ticket_.Push(entry);
-                it_ = entry->entries.NewIterator();
+                it_ = entry->NewIterator();
             } else {
                 ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
                 it_ = ((KeyEntry*)pk_it_->GetValue())         // NOLINT
-                          ->entries.NewIterator();
+                          ->NewIterator();
             }
             it_->SeekToFirst();
             traverse_cnt_++;
@@ -20,7 +20,9 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "proto/tablet.pb.h"
@@ -28,6 +30,7 @@
 #include "storage/segment.h"
 #include "storage/table.h"
 #include "storage/ticket.h"
+#include "storage/window_aggr_cache.h"
 #include "vm/catalog.h"
 
 using ::openmldb::api::LogEntry;
@@ -40,7 +43,7 @@ typedef google::protobuf::RepeatedPtrField<::openmldb::api::Dimension> Dimension
 
 class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
  public:
-    MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+    MemTableWindowIterator(KeyEntryIterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
                            uint64_t expire_cnt)
         : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_() {}
 
@@ -62,7 +65,15 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
 
     // TODO(wangtaize) unify the row object
     const ::hybridse::codec::Row& GetValue() override {
-        row_.Reset(reinterpret_cast<const int8_t*>(it_->GetValue()->data), it_->GetValue()->size);
+        const DataBlock* block = it_->GetValue();
+        if (it_->IsCold()) {
+            // the decoded cold rows are freed with the iterator, but the row may be kept after it
+            auto* buf = reinterpret_cast<int8_t*>(malloc(block->size));
+            memcpy(buf, block->data, block->size);
+            row_.Reset(::hybridse::base::RefCountedSlice::CreateManaged(buf, block->size));
+        } else {
+            row_.Reset(reinterpret_cast<const int8_t*>(block->data), block->size);
+        }
         return row_;
     }
 
@@ -74,7 +85,7 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
     bool IsSeekable() const override { return true; }
 
  private:
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     ::hybridse::codec::Row row_;
@@ -108,7 +119,7 @@ class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     ::openmldb::storage::TTLType ttl_type_;
     uint64_t expire_time_;
     uint64_t expire_cnt_;
@@ -137,7 +148,7 @@ class MemTableTraverseIterator : public TraverseIterator {
     uint32_t const seg_cnt_;
     uint32_t seg_idx_;
     KeyEntries::Iterator* pk_it_;
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
     uint32_t record_idx_;
     uint32_t ts_idx_;
     // uint64_t expire_value_;
@@ -162,6 +173,10 @@ class MemTable : public Table {
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
 
+    // put a row whose value and keys are referenced rather than owned, e.g. decoded
+    // from a mapped snapshot file. dimensions are pairs of index id and key
+    bool Put(uint64_t time, const Slice& value, const std::vector<std::pair<uint32_t, Slice>>& dimensions);
+
     bool GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response);
 
     bool BulkLoad(const std::vector<DataBlock*>& data_blocks,
@@ -183,6 +198,17 @@ class MemTable : public Table {
 
     void SchedGc() override;
 
+    // gc the absolute ttl indexes with the expire wheel of segments in a time slice(ms),
+    // return false if there are keys left and the next slice resumes from where it stopped.
+    // only the caller which has got TryStartIncrementalGc runs the slices until one returns true
+    bool IncrementalGc(uint32_t slice_time);
+
+    // return false if the slices of the last incremental gc are still running
+    bool TryStartIncrementalGc() {
+        bool expected = false;
+        return gc_slicing_.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+    }
+
     int GetCount(uint32_t index, const std::string& pk, uint64_t& count) override;  // NOLINT
 
     uint64_t GetRecordIdxCnt() override;
@@ -217,11 +243,27 @@ class MemTable : public Table {
 
     bool AddIndex(const ::openmldb::common::ColumnKey& column_key);
 
+    // aggregate col of the rows of pk in [start, end] of the index by func, the result is
+    // encoded as the aggr val of a pre-aggregate table. a WindowAggrCache is created for
+    // the first request of the index, col and func, then the rows of pk are kept in it.
+    // return false if the window can not be answered by the cache
+    bool GetWindowAggr(uint32_t index, const std::string& pk, const std::string& func, const std::string& col,
+                       int64_t start, int64_t end, std::string* aggr_val);
+
  private:
     bool CheckAbsolute(const TTLSt& ttl, uint64_t ts);
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
+    bool PutRow(uint64_t time, const char* value, uint32_t size, const std::map<int32_t, Slice>& inner_index_key_map);
+
+    std::shared_ptr<WindowAggrCache> GetWindowAggrCache(const std::shared_ptr<IndexDef>& index_def,
+                                                        const std::string& func, const std::string& col);
+
+    void PutWindowAggrCache(const std::map<int32_t, Slice>& inner_index_key_map,
+                            const std::map<int32_t, uint64_t>& ts_map, const char* data,
+                            const codec::RowView& decoder);
+
  private:
     uint32_t seg_cnt_;
     std::vector<Segment**> segments_;
@@ -231,6 +273,13 @@ class MemTable : public Table {
     bool segment_released_;
     std::atomic<uint64_t> record_byte_size_;
     uint32_t key_entry_max_height_;
+    // the position of segment to resume the incremental gc, only used by the owner of the slices
+    std::atomic<uint32_t> gc_slice_pos_;
+    // whether the slices of an incremental gc are running
+    std::atomic<bool> gc_slicing_;
+    std::mutex window_aggr_cache_mu_;
+    std::atomic<bool> has_window_aggr_cache_;
+    std::shared_ptr<std::vector<std::shared_ptr<WindowAggrCache>>> window_aggr_caches_;
 };
 
 }  // namespace storage
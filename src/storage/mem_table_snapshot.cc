@@ -16,6 +16,7 @@
 
 #include "storage/mem_table_snapshot.h"
 
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #ifdef DISALLOW_COPY_AND_ASSIGN
 #undef DISALLOW_COPY_AND_ASSIGN
@@ -23,7 +24,11 @@
 #include <snappy.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <deque>
+#include <mutex>  // NOLINT
 #include <set>
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "base/file_util.h"
@@ -38,6 +43,7 @@
 #include "common/timer.h"
 #include "gflags/gflags.h"
 #include "log/log_reader.h"
+#include "log/mmap_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
 
@@ -51,6 +57,8 @@ DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(snapshot_thread_num);
+DECLARE_bool(snapshot_recover_mmap);
 
 namespace openmldb {
 namespace storage {
@@ -59,6 +67,151 @@ const std::string SNAPSHOT_SUBFIX = ".sdb";  // NOLINT
 const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
 
+static bool IsCompressedPath(const std::string& path) {
+    return path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
+           path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos;
+}
+
+static bool ReadLengthDelimited(::google::protobuf::io::CodedInputStream* input, const char* base,
+                                ::openmldb::base::Slice* value) {
+    uint32_t len = 0;
+    if (!input->ReadVarint32(&len)) {
+        return false;
+    }
+    int pos = input->CurrentPosition();
+    if (!input->Skip(len)) {
+        return false;
+    }
+    *value = ::openmldb::base::Slice(base + pos, len);
+    return true;
+}
+
+// decode the fields of a serialized LogEntry which recovery needs without building the message.
+// value and the keys of dimensions reference to record. it returns false if the record is
+// malformed or has fields out of ts, value and dimensions, the caller should parse a LogEntry then
+static bool DecodeLogEntry(const ::openmldb::base::Slice& record, uint64_t* ts, ::openmldb::base::Slice* value,
+                           std::vector<std::pair<uint32_t, ::openmldb::base::Slice>>* dimensions) {
+    // tags of LogEntry in tablet.proto
+    static const uint32_t TERM_TAG = (1 << 3) | 0;
+    static const uint32_t LOG_INDEX_TAG = (2 << 3) | 0;
+    static const uint32_t VALUE_TAG = (4 << 3) | 2;
+    static const uint32_t TS_TAG = (5 << 3) | 0;
+    static const uint32_t DIMENSION_TAG = (6 << 3) | 2;
+    static const uint32_t METHOD_TYPE_TAG = (7 << 3) | 0;
+    // tags of Dimension
+    static const uint32_t KEY_TAG = (1 << 3) | 2;
+    static const uint32_t IDX_TAG = (2 << 3) | 0;
+    *ts = 0;
+    value->clear();
+    dimensions->clear();
+    ::google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(record.data()), record.size());
+    uint64_t ignored = 0;
+    while (true) {
+        uint32_t tag = input.ReadTag();
+        if (tag == 0) {
+            return input.CurrentPosition() == static_cast<int>(record.size());
+        }
+        switch (tag) {
+            case TERM_TAG:
+            case LOG_INDEX_TAG:
+            case METHOD_TYPE_TAG:
+                if (!input.ReadVarint64(&ignored)) {
+                    return false;
+                }
+                break;
+            case TS_TAG:
+                if (!input.ReadVarint64(ts)) {
+                    return false;
+                }
+                break;
+            case VALUE_TAG:
+                if (!ReadLengthDelimited(&input, record.data(), value)) {
+                    return false;
+                }
+                break;
+            case DIMENSION_TAG: {
+                ::openmldb::base::Slice dimension;
+                if (!ReadLengthDelimited(&input, record.data(), &dimension)) {
+                    return false;
+                }
+                ::google::protobuf::io::CodedInputStream dim_input(
+                    reinterpret_cast<const uint8_t*>(dimension.data()), dimension.size());
+                ::openmldb::base::Slice key;
+                uint32_t idx = 0;
+                while (true) {
+                    uint32_t dim_tag = dim_input.ReadTag();
+                    if (dim_tag == 0) {
+                        if (dim_input.CurrentPosition() != static_cast<int>(dimension.size())) {
+                            return false;
+                        }
+                        break;
+                    } else if (dim_tag == KEY_TAG) {
+                        if (!ReadLengthDelimited(&dim_input, dimension.data(), &key)) {
+                            return false;
+                        }
+                    } else if (dim_tag == IDX_TAG) {
+                        if (!dim_input.ReadVarint32(&idx)) {
+                            return false;
+                        }
+                    } else {
+                        return false;
+                    }
+                }
+                dimensions->emplace_back(idx, key);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+// read the records of all files of a snapshot one file after another
+class SnapshotReader {
+ public:
+    SnapshotReader(const std::string& snapshot_path, const std::vector<std::string>& files)
+        : snapshot_path_(snapshot_path), files_(files), pos_(0), seq_file_(NULL), reader_(NULL) {}
+    ~SnapshotReader() { Close(); }
+
+    ::openmldb::log::Status ReadRecord(::openmldb::base::Slice* record, std::string* buffer) {
+        while (true) {
+            if (reader_ == NULL) {
+                if (pos_ >= files_.size()) {
+                    return ::openmldb::log::Status::Eof();
+                }
+                std::string path = snapshot_path_ + files_[pos_++];
+                FILE* fd = fopen(path.c_str(), "rb");
+                if (fd == NULL) {
+                    PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+                    return ::openmldb::log::Status::IOError("fail to open " + path);
+                }
+                seq_file_ = ::openmldb::log::NewSeqFile(path, fd);
+                reader_ = new ::openmldb::log::Reader(seq_file_, NULL, false, 0, IsCompressedPath(path));
+            }
+            ::openmldb::log::Status status = reader_->ReadRecord(record, buffer);
+            if (!status.IsEof() && !status.IsWaitRecord()) {
+                return status;
+            }
+            Close();
+        }
+    }
+
+ private:
+    void Close() {
+        delete reader_;
+        reader_ = NULL;
+        // will close the fd atomic
+        delete seq_file_;
+        seq_file_ = NULL;
+    }
+
+    std::string snapshot_path_;
+    std::vector<std::string> files_;
+    uint32_t pos_;
+    ::openmldb::log::SequentialFile* seq_file_;
+    ::openmldb::log::Reader* reader_;
+};
+
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
     : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
 
@@ -84,29 +237,47 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        RecoverFromSnapshot(GetSnapshotFiles(manifest), manifest.count(), table);
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
     return true;
 }
 
-void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt,
+void MemTableSnapshot::RecoverFromSnapshot(const std::vector<std::string>& snapshot_files, uint64_t expect_cnt,
                                            std::shared_ptr<Table> table) {
-    std::string full_path = snapshot_path_ + "/" + snapshot_name;
+    if (snapshot_files.empty()) {
+        return;
+    }
     std::atomic<uint64_t> g_succ_cnt(0);
     std::atomic<uint64_t> g_failed_cnt(0);
-    RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    // each file of the snapshot is read by its own thread
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < snapshot_files.size(); i++) {
+        threads.emplace_back(&MemTableSnapshot::RecoverSingleSnapshot, this, snapshot_path_ + "/" + snapshot_files[i],
+                             table, &g_succ_cnt, &g_failed_cnt);
+    }
+    RecoverSingleSnapshot(snapshot_path_ + "/" + snapshot_files[0], table, &g_succ_cnt, &g_failed_cnt);
+    for (auto& thread : threads) {
+        thread.join();
+    }
     PDLOG(INFO, "[Recover] progress done stat: success count %lu, failed count %lu",
           g_succ_cnt.load(std::memory_order_relaxed), g_failed_cnt.load(std::memory_order_relaxed));
     if (g_succ_cnt.load(std::memory_order_relaxed) != expect_cnt) {
-        PDLOG(WARNING, "snapshot %s , expect cnt %lu but succ_cnt %lu", snapshot_name.c_str(), expect_cnt,
+        PDLOG(WARNING, "snapshot %s , expect cnt %lu but succ_cnt %lu", snapshot_files[0].c_str(), expect_cnt,
               g_succ_cnt.load(std::memory_order_relaxed));
     }
 }
 
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
+    if (FLAGS_snapshot_recover_mmap && !IsCompressed(path)) {
+        std::shared_ptr<MemTable> mem_table = std::dynamic_pointer_cast<MemTable>(table);
+        if (mem_table) {
+            RecoverMappedSnapshot(path, mem_table, g_succ_cnt, g_failed_cnt);
+            return;
+        }
+    }
     ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
     std::atomic<uint64_t> succ_cnt, failed_cnt;
     succ_cnt = failed_cnt = 0;
@@ -194,29 +365,106 @@ void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std
     }
 }
 
-int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
-                                  WriteHandle* wh, uint64_t& count, uint64_t& expired_key_num,
-                                  uint64_t& deleted_key_num) {
-    std::string full_path = snapshot_path_ + manifest.name();
+void MemTableSnapshot::RecoverMappedSnapshot(const std::string& path, std::shared_ptr<MemTable> table,
+                                             std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
+    ::openmldb::log::MmapReader reader(path);
+    ::openmldb::log::Status status = reader.Open();
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to map path %s for error %s", path.c_str(), status.ToString().c_str());
+        return;
+    }
+    // fragmented records are assembled out of the mapping, keep them until all tasks finish
+    std::deque<std::string> fragmented;
+    std::atomic<uint64_t> succ_cnt, failed_cnt;
+    succ_cnt = failed_cnt = 0;
+    ::openmldb::base::TaskPool load_pool(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
+    uint64_t consumed = ::baidu::common::timer::now_time();
+    std::vector<::openmldb::base::Slice> records;
+    records.reserve(FLAGS_load_table_batch);
+    std::string buffer;
+    while (true) {
+        ::openmldb::base::Slice record;
+        status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
+            break;
+        }
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            failed_cnt.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (record.data() == buffer.data()) {
+            fragmented.emplace_back(record.data(), record.size());
+            record = ::openmldb::base::Slice(fragmented.back());
+        }
+        records.push_back(record);
+        if (records.size() >= FLAGS_load_table_batch) {
+            load_pool.AddTask(
+                boost::bind(&MemTableSnapshot::PutMapped, this, path, table, records, &succ_cnt, &failed_cnt));
+            records.clear();
+        }
+    }
+    if (!records.empty()) {
+        load_pool.AddTask(
+            boost::bind(&MemTableSnapshot::PutMapped, this, path, table, records, &succ_cnt, &failed_cnt));
+    }
+    load_pool.Stop();
+    consumed = ::baidu::common::timer::now_time() - consumed;
+    PDLOG(INFO,
+          "map path %s for table tid %u pid %u completed, "
+          "succ_cnt %lu, failed_cnt %lu, consumed %us",
+          path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
+          failed_cnt.load(std::memory_order_relaxed), consumed);
+    if (g_succ_cnt) {
+        g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
+    }
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+    }
+}
+
+void MemTableSnapshot::PutMapped(const std::string& path, const std::shared_ptr<MemTable>& table,
+                                 const std::vector<::openmldb::base::Slice>& records, std::atomic<uint64_t>* succ_cnt,
+                                 std::atomic<uint64_t>* failed_cnt) {
+    uint64_t ts = 0;
+    ::openmldb::base::Slice value;
+    std::vector<std::pair<uint32_t, ::openmldb::base::Slice>> dimensions;
+    ::openmldb::api::LogEntry entry;
+    for (const auto& record : records) {
+        if (DecodeLogEntry(record, &ts, &value, &dimensions)) {
+            table->Put(ts, value, dimensions);
+        } else if (entry.ParseFromArray(record.data(), record.size())) {
+            table->Put(entry.ts(), entry.value(), entry.dimensions());
+        } else {
+            failed_cnt->fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
+        if (scount % 100000 == 0) {
+            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), scount,
+                  failed_cnt->load(std::memory_order_relaxed));
+        }
+    }
+}
+
+int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const std::string& snapshot_name,
+                                  const std::set<uint32_t>& deleted_index, WriteHandle* wh, std::mutex* mu,
+                                  uint64_t* count, uint64_t* expired_key_num, uint64_t* deleted_key_num) {
+    std::string full_path = snapshot_path_ + snapshot_name;
     FILE* fd = fopen(full_path.c_str(), "rb");
     if (fd == NULL) {
         PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
         return -1;
     }
     bool compressed = IsCompressed(full_path);
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(snapshot_name, fd);
     ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
 
     std::string buffer;
     std::string tmp_buf;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
-    std::set<uint32_t> deleted_index;
-    for (const auto& it : table->GetAllIndex()) {
-        if (it->GetStatus() != ::openmldb::storage::IndexStatus::kReady) {
-            deleted_index.insert(it->GetId());
-        }
-    }
     while (true) {
         ::openmldb::base::Slice record;
         ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
@@ -237,41 +485,147 @@ int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb
         }
         int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
         if (ret == 1) {
-            deleted_key_num++;
+            (*deleted_key_num)++;
             continue;
         } else if (ret == 2) {
             record.reset(tmp_buf.data(), tmp_buf.size());
         }
         if (table->IsExpire(entry)) {
-            expired_key_num++;
+            (*expired_key_num)++;
             continue;
         }
-        status = wh->Write(record);
+        {
+            std::lock_guard<std::mutex> lock(*mu);
+            status = wh->Write(record);
+        }
         if (!status.ok()) {
             PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
             has_error = true;
             break;
         }
-        if ((count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
-            PDLOG(INFO, "tackled key num[%lu] total[%lu]", count + expired_key_num, manifest.count());
+        if ((*count + *expired_key_num + *deleted_key_num) % KEY_NUM_DISPLAY == 0) {
+            PDLOG(INFO, "tackled key num[%lu] in %s", *count + *expired_key_num, snapshot_name.c_str());
         }
-        count++;
+        (*count)++;
     }
     delete seq_file;
-    if (expired_key_num + count + deleted_key_num != manifest.count()) {
-        PDLOG(WARNING,
-              "key num not match! total key num[%lu] load key num[%lu] ttl key "
-              "num[%lu]",
-              manifest.count(), count, expired_key_num);
-        has_error = true;
-    }
     if (has_error) {
         return -1;
     }
-    PDLOG(INFO, "load snapshot success. load key num[%lu] ttl key num[%lu]", count, expired_key_num);
+    PDLOG(INFO, "load snapshot %s success. load key num[%lu] ttl key num[%lu]", snapshot_name.c_str(), *count,
+          *expired_key_num);
     return 0;
 }
 
+std::vector<MemTableSnapshot::BinlogRange> MemTableSnapshot::SplitBinlog(uint64_t end_offset, uint32_t part_num) {
+    // a binlog file holds the entries after its start offset
+    std::vector<uint64_t> starts;
+    LogParts::Iterator* it = log_part_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        if (it->GetValue() > offset_ && it->GetValue() < end_offset) {
+            starts.push_back(it->GetValue());
+        }
+        it->Next();
+    }
+    delete it;
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    uint32_t file_num = starts.size() + 1;
+    uint32_t range_num = std::min(part_num, file_num);
+    std::vector<BinlogRange> ranges;
+    uint64_t start = offset_;
+    for (uint32_t i = 1; i < range_num; i++) {
+        uint64_t end = starts[i * file_num / range_num - 1];
+        ranges.emplace_back(start, end);
+        start = end;
+    }
+    ranges.emplace_back(start, end_offset);
+    return ranges;
+}
+
+void MemTableSnapshot::DumpBinlog(std::shared_ptr<Table> table, const std::set<uint32_t>& deleted_index,
+                                  WriteHandle* wh, std::mutex* mu, BinlogRange* range) {
+    ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
+    log_reader.SetOffset(range->start_offset);
+    std::string buffer;
+    std::string tmp_buf;
+    while (range->cur_offset < range->end_offset) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            ::openmldb::api::LogEntry entry;
+            if (!entry.ParseFromString(record.ToString())) {
+                PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
+                range->ret = -1;
+                break;
+            }
+            if (entry.log_index() <= range->cur_offset) {
+                continue;
+            }
+            if (range->cur_offset + 1 != entry.log_index()) {
+                PDLOG(WARNING, "log missing expect offset %lu but %ld", range->cur_offset + 1, entry.log_index());
+                continue;
+            }
+            range->cur_offset = entry.log_index();
+            if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+                continue;
+            }
+            if (entry.has_term()) {
+                range->term = entry.term();
+                range->has_term = true;
+            }
+            int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
+            if (ret == 1) {
+                range->deleted_key_num++;
+                continue;
+            } else if (ret == 2) {
+                record.reset(tmp_buf.data(), tmp_buf.size());
+            }
+            if (table->IsExpire(entry)) {
+                range->expired_key_num++;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(*mu);
+                status = wh->Write(record);
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
+                range->ret = -1;
+                break;
+            }
+            range->count++;
+            if ((range->count + range->expired_key_num + range->deleted_key_num) % KEY_NUM_DISPLAY == 0) {
+                PDLOG(INFO, "has write key num[%lu] expired key num[%lu] from binlog after offset %lu",
+                      range->count, range->expired_key_num, range->start_offset);
+            }
+        } else if (status.IsEof()) {
+            continue;
+        } else if (status.IsWaitRecord()) {
+            int end_log_index = log_reader.GetEndLogIndex();
+            int cur_log_index = log_reader.GetLogIndex();
+            // judge end_log_index greater than cur_log_index
+            if (end_log_index >= 0 && end_log_index > cur_log_index) {
+                log_reader.RollRLogFile();
+                PDLOG(WARNING,
+                      "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] "
+                      "end_log_index[%d] cur_offset[%lu]",
+                      tid_, pid_, cur_log_index, end_log_index, range->cur_offset);
+                continue;
+            }
+            DEBUGLOG("has read all record!");
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
+            range->ret = -1;
+            break;
+        }
+    }
+}
+
 uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
     deleted_keys_.clear();
     ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
@@ -352,42 +706,61 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
     }
     making_snapshot_.store(true, std::memory_order_release);
     std::string now_time = ::openmldb::base::GetNowTime();
-    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
-    if (FLAGS_snapshot_compression != "off") {
-        snapshot_name.append(".");
-        snapshot_name.append(FLAGS_snapshot_compression);
+    std::string name_prefix = now_time.substr(0, now_time.length() - 2);
+    uint32_t part_num = std::max(FLAGS_snapshot_thread_num, 1u);
+    // every thread writes a part of the snapshot, the first part is named as a single file snapshot
+    std::vector<std::string> part_names;
+    std::vector<WriteHandle*> whs;
+    for (uint32_t i = 0; i < part_num; i++) {
+        std::string name = i == 0 ? name_prefix : name_prefix + "_" + std::to_string(i);
+        name.append(SNAPSHOT_SUBFIX);
+        if (FLAGS_snapshot_compression != "off") {
+            name.append(".");
+            name.append(FLAGS_snapshot_compression);
+        }
+        std::string tmp_file_path = snapshot_path_ + name + ".tmp";
+        FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
+        if (fd == NULL) {
+            PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+            break;
+        }
+        part_names.push_back(name);
+        whs.push_back(new WriteHandle(FLAGS_snapshot_compression, name + ".tmp", fd));
     }
-    std::string snapshot_name_tmp = snapshot_name + ".tmp";
-    std::string full_path = snapshot_path_ + snapshot_name;
-    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
-    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+    if (whs.size() != part_num) {
+        for (uint32_t i = 0; i < whs.size(); i++) {
+            delete whs[i];
+            unlink((snapshot_path_ + part_names[i] + ".tmp").c_str());
+        }
         making_snapshot_.store(false, std::memory_order_release);
         return -1;
     }
+    const std::string& snapshot_name = part_names[0];
+    std::unique_ptr<std::mutex[]> part_mu(new std::mutex[part_num]);
     uint64_t collected_offset = CollectDeletedKey(end_offset);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
     ::openmldb::api::Manifest manifest;
     bool has_error = false;
     uint64_t write_count = 0;
     uint64_t expired_key_num = 0;
     uint64_t deleted_key_num = 0;
     uint64_t last_term = term;
+    std::vector<std::string> old_files;
     int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
-        // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
-            has_error = true;
-        }
+        old_files = GetSnapshotFiles(manifest);
         last_term = manifest.term();
         DEBUGLOG("old manifest term is %lu", last_term);
     } else if (result < 0) {
         // parse manifest error
         has_error = true;
     }
-
+    std::set<uint32_t> ttl_deleted_index;
+    for (const auto& it : table->GetAllIndex()) {
+        if (it->GetStatus() != ::openmldb::storage::IndexStatus::kReady) {
+            ttl_deleted_index.insert(it->GetId());
+        }
+    }
     // get deleted index
     std::set<uint32_t> deleted_index;
     for (const auto& it : table->GetAllIndex()) {
@@ -395,115 +768,110 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
             deleted_index.insert(it->GetId());
         }
     }
-    ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
-    log_reader.SetOffset(offset_);
+    // the files of old snapshot and the ranges of binlog are filtered in the pool at the same time
+    std::vector<BinlogRange> ranges;
+    if (!has_error && collected_offset > offset_) {
+        ranges = SplitBinlog(collected_offset, part_num);
+    }
+    std::vector<int> file_ret(old_files.size(), 0);
+    std::vector<uint64_t> file_count(old_files.size(), 0);
+    std::vector<uint64_t> file_expired(old_files.size(), 0);
+    std::vector<uint64_t> file_deleted(old_files.size(), 0);
+    ::openmldb::base::TaskPool pool(has_error ? 0 : part_num, std::max(old_files.size() + ranges.size(), (size_t)1));
+    for (uint32_t i = 0; !has_error && i < old_files.size(); i++) {
+        pool.AddTask([&, i]() {
+            file_ret[i] = TTLSnapshot(table, old_files[i], ttl_deleted_index, whs[i % part_num],
+                                      &part_mu[i % part_num], &file_count[i], &file_expired[i], &file_deleted[i]);
+        });
+    }
+    for (uint32_t i = 0; i < ranges.size(); i++) {
+        uint32_t part = (old_files.size() + i) % part_num;
+        pool.AddTask([&, i, part]() { DumpBinlog(table, deleted_index, whs[part], &part_mu[part], &ranges[i]); });
+    }
+    pool.Stop();
     uint64_t cur_offset = offset_;
-    std::string buffer;
-    std::string tmp_buf;
-    while (!has_error && cur_offset < collected_offset) {
-        buffer.clear();
-        ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
-        if (status.ok()) {
-            ::openmldb::api::LogEntry entry;
-            if (!entry.ParseFromString(record.ToString())) {
-                PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
-                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
-                has_error = true;
-                break;
-            }
-            if (entry.log_index() <= cur_offset) {
-                continue;
-            }
-            if (cur_offset + 1 != entry.log_index()) {
-                PDLOG(WARNING, "log missing expect offset %lu but %ld", cur_offset + 1, entry.log_index());
-                continue;
-            }
-            cur_offset = entry.log_index();
-            if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-                continue;
-            }
-            if (entry.has_term()) {
-                last_term = entry.term();
-            }
-            int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
-            if (ret == 1) {
-                deleted_key_num++;
-                continue;
-            } else if (ret == 2) {
-                record.reset(tmp_buf.data(), tmp_buf.size());
-            }
-            if (table->IsExpire(entry)) {
-                expired_key_num++;
-                continue;
-            }
-            ::openmldb::log::Status status = wh->Write(record);
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
-                      status.ToString().c_str());
+    bool has_term = false;
+    for (auto it = ranges.rbegin(); it != ranges.rend(); ++it) {
+        if (!has_term && it->has_term) {
+            last_term = it->term;
+            has_term = true;
+        }
+    }
+    for (uint32_t i = 0; !has_error && i < ranges.size(); i++) {
+        const auto& range = ranges[i];
+        if (range.ret < 0) {
+            has_error = true;
+        } else if (i + 1 < ranges.size() && range.cur_offset < range.end_offset) {
+            PDLOG(WARNING, "binlog from %lu to %lu is incomplete, read to %lu. tid %u pid %u", range.start_offset,
+                  range.end_offset, range.cur_offset, tid_, pid_);
+            has_error = true;
+        }
+        cur_offset = range.cur_offset;
+        write_count += range.count;
+        expired_key_num += range.expired_key_num;
+        deleted_key_num += range.deleted_key_num;
+    }
+    if (!old_files.empty() && !has_error) {
+        uint64_t old_count = 0;
+        for (uint32_t i = 0; i < old_files.size(); i++) {
+            if (file_ret[i] < 0) {
                 has_error = true;
-                break;
             }
-            write_count++;
-            if ((write_count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
-                PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", write_count, expired_key_num);
-            }
-        } else if (status.IsEof()) {
-            continue;
-        } else if (status.IsWaitRecord()) {
-            int end_log_index = log_reader.GetEndLogIndex();
-            int cur_log_index = log_reader.GetLogIndex();
-            // judge end_log_index greater than cur_log_index
-            if (end_log_index >= 0 && end_log_index > cur_log_index) {
-                log_reader.RollRLogFile();
-                PDLOG(WARNING,
-                      "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] "
-                      "end_log_index[%d] cur_offset[%lu]",
-                      tid_, pid_, cur_log_index, end_log_index, cur_offset);
-                continue;
-            }
-            DEBUGLOG("has read all record!");
-            break;
-        } else {
-            PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
+            old_count += file_count[i] + file_expired[i] + file_deleted[i];
+            write_count += file_count[i];
+            expired_key_num += file_expired[i];
+            deleted_key_num += file_deleted[i];
+        }
+        if (old_count != manifest.count()) {
+            PDLOG(WARNING, "key num not match! total key num[%lu] load key num[%lu]", manifest.count(), old_count);
             has_error = true;
-            break;
         }
     }
-    if (wh != NULL) {
+    for (auto wh : whs) {
         wh->EndLog();
         delete wh;
-        wh = NULL;
+    }
+    whs.clear();
+    for (uint32_t i = 0; !has_error && i < part_num; i++) {
+        std::string tmp_file_path = snapshot_path_ + part_names[i] + ".tmp";
+        if (rename(tmp_file_path.c_str(), (snapshot_path_ + part_names[i]).c_str()) != 0) {
+            PDLOG(WARNING, "rename[%s] failed", part_names[i].c_str());
+            has_error = true;
+            for (uint32_t j = 0; j < i; j++) {
+                unlink((snapshot_path_ + part_names[j]).c_str());
+            }
+        }
     }
     int ret = 0;
     if (has_error) {
-        unlink(tmp_file_path.c_str());
+        for (const auto& name : part_names) {
+            unlink((snapshot_path_ + name + ".tmp").c_str());
+        }
         ret = -1;
     } else {
-        if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
-            if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
+        std::vector<std::string> parts(part_names.begin() + 1, part_names.end());
+        if (GenManifest(snapshot_name, write_count, cur_offset, last_term, parts) == 0) {
+            // delete old snapshot
+            for (const auto& name : old_files) {
+                if (std::find(part_names.begin(), part_names.end(), name) == part_names.end()) {
+                    DEBUGLOG("old snapshot[%s] has deleted", name.c_str());
+                    unlink((snapshot_path_ + name).c_str());
                 }
-                uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
-                PDLOG(INFO,
-                      "make snapshot[%s] success. update offset from %lu to %lu."
-                      "use %lu second. write key %lu expired key %lu deleted key "
-                      "%lu",
-                      snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
-                      deleted_key_num);
-                offset_ = cur_offset;
-                out_offset = cur_offset;
-            } else {
-                PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
-                unlink(full_path.c_str());
-                ret = -1;
             }
+            uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
+            PDLOG(INFO,
+                  "make snapshot[%s] with %u files success. update offset from %lu to %lu."
+                  "use %lu second. write key %lu expired key %lu deleted key "
+                  "%lu",
+                  snapshot_name.c_str(), part_num, offset_, cur_offset, consumed, write_count, expired_key_num,
+                  deleted_key_num);
+            offset_ = cur_offset;
+            out_offset = cur_offset;
         } else {
-            PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
-            unlink(tmp_file_path.c_str());
+            PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", snapshot_name.c_str());
+            for (const auto& name : part_names) {
+                unlink((snapshot_path_ + name).c_str());
+            }
             ret = -1;
         }
     }
@@ -668,15 +1036,7 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         }
         index_vec.push_back(index_def);
     }
-    std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
-        return base::Status(base::ReturnCode::kError, "fail to open file");
-    }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(snapshot_path_, GetSnapshotFiles(manifest));
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -768,7 +1128,6 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         }
         (*count)++;
     }
-    delete seq_file;
     if (*expired_key_num + write_count + *deleted_key_num != manifest.count()) {
         PDLOG(WARNING, "key num not match! total key[%lu] load key[%lu] ttl key[%lu] delete key [%lu], tid %u pid %u",
                 manifest.count(), *count, *expired_key_num, *deleted_key_num, tid, pid);
@@ -788,15 +1147,7 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
                                                uint64_t& expired_key_num, uint64_t& deleted_key_num) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
-    std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
-        return -1;
-    }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(snapshot_path_, GetSnapshotFiles(manifest));
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -926,7 +1277,6 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
         }
         count++;
     }
-    delete seq_file;
     if (expired_key_num + count + deleted_key_num + schame_size_less_count + other_error_count != manifest.count()) {
         LOG(WARNING) << "key num not match ! total key num[" << manifest.count() << "] load key num[" << count
                      << "] ttl key num[" << expired_key_num << "] schema size less num[" << schame_size_less_count
@@ -1159,9 +1509,11 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
                 // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
+                for (const auto& name : GetSnapshotFiles(manifest)) {
+                    if (name != snapshot_name) {
+                        DEBUGLOG("old snapshot[%s] has deleted", name.c_str());
+                        unlink((snapshot_path_ + name).c_str());
+                    }
                 }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
@@ -1425,9 +1777,11 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
                 // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
+                for (const auto& name : GetSnapshotFiles(manifest)) {
+                    if (name != snapshot_name) {
+                        DEBUGLOG("old snapshot[%s] has deleted", name.c_str());
+                        unlink((snapshot_path_ + name).c_str());
+                    }
                 }
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
@@ -1543,17 +1897,9 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         return false;
     }
     *snapshot_offset = manifest.offset();
-    std::string path = snapshot_path_ + "/" + manifest.name();
     uint64_t succ_cnt = 0;
     uint64_t failed_cnt = 0;
-    FILE* fd = fopen(path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
-        return false;
-    }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-    bool compressed = IsCompressed(path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    SnapshotReader reader(snapshot_path_ + "/", GetSnapshotFiles(manifest));
     ::openmldb::api::LogEntry entry;
     std::string buffer;
     std::string entry_buff;
@@ -1564,9 +1910,9 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
         if (status.IsWaitRecord() || status.IsEof()) {
             PDLOG(INFO,
-                  "read path %s for table tid %u pid %u completed, succ_cnt "
+                  "read snapshot %s for table tid %u pid %u completed, succ_cnt "
                   "%lu, failed_cnt %lu",
-                  path.c_str(), tid_, pid_, succ_cnt, failed_cnt);
+                  manifest.name().c_str(), tid_, pid_, succ_cnt, failed_cnt);
             break;
         }
         if (!status.ok()) {
@@ -1591,7 +1937,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         ::openmldb::base::Slice new_record(entry_str);
         status = whs[index_pid]->Write(new_record);
         if (!status.ok()) {
-            delete seq_file;
             PDLOG(WARNING,
                   "fail to dump index entrylog in snapshot to pid[%u]. tid "
                   "%u pid %u",
@@ -1600,7 +1945,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         }
         succ_cnt++;
     }
-    delete seq_file;
     return true;
 }
 
@@ -1786,13 +2130,7 @@ int MemTableSnapshot::DecodeData(std::shared_ptr<Table> table, const openmldb::a
     return 0;
 }
 
-bool MemTableSnapshot::IsCompressed(const std::string& path) {
-    if (path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
-        path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
-        return true;
-    }
-    return false;
-}
+bool MemTableSnapshot::IsCompressed(const std::string& path) { return IsCompressedPath(path); }
 
 }  // namespace storage
 }  // namespace openmldb
@@ -19,6 +19,7 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <vector>
@@ -29,6 +30,7 @@
 #include "log/log_writer.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
 #include "storage/snapshot.h"
 
 using ::openmldb::api::LogEntry;
@@ -50,20 +52,50 @@ class MemTableSnapshot : public Snapshot {
 
     bool Recover(std::shared_ptr<Table> table, uint64_t& latest_offset) override;
 
-    void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
+    void RecoverFromSnapshot(const std::vector<std::string>& snapshot_files, uint64_t expect_cnt,
+                             std::shared_ptr<Table> table);
 
     int MakeSnapshot(std::shared_ptr<Table> table,
                      uint64_t& out_offset,  // NOLINT
                      uint64_t end_offset,
                      uint64_t term = 0) override;
 
-    int TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest, WriteHandle* wh,
-                    uint64_t& count, uint64_t& expired_key_num,  // NOLINT
-                    uint64_t& deleted_key_num);                  // NOLINT
+    // filter a file of the old snapshot into wh, the writes to wh are guarded by mu
+    int TTLSnapshot(std::shared_ptr<Table> table, const std::string& snapshot_name,
+                    const std::set<uint32_t>& deleted_index, WriteHandle* wh, std::mutex* mu, uint64_t* count,
+                    uint64_t* expired_key_num, uint64_t* deleted_key_num);
+
+    // the binlog entries in (start_offset, end_offset] are dumped by one thread
+    struct BinlogRange {
+        BinlogRange(uint64_t start, uint64_t end)
+            : start_offset(start), end_offset(end), cur_offset(start), term(0), has_term(false), count(0),
+              expired_key_num(0), deleted_key_num(0), ret(0) {}
+        uint64_t start_offset;
+        uint64_t end_offset;
+        uint64_t cur_offset;
+        uint64_t term;
+        bool has_term;
+        uint64_t count;
+        uint64_t expired_key_num;
+        uint64_t deleted_key_num;
+        int ret;
+    };
+
+    // split the binlog to dump into at most part_num ranges at the binlog file boundaries
+    std::vector<BinlogRange> SplitBinlog(uint64_t end_offset, uint32_t part_num);
+
+    // filter the binlog entries of range into wh, the writes to wh are guarded by mu
+    void DumpBinlog(std::shared_ptr<Table> table, const std::set<uint32_t>& deleted_index, WriteHandle* wh,
+                    std::mutex* mu, BinlogRange* range);
 
     void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
              std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
 
+    // put the records of a mapped snapshot file, the records reference to the mapping
+    void PutMapped(const std::string& path, const std::shared_ptr<MemTable>& table,
+                   const std::vector<::openmldb::base::Slice>& records, std::atomic<uint64_t>* succ_cnt,
+                   std::atomic<uint64_t>* failed_cnt);
+
     std::string GenSnapshotName();
 
     base::Status GetAllDecoder(std::shared_ptr<Table> table, std::map<uint8_t, codec::RowView>* decoder_map);
@@ -120,6 +152,11 @@ class MemTableSnapshot : public Snapshot {
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
 
+    // load single uncompressed snapshot through mmap, the records are decoded in place
+    // without building LogEntry messages
+    void RecoverMappedSnapshot(const std::string& path, std::shared_ptr<MemTable> table,
+                               std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt);
+
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
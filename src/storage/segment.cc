@@ -18,6 +18,11 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+
 #include "base/glog_wapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
@@ -26,11 +31,48 @@
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_uint32(gc_incremental_slice_time);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+// the time range of a bucket in the expire wheel
+static const uint64_t EXPIRE_BUCKET_TIME = 60 * 1000;
+// a node of the bucket set and its slot in the hash table
+static const uint64_t EXPIRE_WHEEL_ENTRY_SIZE = 3 * sizeof(void*);
+
+static bool HasExpiredColdBlock(KeyEntry* entry, uint64_t time) {
+    for (const ColdBlock* block = entry->GetCold(); block != NULL; block = block->next) {
+        if (block->GetMinTs() <= time) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the ext is counted in the index size of the segment from it is allocated until the entry is freed
+static uint64_t GetExtByteSize(KeyEntry* entry) {
+    return entry->ext_.load(std::memory_order_relaxed) == NULL ? 0 : sizeof(KeyEntryExt);
+}
+
+// get the min ts of both the rows in skiplist and the frozen rows, return false if the entry is empty
+static bool GetOldestTs(KeyEntry* entry, uint64_t* ts) {
+    bool found = false;
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+    if (node != NULL) {
+        *ts = node->GetKey();
+        found = true;
+    }
+    for (const ColdBlock* block = entry->GetCold(); block != NULL; block = block->next) {
+        if (!found || block->GetMinTs() < *ts) {
+            *ts = block->GetMinTs();
+            found = true;
+        }
+    }
+    return found;
+}
+
 Segment::Segment()
     : entries_(NULL),
       mu_(),
@@ -39,7 +81,8 @@ Segment::Segment()
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      track_expire_(false) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
@@ -54,7 +97,8 @@ Segment::Segment(uint8_t height)
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      track_expire_(false) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
 }
@@ -68,7 +112,8 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      track_expire_(false) {
     entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
     entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
@@ -130,6 +175,13 @@ uint64_t Segment::Release() {
     delete f_it;
     entry_free_list_->Clear();
     idx_cnt_vec_.clear();
+    {
+        std::lock_guard<std::mutex> lock(wheel_mu_);
+        for (const auto& kv : expire_wheel_) {
+            idx_byte_size_.fetch_sub(kv.second.size() * EXPIRE_WHEEL_ENTRY_SIZE, std::memory_order_relaxed);
+        }
+        expire_wheel_.clear();
+    }
     return cnt;
 }
 
@@ -159,7 +211,7 @@ void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t si
     if (ts_cnt_ > 1) {
         return;
     }
-    auto* db = new DataBlock(1, data, size);
+    auto* db = DataBlock::NewBlock(1, data, size);
     Put(key, time, db);
 }
 
@@ -167,59 +219,213 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
+    {
+        // the entry is found without mu_, hold it as the readers do until the row is in
+        Ticket ticket;
+        void* entry = nullptr;
+        if (entries_->Get(key, entry) == 0 && entry != NULL) {
+            ticket.Push((KeyEntry*)entry);                  // NOLINT
+            if (PutToEntry((KeyEntry*)entry, time, row)) {  // NOLINT
+                idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+                if (IsTrackingExpire()) {
+                    TrackExpire(key, (KeyEntry*)entry, time);  // NOLINT
+                }
+                return;
+            }
+        }
+    }
     std::lock_guard<std::mutex> lock(mu_);
     PutUnlock(key, time, row);
 }
 
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
+    void* entry = GetOrCreateEntry(key);
+    PutToEntry((KeyEntry*)entry, time, row);  // NOLINT
+    idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+    if (IsTrackingExpire()) {
+        TrackExpire(key, (KeyEntry*)entry, time);  // NOLINT
+    }
+}
+
+void Segment::WaitPut(const Slice& key) {
+    // a new entry is created under mu_, the rows are inserted under the mutex of the entry
+    std::lock_guard<std::mutex> lock(mu_);
+    void* entry = nullptr;
+    if (entries_->Get(key, entry) < 0 || entry == NULL) {
+        return;
+    }
+    if (ts_cnt_ > 1) {
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            std::lock_guard<::openmldb::base::SpinMutex> entry_lock(((KeyEntry**)entry)[i]->mu_);  // NOLINT
+        }
+    } else {
+        std::lock_guard<::openmldb::base::SpinMutex> entry_lock(((KeyEntry*)entry)->mu_);  // NOLINT
+    }
+}
+
+KeyEntryExt* Segment::GetOrCreateExt(KeyEntry* entry) {
+    KeyEntryExt* ext = entry->ext_.load(std::memory_order_relaxed);
+    if (ext == NULL) {
+        ext = new KeyEntryExt();
+        entry->ext_.store(ext, std::memory_order_release);
+        idx_byte_size_.fetch_add(sizeof(KeyEntryExt), std::memory_order_relaxed);
+    }
+    return ext;
+}
+
+void Segment::TrackExpire(const Slice& key, KeyEntry* entry, uint64_t time) {
+    uint64_t bucket = time / EXPIRE_BUCKET_TIME;
+    // most puts are newer than the oldest row of the key
+    if (bucket >= entry->GetExpireBucket()) {
+        return;
+    }
+    // a removed entry is freed later, it must not get back into the wheel
+    std::lock_guard<::openmldb::base::SpinMutex> entry_lock(entry->mu_);
+    if (entry->removed_) {
+        return;
+    }
+    KeyEntryExt* ext = GetOrCreateExt(entry);
+    if (ext->key.data() == NULL) {
+        // the key of a put is not owned by the segment, the entry is not unlinked with its lock held
+        KeyEntries::Iterator* it = entries_->NewIterator();
+        it->Seek(key);
+        if (it->Valid() && it->GetValue() == entry) {
+            ext->key = it->GetKey();
+        }
+        delete it;
+        if (ext->key.data() == NULL) {
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> lock(wheel_mu_);
+    if (!IsTrackingExpire() || bucket >= ext->expire_bucket.load(std::memory_order_relaxed)) {
+        return;
+    }
+    UntrackExpireUnlock(entry);
+    ext->expire_bucket.store(bucket, std::memory_order_relaxed);
+    expire_wheel_[bucket].insert(entry);
+    idx_byte_size_.fetch_add(EXPIRE_WHEEL_ENTRY_SIZE, std::memory_order_relaxed);
+}
+
+void Segment::UntrackExpireUnlock(KeyEntry* entry) {
+    uint64_t bucket = entry->GetExpireBucket();
+    if (bucket == UINT64_MAX) {
+        return;
+    }
+    entry->ext_.load(std::memory_order_relaxed)->expire_bucket.store(UINT64_MAX, std::memory_order_relaxed);
+    auto bucket_it = expire_wheel_.find(bucket);
+    if (bucket_it == expire_wheel_.end() || bucket_it->second.erase(entry) == 0) {
+        return;
+    }
+    if (bucket_it->second.empty()) {
+        expire_wheel_.erase(bucket_it);
+    }
+    idx_byte_size_.fetch_sub(EXPIRE_WHEEL_ENTRY_SIZE, std::memory_order_relaxed);
+}
+
+void Segment::UntrackExpire(KeyEntry* entry) {
+    // the bucket is set under the lock of entry and only reset without it, so an untracked entry skips wheel_mu_
+    if (entry->GetExpireBucket() == UINT64_MAX) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(wheel_mu_);
+    UntrackExpireUnlock(entry);
+}
+
+void Segment::SetTrackExpire(bool track) {
+    if (ts_cnt_ > 1 || track == IsTrackingExpire()) {
+        return;
+    }
+    if (!track) {
+        std::lock_guard<std::mutex> lock(wheel_mu_);
+        track_expire_.store(false, std::memory_order_relaxed);
+        for (const auto& kv : expire_wheel_) {
+            for (KeyEntry* entry : kv.second) {
+                entry->ext_.load(std::memory_order_relaxed)->expire_bucket.store(UINT64_MAX,
+                                                                                 std::memory_order_relaxed);
+            }
+            idx_byte_size_.fetch_sub(kv.second.size() * EXPIRE_WHEEL_ENTRY_SIZE, std::memory_order_relaxed);
+        }
+        expire_wheel_.clear();
+        return;
+    }
+    track_expire_.store(true, std::memory_order_relaxed);
+    // the keys put from now on are tracked by Put, the ones before are added here
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        uint64_t oldest_ts = 0;
+        if (GetOldestTs(entry, &oldest_ts)) {
+            TrackExpire(it->GetKey(), entry, oldest_ts);
+        }
+        it->Next();
+    }
+    delete it;
+}
+
+void* Segment::GetOrCreateEntry(const Slice& key) {
     void* entry = nullptr;
-    uint32_t byte_size = 0;
     int ret = entries_->Get(key, entry);
-    if (ret < 0 || entry == NULL) {
-        char* pk = new char[key.size()];
-        memcpy(pk, key.data(), key.size());
-        // need to delete memory when free node
-        Slice skey(pk, key.size());
-        entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
+    if (ret == 0 && entry != NULL) {
+        return entry;
+    }
+    char* pk = new char[key.size()];
+    memcpy(pk, key.data(), key.size());
+    // need to delete memory when free node
+    Slice skey(pk, key.size());
+    uint32_t byte_size = 0;
+    if (ts_cnt_ > 1) {
+        auto** entry_arr = new KeyEntry*[ts_cnt_];
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            entry_arr[i] = new KeyEntry(key_entry_max_height_);
+        }
+        entry = (void*)entry_arr;  // NOLINT
+        uint8_t height = entries_->Insert(skey, entry);
+        byte_size = GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
+    } else {
+        auto* key_entry = new KeyEntry(key_entry_max_height_);
+        entry = (void*)key_entry;  // NOLINT
         uint8_t height = entries_->Insert(skey, entry);
-        byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
-        pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        byte_size = GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
     }
-    idx_cnt_.fetch_add(1, std::memory_order_relaxed);
-    uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
-    ((KeyEntry*)entry)                                               // NOLINT
-        ->count_.fetch_add(1, std::memory_order_relaxed);
-    byte_size += GetRecordTsIdxSize(height);
     idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return entry;
+}
+
+bool Segment::PutToEntry(KeyEntry* entry, uint64_t time, DataBlock* row) {
+    uint8_t height = 0;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+        if (entry->removed_) {
+            return false;
+        }
+        height = entry->entries.Insert(time, row);
+    }
+    entry->count_.fetch_add(1, std::memory_order_relaxed);
+    idx_byte_size_.fetch_add(GetRecordTsIdxSize(height), std::memory_order_relaxed);
+    return true;
+}
+
+::openmldb::base::Node<Slice, void*>* Segment::RemoveIfEmpty(const Slice& key, KeyEntry* entry) {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::lock_guard<::openmldb::base::SpinMutex> entry_lock(entry->mu_);
+    if (entry->removed_ || !entry->IsEmpty()) {
+        return NULL;
+    }
+    entry->removed_ = true;
+    UntrackExpire(entry);
+    return entries_->Remove(key);
 }
 
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
-    void* key_entry_or_list = nullptr;
-    uint32_t byte_size = 0;
     std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
-    int ret = entries_->Get(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
     } else {
-        if (ret < 0 || key_entry_or_list == nullptr) {
-            char* pk = new char[key.size()];
-            memcpy(pk, key.data(), key.size());
-            Slice skey(pk, key.size());
-            auto** entry_arr_tmp = new KeyEntry*[ts_cnt_];
-            for (uint32_t i = 0; i < ts_cnt_; i++) {
-                entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
-            }
-            auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
-            uint8_t height = entries_->Insert(skey, entry_arr);
-            byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-            pk_cnt_.fetch_add(1, std::memory_order_relaxed);
-        }
-        uint8_t height = ((KeyEntry**)key_entry_or_list)[key_entry_id]->entries.Insert(  // NOLINT
-            time, row);
-        ((KeyEntry**)key_entry_or_list)[key_entry_id]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
-        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+        auto** entry_arr = (KeyEntry**)GetOrCreateEntry(key);  // NOLINT
+        PutToEntry(entry_arr[key_entry_id], time, row);
         idx_cnt_vec_[key_entry_id]->fetch_add(1, std::memory_order_relaxed);
     }
 }
@@ -236,54 +442,77 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
         }
         return;
     }
+    // the entries are found without mu_, hold them as the readers do until the rows are in
+    Ticket ticket;
     void* entry_arr = NULL;
-    std::lock_guard<std::mutex> lock(mu_);
+    if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
+        entry_arr = NULL;
+    } else {
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            ticket.Push(((KeyEntry**)entry_arr)[i]);  // NOLINT
+        }
+    }
     for (const auto& kv : ts_map) {
-        uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
         if (pos == ts_idx_map_.end()) {
             continue;
         }
-        if (entry_arr == NULL) {
-            int ret = entries_->Get(key, entry_arr);
-            if (ret < 0 || entry_arr == NULL) {
-                char* pk = new char[key.size()];
-                memcpy(pk, key.data(), key.size());
-                Slice skey(pk, key.size());
-                KeyEntry** entry_arr_tmp = new KeyEntry*[ts_cnt_];
-                for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
-                }
-                entry_arr = (void*)entry_arr_tmp;  // NOLINT
-                uint8_t height = entries_->Insert(skey, entry_arr);
-                byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
-                pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+        if (entry_arr == NULL || !PutToEntry(((KeyEntry**)entry_arr)[pos->second], kv.second, row)) {  // NOLINT
+            // the key is absent or its entries have been removed by gc or delete
+            std::lock_guard<std::mutex> lock(mu_);
+            entry_arr = GetOrCreateEntry(key);
+            // the rest of ts_map is put to the new entries without mu_
+            for (uint32_t i = 0; i < ts_cnt_; i++) {
+                ticket.Push(((KeyEntry**)entry_arr)[i]);  // NOLINT
             }
+            PutToEntry(((KeyEntry**)entry_arr)[pos->second], kv.second, row);  // NOLINT
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
-            kv.second, row);
-        ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
-        byte_size += GetRecordTsIdxSize(height);
-        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
         idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
     }
 }
 
-bool Segment::Get(const Slice& key, const uint64_t time, DataBlock** block) {
-    if (block == NULL || ts_cnt_ > 1) {
+// look up the row of time in the skiplist first and then in the frozen rows
+static bool GetFromEntry(KeyEntry* entry, uint64_t time, std::string* value) {
+    DataBlock* block = NULL;
+    if (entry->entries.Get(time, block) == 0 && block != NULL) {
+        value->assign(block->data, block->size);
+        return true;
+    }
+    // the cold blocks are replaced or deleted by gc and freeze with the lock of entry
+    std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+    for (const ColdBlock* cold = entry->GetCold(); cold != NULL; cold = cold->next) {
+        if (cold->GetMinTs() > time || cold->GetMaxTs() < time) {
+            continue;
+        }
+        std::string buf;
+        std::vector<std::pair<uint64_t, Slice>> rows;
+        if (!cold->Unpack(&buf, &rows)) {
+            PDLOG(WARNING, "unpack cold block failed, skip %u rows", cold->GetCount());
+            continue;
+        }
+        auto pos = std::lower_bound(rows.begin(), rows.end(), time,
+                                    [](const std::pair<uint64_t, Slice>& row, uint64_t ts) { return row.first > ts; });
+        if (pos != rows.end() && pos->first == time) {
+            value->assign(pos->second.data(), pos->second.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Segment::Get(const Slice& key, const uint64_t time, std::string* value) {
+    if (value == NULL || ts_cnt_ > 1) {
         return false;
     }
     void* entry = NULL;
     if (entries_->Get(key, entry) < 0 || entry == NULL) {
         return false;
     }
-    *block = ((KeyEntry*)entry)->entries.Get(time);  // NOLINT
-    return true;
+    return GetFromEntry((KeyEntry*)entry, time, value);  // NOLINT
 }
 
-bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock** block) {
-    if (block == NULL) {
+bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, std::string* value) {
+    if (value == NULL) {
         return false;
     }
     auto pos = ts_idx_map_.find(idx);
@@ -291,14 +520,13 @@ bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock
         return false;
     }
     if (ts_cnt_ == 1) {
-        return Get(key, time, block);
+        return Get(key, time, value);
     }
     void* entry = NULL;
     if (entries_->Get(key, entry) < 0 || entry == NULL) {
         return false;
     }
-    *block = ((KeyEntry**)entry)[pos->second]->entries.Get(time);  // NOLINT
-    return true;
+    return GetFromEntry(((KeyEntry**)entry)[pos->second], time, value);  // NOLINT
 }
 
 bool Segment::Delete(const Slice& key) {
@@ -309,6 +537,14 @@ bool Segment::Delete(const Slice& key) {
         if (entry_node == NULL) {
             return false;
         }
+        // make the writers which have found the entry without mu_ retry
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            KeyEntry* entry = ts_cnt_ > 1 ? ((KeyEntry**)entry_node->GetValue())[i]  // NOLINT
+                                          : (KeyEntry*)entry_node->GetValue();     // NOLINT
+            std::lock_guard<::openmldb::base::SpinMutex> entry_lock(entry->mu_);
+            entry->removed_ = true;
+            UntrackExpire(entry);
+        }
     }
     {
         std::lock_guard<std::mutex> lock(gc_mu_);
@@ -357,6 +593,8 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
                 FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
             delete it;
+            GcColdBlocks(entry, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+            idx_byte_size_.fetch_sub(GetExtByteSize(entry), std::memory_order_relaxed);
             delete entry;
             idx_cnt_vec_[i]->fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
         }
@@ -375,6 +613,10 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
             FreeList(data_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         }
         delete it;
+        GcColdBlocks(entry, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        // ReleaseAndCount frees the entries without the free list
+        UntrackExpire(entry);
+        idx_byte_size_.fetch_sub(GetExtByteSize(entry), std::memory_order_relaxed);
         delete entry;
         uint64_t byte_size =
             GetRecordPkIdxSize(entry_node->Height(), entry_node->GetKey().size(), key_entry_max_height_);
@@ -388,19 +630,43 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
     ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* node = NULL;
     {
         std::lock_guard<std::mutex> lock(gc_mu_);
+        if (!gc_pins_.empty()) {
+            uint64_t pin = *gc_pins_.begin();
+            if (pin == 0) {
+                return;
+            }
+            version = std::min(version, pin - 1);
+        }
         node = entry_free_list_->Split(version);
     }
     while (node != NULL) {
         ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
-        FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        delete entry_node;
         ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* tmp = node;
         node = node->GetNextNoBarrier(0);
         delete tmp;
+        if (IsReferenced(entry_node)) {
+            // still held by a ticket, try it again in the next gc
+            std::lock_guard<std::mutex> lock(gc_mu_);
+            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+            continue;
+        }
+        FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        delete entry_node;
         pk_cnt_.fetch_sub(1, std::memory_order_relaxed);
     }
 }
 
+bool Segment::IsReferenced(::openmldb::base::Node<Slice, void*>* entry_node) {
+    for (uint32_t i = 0; i < ts_cnt_; i++) {
+        KeyEntry* entry = ts_cnt_ > 1 ? ((KeyEntry**)entry_node->GetValue())[i]  // NOLINT
+                                      : (KeyEntry*)entry_node->GetValue();     // NOLINT
+        if (entry->refs_.load(std::memory_order_acquire) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Segment::GcFreeList(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
     uint64_t cur_version = gc_version_.load(std::memory_order_relaxed);
     if (cur_version < FLAGS_gc_deleted_pk_version_delta) {
@@ -486,13 +752,13 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
     while (it->Valid()) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+        uint64_t entry_gc_idx_cnt = 0;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                node = entry->entries.SplitByPos(keep_cnt);
+                node = GcEntryByPos(entry, keep_cnt, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             }
         }
-        uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
@@ -526,58 +792,67 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             KeyEntry* entry = entry_arr[pos->second];
             ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
             bool continue_flag = false;
+            uint64_t entry_gc_idx_cnt = 0;
             switch (kv.second.ttl_type) {
                 case ::openmldb::storage::TTLType::kAbsoluteTime: {
                     node = entry->entries.GetLast();
-                    if (node == NULL || node->GetKey() > kv.second.abs_ttl) {
+                    if ((node == NULL || node->GetKey() > kv.second.abs_ttl) &&
+                        !HasExpiredColdBlock(entry, kv.second.abs_ttl)) {
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
-                        SplitList(entry, kv.second.abs_ttl, &node);
-                        if (entry->entries.IsEmpty()) {
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+                        if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+                            node = entry->entries.Split(kv.second.abs_ttl);
+                            GcColdBlocks(entry, kv.second.abs_ttl, entry_gc_idx_cnt, gc_record_cnt,
+                                         gc_record_byte_size);
+                        }
+                        if (entry->IsEmpty()) {
                             empty_cnt++;
                         }
                     }
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                        node = entry->entries.SplitByPos(kv.second.lat_ttl);
+                        node = GcEntryByPos(entry, kv.second.lat_ttl, entry_gc_idx_cnt, gc_record_cnt,
+                                            gc_record_byte_size);
                     }
                     break;
                 }
                 case ::openmldb::storage::TTLType::kAbsAndLat: {
-                    node = entry->entries.GetLast();
-                    if (node == NULL || node->GetKey() > kv.second.abs_ttl) {
+                    uint64_t oldest_ts = 0;
+                    if (!GetOldestTs(entry, &oldest_ts) || oldest_ts > kv.second.abs_ttl) {
                         continue_flag = true;
                     } else {
-                        node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                            node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
+                            node = GcEntryByKeyAndPos(entry, kv.second.abs_ttl, kv.second.lat_ttl, true,
+                                                      entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
                         }
                     }
                     break;
                 }
                 case ::openmldb::storage::TTLType::kAbsOrLat: {
-                    node = entry->entries.GetLast();
-                    if (node == NULL) {
+                    if (entry->IsEmpty()) {
                         continue_flag = true;
                     } else {
-                        node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
-                                node = entry->entries.SplitByPos(kv.second.lat_ttl);
+                                node = GcEntryByPos(entry, kv.second.lat_ttl, entry_gc_idx_cnt, gc_record_cnt,
+                                                    gc_record_byte_size);
                             } else if (kv.second.lat_ttl == 0) {
                                 node = entry->entries.Split(kv.second.abs_ttl);
+                                GcColdBlocks(entry, kv.second.abs_ttl, entry_gc_idx_cnt, gc_record_cnt,
+                                             gc_record_byte_size);
                             } else {
-                                node = entry->entries.SplitByKeyOrPos(kv.second.abs_ttl, kv.second.lat_ttl);
+                                node = GcEntryByKeyAndPos(entry, kv.second.abs_ttl, kv.second.lat_ttl, false,
+                                                          entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
                             }
                         }
-                        if (entry->entries.IsEmpty()) {
+                        if (entry->IsEmpty()) {
                             empty_cnt++;
                         }
                     }
@@ -589,7 +864,6 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             if (continue_flag) {
                 continue;
             }
-            uint64_t entry_gc_idx_cnt = 0;
             FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
             idx_cnt_vec_[pos->second]->fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
@@ -601,14 +875,23 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             {
                 std::lock_guard<std::mutex> lock(mu_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    if (!entry_arr[i]->entries.IsEmpty()) {
+                    entry_arr[i]->mu_.lock();
+                }
+                for (uint32_t i = 0; i < ts_cnt_; i++) {
+                    if (entry_arr[i]->removed_ || !entry_arr[i]->IsEmpty()) {
                         is_empty = false;
                         break;
                     }
                 }
                 if (is_empty) {
+                    for (uint32_t i = 0; i < ts_cnt_; i++) {
+                        entry_arr[i]->removed_ = true;
+                    }
                     entry_node = entries_->Remove(key);
                 }
+                for (uint32_t i = 0; i < ts_cnt_; i++) {
+                    entry_arr[i]->mu_.unlock();
+                }
             }
             if (entry_node != NULL) {
                 std::lock_guard<std::mutex> lock(gc_mu_);
@@ -631,6 +914,12 @@ void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uin
 // fast gc with no global pause
 void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
                      uint64_t& gc_record_byte_size) {
+    if (IsTrackingExpire()) {
+        // the wheel is walked in slices, the rest is left to the next IncrementalGc
+        uint64_t deadline = ::baidu::common::timer::get_micros() + FLAGS_gc_incremental_slice_time * 1000;
+        IncrementalGc4TTL(time, deadline, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        return;
+    }
     uint64_t consumed = ::baidu::common::timer::get_micros();
     uint64_t old = gc_idx_cnt;
     KeyEntries::Iterator* it = entries_->NewIterator();
@@ -640,37 +929,116 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         Slice key = it->GetKey();
         it->Next();
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
-            continue;
-        } else if (node->GetKey() > time) {
-            DEBUGLOG(
-                "[Gc4TTL] segment gc with key %lu need not ttl, last node "
-                "key %lu",
-                time, node->GetKey());
+        if ((node == NULL || node->GetKey() > time) && !HasExpiredColdBlock(entry, time)) {
+            DEBUGLOG("[Gc4TTL] segment gc with key %lu need not ttl", time);
             continue;
         }
-        node = NULL;
-        ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        GcEntry4TTL(key, entry, time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    }
+    DEBUGLOG("[Gc4TTL] segment gc with key %lu ,consumed %lu, count %lu", time,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
+    idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
+    delete it;
+}
+
+void Segment::GcEntry4TTL(const Slice& key, KeyEntry* entry, const uint64_t time, uint64_t& gc_idx_cnt,
+                          uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+    ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+    bool is_empty = false;
+    uint64_t entry_gc_idx_cnt = 0;
+    {
+        std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+        if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+            node = entry->entries.Split(time);
+            GcColdBlocks(entry, time, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+        is_empty = entry->IsEmpty();
+    }
+    if (is_empty) {
+        entry_node = RemoveIfEmpty(key, entry);
+    }
+    if (entry_node != NULL) {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+    }
+    FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
+    gc_idx_cnt += entry_gc_idx_cnt;
+}
+
+bool Segment::IncrementalGc(const TTLSt& ttl_st, uint64_t deadline, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                            uint64_t& gc_record_byte_size) {
+    if (ttl_st.ttl_type != ::openmldb::storage::TTLType::kAbsoluteTime || ttl_st.abs_ttl == 0) {
+        return true;
+    }
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    uint64_t expire_time = cur_time - ttl_offset_ - ttl_st.abs_ttl;
+    return IncrementalGc4TTL(expire_time, deadline, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+}
+
+bool Segment::IncrementalGc4TTL(const uint64_t time, uint64_t deadline, uint64_t& gc_idx_cnt,
+                                uint64_t& gc_record_cnt, uint64_t& gc_record_byte_size) {
+    if (!IsTrackingExpire()) {
+        return true;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = gc_idx_cnt;
+    uint64_t max_bucket = time / EXPIRE_BUCKET_TIME;
+    // the entries popped from the wheel may be removed by Delete or the gc meanwhile, the pin keeps them
+    // on the free list until the walk is done
+    uint64_t pin = 0;
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        pin = gc_version_.load(std::memory_order_relaxed);
+        gc_pins_.insert(pin);
+    }
+    // the entries whose oldest rows are still in the visited buckets, add them back after the loop
+    std::vector<KeyEntry*> pending_entries;
+    uint64_t visit_cnt = 0;
+    bool finished = true;
+    while (true) {
+        if (deadline != UINT64_MAX && ::baidu::common::timer::get_micros() >= deadline) {
+            finished = false;
+            break;
+        }
+        KeyEntry* entry = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
-            SplitList(entry, time, &node);
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+            std::lock_guard<std::mutex> lock(wheel_mu_);
+            auto bucket_it = expire_wheel_.begin();
+            if (bucket_it == expire_wheel_.end() || bucket_it->first > max_bucket) {
+                break;
             }
+            entry = *bucket_it->second.begin();
+            UntrackExpireUnlock(entry);
         }
-        if (entry_node != NULL) {
-            std::lock_guard<std::mutex> lock(gc_mu_);
-            entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
+        visit_cnt++;
+        // a tracked entry has the ext with its key, both are kept until the entry is freed
+        const Slice& key = entry->ext_.load(std::memory_order_relaxed)->key;
+        GcEntry4TTL(key, entry, time, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        uint64_t oldest_ts = 0;
+        if (GetOldestTs(entry, &oldest_ts)) {
+            if (oldest_ts / EXPIRE_BUCKET_TIME <= max_bucket) {
+                pending_entries.push_back(entry);
+            } else {
+                TrackExpire(key, entry, oldest_ts);
+            }
         }
-        uint64_t entry_gc_idx_cnt = 0;
-        FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
-        gc_idx_cnt += entry_gc_idx_cnt;
     }
-    DEBUGLOG("[Gc4TTL] segment gc with key %lu ,consumed %lu, count %lu", time,
+    for (auto* entry : pending_entries) {
+        uint64_t oldest_ts = 0;
+        if (GetOldestTs(entry, &oldest_ts)) {
+            TrackExpire(entry->ext_.load(std::memory_order_relaxed)->key, entry, oldest_ts);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(gc_mu_);
+        gc_pins_.erase(gc_pins_.find(pin));
+    }
+    DEBUGLOG("[IncrementalGc4TTL] segment gc with key %lu, visit %lu keys, consumed %lu, count %lu", time, visit_cnt,
              (::baidu::common::timer::get_micros() - consumed) / 1000, gc_idx_cnt - old);
     idx_cnt_.fetch_sub(gc_idx_cnt - old, std::memory_order_relaxed);
-    delete it;
+    return finished;
 }
 
 void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
@@ -685,25 +1053,26 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
     it->SeekToFirst();
     while (it->Valid()) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         it->Next();
-        if (node == NULL) {
+        uint64_t oldest_ts = 0;
+        if (!GetOldestTs(entry, &oldest_ts)) {
             continue;
-        } else if (node->GetKey() > time) {
+        } else if (oldest_ts > time) {
             DEBUGLOG(
                 "[Gc4TTLAndHead] segment gc with key %lu need not ttl, last "
                 "node key %lu",
-                time, node->GetKey());
+                time, oldest_ts);
             continue;
         }
-        node = NULL;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
+        uint64_t entry_gc_idx_cnt = 0;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
+                node = GcEntryByKeyAndPos(entry, time, keep_cnt, true, entry_gc_idx_cnt, gc_record_cnt,
+                                          gc_record_byte_size);
             }
         }
-        uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
@@ -736,26 +1105,28 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         Slice key = it->GetKey();
         it->Next();
-        ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
-        if (node == NULL) {
+        if (entry->IsEmpty()) {
             continue;
         }
-        node = NULL;
+        ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
+        bool is_empty = false;
+        uint64_t entry_gc_idx_cnt = 0;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
-                node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
-            }
-            if (entry->entries.IsEmpty()) {
-                entry_node = entries_->Remove(key);
+                node = GcEntryByKeyAndPos(entry, time, keep_cnt, false, entry_gc_idx_cnt, gc_record_cnt,
+                                          gc_record_byte_size);
             }
+            is_empty = entry->IsEmpty();
+        }
+        if (is_empty) {
+            entry_node = RemoveIfEmpty(key, entry);
         }
         if (entry_node != NULL) {
             std::lock_guard<std::mutex> lock(gc_mu_);
             entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
         }
-        uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
         gc_idx_cnt += entry_gc_idx_cnt;
@@ -768,6 +1139,221 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
     delete it;
 }
 
+void Segment::Freeze(const uint64_t time, uint64_t& freeze_record_cnt, uint64_t& released_byte_size,
+                     uint64_t& cold_byte_size) {
+    uint64_t consumed = ::baidu::common::timer::get_micros();
+    uint64_t old = freeze_record_cnt;
+    KeyEntries::Iterator* it = entries_->NewIterator();
+    it->SeekToFirst();
+    while (it->Valid()) {
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            KeyEntry* entry = ts_cnt_ > 1 ? ((KeyEntry**)it->GetValue())[i]  // NOLINT
+                                          : (KeyEntry*)it->GetValue();     // NOLINT
+            ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
+            if (node == NULL || node->GetKey() > time) {
+                continue;
+            }
+            std::lock_guard<::openmldb::base::SpinMutex> lock(entry->mu_);
+            if (entry->refs_.load(std::memory_order_acquire) <= 0) {
+                FreezeEntry(entry, time, freeze_record_cnt, released_byte_size, cold_byte_size);
+            }
+        }
+        it->Next();
+    }
+    DEBUGLOG("[Freeze] segment freeze with key %lu consumed %lu, count %lu", time,
+             (::baidu::common::timer::get_micros() - consumed) / 1000, freeze_record_cnt - old);
+    delete it;
+}
+
+void Segment::FreezeEntry(KeyEntry* entry, uint64_t time, uint64_t& freeze_record_cnt, uint64_t& released_byte_size,
+                          uint64_t& cold_byte_size) {
+    std::vector<std::pair<uint64_t, Slice>> rows;
+    TimeEntries::Iterator* it = entry->entries.NewIterator();
+    it->Seek(time);
+    while (it->Valid()) {
+        rows.emplace_back(it->GetKey(), Slice(it->GetValue()->data, it->GetValue()->size));
+        it->Next();
+    }
+    delete it;
+    if (rows.empty()) {
+        return;
+    }
+    uint32_t freeze_cnt = rows.size();
+    // merge into the newest block until it is full, so that a key does not end up with lots of tiny blocks
+    KeyEntryExt* ext = GetOrCreateExt(entry);
+    ColdBlock* head = ext->cold.load(std::memory_order_relaxed);
+    std::string head_buf;
+    bool merge_head = false;
+    if (head != NULL && head->GetCount() + rows.size() <= MAX_COLD_BLOCK_ROW_CNT) {
+        std::vector<std::pair<uint64_t, Slice>> head_rows;
+        if (head->Unpack(&head_buf, &head_rows)) {
+            std::vector<std::pair<uint64_t, Slice>> merged;
+            merged.reserve(rows.size() + head_rows.size());
+            std::merge(rows.begin(), rows.end(), head_rows.begin(), head_rows.end(), std::back_inserter(merged),
+                       [](const std::pair<uint64_t, Slice>& a, const std::pair<uint64_t, Slice>& b) {
+                           return a.first > b.first;
+                       });
+            rows.swap(merged);
+            merge_head = true;
+        }
+    }
+    ColdBlock* block = ColdBlock::Pack(rows);
+    block->next = merge_head ? head->next : head;
+    cold_byte_size += block->GetByteSize();
+    // publish the cold block before unlinking the rows from skiplist
+    ext->cold.store(block, std::memory_order_release);
+    if (merge_head) {
+        released_byte_size += head->GetByteSize();
+        delete head;
+    }
+    ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.Split(time);
+    while (node != NULL) {
+        ::openmldb::base::Node<uint64_t, DataBlock*>* tmp = node;
+        idx_byte_size_.fetch_sub(GetRecordTsIdxSize(tmp->Height()), std::memory_order_relaxed);
+        node = node->GetNextNoBarrier(0);
+        if (tmp->GetValue()->dim_cnt_down > 1) {
+            tmp->GetValue()->dim_cnt_down--;
+        } else {
+            released_byte_size += GetRecordSize(tmp->GetValue()->size);
+            delete tmp->GetValue();
+        }
+        delete tmp;
+    }
+    freeze_record_cnt += freeze_cnt;
+}
+
+void Segment::GcColdBlocks(KeyEntry* entry, uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                           uint64_t& gc_record_byte_size) {
+    KeyEntryExt* ext = entry->ext_.load(std::memory_order_relaxed);
+    if (ext == NULL) {
+        return;
+    }
+    ColdBlock* pre = NULL;
+    ColdBlock* block = ext->cold.load(std::memory_order_relaxed);
+    while (block != NULL) {
+        ColdBlock* next = block->next;
+        if (block->GetMinTs() > time) {
+            pre = block;
+            block = next;
+            continue;
+        }
+        ColdBlock* remain = NULL;
+        if (block->GetMaxTs() > time) {
+            std::string buf;
+            std::vector<std::pair<uint64_t, Slice>> rows;
+            if (block->Unpack(&buf, &rows)) {
+                auto pos = std::find_if(rows.begin(), rows.end(),
+                                        [time](const std::pair<uint64_t, Slice>& row) { return row.first <= time; });
+                rows.erase(pos, rows.end());
+                remain = ColdBlock::Pack(rows);
+            } else {
+                PDLOG(WARNING, "unpack cold block failed, drop %u rows", block->GetCount());
+            }
+        }
+        uint32_t remain_cnt = 0;
+        uint64_t remain_byte_size = 0;
+        if (remain != NULL) {
+            remain->next = next;
+            remain_cnt = remain->GetCount();
+            remain_byte_size = remain->GetByteSize();
+        }
+        if (pre == NULL) {
+            ext->cold.store(remain != NULL ? remain : next, std::memory_order_release);
+        } else {
+            pre->next = remain != NULL ? remain : next;
+        }
+        gc_idx_cnt += block->GetCount() - remain_cnt;
+        gc_record_cnt += block->GetCount() - remain_cnt;
+        if (block->GetByteSize() > remain_byte_size) {
+            gc_record_byte_size += block->GetByteSize() - remain_byte_size;
+        }
+        delete block;
+        if (remain != NULL) {
+            pre = remain;
+        }
+        block = next;
+    }
+}
+
+bool Segment::GetExpireTsByPos(KeyEntry* entry, uint64_t keep_cnt, uint64_t* expire_ts) {
+    if (keep_cnt == 0) {
+        *expire_ts = UINT64_MAX;
+        return true;
+    }
+    // a min heap of the latest keep_cnt ts
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> latest;
+    TimeEntries::Iterator* it = entry->entries.NewIterator();
+    it->SeekToFirst();
+    while (it->Valid() && latest.size() < keep_cnt) {
+        latest.push(it->GetKey());
+        it->Next();
+    }
+    delete it;
+    for (const ColdBlock* block = entry->GetCold(); block != NULL; block = block->next) {
+        // none of the rows of the block is later than the latest keep_cnt rows found so far
+        if (latest.size() == keep_cnt && block->GetMaxTs() <= latest.top()) {
+            continue;
+        }
+        std::string buf;
+        std::vector<std::pair<uint64_t, Slice>> rows;
+        if (!block->Unpack(&buf, &rows)) {
+            PDLOG(WARNING, "unpack cold block failed, skip %u rows", block->GetCount());
+            continue;
+        }
+        for (const auto& row : rows) {
+            if (latest.size() < keep_cnt) {
+                latest.push(row.first);
+            } else if (row.first > latest.top()) {
+                latest.pop();
+                latest.push(row.first);
+            } else {
+                break;
+            }
+        }
+    }
+    // the rows of the same ts as the keep_cnt-th latest one are all kept
+    if (latest.size() < keep_cnt || latest.top() == 0) {
+        return false;
+    }
+    *expire_ts = latest.top() - 1;
+    return true;
+}
+
+::openmldb::base::Node<uint64_t, DataBlock*>* Segment::GcEntryByPos(KeyEntry* entry, uint64_t keep_cnt,
+                                                                   uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt,
+                                                                   uint64_t& gc_record_byte_size) {
+    if (entry->GetCold() == NULL) {
+        return entry->entries.SplitByPos(keep_cnt);
+    }
+    uint64_t expire_ts = 0;
+    if (!GetExpireTsByPos(entry, keep_cnt, &expire_ts)) {
+        return NULL;
+    }
+    GcColdBlocks(entry, expire_ts, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    return entry->entries.Split(expire_ts);
+}
+
+::openmldb::base::Node<uint64_t, DataBlock*>* Segment::GcEntryByKeyAndPos(KeyEntry* entry, uint64_t time,
+                                                                         uint64_t keep_cnt, bool and_pos,
+                                                                         uint64_t& gc_idx_cnt,
+                                                                         uint64_t& gc_record_cnt,
+                                                                         uint64_t& gc_record_byte_size) {
+    if (entry->GetCold() == NULL) {
+        return and_pos ? entry->entries.SplitByKeyAndPos(time, keep_cnt)
+                       : entry->entries.SplitByKeyOrPos(time, keep_cnt);
+    }
+    uint64_t expire_ts = 0;
+    if (GetExpireTsByPos(entry, keep_cnt, &expire_ts)) {
+        expire_ts = and_pos ? std::min(time, expire_ts) : std::max(time, expire_ts);
+    } else if (and_pos) {
+        return NULL;
+    } else {
+        expire_ts = time;
+    }
+    GcColdBlocks(entry, expire_ts, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    return entry->entries.Split(expire_ts);
+}
+
 int Segment::GetCount(const Slice& key, uint64_t& count) {
     if (ts_cnt_ > 1) {
         return -1;
@@ -806,8 +1392,8 @@ MemTableIterator* Segment::NewIterator(const Slice& key, Ticket& ticket) {
     if (entries_->Get(key, entry) < 0 || entry == NULL) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push((KeyEntry*)entry);                                           // NOLINT
-    return new MemTableIterator(((KeyEntry*)entry)->entries.NewIterator());  // NOLINT
+    ticket.Push((KeyEntry*)entry);                                   // NOLINT
+    return new MemTableIterator(((KeyEntry*)entry)->NewIterator());  // NOLINT
 }
 
 MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& ticket) {
@@ -822,11 +1408,172 @@ MemTableIterator* Segment::NewIterator(const Slice& key, uint32_t idx, Ticket& t
     if (entries_->Get(key, entry_arr) < 0 || entry_arr == NULL) {
         return new MemTableIterator(NULL);
     }
-    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                         // NOLINT
-    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->entries.NewIterator());  // NOLINT
+    ticket.Push(((KeyEntry**)entry_arr)[pos->second]);                                 // NOLINT
+    return new MemTableIterator(((KeyEntry**)entry_arr)[pos->second]->NewIterator());  // NOLINT
+}
+
+KeyEntryIterator::KeyEntryIterator(TimeEntries::Iterator* it, const ColdBlock* cold)
+    : it_(it),
+      cold_(),
+      cold_next_(0),
+      cold_seek_ts_(UINT64_MAX),
+      cold_cur_(-1),
+      hot_end_(false),
+      on_hot_(true),
+      valid_(false),
+      key_(0),
+      value_(NULL) {
+    for (const ColdBlock* block = cold; block != NULL; block = block->next) {
+        cold_.emplace_back(block);
+    }
+    // blocks may overlap if some stale rows arrived after the last freeze
+    std::stable_sort(cold_.begin(), cold_.end(), [](const ColdCursor& a, const ColdCursor& b) {
+        return a.block->GetMaxTs() > b.block->GetMaxTs();
+    });
+}
+
+KeyEntryIterator::~KeyEntryIterator() { delete it_; }
+
+void KeyEntryIterator::Decode(ColdCursor* cursor) {
+    std::string buf;
+    std::vector<std::pair<uint64_t, Slice>> rows;
+    if (!cursor->block->Unpack(&buf, &rows)) {
+        PDLOG(WARNING, "unpack cold block failed, skip %u rows", cursor->block->GetCount());
+        rows.clear();
+    }
+    uint64_t arena_size = 0;
+    for (const auto& row : rows) {
+        arena_size += (sizeof(DataBlock) + row.second.size() + 7) & ~7UL;
+    }
+    cursor->arena.reset(new char[arena_size]);
+    char* mem = cursor->arena.get();
+    cursor->rows.reserve(rows.size());
+    for (const auto& row : rows) {
+        cursor->rows.emplace_back(row.first, DataBlock::NewBlock(mem, 1, row.second.data(), row.second.size()));
+        mem += (sizeof(DataBlock) + row.second.size() + 7) & ~7UL;
+    }
+}
+
+void KeyEntryIterator::Activate(ColdCursor* cursor) {
+    if (cursor->block->GetMinTs() > cold_seek_ts_) {
+        // all the rows are before the seek position
+        return;
+    }
+    if (!cursor->arena) {
+        Decode(cursor);
+    }
+    cursor->active = true;
+    if (cursor->block->GetMaxTs() <= cold_seek_ts_) {
+        cursor->pos = 0;
+        return;
+    }
+    cursor->pos = std::lower_bound(cursor->rows.begin(), cursor->rows.end(), cold_seek_ts_,
+                                   [](const std::pair<uint64_t, DataBlock*>& row, uint64_t ts) {
+                                       return row.first > ts;
+                                   }) -
+                  cursor->rows.begin();
+}
+
+void KeyEntryIterator::ResetCold(uint64_t time) {
+    cold_seek_ts_ = time;
+    cold_next_ = 0;
+    cold_cur_ = -1;
+    for (auto& cursor : cold_) {
+        cursor.active = false;
+    }
+}
+
+void KeyEntryIterator::SettleCold() {
+    bool hot_valid = HotValid();
+    while (true) {
+        cold_cur_ = -1;
+        for (uint32_t i = 0; i < cold_next_; i++) {
+            if (cold_[i].Valid() && (cold_cur_ < 0 || cold_[i].GetTs() > cold_[cold_cur_].GetTs())) {
+                cold_cur_ = i;
+            }
+        }
+        if (cold_next_ >= cold_.size()) {
+            return;
+        }
+        // the blocks behind can't hold a row later than the current rows
+        uint64_t bound = std::min(cold_[cold_next_].block->GetMaxTs(), cold_seek_ts_);
+        if ((hot_valid && it_->GetKey() >= bound) ||
+            (cold_cur_ >= 0 && cold_[cold_cur_].GetTs() >= bound)) {
+            return;
+        }
+        Activate(&cold_[cold_next_++]);
+    }
+}
+
+void KeyEntryIterator::Settle() {
+    SettleCold();
+    bool hot_valid = HotValid();
+    if (!hot_valid && cold_cur_ < 0) {
+        valid_ = false;
+        return;
+    }
+    valid_ = true;
+    if (hot_valid && (cold_cur_ < 0 || it_->GetKey() >= cold_[cold_cur_].GetTs())) {
+        on_hot_ = true;
+        key_ = it_->GetKey();
+        value_ = it_->GetValue();
+    } else {
+        on_hot_ = false;
+        const auto& cursor = cold_[cold_cur_];
+        key_ = cursor.rows[cursor.pos].first;
+        value_ = cursor.rows[cursor.pos].second;
+    }
+}
+
+void KeyEntryIterator::Next() {
+    if (!valid_) {
+        return;
+    }
+    if (on_hot_) {
+        it_->Next();
+    } else {
+        cold_[cold_cur_].pos++;
+    }
+    Settle();
+}
+
+void KeyEntryIterator::Seek(const uint64_t time) {
+    hot_end_ = false;
+    it_->Seek(time);
+    ResetCold(time);
+    Settle();
+}
+
+void KeyEntryIterator::SeekToFirst() {
+    hot_end_ = false;
+    it_->SeekToFirst();
+    ResetCold(UINT64_MAX);
+    Settle();
+}
+
+void KeyEntryIterator::SeekToLast() {
+    hot_end_ = false;
+    it_->SeekToLast();
+    ResetCold(UINT64_MAX);
+    // only the block holding the oldest row is decompressed
+    int32_t last = -1;
+    for (uint32_t i = 0; i < cold_.size(); i++) {
+        if (last < 0 || cold_[i].block->GetMinTs() <= cold_[last].block->GetMinTs()) {
+            last = i;
+        }
+    }
+    cold_next_ = cold_.size();
+    if (last >= 0 && (!it_->Valid() || it_->GetKey() > cold_[last].block->GetMinTs())) {
+        Activate(&cold_[last]);
+        if (!cold_[last].rows.empty()) {
+            hot_end_ = true;
+            cold_[last].pos = cold_[last].rows.size() - 1;
+        }
+    }
+    Settle();
 }
 
-MemTableIterator::MemTableIterator(TimeEntries::Iterator* it) : it_(it) {}
+MemTableIterator::MemTableIterator(KeyEntryIterator* it) : it_(it) {}
 
 MemTableIterator::~MemTableIterator() {
     if (it_ != NULL) {
@@ -21,11 +21,18 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <new>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
 #include "base/slice.h"
+#include "base/spinlock.h"
 #include "proto/tablet.pb.h"
+#include "storage/cold_block.h"
 #include "storage/iterator.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
@@ -43,16 +50,19 @@ class Ticket;
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // the row is stored right after the block in the same allocation
+    bool inline_data;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), inline_data(false), size(len), data(NULL) {
         data = new char[len];
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+        : dim_cnt_down(dim_cnt), inline_data(false), size(len), data(NULL) {
         if (skip_copy) {
             data = input;
         } else {
@@ -61,10 +71,31 @@ struct DataBlock {
         }
     }
 
+    // Allocate the block header and a copy of the row with a single malloc
+    static DataBlock* NewBlock(uint8_t dim_cnt, const char* input, uint32_t len) {
+        return NewBlock(::operator new(sizeof(DataBlock) + len), dim_cnt, input, len);
+    }
+
+    // Build the block in mem which holds sizeof(DataBlock) + len bytes at least
+    static DataBlock* NewBlock(void* mem, uint8_t dim_cnt, const char* input, uint32_t len) {
+        auto* block = new (mem) DataBlock(dim_cnt, len);
+        memcpy(block->data, input, len);
+        return block;
+    }
+
+    // the allocated size of an inline block differs from sizeof(DataBlock)
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
     ~DataBlock() {
-        delete[] data;
+        if (!inline_data) {
+            delete[] data;
+        }
         data = NULL;
     }
+
+ private:
+    DataBlock(uint8_t dim_cnt, uint32_t len)
+        : dim_cnt_down(dim_cnt), inline_data(true), size(len), data(reinterpret_cast<char*>(this + 1)) {}
 };
 
 // the desc time comparator
@@ -82,9 +113,71 @@ struct TimeComparator {
 static const TimeComparator tcmp;
 typedef ::openmldb::base::Skiplist<uint64_t, DataBlock*, TimeComparator> TimeEntries;
 
+// Iterate the rows of a key entry in ts desc order. The rows in skiplist are
+// merged with the frozen rows. A cold block is decompressed only when the
+// iterator reaches its ts range, and the blocks out of the seek range are
+// skipped by their min/max ts without decompressing
+class KeyEntryIterator {
+ public:
+    KeyEntryIterator(TimeEntries::Iterator* it, const ColdBlock* cold);
+    ~KeyEntryIterator();
+    KeyEntryIterator(const KeyEntryIterator&) = delete;
+    KeyEntryIterator& operator=(const KeyEntryIterator&) = delete;
+
+    bool Valid() const { return valid_; }
+    void Next();
+    const uint64_t& GetKey() const { return key_; }
+    DataBlock* GetValue() const { return value_; }
+    // the current row is decoded from a cold block, it is freed with the iterator
+    bool IsCold() const { return valid_ && !on_hot_; }
+    void Seek(const uint64_t time);
+    void SeekToFirst();
+    void SeekToLast();
+
+ private:
+    // the decoded rows of a cold block, which are kept until the iterator is
+    // deleted so the returned data blocks stay valid
+    struct ColdCursor {
+        explicit ColdCursor(const ColdBlock* cold_block) : block(cold_block), pos(0), active(false) {}
+        const ColdBlock* block;
+        std::vector<std::pair<uint64_t, DataBlock*>> rows;
+        // the memory of the data blocks in rows
+        std::unique_ptr<char[]> arena;
+        uint32_t pos;
+        bool active;
+        bool Valid() const { return active && pos < rows.size(); }
+        uint64_t GetTs() const { return rows[pos].first; }
+    };
+
+    bool HotValid() const { return !hot_end_ && it_->Valid(); }
+    void Decode(ColdCursor* cursor);
+    // activate the cursor and position it at cold_seek_ts_
+    void Activate(ColdCursor* cursor);
+    void ResetCold(uint64_t time);
+    // find the cursor of the next cold row, activate the blocks which may
+    // hold a row not later than the next hot row
+    void SettleCold();
+    void Settle();
+
+ private:
+    TimeEntries::Iterator* it_;
+    // sorted by max ts in desc order
+    std::vector<ColdCursor> cold_;
+    // the blocks before it have been activated or skipped since the last seek
+    uint32_t cold_next_;
+    uint64_t cold_seek_ts_;
+    // the cursor of the current cold row, -1 means no cold row
+    int32_t cold_cur_;
+    bool hot_end_;
+    bool on_hot_;
+    bool valid_;
+    uint64_t key_;
+    DataBlock* value_;
+};
+
 class MemTableIterator : public TableIterator {
  public:
-    explicit MemTableIterator(TimeEntries::Iterator* it);
+    explicit MemTableIterator(KeyEntryIterator* it);
     virtual ~MemTableIterator();
     void Seek(const uint64_t time) override;
     bool Valid() override;
@@ -95,14 +188,28 @@ class MemTableIterator : public TableIterator {
     void SeekToLast() override;
 
  private:
-    TimeEntries::Iterator* it_;
+    KeyEntryIterator* it_;
+};
+
+// The state of a key which only the frozen rows and the expire wheel use. It is allocated with the lock of the
+// entry the first time one of them needs it and freed with the entry, so the keys without them don't pay for it
+struct KeyEntryExt {
+    KeyEntryExt() : cold(NULL), expire_bucket(UINT64_MAX), key(NULL, 0) {}
+    // the frozen rows, modified with the lock of the entry
+    std::atomic<ColdBlock*> cold;
+    // the expire wheel bucket the key is registered in, UINT64_MAX means not registered
+    std::atomic<uint64_t> expire_bucket;
+    // the key owned by the key node of the segment, the expire wheel finds the key of the entry by it.
+    // NULL data means it is not set yet
+    Slice key;
 };
 
 class KeyEntry {
  public:
-    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0) {}
-    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0) {}
-    ~KeyEntry() {}
+    KeyEntry() : entries(12, 4, tcmp), refs_(0), mu_(), removed_(false), count_(0), ext_(NULL) {}
+    explicit KeyEntry(uint8_t height)
+        : entries(height, 4, tcmp), refs_(0), mu_(), removed_(false), count_(0), ext_(NULL) {}
+    ~KeyEntry() { delete ext_.load(std::memory_order_relaxed); }
 
     // just return the count of datablock
     uint64_t Release() {
@@ -122,9 +229,33 @@ class KeyEntry {
         }
         entries.Clear();
         delete it;
+        KeyEntryExt* ext = ext_.load(std::memory_order_relaxed);
+        ColdBlock* cold = ext == NULL ? NULL : ext->cold.exchange(NULL, std::memory_order_relaxed);
+        while (cold != NULL) {
+            cnt += cold->GetCount();
+            ColdBlock* tmp = cold;
+            cold = cold->next;
+            delete tmp;
+        }
         return cnt;
     }
 
+    // iterate both the rows in skiplist and the frozen rows, delete it after it's used
+    KeyEntryIterator* NewIterator() { return new KeyEntryIterator(entries.NewIterator(), GetCold()); }
+
+    bool IsEmpty() { return entries.IsEmpty() && GetCold() == NULL; }
+
+    // the newest cold block of the frozen rows, which are older than all rows in entries usually
+    ColdBlock* GetCold() const {
+        KeyEntryExt* ext = ext_.load(std::memory_order_acquire);
+        return ext == NULL ? NULL : ext->cold.load(std::memory_order_acquire);
+    }
+
+    uint64_t GetExpireBucket() const {
+        KeyEntryExt* ext = ext_.load(std::memory_order_acquire);
+        return ext == NULL ? UINT64_MAX : ext->expire_bucket.load(std::memory_order_relaxed);
+    }
+
     void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
 
     void UnRef() { refs_.fetch_sub(1, std::memory_order_relaxed); }
@@ -133,8 +264,15 @@ class KeyEntry {
 
  public:
     TimeEntries entries;
-    std::atomic<uint64_t> refs_;
+    // the tickets holding the entry, it shares a word with mu_ and removed_
+    std::atomic<uint32_t> refs_;
+    // writers and gc of the entries serialize on this lock instead of the segment lock
+    ::openmldb::base::SpinMutex mu_;
+    // the entry has been unlinked from the segment, guarded by mu_
+    bool removed_;
     std::atomic<uint64_t> count_;
+    // NULL until the key has frozen rows or is tracked by the expire wheel, set with mu_
+    std::atomic<KeyEntryExt*> ext_;
     friend Segment;
 };
 
@@ -157,16 +295,20 @@ class Segment {
 
     void Put(const Slice& key, uint64_t time, DataBlock* row);
 
+    // need to hold mu_
     void PutUnlock(const Slice& key, uint64_t time, DataBlock* row);
 
     void BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row);
 
     void Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
 
-    // Get time data
-    bool Get(const Slice& key, uint64_t time, DataBlock** block);
+    // wait for the running puts of key. a put of key after it sees what is done before it
+    void WaitPut(const Slice& key);
 
-    bool Get(const Slice& key, uint32_t idx, uint64_t time, DataBlock** block);
+    // Get time data, the frozen rows are searched if the row is not in skiplist
+    bool Get(const Slice& key, uint64_t time, std::string* value);
+
+    bool Get(const Slice& key, uint32_t idx, uint64_t time, std::string* value);
 
     bool Delete(const Slice& key);
 
@@ -191,6 +333,18 @@ class Segment {
                       uint64_t& gc_idx_cnt,                                            // NOLINT
                       uint64_t& gc_record_cnt,                                         // NOLINT
                       uint64_t& gc_record_byte_size);                                  // NOLINT
+    // gc the abs ttl only with the keys in the expired buckets of the expire wheel,
+    // return false if deadline(us) is reached before all of them are visited
+    bool IncrementalGc(const TTLSt& ttl_st, uint64_t deadline, uint64_t& gc_idx_cnt,  // NOLINT
+                       uint64_t& gc_record_cnt,                                        // NOLINT
+                       uint64_t& gc_record_byte_size);                                 // NOLINT
+    bool IncrementalGc4TTL(const uint64_t time, uint64_t deadline, uint64_t& gc_idx_cnt,  // NOLINT
+                           uint64_t& gc_record_cnt,                                       // NOLINT
+                           uint64_t& gc_record_byte_size);                                // NOLINT
+    // pack the rows not later than time into the cold blocks of each key
+    void Freeze(const uint64_t time, uint64_t& freeze_record_cnt,  // NOLINT
+                uint64_t& released_byte_size,                      // NOLINT
+                uint64_t& cold_byte_size);                         // NOLINT
     void GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt,                                            // NOLINT
                    uint64_t& gc_record_byte_size);                                     // NOLINT
@@ -214,6 +368,11 @@ class Segment {
 
     inline uint64_t GetTsCnt() { return ts_cnt_; }
 
+    // whether the oldest ts of each key is tracked in the expire wheel
+    inline bool IsTrackingExpire() const { return track_expire_.load(std::memory_order_relaxed); }
+    // only an absolute ttl drains the wheel, the keys already in the segment are walked once when it is turned on
+    void SetTrackExpire(bool track);
+
     int GetTsIdx(uint32_t raw_idx, uint32_t& real_idx) {  // NOLINT
         auto iter = ts_idx_map_.find(raw_idx);
         if (iter == ts_idx_map_.end()) {
@@ -251,18 +410,67 @@ class Segment {
                   uint64_t& gc_record_byte_size);  // NOLINT
     void SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uint64_t, DataBlock*>** node);
 
+    // need to hold mu_, return the KeyEntry or KeyEntry array of the key and create it if not exists
+    void* GetOrCreateEntry(const Slice& key);
+    // return false if the entry has been removed from the segment
+    bool PutToEntry(KeyEntry* entry, uint64_t time, DataBlock* row);
+    // need to hold the lock of entry
+    void FreezeEntry(KeyEntry* entry, uint64_t time, uint64_t& freeze_record_cnt,  // NOLINT
+                     uint64_t& released_byte_size,                                 // NOLINT
+                     uint64_t& cold_byte_size);                                    // NOLINT
+    // need to hold the lock of entry, drop the frozen rows not later than time
+    void GcColdBlocks(KeyEntry* entry, uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
+                      uint64_t& gc_record_cnt,                               // NOLINT
+                      uint64_t& gc_record_byte_size);                        // NOLINT
+    // need to hold the lock of entry, keep the latest keep_cnt rows of both the rows in skiplist and the frozen
+    // rows. The frozen rows are gc here, the rows split from skiplist are returned to be freed without the lock
+    ::openmldb::base::Node<uint64_t, DataBlock*>* GcEntryByPos(KeyEntry* entry, uint64_t keep_cnt,
+                                                              uint64_t& gc_idx_cnt,            // NOLINT
+                                                              uint64_t& gc_record_cnt,         // NOLINT
+                                                              uint64_t& gc_record_byte_size);  // NOLINT
+    // need to hold the lock of entry, drop the rows which are not later than time and (and_pos) or (!and_pos)
+    // not in the latest keep_cnt rows. The rows split from skiplist are returned as GcEntryByPos does
+    ::openmldb::base::Node<uint64_t, DataBlock*>* GcEntryByKeyAndPos(KeyEntry* entry, uint64_t time,
+                                                                    uint64_t keep_cnt, bool and_pos,
+                                                                    uint64_t& gc_idx_cnt,            // NOLINT
+                                                                    uint64_t& gc_record_cnt,         // NOLINT
+                                                                    uint64_t& gc_record_byte_size);  // NOLINT
+    // need to hold the lock of entry, get the ts not later than which the rows are out of the latest keep_cnt rows
+    // of both skiplist and the frozen rows. The rows put out of order may be frozen after some older rows are put to
+    // skiplist, so the rows are ranked by ts instead of by their position. return false if no row is out of them
+    bool GetExpireTsByPos(KeyEntry* entry, uint64_t keep_cnt, uint64_t* expire_ts);
+    // need to hold the lock of entry, allocate the ext of entry if it has none
+    KeyEntryExt* GetOrCreateExt(KeyEntry* entry);
+    // register the entry in the expire wheel if time is older than its registered bucket, the key is only
+    // used to find the key owned by the segment when the entry is tracked the first time
+    void TrackExpire(const Slice& key, KeyEntry* entry, uint64_t time);
+    // need to hold wheel_mu_, remove the entry from its bucket
+    void UntrackExpireUnlock(KeyEntry* entry);
+    // need to hold the lock of entry, call it before the entry goes to the free list
+    void UntrackExpire(KeyEntry* entry);
+    void GcEntry4TTL(const Slice& key, KeyEntry* entry, const uint64_t time, uint64_t& gc_idx_cnt,  // NOLINT
+                     uint64_t& gc_record_cnt,                                                      // NOLINT
+                     uint64_t& gc_record_byte_size);                                               // NOLINT
+    // unlink the entry of the key if it is still empty
+    ::openmldb::base::Node<Slice, void*>* RemoveIfEmpty(const Slice& key, KeyEntry* entry);
+
     void GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt,  // NOLINT
                          uint64_t& gc_record_cnt,                 // NOLINT
                          uint64_t& gc_record_byte_size);          // NOLINT
+    // whether any entry of the node is held by a ticket
+    bool IsReferenced(::openmldb::base::Node<Slice, void*>* entry_node);
     void FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64_t& gc_idx_cnt,  // NOLINT
                    uint64_t& gc_record_cnt,         // NOLINT
                    uint64_t& gc_record_byte_size);  // NOLINT
 
  private:
     KeyEntries* entries_;
-    // only Put need mutex
+    // guard the insertion and removal of key entries, puts to an existing key only lock the KeyEntry
     std::mutex mu_;
     std::mutex gc_mu_;
+    // guarded by gc_mu_, the gc versions at which the running wheel walks started. The entries they pop from the
+    // wheel may be removed and put to the free list meanwhile, so the free list is not freed from these versions on
+    std::multiset<uint64_t> gc_pins_;
     std::atomic<uint64_t> idx_cnt_;
     std::atomic<uint64_t> idx_byte_size_;
     std::atomic<uint64_t> pk_cnt_;
@@ -273,6 +481,11 @@ class Segment {
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    std::atomic<bool> track_expire_;
+    // the entries grouped by the bucket of their oldest ts, an entry is in one bucket at most and it is
+    // removed from the wheel before it is unlinked from the segment. The wheel is counted in idx_byte_size_
+    std::mutex wheel_mu_;
+    std::map<uint64_t, std::unordered_set<KeyEntry*>> expire_wheel_;
 };
 
 }  // namespace storage
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "base/slice.h"
+#include "benchmark/benchmark.h"
+#include "storage/segment.h"
+
+namespace openmldb {
+namespace storage {
+
+static Segment* segment = nullptr;
+// emulates the segment wide lock which all writers contended on before the key entries were inserted without it
+static std::mutex segment_mu;
+
+// range(0): 1 to put under the segment wide lock, 0 to put as the tablet does
+// range(1): 1 for all writers to put to one key, 0 for a key per writer
+static void BM_SegmentPut(benchmark::State& state) {  // NOLINT
+    if (state.thread_index == 0) {
+        segment = new Segment();
+    }
+    bool serialize = state.range(0) == 1;
+    std::string pk = state.range(1) == 1 ? "pk" : "pk" + std::to_string(state.thread_index);
+    ::openmldb::base::Slice key(pk);
+    uint64_t ts = 0;
+    for (auto _ : state) {
+        if (serialize) {
+            std::lock_guard<std::mutex> lock(segment_mu);
+            segment->Put(key, ++ts, "test", 4);
+        } else {
+            segment->Put(key, ++ts, "test", 4);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index == 0) {
+        delete segment;
+        segment = nullptr;
+    }
+}
+
+BENCHMARK(BM_SegmentPut)
+    ->ArgNames({"serialize", "shared_key"})
+    ->Args({1, 0})
+    ->Args({0, 0})
+    ->Args({1, 1})
+    ->Args({0, 1})
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+}  // namespace storage
+}  // namespace openmldb
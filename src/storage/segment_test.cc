@@ -16,14 +16,19 @@
 
 #include "storage/segment.h"
 
-#include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "base/glog_wapper.h"
 #include "base/slice.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
+#include "storage/mem_table.h"
 #include "storage/record.h"
 
+DECLARE_uint32(skiplist_max_height);
+
 using ::openmldb::base::Slice;
 
 namespace openmldb {
@@ -37,7 +42,8 @@ class SegmentTest : public ::testing::Test {
 
 TEST_F(SegmentTest, Size) {
     ASSERT_EQ(16, (int64_t)sizeof(DataBlock));
-    ASSERT_EQ(40, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(48, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(32, (int64_t)sizeof(KeyEntryExt));
 }
 
 TEST_F(SegmentTest, DataBlock) {
@@ -51,19 +57,29 @@ TEST_F(SegmentTest, DataBlock) {
     delete db;
 }
 
+TEST_F(SegmentTest, InlineDataBlock) {
+    const char* test = "test";
+    DataBlock* db = DataBlock::NewBlock(2, test, 4);
+    ASSERT_TRUE(db->inline_data);
+    ASSERT_EQ(2, (int64_t)db->dim_cnt_down);
+    ASSERT_EQ(4, (int64_t)db->size);
+    ASSERT_EQ(reinterpret_cast<char*>(db + 1), db->data);
+    ASSERT_EQ(std::string(test, 4), std::string(db->data, db->size));
+    delete db;
+}
+
 TEST_F(SegmentTest, PutAndGet) {
     Segment segment;
     const char* test = "test";
     Slice pk("pk");
     segment.Put(pk, 9768, test, 4);
-    DataBlock* db = NULL;
-    bool ret = segment.Get(pk, 9768, &db);
+    std::string t;
+    bool ret = segment.Get(pk, 9768, &t);
     ASSERT_TRUE(ret);
-    ASSERT_TRUE(db != NULL);
-    ASSERT_EQ(4, (int64_t)db->size);
-    std::string t(db->data, (int64_t)db->size);
+    ASSERT_EQ(4, (int64_t)t.size());
     std::string e = "test";
     ASSERT_EQ(e, t);
+    ASSERT_FALSE(segment.Get(pk, 9769, &t));
 }
 
 TEST_F(SegmentTest, PutAndScan) {
@@ -100,23 +116,30 @@ TEST_F(SegmentTest, Delete) {
     segment.Put(pk, 9528, value.c_str(), value.size());
     segment.Put(pk, 9529, value.c_str(), value.size());
     ASSERT_EQ(1, (int64_t)segment.GetPkCnt());
-    Ticket ticket;
-    MemTableIterator* it = segment.NewIterator("test1", ticket);
-    int size = 0;
-    it->SeekToFirst();
-    while (it->Valid()) {
-        it->Next();
-        size++;
-    }
-    ASSERT_EQ(4, size);
-    delete it;
-    ASSERT_TRUE(segment.Delete(pk));
-    it = segment.NewIterator("test1", ticket);
-    ASSERT_FALSE(it->Valid());
-    delete it;
     uint64_t gc_idx_cnt = 0;
     uint64_t gc_record_cnt = 0;
     uint64_t gc_record_byte_size = 0;
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator("test1", ticket);
+        int size = 0;
+        it->SeekToFirst();
+        while (it->Valid()) {
+            it->Next();
+            size++;
+        }
+        ASSERT_EQ(4, size);
+        delete it;
+        ASSERT_TRUE(segment.Delete(pk));
+        it = segment.NewIterator("test1", ticket);
+        ASSERT_FALSE(it->Valid());
+        delete it;
+        // the entry held by the ticket is kept in the free list
+        segment.IncrGcVersion();
+        segment.IncrGcVersion();
+        segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    }
     segment.IncrGcVersion();
     segment.IncrGcVersion();
     segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
@@ -250,6 +273,417 @@ TEST_F(SegmentTest, TestGc4TTL) {
     ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, IncrementalGc4TTL) {
+    Segment segment;
+    ASSERT_FALSE(segment.IsTrackingExpire());
+    segment.SetTrackExpire(true);
+    ASSERT_TRUE(segment.IsTrackingExpire());
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "PK" + std::to_string(i);
+        segment.Put(pk, 1000 + i, "test1", 5);
+        segment.Put(pk, 200000, "test2", 5);
+    }
+    segment.Put("NEW", 500000, "test3", 5);
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // the slice is over before any key is visited
+    ASSERT_FALSE(segment.IncrementalGc4TTL(1004, 1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(0, (int64_t)gc_idx_cnt);
+    ASSERT_TRUE(segment.IncrementalGc4TTL(1004, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(5, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(5, (int64_t)gc_record_cnt);
+    ASSERT_EQ(5 * GetRecordSize(5), (int64_t)gc_record_byte_size);
+    // the keys which still have rows in the visited bucket are visited again
+    ASSERT_TRUE(segment.IncrementalGc4TTL(100000, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(10, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(11, (int64_t)segment.GetIdxCnt());
+    ASSERT_TRUE(segment.IncrementalGc4TTL(300000, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(20, (int64_t)gc_idx_cnt);
+    uint64_t count = 0;
+    ASSERT_EQ(-1, segment.GetCount("PK0", count));
+    ASSERT_EQ(0, segment.GetCount("NEW", count));
+    ASSERT_EQ(1, (int64_t)count);
+    // a row older than the tracked one moves the key to an earlier bucket
+    segment.Put("NEW", 1000, "test4", 5);
+    ASSERT_TRUE(segment.IncrementalGc4TTL(2000, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(21, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(0, segment.GetCount("NEW", count));
+    ASSERT_EQ(1, (int64_t)count);
+}
+
+TEST_F(SegmentTest, ExpireWheelByteSize) {
+    // the skiplist nodes are of height 1, so the index sizes of the two segments differ only in the wheel
+    uint32_t old_max_height = FLAGS_skiplist_max_height;
+    FLAGS_skiplist_max_height = 1;
+    Segment untracked(1);
+    Segment segment(1);
+    FLAGS_skiplist_max_height = old_max_height;
+    segment.SetTrackExpire(true);
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "PK" + std::to_string(i);
+        for (auto* seg : {&untracked, &segment}) {
+            seg->Put(pk, 1000 + i, "test1", 5);
+            seg->Put(pk, 200000, "test2", 5);
+        }
+    }
+    // each key is in one bucket of the wheel and has an ext
+    ASSERT_EQ(untracked.GetIdxByteSize() + 10 * (3 * sizeof(void*) + sizeof(KeyEntryExt)), segment.GetIdxByteSize());
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    ASSERT_TRUE(segment.IncrementalGc4TTL(300000, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    untracked.Gc4TTL(300000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(40, (int64_t)gc_idx_cnt);
+    // the removed keys leave the wheel, the exts are freed with the entries
+    ASSERT_EQ(untracked.GetIdxByteSize() + 10 * sizeof(KeyEntryExt), segment.GetIdxByteSize());
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+        untracked.IncrGcVersion();
+    }
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    untracked.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(untracked.GetIdxByteSize(), segment.GetIdxByteSize());
+}
+
+TEST_F(SegmentTest, SetTrackExpire) {
+    uint32_t old_max_height = FLAGS_skiplist_max_height;
+    FLAGS_skiplist_max_height = 1;
+    Segment untracked(1);
+    Segment segment(1);
+    FLAGS_skiplist_max_height = old_max_height;
+    for (int i = 0; i < 10; i++) {
+        std::string pk = "PK" + std::to_string(i);
+        for (auto* seg : {&untracked, &segment}) {
+            seg->Put(pk, 1000 + i, "test1", 5);
+            seg->Put(pk, 200000, "test2", 5);
+        }
+    }
+    ASSERT_EQ(untracked.GetIdxByteSize(), segment.GetIdxByteSize());
+    // the keys put before are added to the wheel
+    segment.SetTrackExpire(true);
+    ASSERT_EQ(untracked.GetIdxByteSize() + 10 * (3 * sizeof(void*) + sizeof(KeyEntryExt)), segment.GetIdxByteSize());
+    // a deleted key leaves the wheel before it goes to the free list
+    ASSERT_TRUE(segment.Delete(Slice("PK0")));
+    ASSERT_TRUE(untracked.Delete(Slice("PK0")));
+    ASSERT_EQ(untracked.GetIdxByteSize() + 9 * 3 * sizeof(void*) + 10 * sizeof(KeyEntryExt), segment.GetIdxByteSize());
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    for (int i = 0; i < 3; i++) {
+        segment.IncrGcVersion();
+    }
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(2, (int64_t)gc_idx_cnt);
+    ASSERT_TRUE(segment.IncrementalGc4TTL(100000, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(11, (int64_t)gc_idx_cnt);
+    segment.SetTrackExpire(false);
+    ASSERT_FALSE(segment.IsTrackingExpire());
+    // the wheel is cleared and the following puts are not tracked
+    segment.Put("PK1", 100, "test1", 5);
+    untracked.Put("PK1", 100, "test1", 5);
+    ASSERT_TRUE(segment.IncrementalGc4TTL(300000, UINT64_MAX, gc_idx_cnt, gc_record_cnt, gc_record_byte_size));
+    ASSERT_EQ(11, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(10, (int64_t)segment.GetIdxCnt());
+}
+
+TEST_F(SegmentTest, FreezeAndIterate) {
+    Segment segment;
+    Slice pk("PK");
+    for (uint64_t ts = 1000; ts < 1010; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    uint64_t freeze_record_cnt = 0;
+    uint64_t released_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    segment.Freeze(1004, freeze_record_cnt, released_byte_size, cold_byte_size);
+    ASSERT_EQ(5, (int64_t)freeze_record_cnt);
+    ASSERT_EQ(5 * GetRecordSize(9), released_byte_size);
+    ASSERT_GT(cold_byte_size, 0u);
+    // a stale row arrives after the freeze and the next freeze merges it into the cold block
+    segment.Put(pk, 1002, "stale", 5);
+    segment.Freeze(1004, freeze_record_cnt, released_byte_size, cold_byte_size);
+    ASSERT_EQ(6, (int64_t)freeze_record_cnt);
+    segment.Put(pk, 1003, "stale", 5);
+    ASSERT_EQ(12, (int64_t)segment.GetIdxCnt());
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->SeekToFirst();
+    std::vector<uint64_t> keys;
+    while (it->Valid()) {
+        keys.push_back(it->GetKey());
+        it->Next();
+    }
+    std::vector<uint64_t> expect = {1009, 1008, 1007, 1006, 1005, 1004, 1003, 1003, 1002, 1002, 1001, 1000};
+    ASSERT_EQ(expect, keys);
+    it->Seek(1001);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(1001, (int64_t)it->GetKey());
+    ::openmldb::base::Slice value = it->GetValue();
+    ASSERT_EQ("value1001", std::string(value.data(), value.size()));
+    it->SeekToLast();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(1000, (int64_t)it->GetKey());
+    delete it;
+
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    ticket.Pop();
+    segment.Gc4TTL(1001, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(2, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(2, (int64_t)gc_record_cnt);
+    ASSERT_EQ(10, (int64_t)segment.GetIdxCnt());
+    segment.Gc4TTL(1009, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(12, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+    ASSERT_EQ(1, (int64_t)segment.GetPkCnt());
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(0, (int64_t)segment.GetPkCnt());
+}
+
+TEST_F(SegmentTest, IterateColdBlocks) {
+    Segment segment;
+    Slice pk("PK");
+    // the first freeze packs 4000 rows into a block, the second one can't be merged into it
+    for (uint64_t ts = 1000; ts < 5200; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+        if (ts == 4999) {
+            uint64_t freeze_record_cnt = 0;
+            uint64_t released_byte_size = 0;
+            uint64_t cold_byte_size = 0;
+            segment.Freeze(4999, freeze_record_cnt, released_byte_size, cold_byte_size);
+            ASSERT_EQ(4000, (int64_t)freeze_record_cnt);
+        }
+    }
+    uint64_t freeze_record_cnt = 0;
+    uint64_t released_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    segment.Freeze(5199, freeze_record_cnt, released_byte_size, cold_byte_size);
+    ASSERT_EQ(200, (int64_t)freeze_record_cnt);
+    for (uint64_t ts = 10000; ts < 10010; ts++) {
+        segment.Put(pk, ts, "hot", 3);
+    }
+    Ticket ticket;
+    MemTableIterator* it = segment.NewIterator(pk, ticket);
+    it->Seek(5100);
+    uint64_t expect = 5100;
+    while (it->Valid()) {
+        ASSERT_EQ(expect, it->GetKey());
+        ::openmldb::base::Slice value = it->GetValue();
+        ASSERT_EQ("value" + std::to_string(expect), std::string(value.data(), value.size()));
+        expect--;
+        it->Next();
+    }
+    ASSERT_EQ(999u, expect);
+    it->Seek(3000);
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(3000u, it->GetKey());
+    it->SeekToFirst();
+    ASSERT_EQ(10009u, it->GetKey());
+    delete it;
+    ticket.Pop();
+
+    // latest ttl keeps the hot rows and the newest cold rows
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4Head(110, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(4100, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(4100, (int64_t)gc_record_cnt);
+    ASSERT_EQ(110, (int64_t)segment.GetIdxCnt());
+    it = segment.NewIterator(pk, ticket);
+    it->SeekToLast();
+    ASSERT_TRUE(it->Valid());
+    ASSERT_EQ(5100u, it->GetKey());
+    delete it;
+}
+
+TEST_F(SegmentTest, GetFrozenRow) {
+    Segment segment;
+    Slice pk("PK");
+    for (uint64_t ts = 1000; ts < 1010; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    uint64_t freeze_record_cnt = 0;
+    uint64_t released_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    segment.Freeze(1004, freeze_record_cnt, released_byte_size, cold_byte_size);
+    ASSERT_EQ(5, (int64_t)freeze_record_cnt);
+    std::string value;
+    ASSERT_TRUE(segment.Get(pk, 1002, &value));
+    ASSERT_EQ("value1002", value);
+    ASSERT_TRUE(segment.Get(pk, 1007, &value));
+    ASSERT_EQ("value1007", value);
+    ASSERT_FALSE(segment.Get(pk, 999, &value));
+}
+
+TEST_F(SegmentTest, ReadColdRowAfterIterator) {
+    Segment segment;
+    Slice pk("PK");
+    for (uint64_t ts = 1000; ts < 1010; ts++) {
+        std::string value = "value" + std::to_string(ts);
+        segment.Put(pk, ts, value.c_str(), value.size());
+    }
+    uint64_t freeze_record_cnt = 0;
+    uint64_t released_byte_size = 0;
+    uint64_t cold_byte_size = 0;
+    segment.Freeze(1004, freeze_record_cnt, released_byte_size, cold_byte_size);
+    ASSERT_EQ(5, (int64_t)freeze_record_cnt);
+    void* entry = NULL;
+    ASSERT_EQ(0, segment.GetKeyEntries()->Get(pk, entry));
+    std::vector<::hybridse::codec::Row> rows;
+    {
+        MemTableWindowIterator it(((KeyEntry*)entry)->NewIterator(), TTLType::kAbsoluteTime, 0, 0);  // NOLINT
+        it.SeekToFirst();
+        while (it.Valid()) {
+            rows.push_back(it.GetValue());
+            it.Next();
+        }
+    }
+    // the decoded cold blocks have been freed with the iterator
+    ASSERT_EQ(10u, rows.size());
+    for (uint64_t i = 0; i < rows.size(); i++) {
+        std::string value(reinterpret_cast<const char*>(rows[i].buf()), rows[i].size());
+        ASSERT_EQ("value" + std::to_string(1009 - i), value);
+    }
+}
+
+TEST_F(SegmentTest, GcFrozenRowsAfterTTLChange) {
+    auto put_and_freeze = [](Segment* segment, const std::vector<std::string>& pks) {
+        for (const auto& pk : pks) {
+            for (uint64_t ts = 1000; ts < 1010; ts++) {
+                segment->Put(Slice(pk), ts, "test", 4);
+            }
+        }
+        uint64_t freeze_record_cnt = 0;
+        uint64_t released_byte_size = 0;
+        uint64_t cold_byte_size = 0;
+        // freeze all rows so that the skiplists of the keys are empty
+        segment->Freeze(1009, freeze_record_cnt, released_byte_size, cold_byte_size);
+        ASSERT_EQ(10 * pks.size(), freeze_record_cnt);
+    };
+    {
+        Segment segment;
+        put_and_freeze(&segment, {"PK1", "PK2"});
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        // keep the rows later than 1004 or in the latest 3
+        segment.Gc4TTLAndHead(1004, 3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(10, (int64_t)gc_idx_cnt);
+        ASSERT_EQ(10, (int64_t)gc_record_cnt);
+        ASSERT_EQ(10, (int64_t)segment.GetIdxCnt());
+        std::string value;
+        ASSERT_TRUE(segment.Get("PK1", 1005, &value));
+        ASSERT_FALSE(segment.Get("PK1", 1004, &value));
+    }
+    {
+        Segment segment;
+        put_and_freeze(&segment, {"PK1", "PK2"});
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        // keep the rows later than 1004 and in the latest 3
+        segment.Gc4TTLOrHead(1004, 3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(14, (int64_t)gc_idx_cnt);
+        ASSERT_EQ(14, (int64_t)gc_record_cnt);
+        ASSERT_EQ(6, (int64_t)segment.GetIdxCnt());
+        std::string value;
+        ASSERT_TRUE(segment.Get("PK2", 1007, &value));
+        ASSERT_FALSE(segment.Get("PK2", 1006, &value));
+        segment.Gc4TTLOrHead(1010, 3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(20, (int64_t)gc_idx_cnt);
+        ASSERT_EQ(0, (int64_t)segment.GetIdxCnt());
+    }
+    {
+        std::vector<uint32_t> ts_idx_vec = {1, 3};
+        Segment segment(8, ts_idx_vec);
+        std::map<int32_t, uint64_t> ts_map;
+        for (uint64_t ts = 1000; ts < 1010; ts++) {
+            ts_map[1] = ts;
+            ts_map[3] = ts;
+            segment.Put(Slice("PK"), ts_map, DataBlock::NewBlock(2, "test", 4));
+        }
+        uint64_t freeze_record_cnt = 0;
+        uint64_t released_byte_size = 0;
+        uint64_t cold_byte_size = 0;
+        segment.Freeze(1009, freeze_record_cnt, released_byte_size, cold_byte_size);
+        ASSERT_EQ(20, (int64_t)freeze_record_cnt);
+        std::map<uint32_t, TTLSt> ttl_st_map;
+        ttl_st_map.emplace(1, TTLSt(1004, 3, ::openmldb::storage::kAbsAndLat));
+        ttl_st_map.emplace(3, TTLSt(1004, 3, ::openmldb::storage::kAbsOrLat));
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        segment.GcAllType(ttl_st_map, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(12, (int64_t)gc_idx_cnt);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetIdxCnt(1, count));
+        ASSERT_EQ(5, (int64_t)count);
+        ASSERT_EQ(0, segment.GetIdxCnt(3, count));
+        ASSERT_EQ(3, (int64_t)count);
+        std::string value;
+        ASSERT_TRUE(segment.Get("PK", 1, 1005, &value));
+        ASSERT_FALSE(segment.Get("PK", 3, 1005, &value));
+    }
+}
+
+TEST_F(SegmentTest, GcFrozenRowsPutOutOfOrder) {
+    // the rows put after the freeze are older than the frozen ones
+    auto put_and_freeze = [](Segment* segment) {
+        for (uint64_t ts = 1000; ts < 1010; ts++) {
+            segment->Put(Slice("PK"), ts, "test", 4);
+        }
+        uint64_t freeze_record_cnt = 0;
+        uint64_t released_byte_size = 0;
+        uint64_t cold_byte_size = 0;
+        segment->Freeze(1009, freeze_record_cnt, released_byte_size, cold_byte_size);
+        ASSERT_EQ(10, (int64_t)freeze_record_cnt);
+        for (uint64_t ts = 990; ts < 995; ts++) {
+            segment->Put(Slice("PK"), ts, "test", 4);
+        }
+    };
+    {
+        Segment segment;
+        put_and_freeze(&segment);
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        segment.Gc4Head(3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(12, (int64_t)gc_idx_cnt);
+        ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+        std::string value;
+        ASSERT_TRUE(segment.Get("PK", 1007, &value));
+        ASSERT_FALSE(segment.Get("PK", 1006, &value));
+        ASSERT_FALSE(segment.Get("PK", 994, &value));
+    }
+    {
+        Segment segment;
+        put_and_freeze(&segment);
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        // keep the rows later than 1005 or in the latest 3
+        segment.Gc4TTLAndHead(1005, 3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(11, (int64_t)gc_idx_cnt);
+        std::string value;
+        ASSERT_TRUE(segment.Get("PK", 1006, &value));
+        ASSERT_FALSE(segment.Get("PK", 1005, &value));
+        ASSERT_FALSE(segment.Get("PK", 994, &value));
+        // keep the rows later than 1005 and in the latest 3
+        segment.Gc4TTLOrHead(1005, 3, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        ASSERT_EQ(12, (int64_t)gc_idx_cnt);
+        ASSERT_EQ(3, (int64_t)segment.GetIdxCnt());
+    }
+}
+
 TEST_F(SegmentTest, TestGc4TTLAndHead) {
     Segment segment;
     segment.Put("PK1", 9766, "test1", 5);
@@ -395,18 +829,85 @@ TEST_F(SegmentTest, PutAndGetTS) {
     }
     DataBlock db(1, "test1", 5);
     segment.Put(pk, ts_map, &db);
-    DataBlock* result = NULL;
-    bool ret = segment.Get(pk, 0, 1101, &result);
+    std::string t;
+    bool ret = segment.Get(pk, 0, 1101, &t);
     ASSERT_FALSE(ret);
-    ret = segment.Get(pk, 1, 1101, &result);
+    ret = segment.Get(pk, 1, 1101, &t);
     ASSERT_TRUE(ret);
-    ASSERT_TRUE(result != NULL);
-    ASSERT_EQ(5, (int64_t)result->size);
-    std::string t(result->data, result->size);
+    ASSERT_EQ(5, (int64_t)t.size());
     std::string e = "test1";
     ASSERT_EQ(e, t);
 }
 
+TEST_F(SegmentTest, ConcurrentPutWithGc) {
+    Segment segment;
+    uint32_t thread_num = 8;
+    uint32_t key_num = 100;
+    uint32_t put_num = 2000;
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        workers.emplace_back([&segment, i, key_num, put_num]() {
+            for (uint32_t j = 0; j < put_num; j++) {
+                std::string pk = "pk" + std::to_string(j % key_num);
+                segment.Put(Slice(pk), 10000 + i * put_num + j, "test", 4);
+            }
+        });
+    }
+    workers.emplace_back([&segment]() {
+        uint64_t gc_idx_cnt = 0;
+        uint64_t gc_record_cnt = 0;
+        uint64_t gc_record_byte_size = 0;
+        for (int i = 0; i < 10; i++) {
+            segment.Gc4TTL(9000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+    });
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQ(thread_num * put_num, segment.GetIdxCnt());
+    ASSERT_EQ(key_num, segment.GetPkCnt());
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < key_num; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        uint64_t count = 0;
+        ASSERT_EQ(0, segment.GetCount(Slice(pk), count));
+        total += count;
+    }
+    ASSERT_EQ(thread_num * put_num, total);
+}
+
+TEST_F(SegmentTest, ConcurrentPutAndDelete) {
+    Segment segment;
+    uint32_t thread_num = 8;
+    uint32_t key_num = 4;
+    uint32_t put_num = 5000;
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        workers.emplace_back([&segment, i, key_num, put_num]() {
+            for (uint32_t j = 0; j < put_num; j++) {
+                std::string pk = "pk" + std::to_string(j % key_num);
+                segment.Put(Slice(pk), i * put_num + j, "test", 4);
+            }
+        });
+    }
+    // the writers which have found an entry without the segment lock race with its removal and free
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    workers.emplace_back([&]() {
+        for (int i = 0; i < 200; i++) {
+            segment.Delete(Slice("pk" + std::to_string(i % key_num)));
+            segment.IncrGcVersion();
+            segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        }
+    });
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    // a row is either in a live or removed entry or freed with its entry
+    ASSERT_EQ(thread_num * put_num, segment.GetIdxCnt() + gc_idx_cnt);
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -30,7 +30,8 @@ namespace storage {
 
 const std::string MANIFEST = "MANIFEST";  // NOLINT
 
-int Snapshot::GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term) {
+int Snapshot::GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term,
+                          const std::vector<std::string>& parts) {
     DEBUGLOG("record offset[%lu]. add snapshot[%s] key_count[%lu]", offset, snapshot_name.c_str(), key_count);
     std::string full_path = snapshot_path_ + MANIFEST;
     std::string tmp_file = snapshot_path_ + MANIFEST + ".tmp";
@@ -40,6 +41,9 @@ int Snapshot::GenManifest(const std::string& snapshot_name, uint64_t key_count,
     manifest.set_name(snapshot_name);
     manifest.set_count(key_count);
     manifest.set_term(term);
+    for (const auto& part : parts) {
+        manifest.add_parts(part);
+    }
     manifest_info.clear();
     google::protobuf::TextFormat::PrintToString(manifest, &manifest_info);
     FILE* fd_write = fopen(tmp_file.c_str(), "w");
@@ -81,5 +85,16 @@ int Snapshot::GetLocalManifest(const std::string& full_path, ::openmldb::api::Ma
     return 0;
 }
 
+std::vector<std::string> Snapshot::GetSnapshotFiles(const ::openmldb::api::Manifest& manifest) {
+    std::vector<std::string> files;
+    if (manifest.has_name()) {
+        files.push_back(manifest.name());
+    }
+    for (const auto& part : manifest.parts()) {
+        files.push_back(part);
+    }
+    return files;
+}
+
 }  // namespace storage
 }  // namespace openmldb
@@ -15,6 +15,8 @@
  */
 
 #include <gflags/gflags.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
 #include <sched.h>
@@ -24,6 +26,7 @@
 #include <unistd.h>
 
 #include <iostream>
+#include <memory>
 
 #include "base/file_util.h"
 #include "base/glog_wapper.h"
@@ -42,6 +45,11 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_string(binlog_compression);
+DECLARE_uint32(snapshot_thread_num);
+DECLARE_bool(snapshot_recover_mmap);
+// the default keeps the test quick, raise it to compare the recovery of a large table with and without mmap
+DEFINE_uint64(recover_snapshot_mmap_rows, 100000, "the rows of the snapshot recovered by Recover_snapshot_mmap");
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -96,7 +104,7 @@ bool RollWLogFile(WriteHandle** wh, LogParts* logs, const std::string& log_path,
         return false;
     }
     logs->Insert(binlog_index, offset);
-    *wh = new WriteHandle("off", name, fd);
+    *wh = new WriteHandle(FLAGS_binlog_compression, name, fd, 0, true);
     binlog_index++;
     return true;
 }
@@ -346,6 +354,43 @@ TEST_F(SnapshotTest, Recover_only_binlog) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SnapshotTest, Recover_binlog_with_torn_tail) {
+    std::string binlog_dir = FLAGS_db_root_path + "/5_5/binlog/";
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, binlog_dir, binlog_index, offset);
+    for (int count = 0; count < 10; count++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key", "value" + std::to_string(count), count + 1, 0);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ASSERT_TRUE(wh->Write(::openmldb::base::Slice(buffer)).ok());
+    }
+    delete wh;
+    // the process exits in the middle of writing a block
+    std::string full_path = binlog_dir + "/" + ::openmldb::base::FormatToString(0, 8) + ".log";
+    FILE* fd = fopen(full_path.c_str(), "ab");
+    ASSERT_TRUE(fd != NULL);
+    std::string torn(30, '\x01');
+    ASSERT_EQ(torn.size(), fwrite(torn.data(), 1, torn.size(), fd));
+    fclose(fd);
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    for (int i = 0; i < 2; i++) {
+        // the end of log is written over the torn block, the binlog can be recovered again
+        std::shared_ptr<MemTable> table =
+            std::make_shared<MemTable>("test", 5, 5, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        uint64_t latest_offset = 0;
+        Binlog binlog(log_part, binlog_dir);
+        ASSERT_TRUE(binlog.RecoverFromBinlog(table, 0, latest_offset));
+        ASSERT_EQ(10u, latest_offset);
+        ASSERT_EQ(10u, table->GetRecordCnt());
+    }
+}
+
 TEST_F(SnapshotTest, Recover_only_snapshot_multi) {
     std::string snapshot_dir = FLAGS_db_root_path + "/3_2/snapshot";
     std::string binlog_dir = FLAGS_db_root_path + "/3_2/binlog";
@@ -722,6 +767,81 @@ TEST_F(SnapshotTest, Recover_only_snapshot) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SnapshotTest, Recover_snapshot_mmap) {
+    std::string snapshot_dir = FLAGS_db_root_path + "/3_3/snapshot";
+    ::openmldb::base::MkdirRecur(snapshot_dir);
+    std::string snapshot1 = "20170609.sdb";
+    if (FLAGS_snapshot_compression != "off") {
+        snapshot1.append(".");
+        snapshot1.append(FLAGS_snapshot_compression);
+    }
+    uint64_t count = FLAGS_recover_snapshot_mmap_rows;
+    {
+        std::string full_path = snapshot_dir + "/" + snapshot1;
+        FILE* fd_w = fopen(full_path.c_str(), "ab+");
+        ASSERT_TRUE(fd_w != NULL);
+        ::openmldb::log::WritableFile* wf = ::openmldb::log::NewWritableFile(snapshot1, fd_w);
+        ::openmldb::log::Writer writer(FLAGS_snapshot_compression, wf);
+        for (uint64_t i = 0; i < count; i++) {
+            std::string value = "value" + std::to_string(i);
+            if (i % 1000 == 0) {
+                // fragmented in the file
+                value.append(10000, 'a');
+            }
+            auto entry = ::openmldb::test::PackKVEntry(i + 1, "key" + std::to_string(i % 100), value, i + 1, 1);
+            if (i % 1000 == 1) {
+                // fields out of the decoded ones make recovery parse the LogEntry
+                entry.set_pk("key" + std::to_string(i % 100));
+            }
+            std::string val;
+            ASSERT_TRUE(entry.SerializeToString(&val));
+            ASSERT_TRUE(writer.AddRecord(Slice(val)).ok());
+        }
+        writer.EndLog();
+        delete wf;
+    }
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::vector<std::shared_ptr<MemTable>> tables;
+    for (bool use_mmap : {true, false}) {
+        FLAGS_snapshot_recover_mmap = use_mmap;
+        std::shared_ptr<MemTable> table =
+            std::make_shared<MemTable>("test", 3, 3, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+        table->Init();
+        LogParts* log_part = new LogParts(12, 4, scmp);
+        MemTableSnapshot snapshot(3, 3, log_part, FLAGS_db_root_path);
+        ASSERT_TRUE(snapshot.Init());
+        ASSERT_EQ(0, snapshot.GenManifest(snapshot1, count, count, 1));
+        uint64_t offset = 0;
+        ASSERT_TRUE(snapshot.Recover(table, offset));
+        ASSERT_EQ(count, offset);
+        ASSERT_EQ(count, table->GetRecordCnt());
+        tables.push_back(table);
+    }
+    FLAGS_snapshot_recover_mmap = true;
+    for (uint64_t i = 0; i < 100; i++) {
+        std::string key = "key" + std::to_string(i);
+        Ticket ticket1;
+        Ticket ticket2;
+        std::unique_ptr<TableIterator> it1(tables[0]->NewIterator(key, ticket1));
+        std::unique_ptr<TableIterator> it2(tables[1]->NewIterator(key, ticket2));
+        it1->SeekToFirst();
+        it2->SeekToFirst();
+        uint64_t num = 0;
+        while (it1->Valid()) {
+            ASSERT_TRUE(it2->Valid());
+            ASSERT_EQ(it2->GetKey(), it1->GetKey());
+            ASSERT_EQ(it2->GetValue().ToString(), it1->GetValue().ToString());
+            it1->Next();
+            it2->Next();
+            num++;
+        }
+        ASSERT_FALSE(it2->Valid());
+        ASSERT_EQ(count / 100, num);
+    }
+    RemoveData(FLAGS_db_root_path);
+}
+
 TEST_F(SnapshotTest, MakeSnapshot) {
     LogParts* log_part = new LogParts(12, 4, scmp);
     MemTableSnapshot snapshot(1, 2, log_part, FLAGS_db_root_path);
@@ -854,6 +974,93 @@ TEST_F(SnapshotTest, MakeSnapshot) {
     ASSERT_EQ(7, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeMultiFileSnapshot) {
+    uint32_t old_thread_num = FLAGS_snapshot_thread_num;
+    FLAGS_snapshot_thread_num = 3;
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(1, 6, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("tx_log", 1, 1, 8, mapping, 2, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/1_6/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/1_6/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset++);
+    auto write_entries = [&](int start, int end) {
+        for (int count = start; count < end; count++) {
+            auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count), "value",
+                                                        ::baidu::common::timer::get_micros() / 1000, 5);
+            std::string buffer;
+            entry.SerializeToString(&buffer);
+            wh->Write(::openmldb::base::Slice(buffer));
+            offset++;
+        }
+    };
+    // the first snapshot reads the three binlog files by three threads
+    for (int i = 0; i < 3; i++) {
+        if (i > 0) {
+            RollWLogFile(&wh, log_part, log_path, binlog_index, offset - 1);
+        }
+        write_entries(i * 10, i * 10 + 10);
+    }
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(30, (int64_t)offset_value);
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_path + "MANIFEST", &manifest));
+    ASSERT_EQ(30, (int64_t)manifest.offset());
+    ASSERT_EQ(30, (int64_t)manifest.count());
+    ASSERT_EQ(2, manifest.parts_size());
+
+    // the readers without parts reject the manifest instead of loading the first file only
+    ::google::protobuf::DescriptorProto old_manifest;
+    ::openmldb::api::Manifest::descriptor()->CopyTo(&old_manifest);
+    ASSERT_EQ("parts", old_manifest.field(old_manifest.field_size() - 1).name());
+    old_manifest.mutable_field()->RemoveLast();
+    ::google::protobuf::FileDescriptorProto old_file;
+    old_file.set_name("old_manifest.proto");
+    *old_file.add_message_type() = old_manifest;
+    ::google::protobuf::DescriptorPool pool;
+    ASSERT_TRUE(pool.BuildFile(old_file) != NULL);
+    ::google::protobuf::DynamicMessageFactory factory;
+    std::unique_ptr<::google::protobuf::Message> old_reader(
+        factory.GetPrototype(pool.FindMessageTypeByName("Manifest"))->New());
+    std::string manifest_text;
+    ::google::protobuf::TextFormat::PrintToString(manifest, &manifest_text);
+    ASSERT_FALSE(::google::protobuf::TextFormat::ParseFromString(manifest_text, old_reader.get()));
+    std::vector<std::string> vec;
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(4, (int32_t)vec.size());
+
+    // the old files are filtered by the threads and replaced by the new ones
+    write_entries(30, 50);
+    sleep(1);
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    manifest.Clear();
+    ASSERT_EQ(0, GetManifest(snapshot_path + "MANIFEST", &manifest));
+    ASSERT_EQ(50, (int64_t)manifest.offset());
+    ASSERT_EQ(50, (int64_t)manifest.count());
+    vec.clear();
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(4, (int32_t)vec.size());
+
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("tx_log", 1, 1, 8, mapping, 2, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    MemTableSnapshot new_snapshot(1, 6, log_part, FLAGS_db_root_path);
+    new_snapshot.Init();
+    uint64_t latest_offset = 0;
+    ASSERT_TRUE(new_snapshot.Recover(new_table, latest_offset));
+    ASSERT_EQ(50, (int64_t)latest_offset);
+    ASSERT_EQ(50, (int64_t)new_table->GetRecordCnt());
+    FLAGS_snapshot_thread_num = old_thread_num;
+}
+
 TEST_F(SnapshotTest, MakeSnapshot_with_delete_index) {
     LogParts* log_part = new LogParts(12, 4, scmp);
     MemTableSnapshot snapshot(1, 3, log_part, FLAGS_db_root_path);
@@ -1721,6 +1928,7 @@ int main(int argc, char** argv) {
         std::cout << "compress type: " << vec[i] << std::endl;
         FLAGS_db_root_path = "/tmp/" + std::to_string(::openmldb::storage::GenRand());
         FLAGS_snapshot_compression = vec[i];
+        FLAGS_binlog_compression = vec[i];
         ret += RUN_ALL_TESTS();
     }
     return ret;
@@ -0,0 +1,525 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/window_aggr_cache.h"
+
+#include <algorithm>
+
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t SEED = 0xe17a1465;
+// the links of a node in the hash map of the states
+static const uint64_t STATE_NODE_OVERHEAD = 2 * sizeof(void*);
+
+using ::openmldb::type::DataType;
+
+bool GetWindowAggrFunc(const std::string& name, WindowAggrFunc* func) {
+    if (name == "sum") {
+        *func = WindowAggrFunc::kSum;
+    } else if (name == "min") {
+        *func = WindowAggrFunc::kMin;
+    } else if (name == "max") {
+        *func = WindowAggrFunc::kMax;
+    } else if (name == "count") {
+        *func = WindowAggrFunc::kCount;
+    } else if (name == "avg") {
+        *func = WindowAggrFunc::kAvg;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+WindowAggrCache::WindowAggrCache(uint32_t index_id, uint32_t inner_pos, uint32_t ts_col_id, int32_t col_idx,
+                                 DataType col_type, WindowAggrFunc func, uint32_t shard_cnt,
+                                 uint64_t max_byte_size)
+    : index_id_(index_id),
+      inner_pos_(inner_pos),
+      ts_col_id_(ts_col_id),
+      col_idx_(col_idx),
+      col_type_(col_type),
+      func_(func),
+      shards_(),
+      shard_max_byte_size_(0),
+      byte_size_(0) {
+    for (uint32_t i = 0; i < std::max(shard_cnt, 1u); i++) {
+        shards_.emplace_back(std::make_unique<Shard>());
+    }
+    if (max_byte_size > 0) {
+        shard_max_byte_size_ = std::max<uint64_t>(max_byte_size / shards_.size(), 1);
+    }
+}
+
+bool WindowAggrCache::IsSupported(WindowAggrFunc func, int32_t col_idx, DataType col_type) {
+    if (col_idx < 0) {
+        return func == WindowAggrFunc::kCount;
+    }
+    switch (col_type) {
+        case DataType::kSmallInt:
+        case DataType::kInt:
+        case DataType::kBigInt:
+        case DataType::kTimestamp:
+        case DataType::kFloat:
+        case DataType::kDouble:
+            return true;
+        case DataType::kDate:
+            return func == WindowAggrFunc::kCount || func == WindowAggrFunc::kMin || func == WindowAggrFunc::kMax;
+        case DataType::kBool:
+        case DataType::kString:
+        case DataType::kVarchar:
+            return func == WindowAggrFunc::kCount;
+        default:
+            return false;
+    }
+}
+
+WindowAggrCache::Shard* WindowAggrCache::GetShard(const std::string& key) {
+    uint32_t idx = 0;
+    if (shards_.size() > 1) {
+        idx = ::openmldb::base::hash(key.c_str(), key.length(), SEED) % shards_.size();
+    }
+    return shards_[idx].get();
+}
+
+std::mutex& WindowAggrCache::GetMutex(const std::string& key) { return GetShard(key)->mu; }
+
+uint64_t WindowAggrCache::GetStateSize(const std::string& key, const KeyState& state) {
+    return sizeof(std::pair<const std::string, KeyState>) + STATE_NODE_OVERHEAD + key.size() +
+           (state.entries.size() + state.extremes.size() + state.pending.size()) * sizeof(Entry);
+}
+
+void WindowAggrCache::Resize(Shard* shard, uint64_t old_size, uint64_t new_size) {
+    shard->byte_size = shard->byte_size + new_size - old_size;
+    if (new_size >= old_size) {
+        byte_size_.fetch_add(new_size - old_size, std::memory_order_relaxed);
+    } else {
+        byte_size_.fetch_sub(old_size - new_size, std::memory_order_relaxed);
+    }
+}
+
+void WindowAggrCache::Evict(Shard* shard, const std::string& key) {
+    if (shard_max_byte_size_ == 0 || shard->byte_size <= shard_max_byte_size_) {
+        return;
+    }
+    auto& states = shard->states;
+    // the keys without requests since the last gc, then the others
+    for (bool only_idle : {true, false}) {
+        for (auto it = states.begin(); it != states.end() && shard->byte_size > shard_max_byte_size_;) {
+            if (it->first == key || (only_idle && it->second.hit)) {
+                ++it;
+                continue;
+            }
+            Resize(shard, GetStateSize(it->first, it->second), 0);
+            it = states.erase(it);
+        }
+    }
+    if (shard->byte_size > shard_max_byte_size_) {
+        auto it = states.find(key);
+        if (it != states.end()) {
+            Resize(shard, GetStateSize(it->first, it->second), 0);
+            states.erase(it);
+        }
+    }
+}
+
+uint64_t WindowAggrCache::StartBuild(const std::string& key) {
+    auto* shard = GetShard(key);
+    auto it = shard->states.find(key);
+    uint64_t old_size = 0;
+    if (it == shard->states.end()) {
+        it = shard->states.emplace(key, KeyState()).first;
+    } else {
+        old_size = GetStateSize(it->first, it->second);
+        it->second = KeyState();
+    }
+    it->second.build_id = ++shard->build_id;
+    Resize(shard, old_size, GetStateSize(it->first, it->second));
+    return it->second.build_id;
+}
+
+bool WindowAggrCache::Install(const std::string& key, uint64_t build_id, Builder* builder) {
+    auto* shard = GetShard(key);
+    auto& states = shard->states;
+    auto it = states.find(key);
+    if (it == states.end() || it->second.build_id != build_id) {
+        return false;
+    }
+    uint64_t old_size = GetStateSize(it->first, it->second);
+    KeyState& state = builder->state_;
+    for (const auto& entry : it->second.pending) {
+        if (entry.ts < state.floor) {
+            continue;
+        }
+        if (entry.ts <= state.scan_ts || (!state.entries.empty() && entry.ts < state.entries.back().ts)) {
+            // the row may be scanned too, rebuilt by the next request
+            Resize(shard, old_size, 0);
+            states.erase(it);
+            return false;
+        }
+        Entry row = entry;
+        row.seq = state.seq++;
+        Push(row, &state);
+        while (state.expire_cnt > 0 && state.entries.size() > state.expire_cnt) {
+            PopFront(&state);
+        }
+    }
+    it->second = std::move(state);
+    Resize(shard, old_size, GetStateSize(it->first, it->second));
+    Evict(shard, key);
+    return true;
+}
+
+void WindowAggrCache::CancelBuild(const std::string& key, uint64_t build_id) {
+    auto* shard = GetShard(key);
+    auto it = shard->states.find(key);
+    if (it != shard->states.end() && it->second.build_id == build_id) {
+        Resize(shard, GetStateSize(it->first, it->second), 0);
+        shard->states.erase(it);
+    }
+}
+
+void WindowAggrCache::Put(const std::string& key, int64_t ts, const char* data, const codec::RowView& decoder) {
+    auto* shard = GetShard(key);
+    auto& states = shard->states;
+    auto it = states.find(key);
+    if (it == states.end()) {
+        return;
+    }
+    KeyState& state = it->second;
+    uint64_t old_size = GetStateSize(it->first, state);
+    if (state.build_id != 0) {
+        Entry entry;
+        NewEntry(ts, data, decoder, &entry);
+        state.pending.push_back(entry);
+        Resize(shard, old_size, GetStateSize(it->first, state));
+        Evict(shard, key);
+        return;
+    }
+    if (ts < state.floor) {
+        // out of any window the state answers
+        return;
+    }
+    if (ts <= state.scan_ts || (!state.entries.empty() && ts < state.entries.back().ts)) {
+        // rebuilt by the next request
+        Resize(shard, old_size, 0);
+        states.erase(it);
+        return;
+    }
+    Entry entry;
+    NewEntry(ts, data, decoder, &entry);
+    entry.seq = state.seq++;
+    Push(entry, &state);
+    while (state.expire_cnt > 0 && state.entries.size() > state.expire_cnt) {
+        PopFront(&state);
+    }
+    Resize(shard, old_size, GetStateSize(it->first, state));
+    Evict(shard, key);
+}
+
+bool WindowAggrCache::Get(const std::string& key, int64_t start, int64_t end, uint64_t expire_cnt,
+                          std::string* aggr_val) {
+    auto* shard = GetShard(key);
+    auto& states = shard->states;
+    auto it = states.find(key);
+    if (it == states.end()) {
+        return false;
+    }
+    KeyState& state = it->second;
+    if (state.build_id != 0 || state.expire_cnt != expire_cnt) {
+        return false;
+    }
+    if (!state.entries.empty() && state.entries.back().ts > end) {
+        return false;
+    }
+    // the rows before floor are expired if the latest expire_cnt rows are all in the state
+    if (start < state.floor && (expire_cnt == 0 || state.entries.size() < expire_cnt)) {
+        return false;
+    }
+    uint64_t old_size = GetStateSize(it->first, state);
+    while (!state.entries.empty() && state.entries.front().ts < start) {
+        PopFront(&state);
+    }
+    Resize(shard, old_size, GetStateSize(it->first, state));
+    state.floor = std::max(state.floor, start);
+    state.hit = true;
+    Encode(state, aggr_val);
+    return true;
+}
+
+void WindowAggrCache::Erase(const std::string& key) {
+    auto* shard = GetShard(key);
+    auto it = shard->states.find(key);
+    if (it != shard->states.end()) {
+        Resize(shard, GetStateSize(it->first, it->second), 0);
+        shard->states.erase(it);
+    }
+}
+
+void WindowAggrCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mu);
+        shard->states.clear();
+        Resize(shard.get(), shard->byte_size, 0);
+    }
+}
+
+void WindowAggrCache::Gc(uint64_t expire_time) {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mu);
+        for (auto it = shard->states.begin(); it != shard->states.end();) {
+            KeyState& state = it->second;
+            uint64_t old_size = GetStateSize(it->first, state);
+            if (!state.hit) {
+                Resize(shard.get(), old_size, 0);
+                it = shard->states.erase(it);
+                continue;
+            }
+            state.hit = false;
+            if (state.build_id != 0) {
+                ++it;
+                continue;
+            }
+            while (!state.entries.empty() && state.entries.front().ts < static_cast<int64_t>(expire_time)) {
+                PopFront(&state);
+            }
+            Resize(shard.get(), old_size, GetStateSize(it->first, state));
+            state.floor = std::max(state.floor, static_cast<int64_t>(expire_time));
+            ++it;
+        }
+    }
+}
+
+uint64_t WindowAggrCache::GetKeyCnt() {
+    uint64_t cnt = 0;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mu);
+        cnt += shard->states.size();
+    }
+    return cnt;
+}
+
+void WindowAggrCache::NewEntry(int64_t ts, const char* data, const codec::RowView& decoder, Entry* entry) const {
+    entry->ts = ts;
+    entry->seq = 0;
+    entry->val.vlong = 0;
+    entry->is_null = col_idx_ < 0 || !DecodeValue(data, decoder, &entry->val);
+}
+
+bool WindowAggrCache::DecodeValue(const char* data, const codec::RowView& decoder, Value* val) const {
+    const int8_t* row = reinterpret_cast<const int8_t*>(data);
+    int32_t ret = -1;
+    switch (col_type_) {
+        case DataType::kBool: {
+            bool v = false;
+            ret = decoder.GetValue(row, col_idx_, col_type_, &v);
+            break;
+        }
+        case DataType::kSmallInt: {
+            int16_t v = 0;
+            ret = decoder.GetValue(row, col_idx_, col_type_, &v);
+            val->vlong = v;
+            break;
+        }
+        case DataType::kInt:
+        case DataType::kDate: {
+            int32_t v = 0;
+            ret = decoder.GetValue(row, col_idx_, col_type_, &v);
+            val->vlong = v;
+            break;
+        }
+        case DataType::kBigInt:
+        case DataType::kTimestamp: {
+            int64_t v = 0;
+            ret = decoder.GetValue(row, col_idx_, col_type_, &v);
+            val->vlong = v;
+            break;
+        }
+        case DataType::kFloat: {
+            float v = 0;
+            ret = decoder.GetValue(row, col_idx_, col_type_, &v);
+            val->vdouble = v;
+            break;
+        }
+        case DataType::kDouble: {
+            double v = 0;
+            ret = decoder.GetValue(row, col_idx_, col_type_, &v);
+            val->vdouble = v;
+            break;
+        }
+        case DataType::kString:
+        case DataType::kVarchar: {
+            char* v = NULL;
+            uint32_t len = 0;
+            ret = decoder.GetValue(row, col_idx_, &v, &len);
+            break;
+        }
+        default:
+            break;
+    }
+    // a column added later than the schema version of the row is null too
+    return ret == 0;
+}
+
+void WindowAggrCache::Push(const Entry& entry, KeyState* state) const {
+    state->entries.push_back(entry);
+    if (entry.is_null) {
+        return;
+    }
+    state->non_null_cnt++;
+    switch (func_) {
+        case WindowAggrFunc::kSum:
+        case WindowAggrFunc::kAvg:
+            if (IsFloat()) {
+                state->sum.vdouble += entry.val.vdouble;
+            } else {
+                state->sum.vlong += entry.val.vlong;
+            }
+            break;
+        case WindowAggrFunc::kMin:
+        case WindowAggrFunc::kMax: {
+            bool is_min = func_ == WindowAggrFunc::kMin;
+            auto& extremes = state->extremes;
+            // an old candidate is useless once a newer row beats it, it leaves the window earlier
+            while (!extremes.empty()) {
+                const Value& back = extremes.back().val;
+                bool beaten = false;
+                if (IsFloat()) {
+                    beaten = is_min ? back.vdouble >= entry.val.vdouble : back.vdouble <= entry.val.vdouble;
+                } else {
+                    beaten = is_min ? back.vlong >= entry.val.vlong : back.vlong <= entry.val.vlong;
+                }
+                if (!beaten) {
+                    break;
+                }
+                extremes.pop_back();
+            }
+            extremes.push_back(entry);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void WindowAggrCache::PopFront(KeyState* state) const {
+    const Entry& entry = state->entries.front();
+    if (!entry.is_null) {
+        state->non_null_cnt--;
+        if (func_ == WindowAggrFunc::kSum || func_ == WindowAggrFunc::kAvg) {
+            if (state->non_null_cnt == 0) {
+                // do not carry the rounding error of the float sum into an empty window
+                state->sum.vlong = 0;
+            } else if (IsFloat()) {
+                state->sum.vdouble -= entry.val.vdouble;
+            } else {
+                state->sum.vlong -= entry.val.vlong;
+            }
+        }
+        if (!state->extremes.empty() && state->extremes.front().seq == entry.seq) {
+            state->extremes.pop_front();
+        }
+    }
+    state->entries.pop_front();
+}
+
+WindowAggrCache::Builder::Builder(const WindowAggrCache& cache, int64_t floor, uint64_t expire_cnt)
+    : cache_(cache), rows_(), state_() {
+    state_.floor = floor;
+    state_.expire_cnt = expire_cnt;
+}
+
+void WindowAggrCache::Builder::Add(int64_t ts, const char* data, const codec::RowView& decoder) {
+    Entry entry;
+    cache_.NewEntry(ts, data, decoder, &entry);
+    rows_.push_back(entry);
+}
+
+void WindowAggrCache::Builder::Finish() {
+    if (!rows_.empty()) {
+        state_.scan_ts = rows_.front().ts;
+    }
+    for (auto it = rows_.rbegin(); it != rows_.rend(); it++) {
+        it->seq = state_.seq++;
+        cache_.Push(*it, &state_);
+    }
+    rows_.clear();
+}
+
+template <typename T>
+static void EncodeValue(T val, std::string* aggr_val) {
+    aggr_val->assign(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+void WindowAggrCache::Encode(const KeyState& state, std::string* aggr_val) const {
+    aggr_val->clear();
+    if (func_ == WindowAggrFunc::kCount) {
+        EncodeValue<int64_t>(col_idx_ < 0 ? state.entries.size() : state.non_null_cnt, aggr_val);
+        return;
+    }
+    if (state.non_null_cnt == 0) {
+        return;
+    }
+    switch (func_) {
+        case WindowAggrFunc::kSum:
+            // the same representation as the sum of the request engine
+            if (col_type_ == DataType::kFloat) {
+                EncodeValue<float>(state.sum.vdouble, aggr_val);
+            } else if (col_type_ == DataType::kDouble) {
+                EncodeValue<double>(state.sum.vdouble, aggr_val);
+            } else {
+                EncodeValue<int64_t>(state.sum.vlong, aggr_val);
+            }
+            break;
+        case WindowAggrFunc::kAvg: {
+            double sum = IsFloat() ? state.sum.vdouble : static_cast<double>(state.sum.vlong);
+            EncodeValue<double>(sum, aggr_val);
+            int64_t cnt = state.non_null_cnt;
+            aggr_val->append(reinterpret_cast<const char*>(&cnt), sizeof(int64_t));
+            break;
+        }
+        case WindowAggrFunc::kMin:
+        case WindowAggrFunc::kMax: {
+            const Value& val = state.extremes.front().val;
+            switch (col_type_) {
+                case DataType::kSmallInt:
+                    EncodeValue<int16_t>(val.vlong, aggr_val);
+                    break;
+                case DataType::kInt:
+                case DataType::kDate:
+                    EncodeValue<int32_t>(val.vlong, aggr_val);
+                    break;
+                case DataType::kFloat:
+                    EncodeValue<float>(val.vdouble, aggr_val);
+                    break;
+                case DataType::kDouble:
+                    EncodeValue<double>(val.vdouble, aggr_val);
+                    break;
+                default:
+                    EncodeValue<int64_t>(val.vlong, aggr_val);
+                    break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_WINDOW_AGGR_CACHE_H_
+#define SRC_STORAGE_WINDOW_AGGR_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "codec/codec.h"
+#include "proto/type.pb.h"
+
+namespace openmldb {
+namespace storage {
+
+enum class WindowAggrFunc {
+    kSum = 1,
+    kMin = 2,
+    kMax = 3,
+    kCount = 4,
+    kAvg = 5,
+};
+
+bool GetWindowAggrFunc(const std::string& name, WindowAggrFunc* func);
+
+// The running aggregate of a column over the rows of each key in a sliding
+// window [start, end] of one index. The state of a key is built from a scan
+// on the first request, rows put afterwards are appended and the window start
+// only moves forward, so a request is answered in amortized O(1) instead of
+// scanning the whole window. min and max keep a monotonic deque.
+//
+// A key is guarded by the mutex returned from GetMutex, the caller holds it
+// around StartBuild, Install, Put, Get and Erase of the key. The scan of a
+// build runs without the mutex, see Install.
+//
+// The states are counted in GetByteSize. Once the states of a shard are over
+// its part of max_byte_size, the keys without any request since the last gc
+// are dropped first, and then the others.
+class WindowAggrCache {
+ public:
+    class Builder;
+
+    // col_idx is -1 for count(*), max_byte_size 0 means no limit
+    WindowAggrCache(uint32_t index_id, uint32_t inner_pos, uint32_t ts_col_id, int32_t col_idx,
+                    ::openmldb::type::DataType col_type, WindowAggrFunc func, uint32_t shard_cnt,
+                    uint64_t max_byte_size = 0);
+    WindowAggrCache(const WindowAggrCache&) = delete;
+    WindowAggrCache& operator=(const WindowAggrCache&) = delete;
+
+    static bool IsSupported(WindowAggrFunc func, int32_t col_idx, ::openmldb::type::DataType col_type);
+
+    inline uint32_t GetIndexId() const { return index_id_; }
+    inline uint32_t GetInnerPos() const { return inner_pos_; }
+    inline uint32_t GetTsColId() const { return ts_col_id_; }
+    inline int32_t GetColIdx() const { return col_idx_; }
+    inline WindowAggrFunc GetFunc() const { return func_; }
+
+    std::mutex& GetMutex(const std::string& key);
+
+    // drop the state of key and start building a new one, the rows put until Install are
+    // kept aside. return the id of the build
+    uint64_t StartBuild(const std::string& key);
+
+    // install the state scanned after StartBuild returned build_id, with the rows put
+    // meanwhile. a row put meanwhile may be in the scan only if its ts is not newer than
+    // the scanned rows, return false and drop the build then, or if it is replaced
+    bool Install(const std::string& key, uint64_t build_id, Builder* builder);
+
+    // drop the build of build_id if it is not replaced
+    void CancelBuild(const std::string& key, uint64_t build_id);
+
+    // append a row of key if it has a state. the state is dropped if ts goes backwards
+    // inside the window, or equals the ts of the scanned rows as the row may be scanned
+    void Put(const std::string& key, int64_t ts, const char* data, const codec::RowView& decoder);
+
+    // encode the aggregate of the rows in [start, end] as the aggr val of a
+    // pre-aggregate table, which is empty if there is no non-null value.
+    // return false if there is no state of key able to answer it
+    bool Get(const std::string& key, int64_t start, int64_t end, uint64_t expire_cnt, std::string* aggr_val);
+
+    void Erase(const std::string& key);
+
+    void Clear();
+
+    // drop the rows older than expire_time, and the keys without any request since the last gc
+    void Gc(uint64_t expire_time);
+
+    uint64_t GetKeyCnt();
+
+    // the memory of the states of all keys
+    inline uint64_t GetByteSize() const { return byte_size_.load(std::memory_order_relaxed); }
+
+ private:
+    union Value {
+        int64_t vlong;
+        double vdouble;
+    };
+
+    struct Entry {
+        int64_t ts;
+        uint64_t seq;
+        Value val;
+        bool is_null;
+    };
+
+    struct KeyState {
+        std::deque<Entry> entries;
+        // the candidates of min or max, ordered by seq
+        std::deque<Entry> extremes;
+        // all rows of ts >= floor are in entries unless they are expired by expire_cnt
+        int64_t floor = 0;
+        uint64_t expire_cnt = 0;
+        uint64_t seq = 0;
+        uint64_t non_null_cnt = 0;
+        Value sum = {};
+        // the latest ts of the scanned rows
+        int64_t scan_ts = INT64_MIN;
+        // not 0 until the build is installed
+        uint64_t build_id = 0;
+        // the rows put during the build
+        std::vector<Entry> pending;
+        bool hit = true;
+    };
+
+    struct Shard {
+        std::mutex mu;
+        std::unordered_map<std::string, KeyState> states;
+        uint64_t build_id = 0;
+        uint64_t byte_size = 0;
+    };
+
+    Shard* GetShard(const std::string& key);
+    static uint64_t GetStateSize(const std::string& key, const KeyState& state);
+    void Resize(Shard* shard, uint64_t old_size, uint64_t new_size);
+    // drop the states of the shard until it is under the limit, the state of key is the last one to drop
+    void Evict(Shard* shard, const std::string& key);
+    bool IsFloat() const {
+        return col_type_ == ::openmldb::type::kFloat || col_type_ == ::openmldb::type::kDouble;
+    }
+    void NewEntry(int64_t ts, const char* data, const codec::RowView& decoder, Entry* entry) const;
+    bool DecodeValue(const char* data, const codec::RowView& decoder, Value* val) const;
+    void Push(const Entry& entry, KeyState* state) const;
+    void PopFront(KeyState* state) const;
+    void Encode(const KeyState& state, std::string* aggr_val) const;
+
+    uint32_t index_id_;
+    uint32_t inner_pos_;
+    uint32_t ts_col_id_;
+    int32_t col_idx_;
+    ::openmldb::type::DataType col_type_;
+    WindowAggrFunc func_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    uint64_t shard_max_byte_size_;
+    std::atomic<uint64_t> byte_size_;
+};
+
+// The state of a key built from a scan of the segments, it needn't the mutex of the key.
+class WindowAggrCache::Builder {
+ public:
+    // the state holds all rows of ts >= floor, keeping at most the latest expire_cnt rows if it is not 0
+    Builder(const WindowAggrCache& cache, int64_t floor, uint64_t expire_cnt);
+
+    // add the scanned rows from the newest to the oldest
+    void Add(int64_t ts, const char* data, const codec::RowView& decoder);
+
+    // push the rows into the state from the oldest, called after the last Add
+    void Finish();
+
+ private:
+    friend class WindowAggrCache;
+
+    const WindowAggrCache& cache_;
+    std::vector<Entry> rows_;
+    KeyState state_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+
+#endif  // SRC_STORAGE_WINDOW_AGGR_CACHE_H_
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/window_aggr_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/glog_wapper.h"
+#include "codec/schema_codec.h"
+#include "codec/sdk_codec.h"
+#include "gtest/gtest.h"
+#include "storage/mem_table.h"
+
+using ::openmldb::codec::SchemaCodec;
+
+namespace openmldb {
+namespace storage {
+
+class WindowAggrCacheTest : public ::testing::Test {
+ public:
+    WindowAggrCacheTest() {}
+    ~WindowAggrCacheTest() {}
+};
+
+// rows of key "card0" with ts and a nullable price, -1 means null
+using Rows = std::vector<std::pair<int64_t, int64_t>>;
+
+static ::openmldb::api::TableMeta GetTableMeta(::openmldb::type::TTLType ttl_type, uint64_t abs_ttl,
+                                               uint64_t lat_ttl) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t1");
+    table_meta.set_tid(1);
+    table_meta.set_pid(0);
+    table_meta.set_seg_cnt(8);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "price", ::openmldb::type::kBigInt);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "amt", ::openmldb::type::kDouble);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts", ::openmldb::type::kTimestamp);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts", ttl_type, abs_ttl, lat_ttl);
+    return table_meta;
+}
+
+static void PutRow(MemTable* table, codec::SDKCodec* codec, const std::string& key, int64_t ts, int64_t price) {
+    std::string value;
+    std::string price_str = price < 0 ? "null" : std::to_string(price);
+    std::string amt_str = price < 0 ? "null" : std::to_string(price * 0.5);
+    ASSERT_EQ(0, codec->EncodeRow({key, price_str, amt_str, std::to_string(ts)}, &value));
+    Dimensions dimensions;
+    auto dim = dimensions.Add();
+    dim->set_key(key);
+    dim->set_idx(0);
+    ASSERT_TRUE(table->Put(0, value, dimensions));
+}
+
+template <typename T>
+static T DecodeVal(const std::string& aggr_val) {
+    EXPECT_EQ(sizeof(T), aggr_val.size());
+    return *reinterpret_cast<const T*>(aggr_val.data());
+}
+
+// compare the cache with an aggregation over all rows of [start, end], keeping the latest expire_cnt rows only
+static void CheckWindow(MemTable* table, const Rows& rows, int64_t start, int64_t end, uint64_t expire_cnt = 0) {
+    int64_t sum = 0, cnt = 0, all = 0, min = INT64_MAX, max = INT64_MIN;
+    uint64_t latest = 0;
+    for (auto it = rows.rbegin(); it != rows.rend(); it++) {
+        if (it->first > end) {
+            continue;
+        }
+        if (it->first < start || (expire_cnt > 0 && latest >= expire_cnt)) {
+            break;
+        }
+        latest++;
+        all++;
+        if (it->second >= 0) {
+            cnt++;
+            sum += it->second;
+            min = std::min(min, it->second);
+            max = std::max(max, it->second);
+        }
+    }
+    std::string val;
+    ASSERT_TRUE(table->GetWindowAggr(0, "card0", "count", "", start, end, &val));
+    ASSERT_EQ(all, DecodeVal<int64_t>(val));
+    ASSERT_TRUE(table->GetWindowAggr(0, "card0", "count", "price", start, end, &val));
+    ASSERT_EQ(cnt, DecodeVal<int64_t>(val));
+    ASSERT_TRUE(table->GetWindowAggr(0, "card0", "sum", "price", start, end, &val));
+    if (cnt == 0) {
+        ASSERT_TRUE(val.empty());
+        return;
+    }
+    ASSERT_EQ(sum, DecodeVal<int64_t>(val));
+    ASSERT_TRUE(table->GetWindowAggr(0, "card0", "min", "price", start, end, &val));
+    ASSERT_EQ(min, DecodeVal<int64_t>(val));
+    ASSERT_TRUE(table->GetWindowAggr(0, "card0", "max", "amt", start, end, &val));
+    ASSERT_DOUBLE_EQ(max * 0.5, DecodeVal<double>(val));
+    ASSERT_TRUE(table->GetWindowAggr(0, "card0", "avg", "amt", start, end, &val));
+    ASSERT_EQ(sizeof(double) + sizeof(int64_t), val.size());
+    ASSERT_NEAR(sum * 0.5, *reinterpret_cast<const double*>(val.data()), 1e-6);
+    ASSERT_EQ(cnt, *reinterpret_cast<const int64_t*>(val.data() + sizeof(double)));
+}
+
+TEST_F(WindowAggrCacheTest, SlidingWindow) {
+    auto table_meta = GetTableMeta(::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable table(table_meta);
+    table.Init();
+    codec::SDKCodec codec(table_meta);
+    Rows rows;
+    const int64_t window = 100;
+    srand(0);
+    for (int i = 0; i < 500; i++) {
+        int64_t ts = 1000 + i * 7 + rand() % 3;  // NOLINT
+        int64_t price = i % 11 == 0 ? -1 : rand() % 1000;  // NOLINT
+        PutRow(&table, &codec, "card0", ts, price);
+        PutRow(&table, &codec, "card1", ts, 1);
+        rows.emplace_back(ts, price);
+        CheckWindow(&table, rows, ts - window, ts);
+        // the next request with exclude current_time
+        CheckWindow(&table, rows, ts + 1 - window, ts);
+    }
+    // a request before the latest row is not answered by the cache
+    std::string val;
+    ASSERT_FALSE(table.GetWindowAggr(0, "card0", "sum", "price", 1000, rows.back().first - 1, &val));
+    // a request with an earlier start scans the rows again
+    CheckWindow(&table, rows, rows.back().first - 10 * window, rows.back().first);
+    CheckWindow(&table, rows, rows.back().first - window, rows.back().first);
+    // unsupported func or col
+    ASSERT_FALSE(table.GetWindowAggr(0, "card0", "sum", "card", 0, INT64_MAX, &val));
+    ASSERT_FALSE(table.GetWindowAggr(0, "card0", "sum", "", 0, INT64_MAX, &val));
+    ASSERT_FALSE(table.GetWindowAggr(0, "card0", "distinct_count", "price", 0, INT64_MAX, &val));
+    ASSERT_FALSE(table.GetWindowAggr(0, "card0", "sum", "not_exist", 0, INT64_MAX, &val));
+}
+
+TEST_F(WindowAggrCacheTest, OutOfOrderAndDelete) {
+    auto table_meta = GetTableMeta(::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable table(table_meta);
+    table.Init();
+    codec::SDKCodec codec(table_meta);
+    Rows rows;
+    for (int64_t ts = 100; ts <= 200; ts += 10) {
+        PutRow(&table, &codec, "card0", ts, ts);
+        rows.emplace_back(ts, ts);
+    }
+    CheckWindow(&table, rows, 150, 200);
+    // a late row inside the window drops the state, it is scanned again
+    PutRow(&table, &codec, "card0", 175, 1);
+    rows.emplace_back(175, 1);
+    std::sort(rows.begin(), rows.end());
+    CheckWindow(&table, rows, 150, 200);
+    // a row before the window is ignored
+    PutRow(&table, &codec, "card0", 120, 2);
+    rows.emplace_back(120, 2);
+    std::sort(rows.begin(), rows.end());
+    CheckWindow(&table, rows, 160, 200);
+    // rows with the same ts are counted once
+    PutRow(&table, &codec, "card0", 200, 3);
+    rows.emplace_back(200, 3);
+    std::sort(rows.begin(), rows.end());
+    CheckWindow(&table, rows, 160, 200);
+    ASSERT_TRUE(table.Delete("card0", 0));
+    std::string val;
+    ASSERT_TRUE(table.GetWindowAggr(0, "card0", "count", "", 160, 200, &val));
+    ASSERT_EQ(0, DecodeVal<int64_t>(val));
+}
+
+TEST_F(WindowAggrCacheTest, LatestTTL) {
+    auto table_meta = GetTableMeta(::openmldb::type::kLatestTime, 0, 5);
+    MemTable table(table_meta);
+    table.Init();
+    codec::SDKCodec codec(table_meta);
+    Rows rows;
+    for (int64_t ts = 100; ts <= 300; ts += 10) {
+        PutRow(&table, &codec, "card0", ts, ts % 7 == 0 ? -1 : ts);
+        rows.emplace_back(ts, ts % 7 == 0 ? -1 : ts);
+        CheckWindow(&table, rows, ts - 100, ts, 5);
+        CheckWindow(&table, rows, ts - 20, ts, 5);
+    }
+    // absandlat is not answered by the cache
+    auto abs_and_lat_meta = GetTableMeta(::openmldb::type::kAbsAndLat, 10, 5);
+    MemTable abs_and_lat(abs_and_lat_meta);
+    abs_and_lat.Init();
+    std::string val;
+    ASSERT_FALSE(abs_and_lat.GetWindowAggr(0, "card0", "count", "", 0, INT64_MAX, &val));
+}
+
+TEST_F(WindowAggrCacheTest, Gc) {
+    auto table_meta = GetTableMeta(::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable table(table_meta);
+    table.Init();
+    codec::SDKCodec codec(table_meta);
+    Rows rows;
+    for (int64_t ts = 100; ts <= 200; ts += 10) {
+        PutRow(&table, &codec, "card0", ts, ts);
+        rows.emplace_back(ts, ts);
+    }
+    CheckWindow(&table, rows, 150, 200);
+    WindowAggrCache cache(0, 0, 3, 1, ::openmldb::type::kBigInt, WindowAggrFunc::kSum, 4);
+    cache.StartBuild("card0");
+    ASSERT_EQ(1u, cache.GetKeyCnt());
+    // kept by the first gc as it is new, dropped by the second one without any request
+    cache.Gc(0);
+    ASSERT_EQ(1u, cache.GetKeyCnt());
+    cache.Gc(0);
+    ASSERT_EQ(0u, cache.GetKeyCnt());
+    table.SchedGc();
+    CheckWindow(&table, rows, 160, 200);
+}
+
+TEST_F(WindowAggrCacheTest, PutDuringBuild) {
+    auto table_meta = GetTableMeta(::openmldb::type::kAbsoluteTime, 0, 0);
+    codec::SDKCodec codec(table_meta);
+    codec::RowView decoder(table_meta.column_desc());
+    std::vector<std::string> values;
+    for (int64_t ts = 100; ts <= 150; ts += 10) {
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow({"card0", std::to_string(ts), "1.0", std::to_string(ts)}, &value));
+        values.push_back(value);
+    }
+    WindowAggrCache cache(0, 0, 3, 1, ::openmldb::type::kBigInt, WindowAggrFunc::kSum, 4);
+    auto scan = [&](WindowAggrCache::Builder* builder, int64_t last_ts) {
+        for (int64_t ts = last_ts; ts >= 100; ts -= 10) {
+            builder->Add(ts, values[(ts - 100) / 10].data(), decoder);
+        }
+        builder->Finish();
+    };
+    std::string val;
+    // the rows newer than the scan are appended on install
+    uint64_t build_id = cache.StartBuild("card0");
+    ASSERT_FALSE(cache.Get("card0", 100, 200, 0, &val));
+    cache.Put("card0", 140, values[4].data(), decoder);
+    cache.Put("card0", 150, values[5].data(), decoder);
+    WindowAggrCache::Builder builder(cache, 100, 0);
+    scan(&builder, 130);
+    ASSERT_TRUE(cache.Install("card0", build_id, &builder));
+    ASSERT_TRUE(cache.Get("card0", 100, 200, 0, &val));
+    ASSERT_EQ(750, DecodeVal<int64_t>(val));
+
+    // the row put at the ts of the scanned rows may be scanned too
+    build_id = cache.StartBuild("card0");
+    cache.Put("card0", 150, values[5].data(), decoder);
+    WindowAggrCache::Builder same_ts(cache, 100, 0);
+    scan(&same_ts, 150);
+    ASSERT_FALSE(cache.Install("card0", build_id, &same_ts));
+    ASSERT_FALSE(cache.Get("card0", 100, 200, 0, &val));
+
+    // so is the one put after install
+    build_id = cache.StartBuild("card0");
+    WindowAggrCache::Builder after(cache, 100, 0);
+    scan(&after, 150);
+    ASSERT_TRUE(cache.Install("card0", build_id, &after));
+    cache.Put("card0", 150, values[5].data(), decoder);
+    ASSERT_FALSE(cache.Get("card0", 100, 200, 0, &val));
+
+    // a replaced build is not installed
+    build_id = cache.StartBuild("card0");
+    uint64_t new_build_id = cache.StartBuild("card0");
+    WindowAggrCache::Builder replaced(cache, 100, 0);
+    scan(&replaced, 150);
+    ASSERT_FALSE(cache.Install("card0", build_id, &replaced));
+    cache.CancelBuild("card0", build_id);
+    ASSERT_EQ(1u, cache.GetKeyCnt());
+    cache.CancelBuild("card0", new_build_id);
+    ASSERT_EQ(0u, cache.GetKeyCnt());
+}
+
+TEST_F(WindowAggrCacheTest, ByteSizeLimit) {
+    auto table_meta = GetTableMeta(::openmldb::type::kAbsoluteTime, 0, 0);
+    codec::SDKCodec codec(table_meta);
+    codec::RowView decoder(table_meta.column_desc());
+    std::vector<std::string> values;
+    for (int64_t ts = 100; ts <= 150; ts += 10) {
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow({"card0", std::to_string(ts), "1.0", std::to_string(ts)}, &value));
+        values.push_back(value);
+    }
+    auto build = [&](WindowAggrCache* cache, const std::string& key) {
+        uint64_t build_id = cache->StartBuild(key);
+        WindowAggrCache::Builder builder(*cache, 100, 0);
+        for (int64_t ts = 140; ts >= 100; ts -= 10) {
+            builder.Add(ts, values[(ts - 100) / 10].data(), decoder);
+        }
+        builder.Finish();
+        return cache->Install(key, build_id, &builder);
+    };
+    std::string val;
+    WindowAggrCache cache(0, 0, 3, 1, ::openmldb::type::kBigInt, WindowAggrFunc::kSum, 1);
+    ASSERT_EQ(0u, cache.GetByteSize());
+    ASSERT_TRUE(build(&cache, "card0"));
+    uint64_t state_size = cache.GetByteSize();
+    ASSERT_GT(state_size, 0u);
+    cache.Put("card0", 150, values[5].data(), decoder);
+    ASSERT_GT(cache.GetByteSize(), state_size);
+    ASSERT_TRUE(build(&cache, "card1"));
+    ASSERT_GT(cache.GetByteSize(), 2 * state_size);
+    cache.Erase("card0");
+    ASSERT_EQ(state_size, cache.GetByteSize());
+    cache.Clear();
+    ASSERT_EQ(0u, cache.GetByteSize());
+
+    // room for two states, the one without requests since the last gc is evicted first
+    WindowAggrCache limited(0, 0, 3, 1, ::openmldb::type::kBigInt, WindowAggrFunc::kSum, 1,
+                            state_size * 5 / 2);
+    ASSERT_TRUE(build(&limited, "card0"));
+    ASSERT_TRUE(build(&limited, "card1"));
+    limited.Gc(0);
+    ASSERT_TRUE(limited.Get("card1", 100, 200, 0, &val));
+    ASSERT_TRUE(build(&limited, "card2"));
+    ASSERT_EQ(2u, limited.GetKeyCnt());
+    ASSERT_LE(limited.GetByteSize(), state_size * 5 / 2);
+    ASSERT_FALSE(limited.Get("card0", 100, 200, 0, &val));
+    ASSERT_TRUE(limited.Get("card1", 100, 200, 0, &val));
+    ASSERT_EQ(600, DecodeVal<int64_t>(val));
+    ASSERT_TRUE(limited.Get("card2", 100, 200, 0, &val));
+
+    // a state over the limit by itself is not kept
+    WindowAggrCache tiny(0, 0, 3, 1, ::openmldb::type::kBigInt, WindowAggrFunc::kSum, 1, state_size / 2);
+    ASSERT_TRUE(build(&tiny, "card0"));
+    ASSERT_EQ(0u, tiny.GetKeyCnt());
+    ASSERT_EQ(0u, tiny.GetByteSize());
+}
+
+}  // namespace storage
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    return RUN_ALL_TESTS();
+}
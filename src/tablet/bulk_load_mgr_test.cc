@@ -17,9 +17,16 @@
 #include "tablet/bulk_load_mgr.h"
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "codec/schema_codec.h"
+#include "codec/sdk_codec.h"
 #include "gtest/gtest.h"
+#include "sdk/bulk_load_builder.h"
+#include "storage/mem_table.h"
+#include "storage/ticket.h"
 
 namespace openmldb::tablet {
 class MockBulkLoadMgr : public BulkLoadMgr {
@@ -62,6 +69,94 @@ TEST_F(BulkLoadMgrTest, create_data_receivers) {
         std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
     }
 }
+
+TEST_F(BulkLoadMgrTest, bulk_load_builder) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t1");
+    table_meta.set_tid(1000);
+    table_meta.set_pid(1);
+    table_meta.set_seg_cnt(8);
+    table_meta.set_mode(::openmldb::api::TableMode::kTableLeader);
+    table_meta.set_format_version(1);
+    codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "mcc", ::openmldb::type::kString);
+    codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "price", ::openmldb::type::kBigInt);
+    codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    codec::SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts2", ::openmldb::type::kBigInt);
+    codec::SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsoluteTime,
+                                 0, 0);
+    codec::SchemaCodec::SetIndex(table_meta.add_column_key(), "card1", "card", "ts2", ::openmldb::type::kAbsoluteTime,
+                                 0, 0);
+    codec::SchemaCodec::SetIndex(table_meta.add_column_key(), "mcc", "mcc", "ts1", ::openmldb::type::kAbsoluteTime,
+                                 0, 0);
+    auto table = std::make_shared<storage::MemTable>(table_meta);
+    ASSERT_TRUE(table->Init());
+    ::openmldb::api::BulkLoadInfoResponse info;
+    ASSERT_TRUE(table->GetBulkLoadInfo(&info));
+    ::openmldb::nameserver::TableInfo table_info;
+    table_info.mutable_column_desc()->CopyFrom(table_meta.column_desc());
+
+    int parts = 0;
+    // the same steps as TabletImpl::BulkLoad
+    auto sender = [&](const ::openmldb::api::BulkLoadRequest& request, const std::string& data, std::string* msg) {
+        parts++;
+        if (!data.empty()) {
+            butil::IOBuf buf;
+            buf.append(data);
+            if (!mgr.AppendData(table->GetId(), table->GetPid(), &request, buf)) {
+                *msg = "append data failed";
+                return false;
+            }
+        }
+        if (request.index_region_size() > 0 && !mgr.BulkLoad(table, &request)) {
+            *msg = "bulk load failed";
+            return false;
+        }
+        if (request.eof()) {
+            mgr.RemoveReceiver(table->GetId(), table->GetPid());
+        }
+        return true;
+    };
+    // a small limit to split the rows into many parts
+    sdk::BulkLoadBuilder builder(table->GetId(), table->GetPid(), table_info, info, 4096, sender);
+    codec::SDKCodec codec(table_meta);
+    std::string msg;
+    for (int i = 0; i < 1000; i++) {
+        std::vector<std::string> row = {"card" + std::to_string(i % 100), "mcc" + std::to_string(i), "13",
+                                        std::to_string(1000 + i), std::to_string(1000 + i)};
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        std::vector<std::pair<std::string, uint32_t>> dimensions = {{row[0], 0}, {row[0], 1}, {row[1], 2}};
+        ASSERT_TRUE(builder.AddRow(value, dimensions, 0, &msg)) << msg;
+    }
+    ASSERT_TRUE(builder.Finish(&msg)) << msg;
+    ASSERT_EQ(1000u, builder.GetRowCnt());
+    ASSERT_GT(parts, 2);
+
+    storage::Ticket ticket;
+    std::unique_ptr<storage::TableIterator> iter(table->NewIterator(0, "card5", ticket));
+    iter->SeekToFirst();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(1995u, iter->GetKey());
+    int count = 0;
+    while (iter->Valid()) {
+        count++;
+        iter->Next();
+    }
+    ASSERT_EQ(10, count);
+    iter.reset(table->NewIterator(1, "card5", ticket));
+    count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        count++;
+    }
+    ASSERT_EQ(10, count);
+    iter.reset(table->NewIterator(2, "mcc10", ticket));
+    iter->SeekToFirst();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(1010u, iter->GetKey());
+    iter->Next();
+    ASSERT_FALSE(iter->Valid());
+}
 }  // namespace openmldb::tablet
 
 int main(int argc, char** argv) {
@@ -50,6 +50,7 @@
 #include "brpc/controller.h"
 #include "butil/iobuf.h"
 #include "codec/codec.h"
+#include "codec/columnar_codec.h"
 #include "codec/row_codec.h"
 #include "codec/sql_rpc_row_codec.h"
 #include "common/timer.h"
@@ -72,6 +73,8 @@ using ::openmldb::storage::DiskTable;
 DECLARE_int32(gc_interval);
 DECLARE_int32(gc_pool_size);
 DECLARE_int32(disk_gc_interval);
+DECLARE_uint32(gc_incremental_slice_time);
+DECLARE_uint32(gc_incremental_slice_interval);
 DECLARE_int32(statdb_ttl);
 DECLARE_uint32(scan_max_bytes_size);
 DECLARE_uint32(scan_reserve_size);
@@ -96,7 +99,9 @@ DECLARE_uint32(task_check_interval);
 DECLARE_uint32(load_index_max_wait_time);
 DECLARE_bool(use_name);
 DECLARE_bool(enable_distsql);
+DECLARE_string(jit_object_cache_dir);
 DECLARE_string(snapshot_compression);
+DECLARE_string(binlog_compression);
 DECLARE_string(file_compression);
 
 // cluster config
@@ -108,6 +113,7 @@ DECLARE_int32(zk_keep_alive_check_interval);
 
 DECLARE_int32(binlog_sync_to_disk_interval);
 DECLARE_int32(binlog_delete_interval);
+DECLARE_int32(binlog_sync_wait_time);
 DECLARE_uint32(absolute_ttl_max);
 DECLARE_uint32(latest_ttl_max);
 DECLARE_uint32(max_traverse_cnt);
@@ -116,6 +122,7 @@ DECLARE_uint32(snapshot_ttl_check_interval);
 DECLARE_uint32(put_slow_log_threshold);
 DECLARE_uint32(query_slow_log_threshold);
 DECLARE_int32(snapshot_pool_size);
+DECLARE_bool(enable_window_aggr_cache);
 
 namespace openmldb {
 namespace tablet {
@@ -207,6 +214,7 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    options.jit_options().SetObjectCacheDir(FLAGS_jit_object_cache_dir);
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
@@ -215,6 +223,10 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
         LOG(ERROR) << "wrong snapshot_compression: " << FLAGS_snapshot_compression;
         return false;
     }
+    if (snapshot_compression_set.find(FLAGS_binlog_compression) == snapshot_compression_set.end()) {
+        LOG(ERROR) << "wrong binlog_compression: " << FLAGS_binlog_compression;
+        return false;
+    }
     std::set<std::string> file_compression_set{"off", "zlib", "lz4"};
     if (file_compression_set.find(FLAGS_file_compression) == file_compression_set.end()) {
         LOG(ERROR) << "wrong FLAGS_file_compression: " << FLAGS_file_compression;
@@ -386,6 +398,51 @@ void TabletImpl::UpdateTTL(RpcController* ctrl, const ::openmldb::api::UpdateTTL
     response->set_msg("ok");
 }
 
+void TabletImpl::UpdateStorageOptions(RpcController* ctrl, const ::openmldb::api::UpdateStorageOptionsRequest* request,
+                                      ::openmldb::api::GeneralResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
+        base::SetResponseStatus(base::ReturnCode::kTableIsNotExist, "table is not exist", response);
+        return;
+    }
+    DiskTable* disk_table = dynamic_cast<DiskTable*>(table.get());
+    if (disk_table == nullptr) {
+        PDLOG(WARNING, "storage options are only for disk table. tid %u, pid %u", tid, pid);
+        base::SetResponseStatus(base::ReturnCode::kTableTypeMismatch, "storage options are only for disk table",
+                                response);
+        return;
+    }
+    std::string msg;
+    if (!disk_table->UpdateStorageOptions(request->storage_options(), &msg)) {
+        PDLOG(WARNING, "fail to update storage options. tid %u, pid %u, msg %s", tid, pid, msg.c_str());
+        base::SetResponseStatus(base::ReturnCode::kInvalidParameter, msg, response);
+        return;
+    }
+    std::string db_root_path;
+    if (!ChooseDBRootPath(tid, pid, table->GetStorageMode(), db_root_path)) {
+        base::SetResponseStatus(base::ReturnCode::kFailToGetDbRootPath, "fail to get db root path", response);
+        PDLOG(WARNING, "fail to get table db root path for tid %u, pid %u", tid, pid);
+        return;
+    }
+    std::string db_path = GetDBPath(db_root_path, tid, pid);
+    if (!::openmldb::base::IsExists(db_path)) {
+        PDLOG(WARNING, "table db path doesn't exist. tid %u, pid %u", tid, pid);
+        base::SetResponseStatus(base::ReturnCode::kTableDbPathIsNotExist, "table db path is not exist", response);
+        return;
+    }
+    if (WriteTableMeta(db_path, table->GetTableMeta().get()) < 0) {
+        PDLOG(WARNING, "write table_meta failed. tid[%u] pid[%u]", tid, pid);
+        base::SetResponseStatus(base::ReturnCode::kWriteDataFailed, "write meta data failed", response);
+        return;
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    response->set_msg("ok");
+}
+
 bool TabletImpl::RegisterZK() {
     if (IsClusterMode()) {
         if (zk_client_ == nullptr) {
@@ -766,7 +823,12 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
         if (request->ts_dimensions_size() > 0) {
             entry.mutable_ts_dimensions()->CopyFrom(request->ts_dimensions());
         }
-        replicator->AppendEntry(entry);
+        if (!replicator->AppendEntry(entry)) {
+            PDLOG(WARNING, "fail to append entry to replicator. tid %u pid %u", request->tid(), request->pid());
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_msg("fail to append entry to replicator");
+            return;
+        }
     } while (false);
 
     ok = UpdateAggrs(request->tid(), request->pid(), request->value(),
@@ -808,6 +870,107 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 }
 
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    std::shared_ptr<Table> table = GetTable(request->tid(), request->pid());
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(request->tid(), request->pid());
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", request->tid(), request->pid());
+    }
+    // the entries of the rows written to the table and their position in the request
+    std::vector<::openmldb::api::LogEntry> entries;
+    std::vector<int> entry_rows;
+    entries.reserve(request->entries_size());
+    entry_rows.reserve(request->entries_size());
+    uint32_t fail_cnt = 0;
+    for (int i = 0; i < request->entries_size(); i++) {
+        const auto& put = request->entries(i);
+        int32_t code = ::openmldb::base::ReturnCode::kOk;
+        if (put.dimensions_size() <= 0 || CheckDimessionPut(&put, table->GetIdxCnt()) != 0) {
+            code = ::openmldb::base::ReturnCode::kInvalidDimensionParameter;
+        } else if (!table->Put(put.time(), put.value(), put.dimensions())) {
+            code = ::openmldb::base::ReturnCode::kPutFailed;
+        }
+        response->add_codes(code);
+        if (code != ::openmldb::base::ReturnCode::kOk) {
+            fail_cnt++;
+            continue;
+        }
+        entries.emplace_back();
+        auto& entry = entries.back();
+        entry.set_ts(put.time());
+        entry.set_value(put.value());
+        entry.mutable_dimensions()->CopyFrom(put.dimensions());
+        if (replicator) {
+            entry.set_term(replicator->GetLeaderTerm());
+        }
+        entry_rows.push_back(i);
+    }
+    if (replicator && !replicator->AppendEntries(&entries)) {
+        PDLOG(WARNING, "fail to append entries to binlog. tid %u, pid %u", request->tid(), request->pid());
+        // none of the rows written to the table is durable
+        for (int row : entry_rows) {
+            response->set_codes(row, ::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+        }
+        response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+        response->set_msg("fail to append entries to replicator");
+        return;
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!UpdateAggrs(request->tid(), request->pid(), entries[i].value(), entries[i].dimensions(),
+                         entries[i].log_index())) {
+            response->set_codes(entry_rows[i], ::openmldb::base::ReturnCode::kError);
+            fail_cnt++;
+        }
+    }
+    if (fail_cnt > 0) {
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("put failed on " + std::to_string(fail_cnt) + " of " +
+                          std::to_string(request->entries_size()) + " rows");
+    } else {
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+    }
+
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put batch]. rows %d time %lu. tid %u, pid %u", request->entries_size(),
+              end_time - start_time, request->tid(), request->pid());
+    }
+    if (replicator && !entries.empty()) {
+        if (FLAGS_binlog_notify_on_put) {
+            replicator->Notify();
+        }
+    }
+    if (!IsClusterMode() && table->GetDB() == openmldb::nameserver::INFORMATION_SCHEMA_DB &&
+        table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
+        UpdateGlobalVarTable();
+    }
+}
+
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
     msg.clear();
     if (table_meta->name().empty()) {
@@ -882,6 +1045,9 @@ int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::
         msg = "storage_mode is unknown";
         return -1;
     }
+    if (table_meta->has_storage_options() && !DiskTable::CheckStorageOptions(table_meta->storage_options(), &msg)) {
+        return -1;
+    }
     return 0;
 }
 
@@ -1570,7 +1736,12 @@ void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::Delete
         ::openmldb::api::Dimension* dimension = entry.add_dimensions();
         dimension->set_key(request->key());
         dimension->set_idx(idx);
-        replicator->AppendEntry(entry);
+        if (!replicator->AppendEntry(entry)) {
+            PDLOG(WARNING, "fail to append entry to replicator. tid %u pid %u", request->tid(), request->pid());
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_msg("fail to append entry to replicator");
+            return;
+        }
     } while (false);
     if (replicator && FLAGS_binlog_notify_on_put) {
         replicator->Notify();
@@ -1648,18 +1819,34 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
         }
         uint32_t byte_size = 0;
         uint32_t count = 0;
-        for (auto& output_row : output_rows) {
-            if (byte_size > FLAGS_scan_max_bytes_size) {
-                LOG(WARNING) << "reach the max byte size truncate result";
-                response->set_schema(session.GetEncodedSchema());
-                response->set_byte_size(byte_size);
-                response->set_count(count);
-                response->set_code(::openmldb::base::kOk);
+        if (request->columnar_result()) {
+            for (auto& output_row : output_rows) {
+                if (byte_size > FLAGS_scan_max_bytes_size) {
+                    LOG(WARNING) << "reach the max byte size truncate result";
+                    break;
+                }
+                byte_size += output_row.size();
+                count += 1;
+            }
+            std::string columnar_buf;
+            if (!codec::EncodeColumnarRows(session.GetSchema(), output_rows, count, &columnar_buf)) {
+                response->set_code(::openmldb::base::kSQLRunError);
+                response->set_msg("fail to encode the result in columnar");
                 return;
             }
-            byte_size += output_row.size();
-            buf->append(reinterpret_cast<void*>(output_row.buf()), output_row.size());
-            count += 1;
+            byte_size = columnar_buf.size();
+            buf->append(columnar_buf);
+            response->set_columnar(true);
+        } else {
+            for (auto& output_row : output_rows) {
+                if (byte_size > FLAGS_scan_max_bytes_size) {
+                    LOG(WARNING) << "reach the max byte size truncate result";
+                    break;
+                }
+                byte_size += output_row.size();
+                buf->append(reinterpret_cast<void*>(output_row.buf()), output_row.size());
+                count += 1;
+            }
         }
         response->set_schema(session.GetEncodedSchema());
         response->set_byte_size(byte_size);
@@ -2184,6 +2371,19 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
+    if (request->pipelined() && request->pre_log_index() > last_log_offset) {
+        // the requests in flight may arrive out of order, wait for the former ones
+        last_log_offset = replicator->WaitOffset(request->pre_log_index(),
+                                                 static_cast<uint64_t>(FLAGS_binlog_sync_wait_time) * 1000);
+        if (request->pre_log_index() > last_log_offset) {
+            PDLOG(WARNING, "pre log index %lu is greater than cur log_offset %lu. tid %u pid %u",
+                  request->pre_log_index(), last_log_offset, tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kAppendEntriesOutOfOrder);
+            response->set_msg("append entries out of order");
+            response->set_log_offset(last_log_offset);
+            return;
+        }
+    }
     for (int32_t i = 0; i < request->entries_size(); i++) {
         const auto& entry = request->entries(i);
         if (entry.log_index() <= last_log_offset) {
@@ -2191,7 +2391,8 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
                     last_log_offset, tid, pid);
             continue;
         }
-        if (!replicator->ApplyEntry(entry)) {
+        // the entries of a request are flushed to binlog together
+        if (!replicator->ApplyEntry(entry, i == request->entries_size() - 1)) {
             PDLOG(WARNING, "fail to write binlog. tid %u pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
             response->set_msg("fail to append entries to replicator");
@@ -2337,6 +2538,9 @@ void TabletImpl::GetTableStatus(RpcController* controller, const ::openmldb::api
             status->set_storage_mode(table->GetStorageMode());
             status->set_name(table->GetName());
             status->set_diskused(table->GetDiskused());
+            if (table->GetStorageMode() != common::kMemory && table->GetTableMeta()->has_storage_options()) {
+                status->mutable_storage_options()->CopyFrom(table->GetTableMeta()->storage_options());
+            }
             if (::openmldb::api::TableState_IsValid(table->GetTableStat())) {
                 status->set_state(::openmldb::api::TableState(table->GetTableStat()));
             }
@@ -2773,6 +2977,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
         std::string snapshot_file;
+        std::vector<std::string> snapshot_files;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2788,11 +2993,19 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 break;
             }
             snapshot_file = manifest.name();
+            snapshot_files = ::openmldb::storage::Snapshot::GetSnapshotFiles(manifest);
         }
         if (table->GetStorageMode() == common::kMemory) {
-            // send snapshot file
-            if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
-                PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
+            // send all files of the snapshot
+            bool send_failed = false;
+            for (const auto& file : snapshot_files) {
+                if (sender.SendFile(file, full_path + file) < 0) {
+                    PDLOG(WARNING, "send snapshot %s failed. tid[%u] pid[%u]", file.c_str(), tid, pid);
+                    send_failed = true;
+                    break;
+                }
+            }
+            if (send_failed) {
                 break;
             }
         } else {
@@ -4063,8 +4276,27 @@ void TabletImpl::GcTable(uint32_t tid, uint32_t pid, bool execute_once) {
         if (!execute_once) {
             gc_pool_.DelayTask(gc_interval * 60 * 1000, boost::bind(&TabletImpl::GcTable, this, tid, pid, false));
         }
+        if (FLAGS_gc_incremental_slice_time > 0 && table->GetStorageMode() == common::kMemory) {
+            // the slices of the last gc may be still running, they own the resume position of the table
+            auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+            if (mem_table && mem_table->TryStartIncrementalGc()) {
+                GcTableSlice(tid, pid);
+            }
+        }
+        return;
+    }
+}
+
+void TabletImpl::GcTableSlice(uint32_t tid, uint32_t pid) {
+    std::shared_ptr<MemTable> table = std::dynamic_pointer_cast<MemTable>(GetTable(tid, pid));
+    if (!table) {
         return;
     }
+    if (!table->IncrementalGc(FLAGS_gc_incremental_slice_time)) {
+        // yield the gc thread to other tables before the next slice
+        gc_pool_.DelayTask(FLAGS_gc_incremental_slice_interval,
+                           boost::bind(&TabletImpl::GcTableSlice, this, tid, pid));
+    }
 }
 
 std::shared_ptr<Snapshot> TabletImpl::GetSnapshot(uint32_t tid, uint32_t pid) {
@@ -4991,7 +5223,12 @@ void TabletImpl::LoadIndexDataInternal(uint32_t tid, uint32_t pid, uint32_t cur_
         } else {
             table->Put(entry);
         }
-        replicator->AppendEntry(entry);
+        if (!replicator->AppendEntry(entry)) {
+            PDLOG(WARNING, "fail to append entry to replicator. tid %u pid %u", tid, pid);
+            delete seq_file;
+            SetTaskStatus(task, ::openmldb::api::TaskStatus::kFailed);
+            return;
+        }
         succ_cnt++;
     }
     delete seq_file;
@@ -5282,6 +5519,23 @@ bool TabletImpl::GetRealEp(uint64_t tid, uint64_t pid, std::map<std::string, std
     return true;
 }
 
+// the compile options of a deployment, the windows of its plain request unions are answered by the window
+// aggregate cache once it is enabled
+static std::shared_ptr<std::unordered_map<std::string, std::string>> GetProcedureOptions(
+    const std::string* long_windows) {
+    std::shared_ptr<std::unordered_map<std::string, std::string>> options = nullptr;
+    if (long_windows || FLAGS_enable_window_aggr_cache) {
+        options = std::make_shared<std::unordered_map<std::string, std::string>>();
+    }
+    if (long_windows) {
+        options->emplace(hybridse::vm::LONG_WINDOWS, *long_windows);
+    }
+    if (FLAGS_enable_window_aggr_cache) {
+        options->emplace(hybridse::vm::WINDOW_AGGR_CACHE, "true");
+    }
+    return options;
+}
+
 void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api::CreateProcedureRequest* request,
                                  openmldb::api::GeneralResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -5298,12 +5552,7 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
     ::hybridse::base::Status status;
     auto sp_info_impl = std::make_shared<openmldb::catalog::ProcedureInfoImpl>(sp_info);
 
-    auto long_windows = sp_info_impl->GetOption(hybridse::vm::LONG_WINDOWS);
-    std::shared_ptr<std::unordered_map<std::string, std::string>> options = nullptr;
-    if (long_windows) {
-        options = std::make_shared<std::unordered_map<std::string, std::string>>();
-        options->emplace(hybridse::vm::LONG_WINDOWS, *long_windows);
-    }
+    auto options = GetProcedureOptions(sp_info_impl->GetOption(hybridse::vm::LONG_WINDOWS));
 
     // build for single request
     ::hybridse::vm::RequestRunSession session;
@@ -5391,7 +5640,9 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     ::hybridse::codec::Row row;
     auto& request_buf = dynamic_cast<brpc::Controller*>(ctrl)->request_attachment();
     size_t input_slices = request.row_slices();
-    if (!codec::DecodeRpcRow(request_buf, 0, request.row_size(), input_slices, &row)) {
+    // the request row is only used in this call and the output row is encoded into the response before returning,
+    // so it refers to the attachment instead of copying it
+    if (!codec::DecodeRpcRow(request_buf, 0, request.row_size(), input_slices, &row, true)) {
         response.set_code(::openmldb::base::kSQLRunError);
         response.set_msg("fail to decode input row");
         return;
@@ -5431,12 +5682,7 @@ void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureI
     const std::string& db_name = sp_info->GetDbName();
     const std::string& sp_name = sp_info->GetSpName();
     const std::string& sql = sp_info->GetSql();
-    auto long_windows = sp_info->GetOption(hybridse::vm::LONG_WINDOWS);
-    std::shared_ptr<std::unordered_map<std::string, std::string>> options = nullptr;
-    if (long_windows) {
-        options = std::make_shared<std::unordered_map<std::string, std::string>>();
-        options->emplace(hybridse::vm::LONG_WINDOWS, *long_windows);
-    }
+    auto options = GetProcedureOptions(sp_info->GetOption(hybridse::vm::LONG_WINDOWS));
 
     ::hybridse::base::Status status;
     // build for single request
@@ -86,6 +86,11 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done);
 
+    // put the rows of one partition, the rows written to the table are
+    // appended to the binlog as one batch
+    void PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                  ::openmldb::api::PutBatchResponse* response, Closure* done);
+
     void Get(RpcController* controller, const ::openmldb::api::GetRequest* request,
              ::openmldb::api::GetResponse* response, Closure* done);
 
@@ -162,6 +167,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void UpdateTTL(RpcController* controller, const ::openmldb::api::UpdateTTLRequest* request,
                    ::openmldb::api::UpdateTTLResponse* response, Closure* done);
 
+    void UpdateStorageOptions(RpcController* controller, const ::openmldb::api::UpdateStorageOptionsRequest* request,
+                              ::openmldb::api::GeneralResponse* response, Closure* done);
+
     void ExecuteGc(RpcController* controller, const ::openmldb::api::ExecuteGcRequest* request,
                    ::openmldb::api::GeneralResponse* response, Closure* done);
 
@@ -300,6 +308,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     void GcTable(uint32_t tid, uint32_t pid, bool execute_once);
 
+    // run the incremental gc of memory table in slices until all expired keys are visited
+    void GcTableSlice(uint32_t tid, uint32_t pid);
+
     void GcTableSnapshot(uint32_t tid, uint32_t pid);
 
     int CheckTableMeta(const openmldb::api::TableMeta* table_meta,
@@ -53,7 +53,8 @@ void ReadLog(const std::string& full_path) {
         full_path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
         for_snapshot = true;
     }
-    Reader reader(rf, NULL, true, 0, for_snapshot);
+    // a binlog may be compressed too, which is told by its first block
+    Reader reader(rf, NULL, true, 0, for_snapshot, !for_snapshot);
     Status status;
     uint64_t success_cnt = 0;
     do {